@@ -377,8 +377,8 @@ void TGlslOutputTraverser::traverseArrayDeclarationWithInit(TIntermDeclaration*
 	assert(decl->containsArrayInitialization());
 	
 	std::stringstream* out = &current->getActiveOutput();
-	TType& type = *decl->getTypePointer();
-	EGlslSymbolType symbol_type = translateType(decl->getTypePointer());
+	const TType& type = decl->getType();
+	EGlslSymbolType symbol_type = translateType(&decl->getType());
 	
 	const bool emit_120_arrays = (m_TargetVersion >= ETargetGLSL_120);
 	const bool emit_old_arrays = !emit_120_arrays || m_ArrayInitWorkaround;
@@ -422,7 +422,7 @@ void TGlslOutputTraverser::traverseArrayDeclarationWithInit(TIntermDeclaration*
 			current->beginStatement();
 			sym->traverse(this);
 			(*out) << "[" << i << "] = ";
-			EGlslSymbolType init_type = translateType(init[i]->getAsTyped()->getTypePointer());
+			EGlslSymbolType init_type = translateType(&init[i]->getAsTyped()->getType());
 
 			bool diffTypes = (symbol_type != init_type);
 			if (diffTypes) {
@@ -496,7 +496,7 @@ bool TGlslOutputTraverser::traverseDeclaration(bool preVisit, TIntermDeclaration
 		return false;
 	}
 
-	TType& type = *decl->getTypePointer();
+	const TType& type = decl->getType();
 	if (type.getBasicType() == EbtTexture)
 	{
 		// right now we can't do anything with "texture" type, just skip it
@@ -512,7 +512,7 @@ bool TGlslOutputTraverser::traverseDeclaration(bool preVisit, TIntermDeclaration
 		out << type.getTypeName();
 	else
 	{
-		EGlslSymbolType symbol_type = translateType(decl->getTypePointer());
+		EGlslSymbolType symbol_type = translateType(&decl->getType());
 		writeType(out, symbol_type, NULL, goit->m_UsePrecision ? decl->getPrecision() : EbpUndefined);
 	}
 
@@ -577,7 +577,7 @@ void TGlslOutputTraverser::traverseSymbol(TIntermSymbol *node, TIntermTraverser
 		}
 		else
 		{
-			int array = node->getTypePointer()->isArray() ? node->getTypePointer()->getArraySize() : 0;
+			int array = node->getType().isArray() ? node->getType().getArraySize() : 0;
 			const char* semantic = "";
 			const char* registerSpec = "";
 
@@ -588,13 +588,13 @@ void TGlslOutputTraverser::traverseSymbol(TIntermSymbol *node, TIntermTraverser
 			}
 			
 			GlslSymbol * sym = new GlslSymbol( goit->m_PrefixTable, node->getSymbol().c_str(), semantic, registerSpec, node->getId(),
-				translateType(node->getTypePointer()), goit->m_UsePrecision?node->getPrecision():EbpUndefined, translateQualifier(node->getQualifier()), array);
+				translateType(&node->getType()), goit->m_UsePrecision?node->getPrecision():EbpUndefined, translateQualifier(node->getQualifier()), array);
 			sym->setIsGlobal(node->isGlobal());
 
 			current->addSymbol(sym);
 			if (sym->getType() == EgstStruct)
 			{
-				GlslStruct *s = goit->createStructFromType( node->getTypePointer());
+				GlslStruct *s = goit->createStructFromType( &node->getType(), node->getTypeLine());
 				sym->setStruct(s);
 			}
 		}
@@ -611,7 +611,7 @@ void TGlslOutputTraverser::traverseParameterSymbol(TIntermSymbol *node, TIntermT
    TGlslOutputTraverser* goit = static_cast<TGlslOutputTraverser*>(it);
    GlslFunction *current = goit->current;
 
-   int array = node->getTypePointer()->isArray() ? node->getTypePointer()->getArraySize() : 0;
+   int array = node->getType().isArray() ? node->getType().getArraySize() : 0;
    const char* semantic = "";
    const char* registerSpec = "";
    if (node->getInfo())
@@ -630,12 +630,12 @@ void TGlslOutputTraverser::traverseParameterSymbol(TIntermSymbol *node, TIntermT
     }
 
    GlslSymbol * sym = new GlslSymbol( goit->m_PrefixTable, node->getSymbol().c_str(), semantic, registerSpec, node->getId(),
-                                      translateType(node->getTypePointer()), prec, translateQualifier(node->getQualifier()), array);
+                                      translateType(&node->getType()), prec, translateQualifier(node->getQualifier()), array);
    current->addParameter(sym);
 
    if (sym->getType() == EgstStruct)
    {
-      GlslStruct *s = goit->createStructFromType( node->getTypePointer());
+      GlslStruct *s = goit->createStructFromType( &node->getType(), node->getTypeLine());
       sym->setStruct(s);
    }
 }
@@ -646,7 +646,7 @@ void TGlslOutputTraverser::traverseConstant( TIntermConstant *node, TIntermTrave
    TGlslOutputTraverser* goit = static_cast<TGlslOutputTraverser*>(it);
    GlslFunction *current = goit->current;
    std::stringstream& out = current->getActiveOutput();
-   EGlslSymbolType type = translateType( node->getTypePointer());
+   EGlslSymbolType type = translateType( &node->getType());
    GlslStruct *str = 0;
 
 
@@ -654,7 +654,7 @@ void TGlslOutputTraverser::traverseConstant( TIntermConstant *node, TIntermTrave
 
    if (type == EgstStruct)
    {
-      str = goit->createStructFromType( node->getTypePointer());
+      str = goit->createStructFromType( &node->getType(), node->getTypeLine());
    }
 
    writeConstantConstructor (out, type, goit->m_UsePrecision?node->getPrecision():EbpUndefined, node, str);
@@ -864,7 +864,7 @@ bool TGlslOutputTraverser::traverseBinary( bool preVisit, TIntermBinary *node, T
    case EOpIndexDirectStruct:
       {
          current->beginStatement();
-         GlslStruct *s = goit->createStructFromType(node->getLeft()->getTypePointer());
+         GlslStruct *s = goit->createStructFromType(&node->getLeft()->getType(), node->getLeft()->getTypeLine());
          if (node->getLeft())
             node->getLeft()->traverse(goit);
 
@@ -1161,9 +1161,9 @@ bool TGlslOutputTraverser::traverseUnary( bool preVisit, TIntermUnary *node, TIn
    case EOpConvIntToBool:
    case EOpConvFloatToBool:
       op = "bool";
-      if (node->getTypePointer()->isVector())
+      if (node->getType().isVector())
       {
-         zero[0] += node->getTypePointer()->getRowsCount();
+         zero[0] += node->getType().getRowsCount();
          op = TString("bvec") + zero; 
       }
       funcStyle = true;
@@ -1173,9 +1173,9 @@ bool TGlslOutputTraverser::traverseUnary( bool preVisit, TIntermUnary *node, TIn
    case EOpConvBoolToFloat:
    case EOpConvIntToFloat:
       op = "float";
-      if (node->getTypePointer()->isVector())
+      if (node->getType().isVector())
       {
-         zero[0] += node->getTypePointer()->getRowsCount();
+         zero[0] += node->getType().getRowsCount();
          op = TString("vec") + zero; 
       }
       funcStyle = true;
@@ -1185,9 +1185,9 @@ bool TGlslOutputTraverser::traverseUnary( bool preVisit, TIntermUnary *node, TIn
    case EOpConvFloatToInt: 
    case EOpConvBoolToInt:
       op = "int";
-      if (node->getTypePointer()->isVector())
+      if (node->getType().isVector())
       {
-         zero[0] += node->getTypePointer()->getRowsCount();
+         zero[0] += node->getType().getRowsCount();
          op = TString("ivec") + zero; 
       }
       funcStyle = true;
@@ -1445,11 +1445,11 @@ bool TGlslOutputTraverser::traverseAggregate( bool preVisit, TIntermAggregate *n
    case EOpFunction:
       {
          GlslFunction *func = new GlslFunction( goit->m_PrefixTable, node->getPlainName().c_str(), node->getName().c_str(),
-                                                translateType(node->getTypePointer()), goit->m_UsePrecision?node->getPrecision():EbpUndefined,
+                                                translateType(&node->getType()), goit->m_UsePrecision?node->getPrecision():EbpUndefined,
 											   node->getSemantic().c_str(), node->getLine()); 
          if (func->getReturnType() == EgstStruct)
          {
-            GlslStruct *s = goit->createStructFromType( node->getTypePointer());
+            GlslStruct *s = goit->createStructFromType( &node->getType(), node->getTypeLine());
             func->setStruct(s);
          }
          goit->functionList.push_back( func);
@@ -1513,8 +1513,8 @@ bool TGlslOutputTraverser::traverseAggregate( bool preVisit, TIntermAggregate *n
       writeFuncCall(goit->m_LinkerPrefix + "constructMat3", node, goit, false, true);
       return false;
 
-   case EOpConstructStruct:  writeFuncCall( node->getTypePointer()->getTypeName(), node, goit); return false;
-   case EOpConstructArray:  writeFuncCall( buildArrayConstructorString(*node->getTypePointer()), node, goit); return false;
+   case EOpConstructStruct:  writeFuncCall( node->getType().getTypeName(), node, goit); return false;
+   case EOpConstructArray:  writeFuncCall( buildArrayConstructorString(node->getType()), node, goit); return false;
 
    case EOpComma:
       {
@@ -1851,7 +1851,7 @@ bool TGlslOutputTraverser::traverseBranch( bool preVisit, TIntermBranch *node,
 }
 
 
-GlslStruct *TGlslOutputTraverser::createStructFromType (TType *type)
+GlslStruct *TGlslOutputTraverser::createStructFromType (const TType *type, const TSourceLoc& line)
 {
    GlslStruct *s = 0;
    std::string structName = type->getTypeName().c_str();
@@ -1881,7 +1881,7 @@ GlslStruct *TGlslOutputTraverser::createStructFromType (TType *type)
       //This is a new structure, build a type for it
       TTypeList &tList = *type->getStruct();
 
-      s = new GlslStruct(structName, type->getLine());
+      s = new GlslStruct(structName, line);
 
       for (TTypeList::iterator it = tList.begin(); it != tList.end(); it++)
       {
@@ -1900,7 +1900,7 @@ GlslStruct *TGlslOutputTraverser::createStructFromType (TType *type)
                                              EqtNone,
                                              prec,
                                              it->type->isArray() ? it->type->getArraySize() : 0,
-                                            (it->type->getBasicType() == EbtStruct) ? createStructFromType(it->type) : NULL,
+                                            (it->type->getBasicType() == EbtStruct) ? createStructFromType(it->type, it->type->getLine()) : NULL,
                                              structName);
          s->addMember(*m);
 		 delete m;
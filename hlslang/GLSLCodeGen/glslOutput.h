@@ -37,7 +37,7 @@ private:
 
 public:
 	TGlslOutputTraverser (TInfoSink& i, std::vector<GlslFunction*> &funcList, std::vector<GlslStruct*> &sList, std::stringstream& deferredArrayInit, std::stringstream& deferredMatrixInit, ETargetVersion version, unsigned options, const TPrefixTable& m_PrefixTable);
-	GlslStruct *createStructFromType( TType *type );
+	GlslStruct *createStructFromType( const TType *type, const TSourceLoc& line );
 	
 	// Info Sink
 	TInfoSink& infoSink;
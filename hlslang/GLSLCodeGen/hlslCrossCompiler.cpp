@@ -9,6 +9,8 @@
 #include "typeSamplers.h"
 #include "propagateMutable.h"
 #include "hlslLinker.h"
+#include "../MachineIndependent/IncludeCache.h"
+#include "../MachineIndependent/RemoveTree.h"
 
 namespace hlsl2glsl
 {
@@ -17,23 +19,44 @@ HlslCrossCompiler::HlslCrossCompiler(EShLanguage l, const ShUserPrefixTable* pt)
 :	language(l)
 ,	m_ASTTransformed(false)
 ,	m_GlslProduced(false)
+,	m_GlslVersion(ETargetVersionCount)
+,	m_AST(0)
+,	m_ASTVersion(ETargetVersionCount)
+,	m_ASTTargetDependent(false)
+,	m_ParseOptions(0)
+,	m_IncludeCache(0)
+,	parseCount(0)
 {
 	m_PrefixTable.copyFrom(pt);
 	linker = new HlslLinker(infoSink, m_PrefixTable);
 }
 
 HlslCrossCompiler::~HlslCrossCompiler()
+{
+   ReleaseAST();
+   SetIncludeCache(0);
+   delete linker;
+}
+
+
+void HlslCrossCompiler::ClearGLSL ()
 {
    for ( std::vector<GlslFunction*>::iterator it = functionList.begin() ; it != functionList.end(); it++)
    {
       delete *it;
    }
+   functionList.clear();
 
    for ( std::vector<GlslStruct*>::iterator it = structList.begin() ; it != structList.end(); it++)
    {
       delete *it;
    }
-   delete linker;
+   structList.clear();
+
+   m_DeferredArrayInit.str("");
+   m_DeferredMatrixInit.str("");
+   m_GlslProduced = false;
+   m_GlslVersion = ETargetVersionCount;
 }
 
 
@@ -46,10 +69,78 @@ void HlslCrossCompiler::TransformAST (TIntermNode *root)
 
 void HlslCrossCompiler::ProduceGLSL (TIntermNode *root, ETargetVersion version, unsigned options)
 {
+	ClearGLSL();
 	m_GlslProduced = true;
+	m_GlslVersion = version;
 	TGlslOutputTraverser glslTraverse (infoSink, functionList, structList, m_DeferredArrayInit, m_DeferredMatrixInit,
 		version, options, m_PrefixTable);
 	root->traverse(&glslTraverse);
 }
 
+
+const std::shared_ptr<TPoolAllocator>& HlslCrossCompiler::GetASTPool()
+{
+	if (!m_ASTPool)
+		m_ASTPool = std::make_shared<TPoolAllocator>();
+	return m_ASTPool;
+}
+
+
+void HlslCrossCompiler::KeepSource (const char* source, unsigned options, const std::shared_ptr<const TPreprocessedSource>& preprocessed)
+{
+	m_Source = source;
+	m_Preprocessed = preprocessed;
+	m_ParseOptions = options;
+}
+
+
+void HlslCrossCompiler::KeepAST (TIntermNode* root, ETargetVersion version, bool targetDependent)
+{
+	m_AST = root;
+	m_ASTVersion = version;
+	m_ASTTargetDependent = targetDependent;
+}
+
+
+void HlslCrossCompiler::ReleaseAST ()
+{
+	ClearGLSL();
+	m_ASTTransformed = false;
+
+	if (m_AST)
+		ir_remove_tree(m_AST);
+	m_AST = 0;
+	m_ASTTypes.clear();
+	if (m_ASTPool)
+		m_ASTPool->popAll();
+
+	m_Source.clear();
+	m_Preprocessed.reset();
+}
+
+
+bool HlslCrossCompiler::CanReuseAST (ETargetVersion version) const
+{
+	if (!m_AST)
+		return false;
+	// Rules only change at GLSL 1.20, see TParseContext::isGLSL120Target
+	return !m_ASTTargetDependent || ((version >= ETargetGLSL_120) == (m_ASTVersion >= ETargetGLSL_120));
+}
+
+
+void HlslCrossCompiler::ReproduceGLSL (ETargetVersion version)
+{
+	ProduceGLSL(m_AST, version, m_ParseOptions);
+}
+
+
+void HlslCrossCompiler::SetIncludeCache (TIncludeCache* cache)
+{
+	if (cache)
+		cache->retain();
+	if (m_IncludeCache)
+		m_IncludeCache->release();
+	m_IncludeCache = cache;
+}
+
 } // namespace hlsl2glsl
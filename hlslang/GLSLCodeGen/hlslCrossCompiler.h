@@ -11,11 +11,16 @@
 
 #include "glslFunction.h"
 #include "glslStruct.h"
+#include "../MachineIndependent/IncludeCache.h"
+#include "../MachineIndependent/TypeTable.h"
+
+#include <memory>
 
 namespace hlsl2glsl
 {
 
 class HlslLinker;
+struct TPreprocessedSource;
 
 class HlslCrossCompiler
 {
@@ -31,6 +36,31 @@ public:
    void ProduceGLSL (TIntermNode* root, ETargetVersion version, unsigned options);
    bool IsASTTransformed() const { return m_ASTTransformed; }
    bool IsGlslProduced() const { return m_GlslProduced; }
+   ETargetVersion GetGlslVersion() const { return m_GlslVersion; }
+
+   /// Pool the syntax tree lives in; it stays with the compiler until the next parse
+   const std::shared_ptr<TPoolAllocator>& GetASTPool();
+   /// Shared types of the nodes of the syntax tree, in its pool
+   TTypeTable& GetASTTypes() { return m_ASTTypes; }
+   /// Remember the source and the transformed tree, to produce GLSL for other targets later.
+   /// preprocessed, if set, holds the tokens the tree was parsed from instead of the source;
+   /// it is set whenever the source could include files, so no include callbacks are needed later.
+   /// targetDependent tells whether parsing looked at the target version.
+   void KeepSource (const char* source, unsigned options, const std::shared_ptr<const TPreprocessedSource>& preprocessed);
+   void KeepAST (TIntermNode* root, ETargetVersion version, bool targetDependent);
+   /// Forget the tree, the GLSL produced from it and the kept source
+   void ReleaseAST ();
+
+   /// Whether the kept tree can produce GLSL for version, or the source has to be parsed again
+   bool CanReuseAST (ETargetVersion version) const;
+   void ReproduceGLSL (ETargetVersion version);
+   const std::string& GetSource() const { return m_Source; }
+   const std::shared_ptr<const TPreprocessedSource>& GetPreprocessed() const { return m_Preprocessed; }
+   unsigned GetParseOptions() const { return m_ParseOptions; }
+
+   /// Include file cache for all parses, may be NULL. The compiler holds a reference.
+   void SetIncludeCache (TIncludeCache* cache);
+   TIncludeCache* GetIncludeCache() const { return m_IncludeCache; }
 
    HlslLinker* GetLinker() { return linker; }
 
@@ -39,6 +69,21 @@ private:
 	TPrefixTable m_PrefixTable;
 	bool m_ASTTransformed;
 	bool m_GlslProduced;
+	ETargetVersion m_GlslVersion;
+
+	void ClearGLSL ();
+
+	// What the last parse left behind
+	std::shared_ptr<TPoolAllocator> m_ASTPool;
+	TTypeTable m_ASTTypes;
+	TIntermNode* m_AST;
+	ETargetVersion m_ASTVersion;
+	bool m_ASTTargetDependent;
+	std::string m_Source;
+	std::shared_ptr<const TPreprocessedSource> m_Preprocessed;
+	unsigned m_ParseOptions;
+
+	TIncludeCache* m_IncludeCache;
 
 public:
 	HlslLinker* linker;
@@ -47,6 +92,20 @@ public:
 	std::vector<GlslStruct*> structList;
 	std::stringstream m_DeferredArrayInit;
 	std::stringstream m_DeferredMatrixInit;
+
+	// Shaders parsed on the handle so far, see Hlsl2Glsl_GetParseCount
+	int parseCount;
+
+	// What the last Hlsl2Glsl_Preprocess produced
+	std::string preprocessedText;
+	std::vector<Hlsl2Glsl_SourceSpan> sourceMap;
+	std::vector<std::string> sourceFiles;
+	std::vector<const char*> sourceFileNames;
+
+	// What the last parse or cached compile with ETranslateOpRecordDependencies included
+	std::vector<TIncludeDependency> dependencies;
+	std::vector<Hlsl2Glsl_Dependency> dependencyList;
+	std::string depfile;
 };
 
 } // namespace hlsl2glsl
@@ -301,6 +301,7 @@ static inline bool UsesBuiltinAttribStrings(ETargetVersion targetVersion, unsign
 HlslLinker::HlslLinker(TInfoSink& infoSink_, const TPrefixTable& prefixTable)
 : infoSink(infoSink_)
 , m_PrefixTable(prefixTable)
+, m_HasLinkedOutput(false)
 , m_Target(ETargetVersionCount)
 , m_Options(0)
 {
@@ -311,7 +312,7 @@ HlslLinker::HlslLinker(TInfoSink& infoSink_, const TPrefixTable& prefixTable)
 }
 
 
-HlslLinker::~HlslLinker()
+static void freeUniformInfo(std::vector<ShUniformInfo>& uniforms)
 {
 	for ( std::vector<ShUniformInfo>::iterator it = uniforms.begin(); it != uniforms.end(); it++)
 	{
@@ -320,6 +321,13 @@ HlslLinker::~HlslLinker()
 		delete [] it->registerSpec;
 		delete [] it->init;
 	}
+	uniforms.clear();
+}
+
+
+HlslLinker::~HlslLinker()
+{
+	freeUniformInfo(uniforms);
 }
 
 static const char* get_builtin_variable_from_semantic(EAttribSemantic sem, ETargetVersion targetVersion)
@@ -959,7 +967,7 @@ void HlslLinker::emitLibraryFunctions(const std::set<TOperator>& libFunctions, E
 	{
 		for (std::set<TOperator>::const_iterator it = libFunctions.begin(); it != libFunctions.end(); it++)
 		{
-			std::string func = getHLSLSupportCode(*it, m_Extensions, lang==EShLangVertex, usePrecision);
+			std::string func = getHLSLSupportCode(*it, m_Extensions, lang==EShLangVertex, usePrecision, m_Target);
 			if (!func.empty())
 			{
 				ReplaceString(func, "@LL@", m_PrefixTable.prefixLinker);
@@ -1543,6 +1551,10 @@ bool HlslLinker::link(HlslCrossCompiler* compiler, const char* entryFunc, ETarge
 	m_Target = targetVersion;
 	m_Options = options;
 	m_Extensions.clear();
+	m_HasLinkedOutput = false;
+	shaderPrefix.str("");
+	shader.str("");
+	freeUniformInfo(uniforms);
 	if (!linkerSanityCheck(compiler, entryFunc))
 		return false;
 	
@@ -1721,8 +1733,18 @@ static std::string CleanupShaderText (const std::string& prefix, const std::stri
 
 const char* HlslLinker::getShaderText() const 
 {
-	bs = CleanupShaderText (shaderPrefix.str(), shader.str());
+	if (!m_HasLinkedOutput)
+		bs = CleanupShaderText (shaderPrefix.str(), shader.str());
 	return bs.c_str();
 }
 
+
+void HlslLinker::setLinkedOutput(const std::string& shaderText, std::vector<ShUniformInfo>& uniformInfo)
+{
+	freeUniformInfo(uniforms);
+	uniforms.swap(uniformInfo);
+	bs = shaderText;
+	m_HasLinkedOutput = true;
+}
+
 } // namespace glslang
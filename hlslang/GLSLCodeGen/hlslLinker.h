@@ -44,8 +44,12 @@ public:
    bool link(HlslCrossCompiler*, const char* entry, ETargetVersion version, unsigned options);
 
    bool setUserAttribName (EAttribSemantic eSemantic, const char *pName);
+   const char* getUserAttribName (EAttribSemantic eSemantic) const { return userAttribString[eSemantic]; }
 
    const char* getShaderText() const;
+
+   /// Take over the output of an earlier link, e.g. from a compile cache. Takes ownership of the uniform strings.
+   void setLinkedOutput(const std::string& shaderText, std::vector<ShUniformInfo>& uniformInfo);
       
    int getUniformCount() const { return (int)uniforms.size(); }
    const ShUniformInfo* getUniformInfo() const  { return (!uniforms.empty()) ? &uniforms[0] : 0; }
@@ -101,6 +105,9 @@ private:
 	
 	// Helper string to store shader text
 	mutable std::string bs;
+
+	// bs already holds the final shader text, set through setLinkedOutput
+	bool m_HasLinkedOutput;
 	
 	// Table holding the list of user attribute names per semantic
 	char userAttribString[EAttrSemCount][MAX_ATTRIB_NAME];
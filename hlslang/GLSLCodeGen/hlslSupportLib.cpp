@@ -6,352 +6,342 @@
 // Implementation of support library to generate GLSL functions to support HLSL
 // functions that don't map to built-ins
 
+#include <cassert>
 #include <map>
 #include <memory>
+#include <mutex>
 #include "hlslSupportLib.h"
 
 namespace hlsl2glsl
 {
 
 typedef std::map<TOperator,std::string> CodeMap;
-thread_local std::unique_ptr<CodeMap> hlslSupportLib;
-thread_local std::unique_ptr<CodeMap> hlslSupportLibESOverrides;
-
 typedef std::map< TOperator, std::pair<std::string,std::string> > CodeExtensionMap;
-thread_local std::unique_ptr<CodeExtensionMap> hlslSupportLibExtensions;
-thread_local std::unique_ptr<CodeExtensionMap> hlslSupportLibExtensionsESOverrides;
 
-void insertPre130TextureLookups()
+// Collects the support code while a library gets built, first insert for an op wins
+struct TSupportLibBuilder
+{
+	CodeMap code;
+	CodeMap esCode;
+	CodeExtensionMap extensions;
+	CodeExtensionMap esExtensions;
+};
+
+static void insertPre130TextureLookups(TSupportLibBuilder& lib)
 {
-    hlslSupportLib->insert( CodeMap::value_type( EOpTex1DBias,
+    lib.code.insert( CodeMap::value_type( EOpTex1DBias,
         "vec4 @LL@tex1Dbias(sampler1D s, vec4 coord) {\n"
         "  return texture1D( s, coord.x, coord.w);\n"
         "}\n\n" )
         );
 
-    hlslSupportLib->insert( CodeMap::value_type( EOpTex1DLod,
+    lib.code.insert( CodeMap::value_type( EOpTex1DLod,
         "vec4 @LL@tex1Dlod(sampler1D s, vec4 coord) {\n"
         "  return texture1DLod( s, coord.x, coord.w);\n"
         "}\n\n" )
         );
-    hlslSupportLibExtensions->insert (std::make_pair(EOpTex1DLod, std::make_pair("","GL_ARB_shader_texture_lod")));
+    lib.extensions.insert (std::make_pair(EOpTex1DLod, std::make_pair("","GL_ARB_shader_texture_lod")));
 
-    hlslSupportLib->insert( CodeMap::value_type( EOpTex1DGrad,
+    lib.code.insert( CodeMap::value_type( EOpTex1DGrad,
         "vec4 @LL@tex1Dgrad(sampler1D s, float coord, float ddx, float ddy) {\n"
         "  return texture1DGradARB( s, coord, ddx, ddy);\n"
         "}\n\n" )
         );
-    hlslSupportLibExtensions->insert (std::make_pair(EOpTex1DGrad, std::make_pair("GL_ARB_shader_texture_lod","GL_ARB_shader_texture_lod")));
+    lib.extensions.insert (std::make_pair(EOpTex1DGrad, std::make_pair("GL_ARB_shader_texture_lod","GL_ARB_shader_texture_lod")));
 
-    hlslSupportLib->insert( CodeMap::value_type( EOpTex2DBias,
+    lib.code.insert( CodeMap::value_type( EOpTex2DBias,
         "vec4 @LL@tex2Dbias(sampler2D s, vec4 coord) {\n"
         "  return texture2D( s, coord.xy, coord.w);\n"
         "}\n\n" )
         );
 
-    hlslSupportLib->insert( CodeMap::value_type( EOpTex2DLod,
+    lib.code.insert( CodeMap::value_type( EOpTex2DLod,
         "vec4 @LL@tex2Dlod(sampler2D s, vec4 coord) {\n"
         "   return texture2DLod( s, coord.xy, coord.w);\n"
         "}\n\n" )
         );
-    hlslSupportLibExtensions->insert (std::make_pair(EOpTex2DLod, std::make_pair("","GL_ARB_shader_texture_lod")));
+    lib.extensions.insert (std::make_pair(EOpTex2DLod, std::make_pair("","GL_ARB_shader_texture_lod")));
 
-    hlslSupportLibESOverrides->insert( CodeMap::value_type( EOpTex2DLod,
+    lib.esCode.insert( CodeMap::value_type( EOpTex2DLod,
         "vec4 @LL@tex2Dlod(sampler2D s, vec4 coord) {\n"
         "   return texture2DLodEXT( s, coord.xy, coord.w);\n"
         "}\n\n" )
         );
-    hlslSupportLibExtensionsESOverrides->insert (std::make_pair(EOpTex2DLod, std::make_pair("","GL_EXT_shader_texture_lod")));
+    lib.esExtensions.insert (std::make_pair(EOpTex2DLod, std::make_pair("","GL_EXT_shader_texture_lod")));
 
-    hlslSupportLib->insert( CodeMap::value_type( EOpTex2DGrad,
+    lib.code.insert( CodeMap::value_type( EOpTex2DGrad,
         "vec4 @LL@tex2Dgrad(sampler2D s, vec2 coord, vec2 ddx, vec2 ddy) {\n"
         "   return texture2DGradARB( s, coord, ddx, ddy);\n"
         "}\n\n" )
         );
-    hlslSupportLibExtensions->insert (std::make_pair(EOpTex2DGrad, std::make_pair("GL_ARB_shader_texture_lod","GL_ARB_shader_texture_lod")));
+    lib.extensions.insert (std::make_pair(EOpTex2DGrad, std::make_pair("GL_ARB_shader_texture_lod","GL_ARB_shader_texture_lod")));
 
-    hlslSupportLibESOverrides->insert( CodeMap::value_type( EOpTex2DGrad,
+    lib.esCode.insert( CodeMap::value_type( EOpTex2DGrad,
         "vec4 @LL@tex2Dgrad(sampler2D s, vec2 coord, vec2 ddx, vec2 ddy) {\n"
         "   return texture2DGradEXT( s, coord, ddx, ddy);\n"
         "}\n\n" )
         );
-    hlslSupportLibExtensionsESOverrides->insert (std::make_pair(EOpTex2DGrad, std::make_pair("GL_EXT_shader_texture_lod","GL_EXT_shader_texture_lod")));
+    lib.esExtensions.insert (std::make_pair(EOpTex2DGrad, std::make_pair("GL_EXT_shader_texture_lod","GL_EXT_shader_texture_lod")));
 
 
-    hlslSupportLib->insert( CodeMap::value_type( EOpTex3DBias,
+    lib.code.insert( CodeMap::value_type( EOpTex3DBias,
         "vec4 @LL@tex3Dbias(sampler3D s, vec4 coord) {\n"
         "  return texture3D( s, coord.xyz, coord.w);\n"
         "}\n\n" )
         );
 
-    hlslSupportLib->insert( CodeMap::value_type( EOpTex3DLod,
+    lib.code.insert( CodeMap::value_type( EOpTex3DLod,
         "vec4 @LL@tex3Dlod(sampler3D s, vec4 coord) {\n"
         "  return texture3DLod( s, coord.xyz, coord.w);\n"
         "}\n\n" )
         );
-    hlslSupportLibExtensions->insert (std::make_pair(EOpTex3DLod, std::make_pair("","GL_ARB_shader_texture_lod")));
+    lib.extensions.insert (std::make_pair(EOpTex3DLod, std::make_pair("","GL_ARB_shader_texture_lod")));
 
-    hlslSupportLib->insert( CodeMap::value_type( EOpTex3DGrad,
+    lib.code.insert( CodeMap::value_type( EOpTex3DGrad,
         "vec4 @LL@tex3Dgrad(sampler3D s, vec3 coord, vec3 ddx, vec3 ddy) {\n"
         "  return texture3DGradARB( s, coord, ddx, ddy);\n"
         "}\n\n" )
         );
-    hlslSupportLibExtensions->insert (std::make_pair(EOpTex3DGrad, std::make_pair("GL_ARB_shader_texture_lod","GL_ARB_shader_texture_lod")));
+    lib.extensions.insert (std::make_pair(EOpTex3DGrad, std::make_pair("GL_ARB_shader_texture_lod","GL_ARB_shader_texture_lod")));
 
-    hlslSupportLib->insert( CodeMap::value_type( EOpTexCubeBias,
+    lib.code.insert( CodeMap::value_type( EOpTexCubeBias,
         "vec4 @LL@texCUBEbias(samplerCube s, vec4 coord) {\n"
         "  return textureCube( s, coord.xyz, coord.w);\n"
         "}\n\n" )
         );
 
-    hlslSupportLib->insert( CodeMap::value_type( EOpTexCubeLod,
+    lib.code.insert( CodeMap::value_type( EOpTexCubeLod,
         "vec4 @LL@texCUBElod(samplerCube s, vec4 coord) {\n"
         "  return textureCubeLod( s, coord.xyz, coord.w);\n"
         "}\n\n" )
         );
-    hlslSupportLibExtensions->insert (std::make_pair(EOpTexCubeLod, std::make_pair("","GL_ARB_shader_texture_lod")));
+    lib.extensions.insert (std::make_pair(EOpTexCubeLod, std::make_pair("","GL_ARB_shader_texture_lod")));
 
-    hlslSupportLibESOverrides->insert( CodeMap::value_type( EOpTexCubeLod,
+    lib.esCode.insert( CodeMap::value_type( EOpTexCubeLod,
 		"vec4 @LL@texCUBElod(samplerCube s, vec4 coord) {\n"
 		"  return textureCubeLodEXT( s, coord.xyz, coord.w);\n"
 		"}\n\n" )
 		);
-	hlslSupportLibExtensionsESOverrides->insert (std::make_pair(EOpTexCubeLod, std::make_pair("","GL_EXT_shader_texture_lod")));
+	lib.esExtensions.insert (std::make_pair(EOpTexCubeLod, std::make_pair("","GL_EXT_shader_texture_lod")));
 
-    hlslSupportLib->insert( CodeMap::value_type( EOpTexCubeGrad,
+    lib.code.insert( CodeMap::value_type( EOpTexCubeGrad,
         "vec4 @LL@texCUBEgrad(samplerCube s, vec3 coord, vec3 ddx, vec3 ddy) {\n"
         "  return textureCubeGradARB( s, coord, ddx, ddy);\n"
         "}\n\n" )
         );
-    hlslSupportLibExtensions->insert (std::make_pair(EOpTexCubeGrad, std::make_pair("GL_ARB_shader_texture_lod","GL_ARB_shader_texture_lod")));
+    lib.extensions.insert (std::make_pair(EOpTexCubeGrad, std::make_pair("GL_ARB_shader_texture_lod","GL_ARB_shader_texture_lod")));
 
-    hlslSupportLibESOverrides->insert( CodeMap::value_type( EOpTexCubeGrad,
+    lib.esCode.insert( CodeMap::value_type( EOpTexCubeGrad,
 		"vec4 @LL@texCUBEgrad(samplerCube s, vec3 coord, vec3 ddx, vec3 ddy) {\n"
 		"  return textureCubeGradEXT( s, coord, ddx, ddy);\n"
 		"}\n\n" )
 		);
-	hlslSupportLibExtensionsESOverrides->insert (std::make_pair(EOpTexCubeGrad, std::make_pair("GL_EXT_shader_texture_lod","GL_EXT_shader_texture_lod")));
+	lib.esExtensions.insert (std::make_pair(EOpTexCubeGrad, std::make_pair("GL_EXT_shader_texture_lod","GL_EXT_shader_texture_lod")));
 
     // shadow2D / shadow2Dproj
-    hlslSupportLib->insert(CodeMap::value_type(EOpShadow2D,
+    lib.code.insert(CodeMap::value_type(EOpShadow2D,
         "float @LL@shadow2D(sampler2DShadow s, vec3 coord) { return shadow2D (s, coord).r; }\n"
         ));
-    hlslSupportLibESOverrides->insert(CodeMap::value_type(EOpShadow2D,
+    lib.esCode.insert(CodeMap::value_type(EOpShadow2D,
         "float @LL@shadow2D(sampler2DShadow s, vec3 coord) { return shadow2DEXT (s, coord); }\n"
         ));
-    hlslSupportLibExtensionsESOverrides->insert (std::make_pair(EOpShadow2D, std::make_pair("","GL_EXT_shadow_samplers")));
+    lib.esExtensions.insert (std::make_pair(EOpShadow2D, std::make_pair("","GL_EXT_shadow_samplers")));
 
-    hlslSupportLib->insert(CodeMap::value_type(EOpShadow2DProj,
+    lib.code.insert(CodeMap::value_type(EOpShadow2DProj,
         "float @LL@shadow2Dproj(sampler2DShadow s, vec4 coord) { return shadow2DProj (s, coord).r; }\n"
         ));
-    hlslSupportLibESOverrides->insert(CodeMap::value_type(EOpShadow2DProj,
+    lib.esCode.insert(CodeMap::value_type(EOpShadow2DProj,
         "float @LL@shadow2Dproj(sampler2DShadow s, vec4 coord) { return shadow2DProjEXT (s, coord); }\n"
         ));
-    hlslSupportLibExtensionsESOverrides->insert (std::make_pair(EOpShadow2DProj, std::make_pair("","GL_EXT_shadow_samplers")));
+    lib.esExtensions.insert (std::make_pair(EOpShadow2DProj, std::make_pair("","GL_EXT_shadow_samplers")));
 
 	// texture arrays
-	hlslSupportLib->insert(CodeMap::value_type(EOpTex2DArray, "vec4 @LL@tex2DArray(sampler2DArray s, vec3 coord) { return texture2DArray (s, coord); }\n"));
-	hlslSupportLibExtensions->insert (std::make_pair(EOpTex2DArray, std::make_pair("GL_EXT_texture_array","GL_EXT_texture_array")));
-	hlslSupportLibESOverrides->insert(CodeMap::value_type(EOpTex2DArray, "vec4 @LL@tex2DArray(sampler2DArrayNV s, vec3 coord) { return texture2DArrayNV (s, coord); }\n"));
-	hlslSupportLibExtensionsESOverrides->insert (std::make_pair(EOpTex2DArray, std::make_pair("GL_NV_texture_array","GL_NV_texture_array")));
-
-	hlslSupportLib->insert(CodeMap::value_type(EOpTex2DArrayLod, "vec4 @LL@tex2DArrayLod(sampler2DArray s, vec4 coord) { return texture2DArrayLod (s, coord.xyz, coord.w); }\n"));
-	hlslSupportLibExtensions->insert (std::make_pair(EOpTex2DArrayLod, std::make_pair("GL_EXT_texture_array","GL_EXT_texture_array")));
-	hlslSupportLibESOverrides->insert(CodeMap::value_type(EOpTex2DArrayLod, "vec4 @LL@tex2DArrayLod(sampler2DArrayNV s, vec4 coord) { return texture2DArrayLodNV (s, coord.xyz, coord.w); }\n"));
-	hlslSupportLibExtensionsESOverrides->insert (std::make_pair(EOpTex2DArrayLod, std::make_pair("GL_NV_texture_array","GL_NV_texture_array")));
-
-	hlslSupportLib->insert(CodeMap::value_type(EOpTex2DArrayBias, "vec4 @LL@tex2DArrayBias(sampler2DArray s, vec4 coord) { return texture2DArray (s, coord.xyz, coord.w); }\n"));
-	hlslSupportLibExtensions->insert (std::make_pair(EOpTex2DArrayBias, std::make_pair("GL_EXT_texture_array","GL_EXT_texture_array")));
-	hlslSupportLibESOverrides->insert(CodeMap::value_type(EOpTex2DArrayBias, "vec4 @LL@tex2DArrayBias(sampler2DArrayNV s, vec4 coord) { return texture2DArrayNV (s, coord.xyz, coord.w); }\n"));
-	hlslSupportLibExtensionsESOverrides->insert (std::make_pair(EOpTex2DArrayBias, std::make_pair("GL_NV_texture_array","GL_NV_texture_array")));
+	lib.code.insert(CodeMap::value_type(EOpTex2DArray, "vec4 @LL@tex2DArray(sampler2DArray s, vec3 coord) { return texture2DArray (s, coord); }\n"));
+	lib.extensions.insert (std::make_pair(EOpTex2DArray, std::make_pair("GL_EXT_texture_array","GL_EXT_texture_array")));
+	lib.esCode.insert(CodeMap::value_type(EOpTex2DArray, "vec4 @LL@tex2DArray(sampler2DArrayNV s, vec3 coord) { return texture2DArrayNV (s, coord); }\n"));
+	lib.esExtensions.insert (std::make_pair(EOpTex2DArray, std::make_pair("GL_NV_texture_array","GL_NV_texture_array")));
+
+	lib.code.insert(CodeMap::value_type(EOpTex2DArrayLod, "vec4 @LL@tex2DArrayLod(sampler2DArray s, vec4 coord) { return texture2DArrayLod (s, coord.xyz, coord.w); }\n"));
+	lib.extensions.insert (std::make_pair(EOpTex2DArrayLod, std::make_pair("GL_EXT_texture_array","GL_EXT_texture_array")));
+	lib.esCode.insert(CodeMap::value_type(EOpTex2DArrayLod, "vec4 @LL@tex2DArrayLod(sampler2DArrayNV s, vec4 coord) { return texture2DArrayLodNV (s, coord.xyz, coord.w); }\n"));
+	lib.esExtensions.insert (std::make_pair(EOpTex2DArrayLod, std::make_pair("GL_NV_texture_array","GL_NV_texture_array")));
+
+	lib.code.insert(CodeMap::value_type(EOpTex2DArrayBias, "vec4 @LL@tex2DArrayBias(sampler2DArray s, vec4 coord) { return texture2DArray (s, coord.xyz, coord.w); }\n"));
+	lib.extensions.insert (std::make_pair(EOpTex2DArrayBias, std::make_pair("GL_EXT_texture_array","GL_EXT_texture_array")));
+	lib.esCode.insert(CodeMap::value_type(EOpTex2DArrayBias, "vec4 @LL@tex2DArrayBias(sampler2DArrayNV s, vec4 coord) { return texture2DArrayNV (s, coord.xyz, coord.w); }\n"));
+	lib.esExtensions.insert (std::make_pair(EOpTex2DArrayBias, std::make_pair("GL_NV_texture_array","GL_NV_texture_array")));
 }
 
-void insertPost120TextureLookups()
+static void insertPost120TextureLookups(TSupportLibBuilder& lib)
 {
-    hlslSupportLib->insert( CodeMap::value_type( EOpTex1DBias,
+    lib.code.insert( CodeMap::value_type( EOpTex1DBias,
         "vec4 @LL@tex1Dbias(sampler1D s, vec4 coord) {\n"
         "  return texture( s, coord.x, coord.w);\n"
         "}\n\n" )
         );
 
-    hlslSupportLib->insert( CodeMap::value_type( EOpTex1DLod,
+    lib.code.insert( CodeMap::value_type( EOpTex1DLod,
         "vec4 @LL@tex1Dlod(sampler1D s, vec4 coord) {\n"
         "  return textureLod( s, coord.x, coord.w);\n"
         "}\n\n" )
         );
-    hlslSupportLibExtensions->insert (std::make_pair(EOpTex1DLod, std::make_pair("","GL_ARB_shader_texture_lod")));
+    lib.extensions.insert (std::make_pair(EOpTex1DLod, std::make_pair("","GL_ARB_shader_texture_lod")));
 
 
-    hlslSupportLib->insert( CodeMap::value_type( EOpTex2DBias,
+    lib.code.insert( CodeMap::value_type( EOpTex2DBias,
         "vec4 @LL@tex2Dbias(sampler2D s, vec4 coord) {\n"
         "  return texture( s, coord.xy, coord.w);\n"
         "}\n\n" )
         );
 
-    hlslSupportLib->insert( CodeMap::value_type( EOpTex2DLod,
+    lib.code.insert( CodeMap::value_type( EOpTex2DLod,
         "vec4 @LL@tex2Dlod(sampler2D s, vec4 coord) {\n"
         "   return textureLod( s, coord.xy, coord.w);\n"
         "}\n\n" )
         );
-    //hlslSupportLibExtensions->insert (std::make_pair(EOpTex2DLod, std::make_pair("","GL_ARB_shader_texture_lod")));
+    //lib.extensions.insert (std::make_pair(EOpTex2DLod, std::make_pair("","GL_ARB_shader_texture_lod")));
 
-    hlslSupportLibESOverrides->insert( CodeMap::value_type( EOpTex2DLod,
+    lib.esCode.insert( CodeMap::value_type( EOpTex2DLod,
         "vec4 @LL@tex2Dlod(sampler2D s, vec4 coord) {\n"
         "   return textureLod( s, coord.xy, coord.w);\n"
         "}\n\n" )
         );
-    //hlslSupportLibExtensionsESOverrides->insert (std::make_pair(EOpTex2DLod, std::make_pair("","GL_EXT_shader_texture_lod")));
-    hlslSupportLibExtensions->insert (std::make_pair(EOpTex1DLod, std::make_pair("","GL_ARB_shader_texture_lod")));
+    //lib.esExtensions.insert (std::make_pair(EOpTex2DLod, std::make_pair("","GL_EXT_shader_texture_lod")));
+    lib.extensions.insert (std::make_pair(EOpTex1DLod, std::make_pair("","GL_ARB_shader_texture_lod")));
 
-    hlslSupportLib->insert( CodeMap::value_type( EOpTex1DGrad,
+    lib.code.insert( CodeMap::value_type( EOpTex1DGrad,
         "vec4 @LL@tex1Dgrad(sampler1D s, float coord, float ddx, float ddy) {\n"
         "   return textureGrad( s, coord, ddx, ddy);\n"
         "}\n\n" )
         );
-    //hlslSupportLibExtensions->insert (std::make_pair(EOpTex1DGrad, std::make_pair("GL_ARB_shader_texture_lod","GL_ARB_shader_texture_lod")));
+    //lib.extensions.insert (std::make_pair(EOpTex1DGrad, std::make_pair("GL_ARB_shader_texture_lod","GL_ARB_shader_texture_lod")));
 
-    hlslSupportLib->insert( CodeMap::value_type( EOpTex2DBias,
+    lib.code.insert( CodeMap::value_type( EOpTex2DBias,
         "vec4 @LL@tex2Dbias(sampler2D s, vec4 coord) {\n"
         "  return texture( s, coord.xy, coord.w);\n"
         "}\n\n" )
         );
 
-    hlslSupportLib->insert( CodeMap::value_type( EOpTex2DGrad,
+    lib.code.insert( CodeMap::value_type( EOpTex2DGrad,
         "vec4 @LL@tex2Dgrad(sampler2D s, vec2 coord, vec2 ddx, vec2 ddy) {\n"
         "   return textureGrad( s, coord, ddx, ddy);\n"
         "}\n\n" )
         );
-    hlslSupportLib->insert( CodeMap::value_type( EOpTex2DLod,
+    lib.code.insert( CodeMap::value_type( EOpTex2DLod,
         "vec4 @LL@tex2Dlod(sampler2D s, vec4 coord) {\n"
         "   return textureLod( s, coord.xy, coord.w);\n"
         "}\n\n" )
         );
-    //hlslSupportLibExtensions->insert (std::make_pair(EOpTex2DGrad, std::make_pair("GL_ARB_shader_texture_lod","GL_ARB_shader_texture_lod")));
-    //hlslSupportLibExtensions->insert (std::make_pair(EOpTex2DLod, std::make_pair("","GL_ARB_shader_texture_lod")));
+    //lib.extensions.insert (std::make_pair(EOpTex2DGrad, std::make_pair("GL_ARB_shader_texture_lod","GL_ARB_shader_texture_lod")));
+    //lib.extensions.insert (std::make_pair(EOpTex2DLod, std::make_pair("","GL_ARB_shader_texture_lod")));
 
-    //hlslSupportLibExtensionsESOverrides->insert (std::make_pair(EOpTex2DGrad, std::make_pair("GL_EXT_shader_texture_lod","GL_EXT_shader_texture_lod")));
-    //hlslSupportLibExtensionsESOverrides->insert (std::make_pair(EOpTex2DLod, std::make_pair("","GL_EXT_shader_texture_lod")));
+    //lib.esExtensions.insert (std::make_pair(EOpTex2DGrad, std::make_pair("GL_EXT_shader_texture_lod","GL_EXT_shader_texture_lod")));
+    //lib.esExtensions.insert (std::make_pair(EOpTex2DLod, std::make_pair("","GL_EXT_shader_texture_lod")));
 
 
-    hlslSupportLib->insert( CodeMap::value_type( EOpTex3DBias,
+    lib.code.insert( CodeMap::value_type( EOpTex3DBias,
         "vec4 @LL@tex3Dbias(sampler3D s, vec4 coord) {\n"
         "  return texture( s, coord.xyz, coord.w);\n"
         "}\n\n" )
         );
-    hlslSupportLib->insert( CodeMap::value_type( EOpTex2DGrad,
+    lib.code.insert( CodeMap::value_type( EOpTex2DGrad,
         "vec4 @LL@tex2Dgrad(sampler2D s, vec2 coord, vec2 ddx, vec2 ddy) {\n"
         "   return textureGrad( s, coord, ddx, ddy);\n"
         "}\n\n" )
         );
-    //hlslSupportLibExtensions->insert (std::make_pair(EOpTex2DGrad, std::make_pair("GL_ARB_shader_texture_lod","GL_ARB_shader_texture_lod")));
+    //lib.extensions.insert (std::make_pair(EOpTex2DGrad, std::make_pair("GL_ARB_shader_texture_lod","GL_ARB_shader_texture_lod")));
 
-    hlslSupportLib->insert( CodeMap::value_type( EOpTex3DLod,
+    lib.code.insert( CodeMap::value_type( EOpTex3DLod,
         "vec4 @LL@tex3Dlod(sampler3D s, vec4 coord) {\n"
         "  return textureLod( s, coord.xyz, coord.w);\n"
         "}\n\n" )
         );
-    hlslSupportLibESOverrides->insert( CodeMap::value_type( EOpTex2DGrad,
+    lib.esCode.insert( CodeMap::value_type( EOpTex2DGrad,
         "vec4 @LL@tex2Dgrad(sampler2D s, vec2 coord, vec2 ddx, vec2 ddy) {\n"
         "   return textureGrad( s, coord, ddx, ddy);\n"
         "}\n\n" )
         );
-    //hlslSupportLibExtensions->insert (std::make_pair(EOpTex3DLod, std::make_pair("","GL_ARB_shader_texture_lod")));
-    //hlslSupportLibExtensionsESOverrides->insert (std::make_pair(EOpTex2DGrad, std::make_pair("GL_EXT_shader_texture_lod","GL_EXT_shader_texture_lod")));
+    //lib.extensions.insert (std::make_pair(EOpTex3DLod, std::make_pair("","GL_ARB_shader_texture_lod")));
+    //lib.esExtensions.insert (std::make_pair(EOpTex2DGrad, std::make_pair("GL_EXT_shader_texture_lod","GL_EXT_shader_texture_lod")));
 
-    hlslSupportLib->insert( CodeMap::value_type( EOpTex3DGrad,
+    lib.code.insert( CodeMap::value_type( EOpTex3DGrad,
         "vec4 @LL@tex3Dgrad(sampler3D s, vec3 coord, vec3 ddx, vec3 ddy) {\n"
         "  return textureGrad( s, coord, ddx, ddy);\n"
         "}\n\n" )
         );
-    //hlslSupportLibExtensions->insert (std::make_pair(EOpTex3DGrad, std::make_pair("GL_ARB_shader_texture_lod","GL_ARB_shader_texture_lod")));
+    //lib.extensions.insert (std::make_pair(EOpTex3DGrad, std::make_pair("GL_ARB_shader_texture_lod","GL_ARB_shader_texture_lod")));
 
-    hlslSupportLib->insert( CodeMap::value_type( EOpTex3DBias,
+    lib.code.insert( CodeMap::value_type( EOpTex3DBias,
         "vec4 @LL@tex3Dbias(sampler3D s, vec4 coord) {\n"
         "  return texture( s, coord.xyz, coord.w);\n"
         "}\n\n" )
         );
 
-    hlslSupportLib->insert( CodeMap::value_type( EOpTexCubeBias,
+    lib.code.insert( CodeMap::value_type( EOpTexCubeBias,
         "vec4 @LL@texCUBEbias(samplerCube s, vec4 coord) {\n"
         "  return texture( s, coord.xyz, coord.w);\n"
         "}\n\n" )
         );
-    hlslSupportLib->insert( CodeMap::value_type( EOpTex3DLod,
+    lib.code.insert( CodeMap::value_type( EOpTex3DLod,
         "vec4 @LL@tex3Dlod(sampler3D s, vec4 coord) {\n"
         "  return textureLod( s, coord.xyz, coord.w);\n"
         "}\n\n" )
         );
 
-    hlslSupportLib->insert( CodeMap::value_type( EOpTexCubeLod,
+    lib.code.insert( CodeMap::value_type( EOpTexCubeLod,
         "vec4 @LL@texCUBElod(samplerCube s, vec4 coord) {\n"
         "  return textureLod( s, coord.xyz, coord.w);\n"
         "}\n\n" )
         );
-    //hlslSupportLibExtensions->insert (std::make_pair(EOpTexCubeLod, std::make_pair("","GL_ARB_shader_texture_lod")));
+    //lib.extensions.insert (std::make_pair(EOpTexCubeLod, std::make_pair("","GL_ARB_shader_texture_lod")));
 
-    hlslSupportLib->insert( CodeMap::value_type( EOpTexCubeGrad,
+    lib.code.insert( CodeMap::value_type( EOpTexCubeGrad,
         "vec4 @LL@texCUBEgrad(samplerCube s, vec3 coord, vec3 ddx, vec3 ddy) {\n"
         "  return textureGrad( s, coord, ddx, ddy);\n"
         "}\n\n" )
         );
-    //hlslSupportLibExtensions->insert (std::make_pair(EOpTexCubeGrad, std::make_pair("GL_ARB_shader_texture_lod","GL_ARB_shader_texture_lod")));
-    //hlslSupportLibExtensions->insert (std::make_pair(EOpTex3DLod, std::make_pair("","GL_ARB_shader_texture_lod")));
+    //lib.extensions.insert (std::make_pair(EOpTexCubeGrad, std::make_pair("GL_ARB_shader_texture_lod","GL_ARB_shader_texture_lod")));
+    //lib.extensions.insert (std::make_pair(EOpTex3DLod, std::make_pair("","GL_ARB_shader_texture_lod")));
 
-    hlslSupportLib->insert( CodeMap::value_type( EOpTex3DGrad,
+    lib.code.insert( CodeMap::value_type( EOpTex3DGrad,
         "vec4 @LL@tex3Dgrad(sampler3D s, vec3 coord, vec3 ddx, vec3 ddy) {\n"
         "  return textureGrad( s, coord, ddx, ddy);\n"
         "}\n\n" )
         );
-    //hlslSupportLibExtensions->insert (std::make_pair(EOpTex3DGrad, std::make_pair("GL_ARB_shader_texture_lod","GL_ARB_shader_texture_lod")));
+    //lib.extensions.insert (std::make_pair(EOpTex3DGrad, std::make_pair("GL_ARB_shader_texture_lod","GL_ARB_shader_texture_lod")));
 
-    hlslSupportLib->insert( CodeMap::value_type( EOpTexCubeBias,
+    lib.code.insert( CodeMap::value_type( EOpTexCubeBias,
         "vec4 @LL@texCUBEbias(samplerCube s, vec4 coord) {\n"
         "  return texture( s, coord.xyz, coord.w);\n"
         "}\n\n" )
         );
 
     // shadow2D / shadow2Dproj
-    hlslSupportLib->insert(CodeMap::value_type(EOpShadow2D,
+    lib.code.insert(CodeMap::value_type(EOpShadow2D,
         "float @LL@shadow2D(sampler2DShadow s, vec3 coord) { return texture (s, coord); }\n"
         ));
-    hlslSupportLibESOverrides->insert(CodeMap::value_type(EOpShadow2D,
+    lib.esCode.insert(CodeMap::value_type(EOpShadow2D,
         "float @LL@shadow2D(mediump sampler2DShadow s, vec3 coord) { return texture (s, coord); }\n"
         ));
-    //hlslSupportLibExtensionsESOverrides->insert (std::make_pair(EOpShadow2D, std::make_pair("","GL_EXT_shadow_samplers")));
+    //lib.esExtensions.insert (std::make_pair(EOpShadow2D, std::make_pair("","GL_EXT_shadow_samplers")));
 
-    hlslSupportLib->insert(CodeMap::value_type(EOpShadow2DProj,
+    lib.code.insert(CodeMap::value_type(EOpShadow2DProj,
         "float @LL@shadow2Dproj(sampler2DShadow s, vec4 coord) { return textureProj (s, coord); }\n"
         ));
-    hlslSupportLibESOverrides->insert(CodeMap::value_type(EOpShadow2DProj,
+    lib.esCode.insert(CodeMap::value_type(EOpShadow2DProj,
         "float @LL@shadow2Dproj(mediump sampler2DShadow s, vec4 coord) { return textureProj (s, coord); }\n"
         ));
-    //hlslSupportLibExtensionsESOverrides->insert (std::make_pair(EOpShadow2DProj, std::make_pair("","GL_EXT_shadow_samplers")));
+    //lib.esExtensions.insert (std::make_pair(EOpShadow2DProj, std::make_pair("","GL_EXT_shadow_samplers")));
 
 	// texture arrays
-	hlslSupportLib->insert(CodeMap::value_type(EOpTex2DArray, "vec4 @LL@tex2DArray(sampler2DArray s, vec3 coord) { return texture (s, coord); }\n"));
-	hlslSupportLib->insert(CodeMap::value_type(EOpTex2DArrayLod, "vec4 @LL@tex2DArrayLod(sampler2DArray s, vec4 coord) { return textureLod (s, coord.xyz, coord.w); }\n"));
-	hlslSupportLib->insert(CodeMap::value_type(EOpTex2DArrayBias, "vec4 @LL@tex2DArrayBias(sampler2DArray s, vec4 coord) { return texture (s, coord.xyz, coord.w); }\n"));
+	lib.code.insert(CodeMap::value_type(EOpTex2DArray, "vec4 @LL@tex2DArray(sampler2DArray s, vec3 coord) { return texture (s, coord); }\n"));
+	lib.code.insert(CodeMap::value_type(EOpTex2DArrayLod, "vec4 @LL@tex2DArrayLod(sampler2DArray s, vec4 coord) { return textureLod (s, coord.xyz, coord.w); }\n"));
+	lib.code.insert(CodeMap::value_type(EOpTex2DArrayBias, "vec4 @LL@tex2DArrayBias(sampler2DArray s, vec4 coord) { return texture (s, coord.xyz, coord.w); }\n"));
 }
 
 
-void initializeHLSLSupportLibrary(ETargetVersion targetVersion)
+static void buildHLSLSupportLibrary(TSupportLibBuilder& lib, ETargetVersion targetVersion)
 {
-	assert(!hlslSupportLib);
-	assert(!hlslSupportLibExtensions);
-	assert(!hlslSupportLibESOverrides);
-	assert(!hlslSupportLibExtensionsESOverrides);
-
-	// Initialize thread-local storage if needed
-	if (hlslSupportLib) {
-		// Support library already initialized for this thread
-		return;
-	}
-
-	hlslSupportLib = std::make_unique<CodeMap>();
-	hlslSupportLibExtensions = std::make_unique<CodeExtensionMap>();
-	hlslSupportLibESOverrides = std::make_unique<CodeMap>();
-	hlslSupportLibExtensionsESOverrides = std::make_unique<CodeExtensionMap>();
-
     //ACS: some texture lookup types were deprecated after 1.20, and 1.40 won't accept them
     bool usePost120TextureLookups = false;
     if(targetVersion!=ETargetVersionCount) //default
@@ -361,9 +351,9 @@ void initializeHLSLSupportLibrary(ETargetVersion targetVersion)
 
    // Initialize GLSL code for the op codes that require support helper functions
 
-   hlslSupportLib->insert( CodeMap::value_type( EOpNull, ""));
+   lib.code.insert( CodeMap::value_type( EOpNull, ""));
 
-   hlslSupportLib->insert( CodeMap::value_type( EOpAbs,
+   lib.code.insert( CodeMap::value_type( EOpAbs,
       "mat2 @LL@abs_mf2x2(mat2 m) {\n"
       "  return mat2( abs(m[0]), abs(m[1]));\n"
       "}\n\n"
@@ -375,7 +365,7 @@ void initializeHLSLSupportLibrary(ETargetVersion targetVersion)
       "}\n\n")
       );
 
-   hlslSupportLib->insert( CodeMap::value_type( EOpAcos,
+   lib.code.insert( CodeMap::value_type( EOpAcos,
       "mat2 @LL@acos_mf2x2(mat2 m) {\n"
       "  return mat2( acos(m[0]), acos(m[1]));\n"
       "}\n\n"
@@ -387,7 +377,7 @@ void initializeHLSLSupportLibrary(ETargetVersion targetVersion)
       "}\n\n")
       );
 
-   hlslSupportLib->insert( CodeMap::value_type( EOpCos,
+   lib.code.insert( CodeMap::value_type( EOpCos,
       "mat2 @LL@cos_mf2x2(mat2 m) {\n"
       "  return mat2( cos(m[0]), cos(m[1]));\n"
       "}\n\n"
@@ -399,7 +389,7 @@ void initializeHLSLSupportLibrary(ETargetVersion targetVersion)
       "}\n\n")
       );
 
-   hlslSupportLib->insert( CodeMap::value_type( EOpAsin,
+   lib.code.insert( CodeMap::value_type( EOpAsin,
       "mat2 @LL@asin_mf2x2(mat2 m) {\n"
       "  return mat2( asin(m[0]), asin(m[1]));\n"
       "}\n\n"
@@ -411,7 +401,7 @@ void initializeHLSLSupportLibrary(ETargetVersion targetVersion)
       "}\n\n")
       );
 
-   hlslSupportLib->insert( CodeMap::value_type( EOpSin,
+   lib.code.insert( CodeMap::value_type( EOpSin,
       "mat2 @LL@sin_mf2x2(mat2 m) {\n"
       "  return mat2( sin(m[0]), sin(m[1]));\n"
       "}\n\n"
@@ -423,7 +413,7 @@ void initializeHLSLSupportLibrary(ETargetVersion targetVersion)
       "}\n\n")
       );
 
-   hlslSupportLib->insert( CodeMap::value_type( EOpDPdx,
+   lib.code.insert( CodeMap::value_type( EOpDPdx,
 	  "float @LL@dFdx_f(float f) {\n"
 	  "  return dFdx(f);\n"
 	  "}\n\n"
@@ -448,9 +438,9 @@ void initializeHLSLSupportLibrary(ETargetVersion targetVersion)
       );
 
 	if (targetVersion < ETargetGLSL_ES_300)
-	hlslSupportLibExtensionsESOverrides->insert (std::make_pair(EOpDPdx, std::make_pair("","GL_OES_standard_derivatives")));
+	lib.esExtensions.insert (std::make_pair(EOpDPdx, std::make_pair("","GL_OES_standard_derivatives")));
 
-   hlslSupportLib->insert( CodeMap::value_type( EOpDPdy,
+   lib.code.insert( CodeMap::value_type( EOpDPdy,
 	  "float @LL@dFdy_f(float f) {\n"
 	  "  return dFdy(f);\n"
 	  "}\n\n"
@@ -475,9 +465,9 @@ void initializeHLSLSupportLibrary(ETargetVersion targetVersion)
       );
 
 	if (targetVersion < ETargetGLSL_ES_300)
-	hlslSupportLibExtensionsESOverrides->insert (std::make_pair(EOpDPdy, std::make_pair("","GL_OES_standard_derivatives")));
+	lib.esExtensions.insert (std::make_pair(EOpDPdy, std::make_pair("","GL_OES_standard_derivatives")));
 
-   hlslSupportLib->insert( CodeMap::value_type( EOpExp,
+   lib.code.insert( CodeMap::value_type( EOpExp,
       "mat2 @LL@exp_mf2x2(mat2 m) {\n"
       "  return mat2( exp(m[0]), exp(m[1]));\n"
       "}\n\n"
@@ -489,7 +479,7 @@ void initializeHLSLSupportLibrary(ETargetVersion targetVersion)
       "}\n\n")
       );
 
-   hlslSupportLib->insert( CodeMap::value_type( EOpExp2,
+   lib.code.insert( CodeMap::value_type( EOpExp2,
       "mat2 @LL@exp2_mf2x2(mat2 m) {\n"
       "  return mat2( exp2(m[0]), exp2(m[1]));\n"
       "}\n\n"
@@ -501,7 +491,7 @@ void initializeHLSLSupportLibrary(ETargetVersion targetVersion)
       "}\n\n")
       );
 
-   hlslSupportLib->insert( CodeMap::value_type( EOpLog,
+   lib.code.insert( CodeMap::value_type( EOpLog,
       "mat2 @LL@log_mf2x2(mat2 m) {\n"
       "  return mat2( log(m[0]), log(m[1]));\n"
       "}\n\n"
@@ -513,7 +503,7 @@ void initializeHLSLSupportLibrary(ETargetVersion targetVersion)
       "}\n\n")
       );
 
-   hlslSupportLib->insert( CodeMap::value_type( EOpLog2,
+   lib.code.insert( CodeMap::value_type( EOpLog2,
       "mat2 @LL@log2_mf2x2(mat2 m) {\n"
       "  return mat2( log2(m[0]), log2(m[1]));\n"
       "}\n\n"
@@ -525,7 +515,7 @@ void initializeHLSLSupportLibrary(ETargetVersion targetVersion)
       "}\n\n")
       );
 
-   hlslSupportLib->insert( CodeMap::value_type( EOpTan,
+   lib.code.insert( CodeMap::value_type( EOpTan,
       "mat2 @LL@tan_mf2x2(mat2 m) {\n"
       "  return mat2( tan(m[0]), tan(m[1]));\n"
       "}\n\n"
@@ -537,7 +527,7 @@ void initializeHLSLSupportLibrary(ETargetVersion targetVersion)
       "}\n\n")
       );
 
-   hlslSupportLib->insert( CodeMap::value_type( EOpAtan,
+   lib.code.insert( CodeMap::value_type( EOpAtan,
       "mat2 @LL@atan_mf2x2(mat2 m) {\n"
       "  return mat2( atan(m[0]), atan(m[1]));\n"
       "}\n\n"
@@ -549,7 +539,7 @@ void initializeHLSLSupportLibrary(ETargetVersion targetVersion)
       "}\n\n")
       );
 
-   hlslSupportLib->insert( CodeMap::value_type( EOpDegrees,
+   lib.code.insert( CodeMap::value_type( EOpDegrees,
       "mat2 @LL@degrees_mf2x2(mat2 m) {\n"
       "  return mat2( degrees(m[0]), degrees(m[1]));\n"
       "}\n\n"
@@ -561,7 +551,7 @@ void initializeHLSLSupportLibrary(ETargetVersion targetVersion)
       "}\n\n")
       );
 
-    hlslSupportLib->insert( CodeMap::value_type( EOpRadians,
+    lib.code.insert( CodeMap::value_type( EOpRadians,
       "mat2 @LL@radians_mf2x2(mat2 m) {\n"
       "  return mat2( radians(m[0]), radians(m[1]));\n"
       "}\n\n"
@@ -573,7 +563,7 @@ void initializeHLSLSupportLibrary(ETargetVersion targetVersion)
       "}\n\n")
       );
 
-    hlslSupportLib->insert( CodeMap::value_type( EOpSqrt,
+    lib.code.insert( CodeMap::value_type( EOpSqrt,
       "mat2 @LL@sqrt_mf2x2(mat2 m) {\n"
       "  return mat2( sqrt(m[0]), sqrt(m[1]));\n"
       "}\n\n"
@@ -585,7 +575,7 @@ void initializeHLSLSupportLibrary(ETargetVersion targetVersion)
       "}\n\n")
       );
 
-   hlslSupportLib->insert( CodeMap::value_type( EOpInverseSqrt,
+   lib.code.insert( CodeMap::value_type( EOpInverseSqrt,
       "mat2 @LL@inversesqrt_mf2x2(mat2 m) {\n"
       "  return mat2( inversesqrt(m[0]), inversesqrt(m[1]));\n"
       "}\n\n"
@@ -597,7 +587,7 @@ void initializeHLSLSupportLibrary(ETargetVersion targetVersion)
       "}\n\n")
       );
 
-   hlslSupportLib->insert( CodeMap::value_type( EOpFloor,
+   lib.code.insert( CodeMap::value_type( EOpFloor,
       "mat2 @LL@floor_mf2x2(mat2 m) {\n"
       "  return mat2( floor(m[0]), floor(m[1]));\n"
       "}\n\n"
@@ -609,7 +599,7 @@ void initializeHLSLSupportLibrary(ETargetVersion targetVersion)
       "}\n\n")
       );
 
-   hlslSupportLib->insert( CodeMap::value_type( EOpSign,
+   lib.code.insert( CodeMap::value_type( EOpSign,
       "mat2 @LL@sign_mf2x2(mat2 m) {\n"
       "  return mat2( sign(m[0]), sign(m[1]));\n"
       "}\n\n"
@@ -621,7 +611,7 @@ void initializeHLSLSupportLibrary(ETargetVersion targetVersion)
       "}\n\n")
       );
 
-   hlslSupportLib->insert( CodeMap::value_type( EOpCeil,
+   lib.code.insert( CodeMap::value_type( EOpCeil,
       "mat2 @LL@ceil_mf2x2(mat2 m) {\n"
       "  return mat2( ceil(m[0]), ceil(m[1]));\n"
       "}\n\n"
@@ -633,7 +623,7 @@ void initializeHLSLSupportLibrary(ETargetVersion targetVersion)
       "}\n\n")
       );
 
-   hlslSupportLib->insert( CodeMap::value_type( EOpFract,
+   lib.code.insert( CodeMap::value_type( EOpFract,
       "mat2 @LL@fract_mf2x2(mat2 m) {\n"
       "  return mat2( fract(m[0]), fract(m[1]));\n"
       "}\n\n"
@@ -645,7 +635,7 @@ void initializeHLSLSupportLibrary(ETargetVersion targetVersion)
       "}\n\n")
       );
 
-   hlslSupportLib->insert( CodeMap::value_type( EOpFwidth,
+   lib.code.insert( CodeMap::value_type( EOpFwidth,
 	  "float @LL@fwidth_f(float f) {\n"
 	  "  return fwidth(f);\n"
 	  "}\n\n"
@@ -669,9 +659,9 @@ void initializeHLSLSupportLibrary(ETargetVersion targetVersion)
       "}\n\n")
       );
 	if (targetVersion < ETargetGLSL_ES_300)
-    hlslSupportLibExtensionsESOverrides->insert (std::make_pair(EOpFwidth, std::make_pair("","GL_OES_standard_derivatives")));
+    lib.esExtensions.insert (std::make_pair(EOpFwidth, std::make_pair("","GL_OES_standard_derivatives")));
 
-   hlslSupportLib->insert( CodeMap::value_type( EOpFclip,
+   lib.code.insert( CodeMap::value_type( EOpFclip,
 	   "void @LL@clip_f(float x) {\n"
 	   "  if ( x<0.0 ) discard;\n"
 	   "}\n"
@@ -686,7 +676,7 @@ void initializeHLSLSupportLibrary(ETargetVersion targetVersion)
 	   "}\n"
 	));
 
-   hlslSupportLib->insert( CodeMap::value_type( EOpPow,
+   lib.code.insert( CodeMap::value_type( EOpPow,
       "mat2 @LL@pow_mf2x2_mf2x2(mat2 m, mat2 y) {\n"
       "  return mat2( pow(m[0],y[0]), pow(m[1],y[1]));\n"
       "}\n\n"
@@ -698,7 +688,7 @@ void initializeHLSLSupportLibrary(ETargetVersion targetVersion)
       "}\n\n")
       );
 
-   hlslSupportLib->insert( CodeMap::value_type( EOpAtan2,
+   lib.code.insert( CodeMap::value_type( EOpAtan2,
       "mat2 @LL@atan2_mf2x2_mf2x2(mat2 m, mat2 y) {\n"
       "  return mat2( atan(m[0],y[0]), atan(m[1],y[1]));\n"
       "}\n\n"
@@ -710,7 +700,7 @@ void initializeHLSLSupportLibrary(ETargetVersion targetVersion)
       "}\n\n")
       );
 
-   hlslSupportLib->insert( CodeMap::value_type( EOpMin,
+   lib.code.insert( CodeMap::value_type( EOpMin,
       "mat2 @LL@min_mf2x2_mf2x2(mat2 m, mat2 y) {\n"
       "  return mat2( min(m[0],y[0]), min(m[1],y[1]));\n"
       "}\n\n"
@@ -722,7 +712,7 @@ void initializeHLSLSupportLibrary(ETargetVersion targetVersion)
       "}\n\n")
       );
 
-   hlslSupportLib->insert( CodeMap::value_type( EOpMax,
+   lib.code.insert( CodeMap::value_type( EOpMax,
       "mat2 @LL@max_mf2x2_mf2x2(mat2 m, mat2 y) {\n"
       "  return mat2( max(m[0],y[0]), max(m[1],y[1]));\n"
       "}\n\n"
@@ -734,7 +724,7 @@ void initializeHLSLSupportLibrary(ETargetVersion targetVersion)
       "}\n\n")
       );
 
-   hlslSupportLib->insert( CodeMap::value_type( EOpTranspose,
+   lib.code.insert( CodeMap::value_type( EOpTranspose,
         "mat2 @LL@transpose_mf2x2(mat2 m) {\n"
         "  return mat2( m[0][0], m[1][0], m[0][1], m[1][1]);\n"
         "}\n\n"
@@ -753,7 +743,7 @@ void initializeHLSLSupportLibrary(ETargetVersion targetVersion)
 
 	// Note: constructing temporary vector and assigning individual components; seems to avoid
 	// some GLSL bugs on AMD (Win7, Radeon HD 58xx, Catalyst 10.5).
-	hlslSupportLib->insert( CodeMap::value_type( EOpMatrixIndex,
+	lib.code.insert( CodeMap::value_type( EOpMatrixIndex,
 		"vec2 @LL@matrixindex_mf2x2_i (mat2 m, int i) { vec2 v; v.x=m[0][i]; v.y=m[1][i]; return v; }\n"
 		"vec3 @LL@matrixindex_mf3x3_i (mat3 m, int i) { vec3 v; v.x=m[0][i]; v.y=m[1][i]; v.z=m[2][i]; return v; }\n"
 		"vec4 @LL@matrixindex_mf4x4_i (mat4 m, int i) { vec4 v; v.x=m[0][i]; v.y=m[1][i]; v.z=m[2][i]; v.w=m[3][i]; return v; }\n")
@@ -763,7 +753,7 @@ void initializeHLSLSupportLibrary(ETargetVersion targetVersion)
 	// (except when the operand is a uniform in vertex shaders). The GLSL specification
 	// leaves it open to vendors to support this or not. So, for NaCl we use if statements to
 	// simulate the indexing.
-	hlslSupportLib->insert( CodeMap::value_type( EOpMatrixIndexDynamic,
+	lib.code.insert( CodeMap::value_type( EOpMatrixIndexDynamic,
 		"#if defined(SHADER_API_GLES) && defined(SHADER_API_DESKTOP)\n"
 		"vec2 @LL@matrixindexdynamic_mf2x2_i (mat2 m, int i) {\n"
 		"	mat2 m2 = @LL@transpose_mf2x2(m);\n"
@@ -786,7 +776,7 @@ void initializeHLSLSupportLibrary(ETargetVersion targetVersion)
 
 
 	// Used in pre-GLSL 1.20
-	hlslSupportLib->insert( CodeMap::value_type( EOpConstructMat2x2FromMat,
+	lib.code.insert( CodeMap::value_type( EOpConstructMat2x2FromMat,
 		"mat2 @LL@constructMat2_mf3x3( mat3 m) {\n"
         "  return mat2( vec2( m[0]), vec2( m[1]));\n"
         "}\n\n"
@@ -794,13 +784,13 @@ void initializeHLSLSupportLibrary(ETargetVersion targetVersion)
         "  return mat2( vec2( m[0]), vec2( m[1]));\n"
         "}\n")
         );
-	hlslSupportLib->insert( CodeMap::value_type( EOpConstructMat3x3FromMat,
+	lib.code.insert( CodeMap::value_type( EOpConstructMat3x3FromMat,
 		"mat3 @LL@constructMat3_mf4x4( mat4 m) {\n"
         "  return mat3( vec3( m[0]), vec3( m[1]), vec3( m[2]));\n"
         "}\n")
         );
 
-   hlslSupportLib->insert( CodeMap::value_type( EOpDeterminant,
+   lib.code.insert( CodeMap::value_type( EOpDeterminant,
         "float @LL@determinant_mf2x2( mat2 m) {\n"
         "    return m[0][0]*m[1][1] - m[0][1]*m[1][0];\n"
         "}\n\n"
@@ -821,7 +811,7 @@ void initializeHLSLSupportLibrary(ETargetVersion targetVersion)
         "}\n")
         );
 
-   hlslSupportLib->insert( CodeMap::value_type( EOpSaturate,
+   lib.code.insert( CodeMap::value_type( EOpSaturate,
         "float @LL@saturate_f( float x) {\n"
         "  return clamp( x, 0.0, 1.0);\n"
         "}\n\n"
@@ -846,7 +836,7 @@ void initializeHLSLSupportLibrary(ETargetVersion targetVersion)
         );
 
 	// \todo [pyry] There is mod() built-in in GLSL
-   hlslSupportLib->insert( CodeMap::value_type( EOpMod,
+   lib.code.insert( CodeMap::value_type( EOpMod,
 	   "float @LL@mod_f_f( float x, float y ) {\n"
 	   "  float d = x / y;\n"
 	   "  float f = fract (abs(d)) * y;\n"
@@ -871,7 +861,7 @@ void initializeHLSLSupportLibrary(ETargetVersion targetVersion)
 	   );
 
 	// \todo [pyry] GLSL ES 3 includes built-in function for this
-   hlslSupportLib->insert( CodeMap::value_type( EOpModf,
+   lib.code.insert( CodeMap::value_type( EOpModf,
         "float @LL@modf_f_i( float x, out int ip) {\n"
 		"  ip = int (x);\n"
 		"  return x-float(ip);\n"
@@ -912,7 +902,7 @@ void initializeHLSLSupportLibrary(ETargetVersion targetVersion)
         );
 
 	// \todo [pyry] Built-in function exists in GLSL ES 3
-	hlslSupportLib->insert (CodeMap::value_type(EOpRound,
+	lib.code.insert (CodeMap::value_type(EOpRound,
 		"float @LL@round_f (float x) { return floor (x+0.5); }\n"
 		"vec2 @LL@round_vf2 (vec2 x) { return floor (x+vec2(0.5)); }\n"
 		"vec3 @LL@round_vf3 (vec3 x) { return floor (x+vec3(0.5)); }\n"
@@ -920,7 +910,7 @@ void initializeHLSLSupportLibrary(ETargetVersion targetVersion)
 	));
 
 	// \todo [pyry] Built-in function exists in GLSL ES 3
-	hlslSupportLib->insert (CodeMap::value_type(EOpTrunc,
+	lib.code.insert (CodeMap::value_type(EOpTrunc,
 		"float @LL@trunc_f (float x) { return x < 0.0 ? -floor(-x) : floor(x); }\n"
 		"vec2 @LL@trunc_vf2 (vec2 v) { return vec2(\n"
 		"  v.x < 0.0 ? -floor(-v.x) : floor(v.x),\n"
@@ -940,7 +930,7 @@ void initializeHLSLSupportLibrary(ETargetVersion targetVersion)
 	));
 
 	// \todo [pyry] Built-in function exists in GLSL ES 3
-   hlslSupportLib->insert( CodeMap::value_type( EOpLdexp,
+   lib.code.insert( CodeMap::value_type( EOpLdexp,
         "float @LL@ldexp_f_f( float x, float expon) {\n"
         "  return x * exp2 ( expon );\n"
         "}\n\n"
@@ -965,7 +955,7 @@ void initializeHLSLSupportLibrary(ETargetVersion targetVersion)
         );
 
 	// \todo [pyry] Built-in function exists in GLSL ES 3
-   hlslSupportLib->insert( CodeMap::value_type( EOpSinCos,
+   lib.code.insert( CodeMap::value_type( EOpSinCos,
         "void @LL@sincos_f_f_f( float x, out float s, out float c) {\n"
         "  s = sin(x); \n"
         "  c = cos(x); \n"
@@ -996,7 +986,7 @@ void initializeHLSLSupportLibrary(ETargetVersion targetVersion)
         "}\n\n" )
         );
 
-   hlslSupportLib->insert( CodeMap::value_type( EOpLog10,
+   lib.code.insert( CodeMap::value_type( EOpLog10,
         "float @LL@log10_f( float x ) {\n"
         "  return log2 ( x ) / 3.32192809; \n"
         "}\n\n"
@@ -1020,7 +1010,7 @@ void initializeHLSLSupportLibrary(ETargetVersion targetVersion)
         "}\n\n")
         );
 
-   hlslSupportLib->insert( CodeMap::value_type( EOpMix,
+   lib.code.insert( CodeMap::value_type( EOpMix,
         "mat2 @LL@mix_mf2x2_mf2x2_mf2x2( mat2 x, mat2 y, mat2 s ) {\n"
         "  return mat2( mix(x[0],y[0],s[0]), mix(x[1],y[1],s[1]) ); \n"
         "}\n\n"
@@ -1032,13 +1022,13 @@ void initializeHLSLSupportLibrary(ETargetVersion targetVersion)
         "}\n\n")
         );
 
-   hlslSupportLib->insert( CodeMap::value_type( EOpLit,
+   lib.code.insert( CodeMap::value_type( EOpLit,
         "vec4 @LL@lit_f_f_f( float n_dot_l, float n_dot_h, float m ) {\n"
         "   return vec4(1, max(0.0, n_dot_l), pow(max(0.0, n_dot_h) * step(0.0, n_dot_l), m), 1.0);\n"
         "}\n\n")
         );
 
-   hlslSupportLib->insert( CodeMap::value_type( EOpSmoothStep,
+   lib.code.insert( CodeMap::value_type( EOpSmoothStep,
         "mat2 @LL@smoothstep_mf2x2_mf2x2_mf2x2( mat2 x, mat2 y, mat2 s ) {\n"
         "  return mat2( smoothstep(x[0],y[0],s[0]), smoothstep(x[1],y[1],s[1]) ); \n"
         "}\n\n"
@@ -1050,7 +1040,7 @@ void initializeHLSLSupportLibrary(ETargetVersion targetVersion)
         "}\n\n")
         );
 
-   hlslSupportLib->insert( CodeMap::value_type( EOpClamp,
+   lib.code.insert( CodeMap::value_type( EOpClamp,
         "mat2 @LL@clamp_mf2x2_mf2x2_mf2x2( mat2 x, mat2 y, mat2 s ) {\n"
         "  return mat2( clamp(x[0],y[0],s[0]), clamp(x[1],y[1],s[1]) ); \n"
         "}\n\n"
@@ -1062,7 +1052,7 @@ void initializeHLSLSupportLibrary(ETargetVersion targetVersion)
         "}\n\n")
         );
 
-   hlslSupportLib->insert( CodeMap::value_type( EOpStep,
+   lib.code.insert( CodeMap::value_type( EOpStep,
       "mat2 @LL@step_mf2x2_mf2x2(mat2 m, mat2 y) {\n"
       "  return mat2( step(m[0],y[0]), step(m[1],y[1]));\n"
       "}\n\n"
@@ -1076,19 +1066,19 @@ void initializeHLSLSupportLibrary(ETargetVersion targetVersion)
 
    //ACS: if we're post-1.20 use the newer, non-deprecated, texture lookups
    if(usePost120TextureLookups) {
-       insertPost120TextureLookups();
+       insertPost120TextureLookups(lib);
    }
    else {
-       insertPre130TextureLookups();
+       insertPre130TextureLookups(lib);
    }
 
-   hlslSupportLib->insert( CodeMap::value_type( EOpD3DCOLORtoUBYTE4,
+   lib.code.insert( CodeMap::value_type( EOpD3DCOLORtoUBYTE4,
         "ivec4 @LL@D3DCOLORtoUBYTE4(vec4 x) {\n"
         "  return ivec4 ( x.zyxw * 255.001953 );\n"
         "}\n\n" )
         );
 
-	hlslSupportLib->insert( CodeMap::value_type( EOpVecTernarySel,
+	lib.code.insert( CodeMap::value_type( EOpVecTernarySel,
 		"vec2 @LL@vecTSel_vb2_vf2_vf2 (bvec2 a, vec2 b, vec2 c) {\n"
 		"  return vec2 (a.x ? b.x : c.x, a.y ? b.y : c.y);\n"
 		"}\n"
@@ -1103,63 +1093,95 @@ void initializeHLSLSupportLibrary(ETargetVersion targetVersion)
 }
 
 
-void finalizeHLSLSupportLibrary()
-{
-	hlslSupportLib.reset();
-	hlslSupportLibExtensions.reset();
-	hlslSupportLibESOverrides.reset();
-	hlslSupportLibExtensionsESOverrides.reset();
-}
 
-std::string getHLSLSupportCode (TOperator op, ExtensionSet& extensions, bool vertexShader, bool gles)
+// Support code and required extensions for one op
+struct TSupportFunction
 {
-	assert (hlslSupportLibExtensions);
-	assert (hlslSupportLibExtensionsESOverrides);
+	TSupportFunction() : hasCode(false), hasExtensions(false) { }
 
-	// if we're using gles, attempt to find the ES version first
-	bool found = false;
-	if (gles)
+	bool hasCode;
+	bool hasExtensions;
+	std::string code;
+	std::string vertexExtension;
+	std::string fragmentExtension;
+};
+
+// Immutable support library for one target, indexed by TOperator
+class TSupportLibrary
+{
+public:
+	explicit TSupportLibrary(ETargetVersion targetVersion)
 	{
-		CodeExtensionMap::iterator eit = hlslSupportLibExtensionsESOverrides->find(op);
-		if (eit != hlslSupportLibExtensionsESOverrides->end())
-		{
-			const std::string& ext = vertexShader ? eit->second.first : eit->second.second;
-			if (!ext.empty())
-				extensions.insert(ext);
-			found = true;
-		}
+		TSupportLibBuilder lib;
+		buildHLSLSupportLibrary(lib, targetVersion);
+		assert(lib.code.count(EOpNull));
+
+		fill(functions, lib.code, lib.extensions);
+		fill(esOverrides, lib.esCode, lib.esExtensions);
 	}
 
-	if (!found)
+	TSupportFunction functions[EOpCount];
+	TSupportFunction esOverrides[EOpCount];
+
+private:
+	static void fill(TSupportFunction* table, const CodeMap& code, const CodeExtensionMap& extensions)
 	{
-		CodeExtensionMap::iterator eit = hlslSupportLibExtensions->find(op);
-		if (eit != hlslSupportLibExtensions->end())
+		for (CodeMap::const_iterator it = code.begin(); it != code.end(); ++it)
 		{
-			const std::string& ext = vertexShader ? eit->second.first : eit->second.second;
-			if (!ext.empty())
-				extensions.insert(ext);
+			table[it->first].hasCode = true;
+			table[it->first].code = it->second;
+		}
+		for (CodeExtensionMap::const_iterator it = extensions.begin(); it != extensions.end(); ++it)
+		{
+			table[it->first].hasExtensions = true;
+			table[it->first].vertexExtension = it->second.first;
+			table[it->first].fragmentExtension = it->second.second;
 		}
 	}
+};
+
+
+// Each target's library is built on first use and then shared by all threads.
+// ETargetVersionCount selects the default library.
+static const TSupportLibrary& getHLSLSupportLibrary(ETargetVersion targetVersion)
+{
+	static std::once_flag built[ETargetVersionCount + 1];
+	static std::unique_ptr<const TSupportLibrary> libraries[ETargetVersionCount + 1];
+
+	assert(targetVersion >= 0 && targetVersion <= ETargetVersionCount);
+	std::call_once(built[targetVersion], [targetVersion]() {
+		libraries[targetVersion].reset(new TSupportLibrary(targetVersion));
+	});
+	return *libraries[targetVersion];
+}
+
 
-	assert (hlslSupportLib);
-	assert (hlslSupportLibESOverrides);
+const std::string& getHLSLSupportCode (TOperator op, ExtensionSet& extensions, bool vertexShader, bool gles, ETargetVersion targetVersion)
+{
+	const TSupportLibrary& lib = getHLSLSupportLibrary(targetVersion);
+
+	// if we're using gles, attempt to find the ES version first
+	const TSupportFunction* ext = &lib.functions[op];
+	if (gles && lib.esOverrides[op].hasExtensions)
+		ext = &lib.esOverrides[op];
+
+	if (ext->hasExtensions)
+	{
+		const std::string& name = vertexShader ? ext->vertexExtension : ext->fragmentExtension;
+		if (!name.empty())
+			extensions.insert(name);
+	}
 
 	// same as above, search for a gles version first
 	bool tex2DLodVSHack = false;
 	if (vertexShader && op == EOpTex2DLod)
 		tex2DLodVSHack = true;
-	if (gles && !tex2DLodVSHack)
-	{
-		CodeMap::iterator it = hlslSupportLibESOverrides->find(op);
-		if (it != hlslSupportLibESOverrides->end())
-			return it->second;
-	}
-
-	CodeMap::iterator it = hlslSupportLib->find(op);
-	if (it == hlslSupportLib->end())
-		it = hlslSupportLib->find(EOpNull); // this always exists
+	if (gles && !tex2DLodVSHack && lib.esOverrides[op].hasCode)
+		return lib.esOverrides[op].code;
 
-	return it->second;
+	if (lib.functions[op].hasCode)
+		return lib.functions[op].code;
+	return lib.functions[EOpNull].code; // this always exists
 }
 
 } // namespace glslang
@@ -14,12 +14,11 @@
 namespace hlsl2glsl
 {
 
-void initializeHLSLSupportLibrary(ETargetVersion targetVersion);
-void finalizeHLSLSupportLibrary();
-
 typedef std::set<std::string> ExtensionSet;
 
-std::string getHLSLSupportCode (TOperator op, ExtensionSet& extensions, bool vertexShader, bool gles);
+/// Support code for op on the given target, empty if none is needed. The support library
+/// is immutable once built, so this can be called from any thread.
+const std::string& getHLSLSupportCode (TOperator op, ExtensionSet& extensions, bool vertexShader, bool gles, ETargetVersion targetVersion);
 
 } // namespace hlsl2glsl
 
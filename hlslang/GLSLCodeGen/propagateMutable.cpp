@@ -3,28 +3,25 @@
 // found in the LICENSE.txt file.
 
 #include "propagateMutable.h"
-#include <set>
+#include <vector>
 #include "localintermediate.h"
 
 namespace hlsl2glsl
 {
 
+// Collects all the symbols in the tree, and which symbol ids are used as mutable uniforms
+// anywhere, so the qualifiers can be fixed up afterwards without traversing again.
 struct TPropagateMutable : public TIntermTraverser 
 {
 	static void traverseSymbol(TIntermSymbol*, TIntermTraverser*);
 	
 	TInfoSink& infoSink;
 	
-	bool abort;
+	std::vector<TIntermSymbol*> symbols;
+	std::vector<bool> mutableIds; // indexed by symbol id
 	
-	// These are used to go into "propagating mode"
-	bool propagating;
-	int id;
 	
-	std::set<int> fixedIds; // to prevent infinite loops
-	
-	
-	TPropagateMutable(TInfoSink &is) : infoSink(is), abort(false), propagating(false), id(0)
+	TPropagateMutable(TInfoSink &is) : infoSink(is)
 	{
 		visitSymbol = traverseSymbol;
 	}
@@ -36,21 +33,15 @@ void TPropagateMutable::traverseSymbol( TIntermSymbol *node, TIntermTraverser *i
 {
 	TPropagateMutable* sit = static_cast<TPropagateMutable*>(it);
 
-	if (sit->abort)
-		return;
+	const int id = node->getId();
+	assert(id >= 0);
 
-	if (sit->propagating && sit->id == node->getId())
-	{
-		node->getTypePointer()->changeQualifier( EvqMutableUniform );
-	}
-	else if (!sit->propagating && sit->fixedIds.find(node->getId()) == sit->fixedIds.end())
+	sit->symbols.push_back(node);
+	if (node->getQualifier() == EvqMutableUniform)
 	{
-		if (node->getQualifier() == EvqMutableUniform)
-		{
-			sit->abort = true;
-			sit->id = node->getId();
-			sit->fixedIds.insert(sit->id);
-		}
+		if (id >= (int)sit->mutableIds.size())
+			sit->mutableIds.resize(id + 1, false);
+		sit->mutableIds[id] = true;
 	}
 }
 
@@ -58,21 +49,16 @@ void PropagateMutableUniforms (TIntermNode* root, TInfoSink &info)
 {
 	TPropagateMutable st(info);
 
-	do
-	{
-		st.abort = false;
-		root->traverse(&st);
+	root->traverse(&st);
 
-		// If we aborted, try to type the node we aborted for
-		if (st.abort)
-		{
-			st.propagating = true;
-			st.abort = false;
-			root->traverse(&st);
-			st.propagating = false;
-			st.abort = true;
-		}
-	} while (st.abort);
+	// Every use of a symbol that is mutable somewhere becomes mutable
+	const int idCount = (int)st.mutableIds.size();
+	for (std::vector<TIntermSymbol*>::iterator it = st.symbols.begin(); it != st.symbols.end(); ++it)
+	{
+		const int id = (*it)->getId();
+		if (id < idCount && st.mutableIds[id])
+			(*it)->getTypePointer()->changeQualifier( EvqMutableUniform );
+	}
 }
 
 } // namespace hlsl2glsl
@@ -7,468 +7,334 @@
 #include "localintermediate.h"
 #include "glslOutput.h"
 
+#include <functional>
+#include <queue>
+
 namespace hlsl2glsl
 {
 
-struct TSamplerTraverser : public TIntermTraverser 
+// A place in the tree that can give a type to a generic sampler: either a texture
+// lookup (sampType is the sampler type the lookup needs), or one argument of a call
+// to a user function (sampType is EbtSamplerGeneric, the type comes from the callee's
+// parameter).
+struct TSamplerRule
 {
-	static void traverseSymbol(TIntermSymbol*, TIntermTraverser*);
-	static void traverseParameterSymbol(TIntermSymbol *node, TIntermTraverser *it);
-	static bool traverseBinary(bool preVisit, TIntermBinary*, TIntermTraverser*);
-	static bool traverseUnary(bool preVisit, TIntermUnary*, TIntermTraverser*);
-	static bool traverseSelection(bool preVisit, TIntermSelection*, TIntermTraverser*);
-	static bool traverseAggregate(bool preVisit, TIntermAggregate*, TIntermTraverser*);
-	static bool traverseLoop(bool preVisit, TIntermLoop*, TIntermTraverser*);
-	static bool traverseBranch(bool preVisit, TIntermBranch*,  TIntermTraverser*);
-	
-	/// Set the type for the sampler
-	void typeSampler( TIntermTyped *node, TBasicType samp);
-	
-	TInfoSink& infoSink;
-	
-	bool abort;
-	
-	// These are used to go into "typing mode"
-	bool typing;
-	int id;
+	TIntermAggregate* node;
 	TBasicType sampType;
-	
-	std::map<std::string,TNodeArray* > functionMap;
-	
-	std::string currentFunction;
-	
-	TSamplerTraverser(TInfoSink &is) : infoSink(is), abort(false), typing(false), id(0), sampType(EbtSamplerGeneric) 
-	{
-		visitSymbol = traverseSymbol;
-		//visitConstant = traverseConstant;
-		visitBinary = traverseBinary;
-		visitUnary = traverseUnary;
-		visitSelection = traverseSelection;
-		visitAggregate = traverseAggregate;
-		visitLoop = traverseLoop;
-		visitBranch = traverseBranch;
-	}
+	int arg;
 };
 
+typedef std::vector<TIntermSymbol*> TSymbolUses;
 
 
-void TSamplerTraverser::traverseSymbol( TIntermSymbol *node, TIntermTraverser *it )
+// Single traversal that indexes everything sampler typing needs:
+//  * every use of a generic sampler symbol, by symbol id
+//  * texture lookups and user function call arguments, in traversal order
+//  * parameters of each function definition (functionMap), and call sites per function
+struct TSamplerTraverser : public TIntermTraverser
 {
-   TSamplerTraverser* sit = static_cast<TSamplerTraverser*>(it);
+	static void traverseSymbol(TIntermSymbol*, TIntermTraverser*);
+	static bool traverseAggregate(bool preVisit, TIntermAggregate*, TIntermTraverser*);
 
-   if (sit->abort)
-      return;
+	/// Set the type for the sampler
+	void typeSampler( TIntermTyped *node, TBasicType samp);
 
-   if (sit->typing && sit->id == node->getId())
-   {
-      TType* type = node->getTypePointer();
-      // Technically most of these should never happen
-	  type->setBasicType (sit->sampType);
-   }
-}
+	/// Type every use of the sampler symbol, and queue up the calls that can now be typed through it
+	void typeSymbol( int id, TBasicType samp);
 
+	void propagate();
+	void reportErrors();
 
-bool TSamplerTraverser::traverseBinary( bool preVisit, TIntermBinary *node, TIntermTraverser *it )
-{
-   TSamplerTraverser* sit = static_cast<TSamplerTraverser*>(it);
+	TInfoSink& infoSink;
 
-   if (sit->abort)
-      return false;
+	std::map<int, TSymbolUses> symbolUses;
+	std::vector<TSamplerRule> rules;
 
-   switch (node->getOp())
-   {
-   case EOpAssign:
-      //believed to be disallowed on samplers...
-      break;
+	std::map<std::string,TNodeArray* > functionMap;
+	std::map<int, std::vector<int> > paramCalls; // parameter id -> call rules passing an argument to it
 
-   case EOpIndexDirect:
-   case EOpIndexIndirect:
-      //not planning to support arrays of samplers with different types 
-      break;
+	std::string currentFunction;
 
-   case EOpIndexDirectStruct:
-      //Structs in samplers not supported
-      break;
+	// rules that might apply, smallest traversal order first
+	std::priority_queue<int, std::vector<int>, std::greater<int> > pending;
 
-   default:
-      break;
-   }
+	TSamplerTraverser(TInfoSink &is) : infoSink(is)
+	{
+		visitSymbol = traverseSymbol;
+		visitAggregate = traverseAggregate;
+	}
+};
 
-   return !(sit->abort);
-}
 
 
-bool TSamplerTraverser::traverseUnary( bool preVisit, TIntermUnary *node, TIntermTraverser *it)
+void TSamplerTraverser::traverseSymbol( TIntermSymbol *node, TIntermTraverser *it )
 {
-   TSamplerTraverser* sit = static_cast<TSamplerTraverser*>(it);
+	TSamplerTraverser* sit = static_cast<TSamplerTraverser*>(it);
 
-   return !(sit->abort);
+	if (node->getBasicType() == EbtSamplerGeneric)
+		sit->symbolUses[node->getId()].push_back(node);
 }
 
 
-bool TSamplerTraverser::traverseSelection( bool preVisit, TIntermSelection *node, TIntermTraverser *it)
+static TBasicType getLookupSamplerType (TOperator op)
 {
-   //TODO: might need to run down this rat hole for ?: operator
-   TSamplerTraverser* sit = static_cast<TSamplerTraverser*>(it);
-
-   return !(sit->abort);
+	switch (op)
+	{
+	//HLSL texture functions
+	case EOpTex1D:
+	case EOpTex1DProj:
+	case EOpTex1DLod:
+	case EOpTex1DBias:
+	case EOpTex1DGrad:
+		return EbtSampler1D;
+
+	case EOpTex2D:
+	case EOpTex2DProj:
+	case EOpTex2DLod:
+	case EOpTex2DBias:
+	case EOpTex2DGrad:
+		return EbtSampler2D;
+
+	case EOpShadow2D:
+	case EOpShadow2DProj:
+		return EbtSampler2DShadow;
+
+	case EOpTex2DArray:
+	case EOpTex2DArrayLod:
+	case EOpTex2DArrayBias:
+		return EbtSampler2DArray;
+
+	case EOpTexRect:
+	case EOpTexRectProj:
+		return EbtSamplerRect;
+
+	case EOpTex3D:
+	case EOpTex3DProj:
+	case EOpTex3DLod:
+	case EOpTex3DBias:
+	case EOpTex3DGrad:
+		return EbtSampler3D;
+
+	case EOpTexCube:
+	case EOpTexCubeProj:
+	case EOpTexCubeLod:
+	case EOpTexCubeBias:
+	case EOpTexCubeGrad:
+		return EbtSamplerCube;
+
+	default:
+		return EbtVoid;
+	}
 }
 
 
 bool TSamplerTraverser::traverseAggregate( bool preVisit, TIntermAggregate *node, TIntermTraverser *it)
 {
-   TSamplerTraverser* sit = static_cast<TSamplerTraverser*>(it);
-   TInfoSink &infoSink = sit->infoSink;
-
-   if (sit->abort)
-      return false;
-
-   if (! (sit->typing) )
-   {
-      switch (node->getOp())
-      {
-      
-      case EOpFunction:
-         // Store the current function name to use to setup the parameters
-         sit->currentFunction = node->getName().c_str(); 
-         break;
-
-      case EOpParameters:
-         // Store the parameters to the function in the map
-         sit->functionMap[sit->currentFunction.c_str()] = &(node->getNodes());
-         break;
-
-      case EOpFunctionCall:
-         {
-            // This is a bit tricky.  Find the function in the map.  Loop over the parameters
-            // and see if the parameters have been marked as a typed sampler.  If so, propagate
-            // the sampler type to the caller
-            if ( sit->functionMap.find ( node->getName().c_str() ) != sit->functionMap.end() )
-            {
-               // Get the sequence of function parameters
-               TNodeArray *funcSequence = sit->functionMap[node->getName().c_str()];
-               
-               // Get the sequence of parameters being passed to function
-               TNodeArray& nodes = node->getNodes();
-
-               // Grab iterators to both sequences
-               TNodeArray::iterator symit = nodes.begin();
-               TNodeArray::iterator funcIt = funcSequence->begin();
-
-               assert (nodes.size() == funcSequence->size());
-               if (nodes.size() == funcSequence->size())
-               {
-                  while (symit != nodes.end())
-                  {
-                     TIntermSymbol *sym = (*symit)->getAsSymbolNode();
-                     TIntermSymbol *funcSym = (*funcIt)->getAsSymbolNode();
-                     
-                     if ( sym != NULL && funcSym != NULL)
-                     {
-                        // If the parameter is generic, and the sampler to which
-                        // it is being passed has been marked, propogate its sampler
-                        // type to the caller.
-                        if ( sym->getBasicType() == EbtSamplerGeneric &&
-                             funcSym->getBasicType() != EbtSamplerGeneric )
-                        {
-                           sit->typeSampler ( sym, funcSym->getBasicType() );
-                        }
-                     }
-                     symit++;
-                     funcIt++;
-                  }
-               }
-            }
-         }
-         break;
-
-         //HLSL texture functions
-      case EOpTex1D:
-      case EOpTex1DProj:
-      case EOpTex1DLod:
-      case EOpTex1DBias:
-      case EOpTex1DGrad:
-         {
-            TNodeArray& nodes = node->getNodes();
-            assert(nodes.size());
-            TIntermTyped *sampArg = nodes[0]->getAsTyped();
-            if ( sampArg)
-            {
-               if (sampArg->getBasicType() == EbtSamplerGeneric)
-               {
-                  //type the sampler
-                  sit->typeSampler( sampArg, EbtSampler1D);
-               }
-               else if (sampArg->getBasicType() != EbtSampler1D)
-               {
-                  //We have a sampler mismatch error
-                  infoSink.info << "Error: " << node->getLine() << ": Sampler type mismatch, likely using a generic sampler as two types\n";
-               }
-            }
-            else
-            {
-               assert(0);
-            }
-
-         }
-         // We need to continue the traverse here, because the calls could be nested 
-         break;
-
-
-      case EOpTex2D:
-      case EOpTex2DProj:
-      case EOpTex2DLod:
-      case EOpTex2DBias:
-      case EOpTex2DGrad:
-         {
-            TNodeArray& nodes = node->getNodes();
-            assert(nodes.size());
-            TIntermTyped *sampArg = nodes[0]->getAsTyped();
-            if ( sampArg)
-            {
-               if (sampArg->getBasicType() == EbtSamplerGeneric)
-               {
-                  //type the sampler
-                  sit->typeSampler( sampArg, EbtSampler2D);
-               }
-               else if (sampArg->getBasicType() != EbtSampler2D)
-               {
-                  //We have a sampler mismatch error
-                  infoSink.info << "Error: " << node->getLine() << ": Sampler type mismatch, likely using a generic sampler as two types\n";
-               }
-            }
-            else
-            {
-               assert(0);
-            }
-
-         }
-         // We need to continue the traverse here, because the calls could be nested 
-         break;
-			  
-		case EOpShadow2D:
-		case EOpShadow2DProj:
+	TSamplerTraverser* sit = static_cast<TSamplerTraverser*>(it);
+
+	switch (node->getOp())
+	{
+	case EOpFunction:
+		// Store the current function name to use to setup the parameters
+		sit->currentFunction = node->getName().c_str();
+		break;
+
+	case EOpParameters:
+		// Store the parameters to the function in the map
+		sit->functionMap[sit->currentFunction] = &(node->getNodes());
+		break;
+
+	case EOpFunctionCall:
 		{
-			TNodeArray& nodes = node->getNodes();
-			assert(nodes.size());
-			TIntermTyped *sampArg = nodes[0]->getAsTyped();
-			if (sampArg)
+			// Each argument could get its sampler type from the matching parameter of the
+			// called function, once that one is typed. The function might not be defined
+			// yet, so just remember the call and match it up once everything is indexed.
+			for (int i = 0; i < (int)node->getNodes().size(); ++i)
 			{
-				if (sampArg->getBasicType() == EbtSamplerGeneric)
-					sit->typeSampler(sampArg, EbtSampler2DShadow);
-				else if (sampArg->getBasicType() != EbtSampler2DShadow)
-					infoSink.info << "Error: " << node->getLine() << ": Sampler type mismatch, likely using a generic sampler as two types\n";
+				TSamplerRule rule = { node, EbtSamplerGeneric, i };
+				sit->rules.push_back(rule);
 			}
-			else
+		}
+		break;
+
+	default:
+		{
+			TBasicType sampType = getLookupSamplerType(node->getOp());
+			if (sampType != EbtVoid)
 			{
-				assert(0);
+				assert(node->getNodes().size());
+				TSamplerRule rule = { node, sampType, 0 };
+				sit->pending.push((int)sit->rules.size());
+				sit->rules.push_back(rule);
 			}
 		}
 		// We need to continue the traverse here, because the calls could be nested
 		break;
+	}
+
+	return true;
+}
+
 
-		case EOpTex2DArray:
-		case EOpTex2DArrayLod:
-		case EOpTex2DArrayBias:
+void TSamplerTraverser::typeSampler( TIntermTyped *node, TBasicType samp )
+{
+	TIntermSymbol *symNode = node->getAsSymbolNode();
+
+	if ( !symNode)
+	{
+		//TODO: add logic to handle sampler arrays and samplers as struct members
+
+		//Don't try typing this one, it is a complex expression
+		TIntermBinary *biNode = node->getAsBinaryNode();
+
+		if ( biNode )
 		{
-			TNodeArray& nodes = node->getNodes();
-			assert(nodes.size());
-			TIntermTyped *sampArg = nodes[0]->getAsTyped();
-			if (sampArg)
+			switch (biNode->getOp())
 			{
-				if (sampArg->getBasicType() == EbtSamplerGeneric)
-					sit->typeSampler(sampArg, EbtSampler2DArray);
-				else if (sampArg->getBasicType() != EbtSampler2DArray)
-					infoSink.info << "Error: " << node->getLine() << ": Sampler type mismatch, likely using a generic sampler as two types\n";
+			case EOpIndexDirect:
+			case EOpIndexIndirect:
+				infoSink.info << "Warning: " << node->getLine() <<  ": typing of sampler arrays presently unsupported\n";
+				break;
+
+			case EOpIndexDirectStruct:
+				infoSink.info << "Warning: " << node->getLine() <<  ": typing of samplers as struct members presently unsupported\n";
+				break;
+			default:
+				break;
 			}
-			else
-			{
-				assert(0);
-			}
-		  }
-		
-		// We need to continue the traverse here, because the calls could be nested 
-		break;
-			  
-	  case EOpTexRect:
-	  case EOpTexRectProj:
-		  {
-			  TNodeArray& nodes = node->getNodes();
-			  assert(nodes.size());
-			  TIntermTyped *sampArg = nodes[0]->getAsTyped();
-			  if ( sampArg)
-			  {
-				  if (sampArg->getBasicType() == EbtSamplerGeneric)
-				  {
-					  //type the sampler
-					  sit->typeSampler( sampArg, EbtSamplerRect);
-				  }
-				  else if (sampArg->getBasicType() != EbtSamplerRect)
-				  {
-					  //We have a sampler mismatch error
-					  infoSink.info << "Error: " << node->getLine() << ": Sampler type mismatch, likely using a generic sampler as two types\n";
-				  }
-			  }
-			  else
-			  {
-				  assert(0);
-			  }
-			  
-		  }
-		  // We need to continue the traverse here, because the calls could be nested 
-		  break;
-			  
-			  
-      case EOpTex3D:
-      case EOpTex3DProj:
-      case EOpTex3DLod:
-      case EOpTex3DBias:
-      case EOpTex3DGrad:
-         {
-            TNodeArray& nodes = node->getNodes();
-            assert(nodes.size());
-            TIntermTyped *sampArg = nodes[0]->getAsTyped();
-            if ( sampArg)
-            {
-               if (sampArg->getBasicType() == EbtSamplerGeneric)
-               {
-                  //type the sampler
-                  sit->typeSampler( sampArg, EbtSampler3D);
-               }
-               else if (sampArg->getBasicType() != EbtSampler3D)
-               {
-                  //We have a sampler mismatch error
-                  infoSink.info << "Error: " << node->getLine() << ": Sampler type mismatch, likely using a generic sampler as two types\n";
-               }
-            }
-            else
-            {
-               assert(0);
-            }
-
-         }
-         // We need to continue the traverse here, because the calls could be nested 
-         break;
-
-      case EOpTexCube:
-      case EOpTexCubeProj:
-      case EOpTexCubeLod:
-      case EOpTexCubeBias:
-      case EOpTexCubeGrad:
-         {
-            TNodeArray& nodes = node->getNodes();
-            assert(nodes.size());
-            TIntermTyped *sampArg = nodes[0]->getAsTyped();
-            if ( sampArg)
-            {
-               if (sampArg->getBasicType() == EbtSamplerGeneric)
-               {
-                  //type the sampler
-                  sit->typeSampler( sampArg, EbtSamplerCube);
-               }
-               else if (sampArg->getBasicType() != EbtSamplerCube)
-               {
-                  //We have a sampler mismatch error
-                  infoSink.info << "Error: " << node->getLine() << ": Sampler type mismatch, likely using a generic sampler as two types\n";
-               }
-            }
-            else
-            {
-               assert(0);
-            }
-
-         }
-         // We need to continue the traverse here, because the calls could be nested 
-         break;
-
-      default: 
-         break;
-      }
-   }
-
-
-   return !(sit->abort);
+		}
+		else
+		{
+			infoSink.info << "Warning: " << node->getLine() <<  ": unexpected expression type for sampler, cannot type\n";
+		}
+	}
+	else
+	{
+		typeSymbol(symNode->getId(), samp);
+	}
 }
 
 
-bool TSamplerTraverser::traverseLoop( bool preVisit, TIntermLoop *node, TIntermTraverser *it)
+void TSamplerTraverser::typeSymbol( int id, TBasicType samp )
 {
-   TSamplerTraverser* sit = static_cast<TSamplerTraverser*>(it);
+	TSymbolUses& uses = symbolUses[id];
+	for (TSymbolUses::iterator it = uses.begin(); it != uses.end(); ++it)
+	{
+		// Technically most of these should never happen
+		(*it)->getTypePointer()->setBasicType(samp);
+	}
 
-   return !(sit->abort);
+	// If this was a parameter of a function definition, the calls to that function
+	// can now pass its type on to their arguments.
+	std::map<int, std::vector<int> >::iterator pit = paramCalls.find(id);
+	if (pit != paramCalls.end())
+	{
+		for (std::vector<int>::iterator cit = pit->second.begin(); cit != pit->second.end(); ++cit)
+			pending.push(*cit);
+	}
 }
 
 
-bool TSamplerTraverser::traverseBranch( bool preVisit, TIntermBranch *node,  TIntermTraverser *it)
+// Applies the rules in the same order as repeatedly restarting the traversal from the root
+// and typing the first sampler found would: always the earliest rule in the tree that can
+// type a still generic sampler. Every rule is looked at a bounded number of times.
+void TSamplerTraverser::propagate()
 {
-   TSamplerTraverser* sit = static_cast<TSamplerTraverser*>(it);
+	for (int r = 0; r < (int)rules.size(); ++r)
+	{
+		const TSamplerRule& rule = rules[r];
+		if (rule.sampType != EbtSamplerGeneric)
+			continue;
+		std::map<std::string,TNodeArray* >::iterator fit = functionMap.find(rule.node->getName().c_str());
+		if (fit == functionMap.end() || rule.arg >= (int)fit->second->size())
+			continue;
+		TIntermSymbol* funcSym = (*fit->second)[rule.arg]->getAsSymbolNode();
+		if (!funcSym)
+			continue;
+
+		// Calls to functions whose parameters are already typed in the source can be used right away,
+		// the others have to wait until the parameter gets typed
+		if (funcSym->getBasicType() != EbtSamplerGeneric)
+			pending.push(r);
+		else
+			paramCalls[funcSym->getId()].push_back(r);
+	}
+
+	while (!pending.empty())
+	{
+		const TSamplerRule& rule = rules[pending.top()];
+		pending.pop();
+
+		TNodeArray& nodes = rule.node->getNodes();
 
-   return !(sit->abort);
+		if (rule.sampType != EbtSamplerGeneric)
+		{
+			TIntermTyped *sampArg = nodes[0]->getAsTyped();
+			// Arguments that are not plain symbols are reported in reportErrors
+			if (sampArg && sampArg->getAsSymbolNode() && sampArg->getBasicType() == EbtSamplerGeneric)
+				typeSampler(sampArg, rule.sampType);
+			continue;
+		}
+
+		// Get the sequence of function parameters
+		TNodeArray *funcSequence = functionMap[rule.node->getName().c_str()];
+
+		assert (nodes.size() == funcSequence->size());
+		if (nodes.size() != funcSequence->size())
+			continue;
+
+		TIntermSymbol *sym = nodes[rule.arg]->getAsSymbolNode();
+		TIntermSymbol *funcSym = (*funcSequence)[rule.arg]->getAsSymbolNode();
+
+		// If the parameter is generic, and the sampler to which
+		// it is being passed has been marked, propogate its sampler
+		// type to the caller.
+		if ( sym != NULL && funcSym != NULL &&
+			 sym->getBasicType() == EbtSamplerGeneric &&
+			 funcSym->getBasicType() != EbtSamplerGeneric )
+		{
+			typeSampler ( sym, funcSym->getBasicType() );
+		}
+	}
 }
 
 
-void TSamplerTraverser::typeSampler( TIntermTyped *node, TBasicType samp )
+void TSamplerTraverser::reportErrors()
 {
-   TIntermSymbol *symNode = node->getAsSymbolNode();
-
-   if ( !symNode)
-   {
-      //TODO: add logic to handle sampler arrays and samplers as struct members
-
-      //Don't try typing this one, it is a complex expression
-      TIntermBinary *biNode = node->getAsBinaryNode();
-
-      if ( biNode )
-      {
-         switch (biNode->getOp())
-         {
-         case EOpIndexDirect:
-         case EOpIndexIndirect:
-            infoSink.info << "Warning: " << node->getLine() <<  ": typing of sampler arrays presently unsupported\n";
-            break;
-
-         case EOpIndexDirectStruct:
-            infoSink.info << "Warning: " << node->getLine() <<  ": typing of samplers as struct members presently unsupported\n";
-            break;
-         default:
-            break;
-         }
-      }
-      else
-      {
-         infoSink.info << "Warning: " << node->getLine() <<  ": unexpected expression type for sampler, cannot type\n";
-      }
-      abort = false;
-   }
-   else
-   {
-      // We really have something to type, abort this traverse and activate typing
-      abort = true;
-      id = symNode->getId();
-      sampType = samp;
-   }
+	for (std::vector<TSamplerRule>::iterator it = rules.begin(); it != rules.end(); ++it)
+	{
+		if (it->sampType == EbtSamplerGeneric)
+			continue;
+
+		TIntermTyped *sampArg = it->node->getNodes()[0]->getAsTyped();
+		if ( sampArg)
+		{
+			if (sampArg->getBasicType() == EbtSamplerGeneric)
+			{
+				// could not be typed
+				typeSampler( sampArg, it->sampType);
+			}
+			else if (sampArg->getBasicType() != it->sampType)
+			{
+				//We have a sampler mismatch error
+				infoSink.info << "Error: " << it->node->getLine() << ": Sampler type mismatch, likely using a generic sampler as two types\n";
+			}
+		}
+		else
+		{
+			assert(0);
+		}
+	}
 }
 
 
 void PropagateSamplerTypes (TIntermNode* root, TInfoSink &info)
 {
-   TSamplerTraverser st(info);
-
-   do
-   {
-      st.abort = false;
-      root->traverse( &st);
-
-      // If we aborted, try to type the node we aborted for
-      if (st.abort)
-      {
-         st.typing = true;
-         st.abort = false;
-         root->traverse( &st);
-         st.typing = false;
-         st.abort = true;
-      }
-   } while (st.abort);
+	TSamplerTraverser st(info);
+
+	root->traverse(&st);
+	st.propagate();
+	st.reportErrors();
 }
 
 } // namespace hlsl2glsl
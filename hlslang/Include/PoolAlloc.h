@@ -54,6 +54,9 @@ public:
    // available, otherwise a properly aligned pointer to 'numBytes' of memory.
    void* allocate(size_t numBytes);
 
+   // Bytes handed out since the pool was made, whatever was popped since
+   size_t getTotalBytes() const { return totalBytes; }
+
    // There is no deallocate.  The point of this class is that
    // deallocation can be skipped by the user of it, as the model
    // of use is to simultaneously deallocate everything at once
@@ -246,6 +246,7 @@ public:
    void setBasicType(TBasicType t) { type = t; }
    void setPrecision(TPrecision p) { precision = p; }
    void changeQualifier(TQualifier q) { qualifier = q; }
+   void setLine(const TSourceLoc& l) { line = l; }
 
    int getColsCount() const { return matcols; }
    void setColsCount(int count) { matcols = count; }
@@ -280,7 +281,7 @@ public:
    int getMaxArraySize () const { return maxArraySize; }
    void clearArrayness() { array = false; arraySize = 0; maxArraySize = 0; }
    void setArrayInformationType(TType* t) { arrayInformationType = t; }
-   TType* getArrayInformationType() { return arrayInformationType; }
+   TType* getArrayInformationType() const { return arrayInformationType; }
    bool isVector() const { return matrows > 1 && !matrix; }
    static const char* getBasicString(TBasicType t)
    {
@@ -323,7 +324,7 @@ public:
       return totalSize;
    }
 
-   TString& getMangledName()
+   const TString& getMangledName() const
    {
       if (!mangled)
       {
@@ -344,6 +345,8 @@ public:
    }
    bool operator==(const TType& right) const
    {
+      if (this == &right)
+         return true;
       return      type == right.type   &&
       matrows == right.matrows &&
       matcols == right.matcols &&
@@ -380,6 +383,11 @@ public:
 
    void buildMangledName(TString&) const;
 
+   // For TTypeTable: all that makes a type, which leaves out the lazily computed parts and
+   // the line, which nodes keep themselves
+   bool sameAs(const TType& right) const;
+   unsigned int hash() const;
+
    // Determine the parameter compatibility between this type and the parameter type
    ECompatibility determineCompatibility ( const TType *pType ) const;
 
@@ -401,12 +409,19 @@ private:
    int maxArraySize;
    TType* arrayInformationType;
    TString *fieldName;         // for structure field names
-   TString *mangled;
+   mutable TString *mangled;
    TString *typeName;          // for structure field type name
    TString *semantic; //for semantics on structure fields
 };
 
 
+//
+// The shared copy of type for syntax tree nodes, from the type table of the compile if there
+// is one, else a copy of its own. Either way it is only read.
+//
+const TType* InternType(const TType& type);
+
+
 class TAnnotation
 {
 public:
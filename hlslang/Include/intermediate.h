@@ -283,6 +283,8 @@ enum TOperator
 
 	// Ternary selection on vector
 	EOpVecTernarySel,
+
+	EOpCount
 };
 
 class TIntermTraverser;
@@ -343,32 +345,54 @@ class TIntermBinary;
 class TIntermTyped : public TIntermNode
 {
 public:
-	TIntermTyped(const TType& t) : type(t)
+	TIntermTyped(const TType& t) : type(InternType(t)), ownType(0), typeLine(t.getLine())
 	{
 	}
 
 	virtual TIntermTyped* getAsTyped() { return this; }
 
-	void setType(const TType& t) { type = t; }
-	TType getType() const { return type; }
-	TType* getTypePointer() { return &type; }
-
-	TBasicType getBasicType() const { return type.getBasicType(); }
-	TQualifier getQualifier() const { return type.getQualifier(); }
-	TPrecision getPrecision() const { return type.getPrecision(); }
-	int getColsCount() const { return type.getColsCount(); }
-	int getRowsCount() const { return type.getRowsCount(); }
-	int getSize() const { return type.getInstanceSize(); }
-	bool isMatrix() const { return type.isMatrix(); }
-	bool isArray()  const { return type.isArray(); }
-	bool isVector() const { return type.isVector(); }
-	bool isScalar() const { return type.isScalar(); }
-	const char* getBasicString() const { return type.getBasicString(); }
-	const char* getQualifierString() const { return type.getQualifierString(); }
-	TString getCompleteString() const { return type.getCompleteString(); }
+	void setType(const TType& t) { type = InternType(t); ownType = 0; typeLine = t.getLine(); }
+	// Takes the type of another node, with its line
+	void setType(const TIntermTyped& from) { setType(from.getType()); typeLine = from.typeLine; }
+	// The shared type has no line, see getTypeLine
+	const TType& getType() const { return *type; }
+	const TSourceLoc& getTypeLine() const { return typeLine; }
+	void setTypeLine(const TSourceLoc& l)
+	{
+		typeLine = l;
+		if (ownType)
+			ownType->setLine(l);
+	}
+	// The type to change in place, the node's own copy of it
+	TType* getTypePointer()
+	{
+		if (!ownType)
+		{
+			ownType = new TType(*type);
+			ownType->setLine(typeLine);
+			type = ownType;
+		}
+		return ownType;
+	}
+
+	TBasicType getBasicType() const { return type->getBasicType(); }
+	TQualifier getQualifier() const { return type->getQualifier(); }
+	TPrecision getPrecision() const { return type->getPrecision(); }
+	int getColsCount() const { return type->getColsCount(); }
+	int getRowsCount() const { return type->getRowsCount(); }
+	int getSize() const { return type->getInstanceSize(); }
+	bool isMatrix() const { return type->isMatrix(); }
+	bool isArray()  const { return type->isArray(); }
+	bool isVector() const { return type->isVector(); }
+	bool isScalar() const { return type->isScalar(); }
+	const char* getBasicString() const { return type->getBasicString(); }
+	const char* getQualifierString() const { return type->getQualifierString(); }
+	TString getCompleteString() const { return type->getCompleteString(); }
 
 protected:
-	TType type;
+	const TType* type;  // shared with other nodes, see InternType
+	TType* ownType;     // type, once getTypePointer gave the node its own copy
+	TSourceLoc typeLine;
 };
 
 
@@ -502,9 +526,10 @@ private:
 class TIntermConstant : public TIntermTyped
 {
 public:
-	TIntermConstant(const TType& t) : TIntermTyped(t)
+	// Holds one zeroed value per component of the type
+	TIntermConstant(const TType& t) : TIntermTyped(t), count(0)
 	{
-		grow(t.getObjectSize() - 1);
+		resize(t.getObjectSize());
 	}
 
 	virtual TIntermConstant* getAsConstant()
@@ -521,39 +546,63 @@ public:
 		};
 	};
 	
-	#define defset(i, t) Value& v = values[(i)]; v.as##t = (val); v.type = Ebt##t
+	#define defset(i, t) assert((i) < count); Value& v = data()[(i)]; v.as##t = (val); v.type = Ebt##t
 	void setValue(unsigned val)			{ defset(0, Int); }
 	void setValue(int val)				{ defset(0, Int); }
 	void setValue(float val)			{ defset(0, Float); }
 	void setValue(bool val)				{ defset(0, Bool); }
-	void setValue(unsigned i, int val)	{ grow(i); defset(i, Int); }
-	void setValue(unsigned i, float val){ grow(i); defset(i, Float); ;}
-	void setValue(unsigned i, bool val) { grow(i); defset(i, Bool); }
-	void setValue(unsigned i, const Value& val) { values[i] = val; }
-
-	int toInt(unsigned i = 0) { return values[i].asInt; }
-	float toFloat(unsigned i = 0) { return values[i].asFloat; }
-	bool toBool(unsigned i = 0) { return values[i].asBool; }
+	void setValue(unsigned i, int val)	{ defset(i, Int); }
+	void setValue(unsigned i, float val){ defset(i, Float); }
+	void setValue(unsigned i, bool val) { defset(i, Bool); }
+	void setValue(unsigned i, const Value& val) { assert(i < count); data()[i] = val; }
 	#undef defset
+
+	// Sets the first n values at once
+	void setValues(const Value* vals, unsigned n)
+	{
+		assert(n <= count);
+		Value* v = data();
+		for (unsigned i = 0; i != n; ++i)
+			v[i] = vals[i];
+	}
+
+	int toInt(unsigned i = 0) const { assert(i < count); return data()[i].asInt; }
+	float toFloat(unsigned i = 0) const { assert(i < count); return data()[i].asFloat; }
+	bool toBool(unsigned i = 0) const { assert(i < count); return data()[i].asBool; }
 	
-	const Value& getValue(unsigned i = 0) const { return values[i]; }
-	Value& getValue(unsigned i = 0) { return values[i]; }
+	const Value& getValue(unsigned i = 0) const { assert(i < count); return data()[i]; }
+	Value& getValue(unsigned i = 0) { assert(i < count); return data()[i]; }
 	
-	unsigned getCount() {
-		return values.size();
+	unsigned getCount() const {
+		return count;
 	}
 	
-	void copyValuesFrom(const TIntermConstant& c) { values = c.values; }
+	// Takes the values of c, as many as it has, whatever the size of this node's type
+	void copyValuesFrom(const TIntermConstant& c)
+	{
+		resize(c.count);
+		setValues(c.data(), c.count);
+	}
 
 	virtual void traverse(TIntermTraverser* );
-protected:
-	void grow(unsigned ix) {
-		if (values.size() <= ix)
-			values.resize(ix + 1);
-	}
-	
-	typedef TVector<Value> Values;
-	Values values;
+private:
+	// no copying
+	TIntermConstant(const TIntermConstant&);
+	TIntermConstant& operator=(const TIntermConstant&);
+
+	// Sets the number of values, the new ones zeroed
+	void resize(unsigned n);
+
+	// A scalar is kept in the node, anything bigger in one block from the pool
+	enum { kInlineValues = 1 };
+	Value* data() { return count <= kInlineValues ? inlineValues : values; }
+	const Value* data() const { return count <= kInlineValues ? inlineValues : values; }
+
+	union {
+		Value inlineValues[kInlineValues];
+		Value* values;
+	};
+	unsigned count;
 };
 
 //
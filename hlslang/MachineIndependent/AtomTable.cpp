@@ -0,0 +1,96 @@
+// Copyright (c) The HLSL2GLSLFork Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE.txt file.
+
+
+#include "AtomTable.h"
+
+namespace hlsl2glsl
+{
+
+// FNV-1a
+unsigned int TAtomTable::Hash(const char* name, size_t length)
+{
+	unsigned int hash = 2166136261u;
+	for (size_t i = 0; i < length; ++i)
+	{
+		hash ^= static_cast<unsigned char>(name[i]);
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+
+TAtom TAtomTable::find(const char* name, size_t length, unsigned int hash) const
+{
+	if (parent)
+	{
+		if (TAtom atom = parent->find(name, length, hash))
+			return atom;
+	}
+	if (slots.empty())
+		return 0;
+
+	const size_t mask = slots.size() - 1;
+	for (size_t i = hash & mask; slots[i].atom; i = (i + 1) & mask)
+	{
+		const TSlot& slot = slots[i];
+		if (slot.hash == hash && slot.atom->size() == length && memcmp(slot.atom->c_str(), name, length) == 0)
+			return slot.atom;
+	}
+	return 0;
+}
+
+
+TAtom TAtomTable::intern(const char* name, size_t length)
+{
+	const unsigned int hash = Hash(name, length);
+	if (TAtom atom = find(name, length, hash))
+		return atom;
+
+	assert(!frozen);
+	if ((count + 1) * 2 > slots.size())
+		grow();
+
+	void* memory = GlobalPoolAllocator.allocate(sizeof(TString));
+	TAtom atom = new(memory) TString(name, length);
+
+	const size_t mask = slots.size() - 1;
+	size_t i = hash & mask;
+	while (slots[i].atom)
+		i = (i + 1) & mask;
+	slots[i].hash = hash;
+	slots[i].atom = atom;
+	++count;
+	return atom;
+}
+
+
+void TAtomTable::grow()
+{
+	std::vector<TSlot> old;
+	old.swap(slots);
+	const TSlot empty = { 0, 0 };
+	slots.resize(old.empty() ? 64 : old.size() * 2, empty);
+
+	const size_t mask = slots.size() - 1;
+	for (size_t j = 0; j < old.size(); ++j)
+	{
+		if (!old[j].atom)
+			continue;
+		size_t i = old[j].hash & mask;
+		while (slots[i].atom)
+			i = (i + 1) & mask;
+		slots[i] = old[j];
+	}
+}
+
+
+void TAtomTable::clear()
+{
+	slots.clear();
+	count = 0;
+	frozen = false;
+}
+
+} // namespace hlsl2glsl
@@ -0,0 +1,75 @@
+// Copyright (c) The HLSL2GLSLFork Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE.txt file.
+
+
+#ifndef _ATOM_TABLE_INCLUDED_
+#define _ATOM_TABLE_INCLUDED_
+
+//
+// Interned identifiers. Every spelling gets one pool string, its atom, so names that
+// went through the same table compare by pointer.
+//
+// A compile's table is chained to the frozen table of the built-in symbols: names the
+// built-ins know come back as the built-in atoms, everything else is added to the
+// compile's own table. The built-in table is only read once frozen, so any number of
+// compiles can share it from any number of threads.
+//
+
+#include <cstring>
+#include <vector>
+
+#include "../Include/Common.h"
+
+namespace hlsl2glsl
+{
+
+typedef const TString* TAtom;
+
+class TAtomTable
+{
+public:
+	explicit TAtomTable(const TAtomTable* parent = 0) : parent(parent), count(0), frozen(false)
+	{
+		assert(!parent || parent->frozen);
+	}
+
+	/// The atom for a name, added to this table if it has none yet. The string is made
+	/// in the current pool.
+	TAtom intern(const char* name, size_t length);
+	TAtom intern(const char* name) { return intern(name, strlen(name)); }
+	TAtom intern(const TString& name) { return intern(name.c_str(), name.size()); }
+
+	/// The atom for a name, or null if it has none, without adding it
+	TAtom find(const char* name, size_t length) const { return find(name, length, Hash(name, length)); }
+	TAtom find(const TString& name) const { return find(name.c_str(), name.size()); }
+
+	// After this the table is only read, so it can be shared between threads
+	void freeze() { frozen = true; }
+	bool isFrozen() const { return frozen; }
+
+	// Forget all atoms, when the pool they are in goes away
+	void clear();
+
+	size_t size() const { return count; }
+
+private:
+	struct TSlot
+	{
+		unsigned int hash;
+		TAtom atom;
+	};
+
+	static unsigned int Hash(const char* name, size_t length);
+	TAtom find(const char* name, size_t length, unsigned int hash) const;
+	void grow();
+
+	const TAtomTable* parent;
+	std::vector<TSlot> slots;   // open addressing, a power of two in size
+	size_t count;
+	bool frozen;
+};
+
+} // namespace hlsl2glsl
+
+#endif // _ATOM_TABLE_INCLUDED_
@@ -0,0 +1,49 @@
+// Copyright (c) The HLSL2GLSLFork Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE.txt file.
+
+
+#include "BuiltInSymbols.h"
+
+namespace hlsl2glsl
+{
+
+static TType BuiltInType(const TBuiltInType& t)
+{
+	TPublicType publicType;
+	TSourceLoc line = { 0, t.line };
+	publicType.setBasic(static_cast<TBasicType>(t.type), static_cast<TQualifier>(t.qualifier), line);
+	publicType.precision = static_cast<TPrecision>(t.precision);
+	publicType.matcols = t.cols;
+	publicType.matrows = t.rows;
+	publicType.matrix = t.matrix != 0;
+	return TType(publicType);
+}
+
+
+void LoadBuiltInSymbolTable(const TBuiltInSymbolData& data, TSymbolTable& symbolTable)
+{
+	TSymbolTableLevel* level = new TSymbolTableLevel(symbolTable.getAtoms());
+
+	for (int i = 0; i < data.functionCount; ++i)
+	{
+		const TBuiltInFunction& f = data.functions[i];
+
+		TType returnType = BuiltInType(f.returnType);
+		TFunction* function = new TFunction(NewPoolTString(data.names + f.name), returnType, static_cast<TOperator>(f.op));
+		for (int p = 0; p < f.parameterCount; ++p)
+		{
+			const TBuiltInParameter& bp = data.parameters[f.firstParameter + p];
+			TParameter param = { bp.name >= 0 ? NewPoolTString(data.names + bp.name) : 0, 0, new TType(BuiltInType(bp.type)) };
+			function->addParameter(param);
+		}
+		function->setUniqueId(f.uniqueId);
+		function->setGlobal(true);
+
+		level->insert(*function);
+	}
+
+	symbolTable.pushSharedBuiltInLevel(level, data.lastUniqueId);
+}
+
+} // namespace hlsl2glsl
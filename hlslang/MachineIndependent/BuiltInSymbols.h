@@ -0,0 +1,72 @@
+// Copyright (c) The HLSL2GLSLFork Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE.txt file.
+
+
+#ifndef _BUILT_IN_SYMBOLS_INCLUDED_
+#define _BUILT_IN_SYMBOLS_INCLUDED_
+
+//
+// Built-in symbol tables in a constant, pointer free form.
+//
+// Parsing the built-in prototypes from Initialize.cpp is by far the most expensive part
+// of Hlsl2Glsl_Initialize, so this is done once at build time by GenBuiltInSymbols.cpp, which
+// writes the resulting symbol tables out as the tables below. At startup they are turned
+// back into symbols directly. When no prebuilt tables are compiled in, the prototypes are
+// parsed as before.
+//
+
+#include "SymbolTable.h"
+#include "../../include/hlsl2glsl.h"
+
+namespace hlsl2glsl
+{
+
+struct TBuiltInType
+{
+	unsigned char type;       // TBasicType
+	unsigned char precision;  // TPrecision
+	unsigned char qualifier;  // TQualifier
+	unsigned char cols;
+	unsigned char rows;
+	unsigned char matrix;
+	unsigned short line;
+};
+
+struct TBuiltInParameter
+{
+	int name;   // offset into TBuiltInSymbolData::names, -1 for unnamed parameters
+	TBuiltInType type;
+};
+
+struct TBuiltInFunction
+{
+	int name;   // offset into TBuiltInSymbolData::names
+	int uniqueId;
+	int op;     // TOperator
+	int firstParameter;
+	int parameterCount;
+	TBuiltInType returnType;
+};
+
+struct TBuiltInSymbolData
+{
+	const TBuiltInFunction* functions;
+	int functionCount;
+	const TBuiltInParameter* parameters;
+	const char* names;   // nul terminated names, one after the other
+	int lastUniqueId;
+};
+
+/// Prebuilt tables for each language, or null if the library was built without them
+extern const TBuiltInSymbolData* const PrebuiltBuiltInSymbols;
+
+/// Fill in the shared built-in level of an empty symbol table from prebuilt data
+void LoadBuiltInSymbolTable(const TBuiltInSymbolData& data, TSymbolTable& symbolTable);
+
+/// Parse the built-in prototypes into symbolTables, one table for each language
+bool ParseBuiltInSymbolTables(TSymbolTable* symbolTables, TInfoSink& infoSink);
+
+} // namespace hlsl2glsl
+
+#endif // _BUILT_IN_SYMBOLS_INCLUDED_
@@ -0,0 +1,16 @@
+// Copyright (c) The HLSL2GLSLFork Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE.txt file.
+
+
+// Used instead of the generated tables by GenBuiltInSymbols itself, and when building
+// without HLSL2GLSL_PREBUILT_BUILTINS: the built-in prototypes get parsed at startup.
+
+#include "BuiltInSymbols.h"
+
+namespace hlsl2glsl
+{
+
+const TBuiltInSymbolData* const PrebuiltBuiltInSymbols = 0;
+
+} // namespace hlsl2glsl
@@ -0,0 +1,291 @@
+// Copyright (c) The HLSL2GLSLFork Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE.txt file.
+
+
+#include "CompileCache.h"
+
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <list>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <unordered_map>
+
+namespace hlsl2glsl
+{
+
+// -----------------------------------------------------------------------------
+// Stores
+
+namespace {
+
+class TMemoryCompileCache : public TCompileCache
+{
+public:
+	explicit TMemoryCompileCache(size_t maxBytes) : maxBytes(maxBytes), totalBytes(0) { }
+
+	virtual bool load(const std::string& key, std::string& value)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		TEntryMap::iterator it = entries.find(key);
+		if (it == entries.end())
+			return false;
+
+		// Move to the front of the LRU list
+		lru.splice(lru.begin(), lru, it->second);
+		value = it->second->second;
+		return true;
+	}
+
+	virtual void save(const std::string& key, const std::string& value)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		TEntryMap::iterator it = entries.find(key);
+		if (it != entries.end())
+		{
+			totalBytes -= it->second->second.size();
+			lru.erase(it->second);
+			entries.erase(it);
+		}
+
+		lru.push_front(std::make_pair(key, value));
+		entries[key] = lru.begin();
+		totalBytes += value.size();
+
+		while (maxBytes && totalBytes > maxBytes && !lru.empty())
+		{
+			totalBytes -= lru.back().second.size();
+			entries.erase(lru.back().first);
+			lru.pop_back();
+		}
+	}
+
+private:
+	typedef std::list< std::pair<std::string, std::string> > TEntryList;
+	typedef std::unordered_map<std::string, TEntryList::iterator> TEntryMap;
+
+	std::mutex mutex;
+	TEntryList lru;   // most recently used first
+	TEntryMap entries;
+	size_t maxBytes;
+	size_t totalBytes;
+};
+
+
+class TDirectoryCompileCache : public TCompileCache
+{
+public:
+	explicit TDirectoryCompileCache(const std::string& path)
+	:	directory(path)
+	,	tempCounter(0)
+	{
+		if (!directory.empty() && directory[directory.size() - 1] != '/' && directory[directory.size() - 1] != '\\')
+			directory += '/';
+
+		// Tells temporary files of different processes sharing the directory apart
+		std::random_device random;
+		std::ostringstream tag;
+		tag << std::hex << random() << random();
+		tempTag = tag.str();
+	}
+
+	virtual bool load(const std::string& key, std::string& value)
+	{
+		std::ifstream in((directory + key).c_str(), std::ios::binary);
+		if (!in)
+			return false;
+		value.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+		return !in.bad();
+	}
+
+	virtual void save(const std::string& key, const std::string& value)
+	{
+		std::ostringstream tempName;
+		tempName << directory << key << ".tmp-" << tempTag << "-" << tempCounter++;
+		const std::string temp = tempName.str();
+		const std::string target = directory + key;
+
+		{
+			std::ofstream out(temp.c_str(), std::ios::binary | std::ios::trunc);
+			out.write(value.data(), static_cast<std::streamsize>(value.size()));
+			out.close();
+			if (!out)
+			{
+				std::remove(temp.c_str());
+				return;
+			}
+		}
+
+		// Renaming within a directory is atomic. Where it does not replace existing files,
+		// the entry is already there, with the same content since keys are content hashes.
+		if (std::rename(temp.c_str(), target.c_str()) != 0)
+			std::remove(temp.c_str());
+	}
+
+private:
+	std::string directory;
+	std::string tempTag;
+	std::atomic<unsigned> tempCounter;
+};
+
+
+class TCallbackCompileCache : public TCompileCache
+{
+public:
+	explicit TCallbackCompileCache(const Hlsl2Glsl_CacheCallbacks& callbacks) : callbacks(callbacks) { }
+
+	virtual bool load(const std::string& key, std::string& value)
+	{
+		return callbacks.load && callbacks.load(key.c_str(), value, callbacks.data);
+	}
+
+	virtual void save(const std::string& key, const std::string& value)
+	{
+		if (callbacks.save)
+			callbacks.save(key.c_str(), value, callbacks.data);
+	}
+
+private:
+	Hlsl2Glsl_CacheCallbacks callbacks;
+};
+
+} // namespace
+
+
+TCompileCache* NewMemoryCompileCache(size_t maxBytes)
+{
+	return new TMemoryCompileCache(maxBytes);
+}
+
+TCompileCache* NewDirectoryCompileCache(const std::string& path)
+{
+	return new TDirectoryCompileCache(path);
+}
+
+TCompileCache* NewCallbackCompileCache(const Hlsl2Glsl_CacheCallbacks& callbacks)
+{
+	return new TCallbackCompileCache(callbacks);
+}
+
+
+// -----------------------------------------------------------------------------
+// Entries
+//
+// A header line, then every field as "<length>:<bytes>", numbers as "<value>;".
+
+static const char kEntryHeader[] = "hlsl2glsl compile cache 1\n";
+
+static void WriteString(std::string& out, const std::string& s)
+{
+	std::ostringstream length;
+	length << s.size() << ':';
+	out += length.str();
+	out += s;
+}
+
+static void WriteInt(std::string& out, int value)
+{
+	std::ostringstream number;
+	number << value << ';';
+	out += number.str();
+}
+
+static bool ReadInt(const std::string& in, size_t& pos, char terminator, long long& value)
+{
+	size_t end = in.find(terminator, pos);
+	if (end == std::string::npos || end == pos)
+		return false;
+	std::istringstream number(in.substr(pos, end - pos));
+	if (!(number >> value) || !number.eof())
+		return false;
+	pos = end + 1;
+	return true;
+}
+
+static bool ReadInt(const std::string& in, size_t& pos, int& value)
+{
+	long long n;
+	if (!ReadInt(in, pos, ';', n))
+		return false;
+	value = static_cast<int>(n);
+	return true;
+}
+
+static bool ReadString(const std::string& in, size_t& pos, std::string& s)
+{
+	long long length;
+	if (!ReadInt(in, pos, ':', length) || length < 0 || static_cast<unsigned long long>(length) > in.size() - pos)
+		return false;
+	s.assign(in, pos, static_cast<size_t>(length));
+	pos += static_cast<size_t>(length);
+	return true;
+}
+
+
+std::string SerializeCachedCompile(const TCachedCompile& compile)
+{
+	std::string out = kEntryHeader;
+	WriteInt(out, compile.success ? 1 : 0);
+	WriteString(out, compile.shaderText);
+	WriteString(out, compile.infoLog);
+	WriteInt(out, static_cast<int>(compile.uniforms.size()));
+	for (std::vector<TCachedUniform>::const_iterator it = compile.uniforms.begin(); it != compile.uniforms.end(); ++it)
+	{
+		WriteString(out, it->name);
+		WriteInt(out, it->hasSemantic ? 1 : 0);
+		WriteString(out, it->semantic);
+		WriteInt(out, it->hasRegisterSpec ? 1 : 0);
+		WriteString(out, it->registerSpec);
+		WriteInt(out, it->type);
+		WriteInt(out, it->arraySize);
+	}
+	return out;
+}
+
+
+bool DeserializeCachedCompile(const std::string& value, TCachedCompile& compile)
+{
+	const size_t headerSize = sizeof(kEntryHeader) - 1;
+	if (value.compare(0, headerSize, kEntryHeader) != 0)
+		return false;
+
+	size_t pos = headerSize;
+	int success, uniformCount;
+	if (!ReadInt(value, pos, success) ||
+		!ReadString(value, pos, compile.shaderText) ||
+		!ReadString(value, pos, compile.infoLog) ||
+		!ReadInt(value, pos, uniformCount) || uniformCount < 0)
+	{
+		return false;
+	}
+	compile.success = success != 0;
+
+	compile.uniforms.clear();
+	for (int i = 0; i < uniformCount; ++i)
+	{
+		TCachedUniform uniform;
+		int hasSemantic, hasRegisterSpec;
+		if (!ReadString(value, pos, uniform.name) ||
+			!ReadInt(value, pos, hasSemantic) ||
+			!ReadString(value, pos, uniform.semantic) ||
+			!ReadInt(value, pos, hasRegisterSpec) ||
+			!ReadString(value, pos, uniform.registerSpec) ||
+			!ReadInt(value, pos, uniform.type) ||
+			!ReadInt(value, pos, uniform.arraySize))
+		{
+			return false;
+		}
+		uniform.hasSemantic = hasSemantic != 0;
+		uniform.hasRegisterSpec = hasRegisterSpec != 0;
+		compile.uniforms.push_back(uniform);
+	}
+
+	// Anything left over means a damaged or foreign entry
+	return pos == value.size();
+}
+
+} // namespace hlsl2glsl
@@ -0,0 +1,71 @@
+// Copyright (c) The HLSL2GLSLFork Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE.txt file.
+
+
+#ifndef _COMPILE_CACHE_INCLUDED_
+#define _COMPILE_CACHE_INCLUDED_
+
+//
+// Content-addressed cache of compile results, see Hlsl2Glsl_CompileCached.
+//
+// A result is stored under the hash of everything that can change it: the preprocessed
+// tokens with their source positions, language, entry point, target, options, prefix
+// table and user attribute names. The stores below only map such keys to opaque values.
+//
+
+#include <string>
+#include <vector>
+
+#include "../../include/hlsl2glsl.h"
+
+namespace hlsl2glsl
+{
+
+class TCompileCache
+{
+public:
+	virtual ~TCompileCache() { }
+
+	// Both get called from any number of threads at once
+	virtual bool load(const std::string& key, std::string& value) = 0;
+	virtual void save(const std::string& key, const std::string& value) = 0;
+};
+
+/// In-memory store that drops the least recently used entries beyond maxBytes of values (0 for no limit)
+TCompileCache* NewMemoryCompileCache(size_t maxBytes);
+
+/// Store with one file per entry in an existing directory. Entries are written to a temporary
+/// file first and then renamed, so readers never see partial entries.
+TCompileCache* NewDirectoryCompileCache(const std::string& path);
+
+/// Store implemented by the application
+TCompileCache* NewCallbackCompileCache(const Hlsl2Glsl_CacheCallbacks& callbacks);
+
+
+struct TCachedUniform
+{
+	std::string name;
+	bool hasSemantic;
+	std::string semantic;
+	bool hasRegisterSpec;
+	std::string registerSpec;
+	int type;
+	int arraySize;
+};
+
+// What a compile leaves behind in its compiler, as far as the API exposes it
+struct TCachedCompile
+{
+	bool success;
+	std::string shaderText;
+	std::string infoLog;
+	std::vector<TCachedUniform> uniforms;
+};
+
+std::string SerializeCachedCompile(const TCachedCompile& compile);
+bool DeserializeCachedCompile(const std::string& value, TCachedCompile& compile);
+
+} // namespace hlsl2glsl
+
+#endif // _COMPILE_CACHE_INCLUDED_
@@ -0,0 +1,144 @@
+// Copyright (c) The HLSL2GLSLFork Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE.txt file.
+
+
+#include "ContentHash.h"
+
+#include <cstring>
+
+namespace hlsl2glsl
+{
+
+static const unsigned int kRoundConstants[64] = {
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+static inline unsigned int RotateRight(unsigned int x, int n)
+{
+	return (x >> n) | (x << (32 - n));
+}
+
+
+TContentHash::TContentHash()
+:	bufferSize(0)
+,	totalSize(0)
+{
+	state[0] = 0x6a09e667;
+	state[1] = 0xbb67ae85;
+	state[2] = 0x3c6ef372;
+	state[3] = 0xa54ff53a;
+	state[4] = 0x510e527f;
+	state[5] = 0x9b05688c;
+	state[6] = 0x1f83d9ab;
+	state[7] = 0x5be0cd19;
+}
+
+
+void TContentHash::processBlock(const unsigned char* block)
+{
+	unsigned int w[64];
+	for (int i = 0; i < 16; ++i)
+	{
+		w[i] = (unsigned int)block[i*4] << 24 | (unsigned int)block[i*4+1] << 16 |
+			(unsigned int)block[i*4+2] << 8 | (unsigned int)block[i*4+3];
+	}
+	for (int i = 16; i < 64; ++i)
+	{
+		unsigned int s0 = RotateRight(w[i-15], 7) ^ RotateRight(w[i-15], 18) ^ (w[i-15] >> 3);
+		unsigned int s1 = RotateRight(w[i-2], 17) ^ RotateRight(w[i-2], 19) ^ (w[i-2] >> 10);
+		w[i] = w[i-16] + s0 + w[i-7] + s1;
+	}
+
+	unsigned int a = state[0], b = state[1], c = state[2], d = state[3];
+	unsigned int e = state[4], f = state[5], g = state[6], h = state[7];
+	for (int i = 0; i < 64; ++i)
+	{
+		unsigned int s1 = RotateRight(e, 6) ^ RotateRight(e, 11) ^ RotateRight(e, 25);
+		unsigned int ch = (e & f) ^ (~e & g);
+		unsigned int t1 = h + s1 + ch + kRoundConstants[i] + w[i];
+		unsigned int s0 = RotateRight(a, 2) ^ RotateRight(a, 13) ^ RotateRight(a, 22);
+		unsigned int maj = (a & b) ^ (a & c) ^ (b & c);
+		unsigned int t2 = s0 + maj;
+		h = g; g = f; f = e; e = d + t1;
+		d = c; c = b; b = a; a = t1 + t2;
+	}
+
+	state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+	state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+}
+
+
+void TContentHash::add(const void* data, size_t size)
+{
+	const unsigned char* bytes = static_cast<const unsigned char*>(data);
+	totalSize += size;
+
+	if (bufferSize)
+	{
+		size_t n = size < 64 - bufferSize ? size : 64 - bufferSize;
+		memcpy(buffer + bufferSize, bytes, n);
+		bufferSize += n;
+		bytes += n;
+		size -= n;
+		if (bufferSize < 64)
+			return;
+		processBlock(buffer);
+		bufferSize = 0;
+	}
+
+	for (; size >= 64; bytes += 64, size -= 64)
+		processBlock(bytes);
+
+	memcpy(buffer, bytes, size);
+	bufferSize = size;
+}
+
+
+void TContentHash::addString(const char* s, size_t length)
+{
+	addInt(static_cast<long long>(length));
+	add(s, length);
+}
+
+
+void TContentHash::addInt(long long value)
+{
+	unsigned char bytes[8];
+	for (int i = 0; i < 8; ++i)
+		bytes[i] = static_cast<unsigned char>(static_cast<unsigned long long>(value) >> (i * 8));
+	add(bytes, sizeof(bytes));
+}
+
+
+std::string TContentHash::finish()
+{
+	const unsigned long long bitCount = totalSize * 8;
+
+	static const unsigned char kPadding[64] = { 0x80 };
+	add(kPadding, bufferSize < 56 ? 56 - bufferSize : 120 - bufferSize);
+
+	unsigned char length[8];
+	for (int i = 0; i < 8; ++i)
+		length[i] = static_cast<unsigned char>(bitCount >> ((7 - i) * 8));
+	add(length, sizeof(length));
+
+	static const char kHexDigits[] = "0123456789abcdef";
+	std::string hex;
+	hex.reserve(64);
+	for (int i = 0; i < 8; ++i)
+	{
+		for (int shift = 28; shift >= 0; shift -= 4)
+			hex += kHexDigits[(state[i] >> shift) & 0xf];
+	}
+	return hex;
+}
+
+} // namespace hlsl2glsl
@@ -0,0 +1,44 @@
+// Copyright (c) The HLSL2GLSLFork Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE.txt file.
+
+
+#ifndef _CONTENT_HASH_INCLUDED_
+#define _CONTENT_HASH_INCLUDED_
+
+#include <cstddef>
+#include <string>
+
+namespace hlsl2glsl
+{
+
+//
+// SHA-256 over a sequence of values, used to content-address compile results.
+// Strings are added with their length, so that different sequences of strings
+// never hash the same byte stream.
+//
+class TContentHash
+{
+public:
+	TContentHash();
+
+	void add(const void* data, size_t size);
+	void add(const std::string& s) { addString(s.data(), s.size()); }
+	void addString(const char* s, size_t length);
+	void addInt(long long value);
+
+	/// Finish the hash and return it as 64 lowercase hex digits. The hash cannot be added to afterwards.
+	std::string finish();
+
+private:
+	void processBlock(const unsigned char* block);
+
+	unsigned int state[8];
+	unsigned char buffer[64];
+	size_t bufferSize;
+	unsigned long long totalSize;
+};
+
+} // namespace hlsl2glsl
+
+#endif // _CONTENT_HASH_INCLUDED_
@@ -0,0 +1,211 @@
+// Copyright (c) The HLSL2GLSLFork Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE.txt file.
+
+
+//
+// Build time tool: parses the built-in prototypes once and writes the resulting
+// symbol tables out as C++ source, see BuiltInSymbols.h.
+//
+// usage: GenBuiltInSymbols <output.cpp>
+//
+
+#include "BuiltInSymbols.h"
+
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+
+using namespace hlsl2glsl;
+
+namespace {
+
+static const char* kLanguageNames[EShLangCount] = { "Vertex", "Fragment" };
+
+class TBuiltInWriter
+{
+public:
+	bool addLanguage(EShLanguage language, const TSymbolTable& symbolTable);
+	void write(std::ostream& out) const;
+
+private:
+	int addName(const TString& name);
+	static void writeType(std::ostream& out, const TType& type);
+
+	std::string names;
+	std::map<std::string, int> nameOffsets;
+
+	std::string functionTables[EShLangCount];
+	std::string parameterTables[EShLangCount];
+	int lastUniqueIds[EShLangCount];
+	int sameAs[EShLangCount];
+	int functionCounts[EShLangCount];
+};
+
+
+int TBuiltInWriter::addName(const TString& name)
+{
+	std::map<std::string, int>::const_iterator it = nameOffsets.find(name.c_str());
+	if (it != nameOffsets.end())
+		return it->second;
+
+	int offset = static_cast<int>(names.size());
+	nameOffsets[name.c_str()] = offset;
+	names += name.c_str();
+	names += '\0';
+	return offset;
+}
+
+
+void TBuiltInWriter::writeType(std::ostream& out, const TType& type)
+{
+	out << "{ " << type.getBasicType() << ", " << type.getPrecision() << ", " << type.getQualifier() << ", "
+		<< type.getColsCount() << ", " << type.getRowsCount() << ", " << (type.isMatrix() ? 1 : 0) << ", "
+		<< type.getLine().line << " }";
+}
+
+
+bool TBuiltInWriter::addLanguage(EShLanguage language, const TSymbolTable& symbolTable)
+{
+	std::ostringstream functions, parameters;
+	int functionCount = 0, parameterCount = 0;
+
+	// The level is keyed by atom pointers, so sort by mangled name to write the same file every time
+	const TSymbolTableLevel* level = symbolTable.getSharedBuiltInLevel();
+	std::map<std::string, const TSymbol*> symbols;
+	for (TSymbolTableLevel::const_iterator it = level->begin(); it != level->end(); ++it)
+		symbols[it->symbol->getMangledName().c_str()] = it->symbol;
+
+	for (std::map<std::string, const TSymbol*>::const_iterator it = symbols.begin(); it != symbols.end(); ++it)
+	{
+		if (!it->second->isFunction())
+		{
+			fprintf(stderr, "GenBuiltInSymbols: unsupported built-in symbol '%s'\n", it->second->getName().c_str());
+			return false;
+		}
+
+		const TFunction& function = *static_cast<const TFunction*>(it->second);
+		const TType& returnType = function.getReturnType();
+		if (returnType.getStruct() || returnType.isArray() || function.getInfo())
+		{
+			fprintf(stderr, "GenBuiltInSymbols: unsupported built-in function '%s'\n", function.getMangledName().c_str());
+			return false;
+		}
+
+		functions << "\t{ " << addName(function.getName()) << ", " << function.getUniqueId() << ", " << function.getBuiltInOp()
+			<< ", " << parameterCount << ", " << function.getParamCount() << ", ";
+		writeType(functions, returnType);
+		functions << " }, // " << function.getMangledName() << "\n";
+		++functionCount;
+
+		for (int i = 0; i < function.getParamCount(); ++i)
+		{
+			const TParameter& param = function[i];
+			if (param.type->getStruct() || param.type->isArray() || param.info)
+			{
+				fprintf(stderr, "GenBuiltInSymbols: unsupported parameter in built-in function '%s'\n", function.getMangledName().c_str());
+				return false;
+			}
+			parameters << "\t{ " << (param.name ? addName(*param.name) : -1) << ", ";
+			writeType(parameters, *param.type);
+			parameters << " },\n";
+			++parameterCount;
+		}
+	}
+
+	// Languages usually share all the built-ins, only write them out once then
+	functionTables[language] = functions.str();
+	parameterTables[language] = parameters.str();
+	sameAs[language] = language;
+	for (int l = 0; l < language; ++l)
+	{
+		if (sameAs[l] == l && functionTables[l] == functionTables[language] && parameterTables[l] == parameterTables[language])
+			sameAs[language] = l;
+	}
+	lastUniqueIds[language] = symbolTable.getUniqueId();
+	functionCounts[language] = functionCount;
+	return true;
+}
+
+
+void TBuiltInWriter::write(std::ostream& out) const
+{
+	out << "// Generated by GenBuiltInSymbols from the built-in prototypes in Initialize.cpp, do not edit.\n\n";
+	out << "#include \"BuiltInSymbols.h\"\n\n";
+	out << "namespace hlsl2glsl\n{\n\n";
+
+	out << "static const char kNames[] =\n";
+	for (size_t start = 0; start < names.size(); start = names.find('\0', start) + 1)
+		out << "\t\"" << names.c_str() + start << "\\0\"\n";
+	out << ";\n\n";
+
+	for (int l = 0; l < EShLangCount; ++l)
+	{
+		if (sameAs[l] != l)
+			continue;
+		out << "static const TBuiltInFunction k" << kLanguageNames[l] << "Functions[] = {\n" << functionTables[l] << "};\n\n";
+		out << "static const TBuiltInParameter k" << kLanguageNames[l] << "Parameters[] = {\n" << parameterTables[l] << "};\n\n";
+	}
+
+	out << "static const TBuiltInSymbolData kBuiltInSymbols[EShLangCount] = {\n";
+	for (int l = 0; l < EShLangCount; ++l)
+	{
+		const char* name = kLanguageNames[sameAs[l]];
+		out << "\t{ k" << name << "Functions, " << functionCounts[l] << ", k" << name << "Parameters, kNames, "
+			<< lastUniqueIds[l] << " }, // " << kLanguageNames[l] << "\n";
+	}
+	out << "};\n\n";
+
+	out << "const TBuiltInSymbolData* const PrebuiltBuiltInSymbols = kBuiltInSymbols;\n\n";
+	out << "} // namespace hlsl2glsl\n";
+}
+
+} // namespace
+
+
+int main(int argc, char** argv)
+{
+	if (argc != 2)
+	{
+		fprintf(stderr, "usage: %s <output.cpp>\n", argv[0]);
+		return 1;
+	}
+
+	if (!Hlsl2Glsl_Initialize())
+	{
+		fprintf(stderr, "GenBuiltInSymbols: failed to initialize\n");
+		return 1;
+	}
+
+	TBuiltInWriter writer;
+	bool success = true;
+	{
+		TInfoSink infoSink;
+		TSymbolTable symbolTables[EShLangCount];
+		if (!ParseBuiltInSymbolTables(symbolTables, infoSink))
+		{
+			fprintf(stderr, "GenBuiltInSymbols: failed to parse built-ins\n%s", infoSink.info.c_str());
+			success = false;
+		}
+
+		for (int l = 0; success && l < EShLangCount; ++l)
+			success = writer.addLanguage(static_cast<EShLanguage>(l), symbolTables[l]);
+	}
+
+	Hlsl2Glsl_Shutdown();
+
+	if (!success)
+		return 1;
+
+	std::ofstream out(argv[1], std::ios::binary);
+	writer.write(out);
+	if (!out)
+	{
+		fprintf(stderr, "GenBuiltInSymbols: cannot write %s\n", argv[1]);
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,374 @@
+// Copyright (c) The HLSL2GLSLFork Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE.txt file.
+
+
+//
+// Build time tool: finds a perfect hash for the keywords of the scanner and writes the
+// table and its lookup out as C++ source, see Keywords.h.
+//
+// usage: GenKeywords <output.cpp>
+//
+
+#include "Keywords.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace hlsl2glsl;
+
+namespace {
+
+static const unsigned int kBucketBits = 6;
+static const unsigned int kSlotBits = 8;
+static const unsigned int kMaxDisplacement = 1 << 16;
+
+struct TEntry
+{
+	std::string name;
+	std::string token;
+	const char* kind;
+	const char* basicType;
+	const char* precision;
+	int rows;
+	int cols;
+	bool matrix;
+};
+
+class TKeywordList
+{
+public:
+	TKeywordList();
+
+	bool findPositions();
+	bool findPerfectHash();
+	void write(std::ostream& out) const;
+
+private:
+	void add(const std::string& name, const std::string& token, const char* kind,
+		const char* basicType = "EbtVoid", const char* precision = "EbpUndefined", int rows = 0, int cols = 0, bool matrix = false);
+	void addType(const std::string& name, const std::string& token, const char* basicType, const char* precision,
+		int rows = 1, int cols = 1, bool matrix = false);
+	void addNumericTypes(const char* name, const char* scalarToken, const char* vectorToken, const char* matrixToken,
+		const char* basicType, const char* precision);
+
+	unsigned int hash(const std::string& name) const;
+	size_t countDistinct(const std::vector<int>& candidate) const;
+
+	std::vector<TEntry> entries;
+	std::vector<int> positions;               // of the characters the hash reads
+	std::vector<unsigned int> displacements;  // per bucket
+	std::vector<int> slots;                   // index into entries, -1 if empty
+};
+
+
+void TKeywordList::add(const std::string& name, const std::string& token, const char* kind,
+	const char* basicType, const char* precision, int rows, int cols, bool matrix)
+{
+	TEntry entry = { name, token, kind, basicType, precision, rows, cols, matrix };
+	entries.push_back(entry);
+}
+
+
+void TKeywordList::addType(const std::string& name, const std::string& token, const char* basicType, const char* precision,
+	int rows, int cols, bool matrix)
+{
+	add(name, token, "EKwType", basicType, precision, rows, cols, matrix);
+}
+
+
+// name, name1 to name4 and, given a matrix token, nameRxC for all the matrix sizes
+void TKeywordList::addNumericTypes(const char* name, const char* scalarToken, const char* vectorToken, const char* matrixToken,
+	const char* basicType, const char* precision)
+{
+	const std::string base = name;
+	addType(base, scalarToken, basicType, precision);
+	addType(base + "1", scalarToken, basicType, precision);
+	for (int size = 2; size <= 4; ++size)
+		addType(base + std::to_string(size), vectorToken + std::to_string(size), basicType, precision, 1, size);
+
+	if (!matrixToken)
+		return;
+	for (int rows = 2; rows <= 4; ++rows)
+	{
+		for (int cols = 2; cols <= 4; ++cols)
+		{
+			const std::string shape = std::to_string(rows) + "x" + std::to_string(cols);
+			addType(base + shape, matrixToken + shape, basicType, precision, rows, cols, true);
+		}
+	}
+}
+
+
+TKeywordList::TKeywordList()
+{
+	add("const", "CONST_QUAL", "EKwPlain");
+	add("static", "STATIC_QUAL", "EKwPlain");
+	add("uniform", "UNIFORM", "EKwPlain");
+	add("break", "BREAK", "EKwPlain");
+	add("continue", "CONTINUE", "EKwPlain");
+	add("do", "DO", "EKwPlain");
+	add("for", "FOR", "EKwPlain");
+	add("while", "WHILE", "EKwPlain");
+	add("if", "IF", "EKwPlain");
+	add("else", "ELSE", "EKwPlain");
+	add("in", "IN_QUAL", "EKwPlain");
+	add("out", "OUT_QUAL", "EKwPlain");
+	add("inout", "INOUT_QUAL", "EKwPlain");
+	add("discard", "DISCARD", "EKwPlain");
+	add("return", "RETURN", "EKwPlain");
+	add("struct", "STRUCT", "EKwPlain");
+	add("true", "BOOLCONSTANT", "EKwTrue");
+	add("false", "BOOLCONSTANT", "EKwFalse");
+
+	addNumericTypes("float", "FLOAT_TYPE", "VEC", "MATRIX", "EbtFloat", "EbpHigh");
+	addNumericTypes("half", "HALF_TYPE", "HVEC", "HMATRIX", "EbtFloat", "EbpMedium");
+	addNumericTypes("fixed", "FIXED_TYPE", "FVEC", "FMATRIX", "EbtFloat", "EbpLow");
+	addNumericTypes("int", "INT_TYPE", "IVEC", NULL, "EbtInt", "EbpHigh");
+	addNumericTypes("uint", "INT_TYPE", "IVEC", NULL, "EbtInt", "EbpHigh"); // @TODO proper unsigned types?
+	addNumericTypes("bool", "BOOL_TYPE", "BVEC", NULL, "EbtBool", "EbpHigh");
+
+	addType("void", "VOID_TYPE", "EbtVoid", "EbpUndefined");
+	addType("string", "STRING_TYPE", "EbtVoid", "EbpUndefined");
+	addType("vector", "VECTOR", "EbtVoid", "EbpUndefined");
+	addType("matrix", "MATRIX", "EbtVoid", "EbpUndefined");
+	addType("register", "REGISTER", "EbtVoid", "EbpUndefined");
+
+	// ES3 doesn't have default precision for shadow samplers, so these are always lowp
+	addType("sampler", "SAMPLERGENERIC", "EbtSamplerGeneric", "EbpUndefined");
+	addType("sampler1D", "SAMPLER1D", "EbtSampler1D", "EbpUndefined");
+	addType("sampler1DShadow", "SAMPLER1DSHADOW", "EbtSampler1DShadow", "EbpLow");
+	addType("sampler2D", "SAMPLER2D", "EbtSampler2D", "EbpUndefined");
+	addType("sampler2DShadow", "SAMPLER2DSHADOW", "EbtSampler2DShadow", "EbpLow");
+	addType("sampler2DArray", "SAMPLER2DARRAY", "EbtSampler2DArray", "EbpLow");
+	addType("sampler2D_half", "SAMPLER2D_HALF", "EbtSampler2D", "EbpMedium");
+	addType("sampler2D_float", "SAMPLER2D_FLOAT", "EbtSampler2D", "EbpHigh");
+	addType("sampler3D", "SAMPLER3D", "EbtSampler3D", "EbpLow");
+	addType("samplerRECT", "SAMPLERRECT", "EbtSamplerRect", "EbpUndefined");
+	addType("samplerRECTShadow", "SAMPLERRECTSHADOW", "EbtSamplerRectShadow", "EbpLow");
+	addType("samplerCUBE", "SAMPLERCUBE", "EbtSamplerCube", "EbpUndefined");
+	addType("samplerCUBE_half", "SAMPLERCUBE_HALF", "EbtSamplerCube", "EbpMedium");
+	addType("samplerCUBE_float", "SAMPLERCUBE_FLOAT", "EbtSamplerCube", "EbpHigh");
+	addType("texture", "TEXTURE", "EbtTexture", "EbpUndefined");
+	addType("texture2D", "TEXTURE", "EbtTexture", "EbpUndefined");
+	addType("texture3D", "TEXTURE", "EbtTexture", "EbpUndefined");
+	addType("textureRECT", "TEXTURE", "EbtTexture", "EbpUndefined");
+	addType("textureCUBE", "TEXTURE", "EbtTexture", "EbpUndefined");
+	addType("sampler_state", "SAMPLERSTATE", "EbtVoid", "EbpUndefined");
+
+	add("inline", "0", "EKwIgnored");
+	add("noinline", "0", "EKwIgnored");
+
+	static const char* reserved[] = {
+		"asm", "class", "union", "enum", "typedef", "template", "this", "packed",
+		"goto", "switch", "default",
+		"volatile", "public", "extern", "external", "interface",
+		"long", "short", "double", "unsigned", "sampler3DRect",
+		"sizeof", "cast", "namespace", "using",
+	};
+	for (size_t i = 0; i < sizeof(reserved) / sizeof(reserved[0]); ++i)
+		add(reserved[i], "0", "EKwReserved");
+}
+
+
+unsigned int TKeywordList::hash(const std::string& name) const
+{
+	unsigned int h = KeywordMix(2166136261u, static_cast<unsigned int>(name.size()));
+	for (size_t p = 0; p < positions.size(); ++p)
+		h = KeywordMix(h, KeywordChar(name.c_str(), name.size(), positions[p]));
+	return h;
+}
+
+
+// How many keywords the length and the characters at candidate tell apart
+size_t TKeywordList::countDistinct(const std::vector<int>& candidate) const
+{
+	std::set<std::string> keys;
+	for (size_t i = 0; i < entries.size(); ++i)
+	{
+		const std::string& name = entries[i].name;
+		std::string key(1, static_cast<char>(name.size()));
+		for (size_t p = 0; p < candidate.size(); ++p)
+			key += static_cast<char>(KeywordChar(name.c_str(), name.size(), candidate[p]));
+		keys.insert(key);
+	}
+	return keys.size();
+}
+
+
+// Like gperf, pick character positions one at a time, each the one that tells the most
+// keywords apart, until the length and those characters tell all of them apart
+bool TKeywordList::findPositions()
+{
+	size_t maxLength = 0;
+	std::set<std::string> names;
+	for (size_t i = 0; i < entries.size(); ++i)
+	{
+		if (!names.insert(entries[i].name).second)
+		{
+			fprintf(stderr, "GenKeywords: duplicate keyword '%s'\n", entries[i].name.c_str());
+			return false;
+		}
+		maxLength = std::max(maxLength, entries[i].name.size());
+	}
+
+	size_t distinct = countDistinct(positions);
+	while (distinct < entries.size())
+	{
+		std::vector<int> best;
+		size_t bestDistinct = distinct;
+		for (int position = -static_cast<int>(maxLength); position < static_cast<int>(maxLength); ++position)
+		{
+			std::vector<int> candidate = positions;
+			candidate.push_back(position);
+			const size_t candidateDistinct = countDistinct(candidate);
+			if (candidateDistinct > bestDistinct)
+			{
+				best = candidate;
+				bestDistinct = candidateDistinct;
+			}
+		}
+		if (best.empty())
+		{
+			fprintf(stderr, "GenKeywords: no character positions tell all keywords apart\n");
+			return false;
+		}
+		positions = best;
+		distinct = bestDistinct;
+	}
+	return true;
+}
+
+
+// Hash and displace: the largest buckets go first, each takes the first displacement that
+// puts all its names into free slots
+bool TKeywordList::findPerfectHash()
+{
+	if (entries.size() >= 255)
+	{
+		fprintf(stderr, "GenKeywords: too many keywords for the slot table\n");
+		return false;
+	}
+
+	std::vector<std::vector<int> > buckets(1 << kBucketBits);
+	for (size_t i = 0; i < entries.size(); ++i)
+		buckets[hash(entries[i].name) & ((1 << kBucketBits) - 1)].push_back(static_cast<int>(i));
+
+	std::vector<int> order(buckets.size());
+	for (size_t b = 0; b < buckets.size(); ++b)
+		order[b] = static_cast<int>(b);
+	std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return buckets[a].size() > buckets[b].size(); });
+
+	displacements.assign(buckets.size(), 0);
+	slots.assign(1 << kSlotBits, -1);
+	for (size_t o = 0; o < order.size(); ++o)
+	{
+		const std::vector<int>& bucket = buckets[order[o]];
+		if (bucket.empty())
+			break;
+
+		bool placed = false;
+		for (unsigned int displacement = 0; !placed && displacement < kMaxDisplacement; ++displacement)
+		{
+			std::vector<unsigned int> taken;
+			placed = true;
+			for (size_t k = 0; placed && k < bucket.size(); ++k)
+			{
+				const unsigned int slot = KeywordSlot(hash(entries[bucket[k]].name), displacement, kSlotBits);
+				placed = slots[slot] < 0 && std::find(taken.begin(), taken.end(), slot) == taken.end();
+				taken.push_back(slot);
+			}
+			if (!placed)
+				continue;
+
+			displacements[order[o]] = displacement;
+			for (size_t k = 0; k < bucket.size(); ++k)
+				slots[taken[k]] = bucket[k];
+		}
+		if (!placed)
+		{
+			fprintf(stderr, "GenKeywords: no perfect hash for the keywords, the table needs more slots\n");
+			return false;
+		}
+	}
+	return true;
+}
+
+
+void TKeywordList::write(std::ostream& out) const
+{
+	size_t maxLength = 0;
+	for (size_t i = 0; i < entries.size(); ++i)
+		maxLength = std::max(maxLength, entries[i].name.size());
+
+	out << "// Generated by GenKeywords from the keyword list in GenKeywords.cpp, do not edit.\n\n";
+	out << "#include \"ParseHelper.h\"\n";
+	out << "#include \"Keywords.h\"\n";
+	out << "#include \"hlslang_tab.h\"\n\n";
+	out << "#include <cstring>\n\n";
+	out << "namespace hlsl2glsl\n{\n\n";
+
+	out << "static const TKeyword kKeywords[] = {\n";
+	for (size_t i = 0; i < entries.size(); ++i)
+	{
+		const TEntry& entry = entries[i];
+		out << "\t{ \"" << entry.name << "\", " << entry.name.size() << ", " << entry.token << ", " << entry.kind << ", "
+			<< entry.basicType << ", " << entry.precision << ", " << entry.rows << ", " << entry.cols << ", "
+			<< (entry.matrix ? "true" : "false") << " },\n";
+	}
+	out << "};\n\n";
+
+	out << "static const unsigned short kBucketDisplacements[" << displacements.size() << "] = {";
+	for (size_t b = 0; b < displacements.size(); ++b)
+		out << (b % 16 ? " " : "\n\t") << displacements[b] << ",";
+	out << "\n};\n\n";
+
+	out << "// Index into kKeywords plus one, 0 for empty slots\n";
+	out << "static const unsigned char kSlots[" << slots.size() << "] = {";
+	for (size_t s = 0; s < slots.size(); ++s)
+		out << (s % 16 ? " " : "\n\t") << slots[s] + 1 << ",";
+	out << "\n};\n\n";
+
+	out << "const TKeyword* FindKeyword(const char* name, size_t length)\n{\n";
+	out << "\tif (length > " << maxLength << ")\n\t\treturn NULL;\n\n";
+	out << "\tunsigned int hash = KeywordMix(2166136261u, static_cast<unsigned int>(length));\n";
+	for (size_t p = 0; p < positions.size(); ++p)
+		out << "\thash = KeywordMix(hash, KeywordChar(name, length, " << positions[p] << "));\n";
+	out << "\tconst unsigned int displacement = kBucketDisplacements[hash & " << (1 << kBucketBits) - 1 << "];\n";
+	out << "\tconst unsigned int slot = kSlots[KeywordSlot(hash, displacement, " << kSlotBits << ")];\n";
+	out << "\tif (!slot)\n\t\treturn NULL;\n\n";
+	out << "\tconst TKeyword* keyword = &kKeywords[slot - 1];\n";
+	out << "\treturn keyword->length == length && memcmp(keyword->name, name, length) == 0 ? keyword : NULL;\n";
+	out << "}\n\n";
+	out << "} // namespace hlsl2glsl\n";
+}
+
+} // namespace
+
+
+int main(int argc, char** argv)
+{
+	if (argc != 2)
+	{
+		fprintf(stderr, "usage: %s <output.cpp>\n", argv[0]);
+		return 1;
+	}
+
+	TKeywordList keywords;
+	if (!keywords.findPositions() || !keywords.findPerfectHash())
+		return 1;
+
+	std::ofstream out(argv[1], std::ios::binary);
+	keywords.write(out);
+	if (!out)
+	{
+		fprintf(stderr, "GenKeywords: cannot write %s\n", argv[1]);
+		return 1;
+	}
+
+	return 0;
+}
@@ -9,6 +9,12 @@
 
 #include "../../include/hlsl2glsl.h"
 #include "Initialize.h"
+#include "BuiltInSymbols.h"
+#include "CompileCache.h"
+#include "ContentHash.h"
+#include "IncludeCache.h"
+#include "ThreadPool.h"
+#include "TypeTable.h"
 #include "../GLSLCodeGen/hlslSupportLib.h"
 
 #include "../GLSLCodeGen/hlslCrossCompiler.h"
@@ -18,6 +24,9 @@
 #include "../Include/InitializeParseContext.h"
 
 #include <atomic>
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
 
 using namespace hlsl2glsl;
 
@@ -75,9 +84,12 @@ static bool DetachThread()
 
 
 // A symbol table for each language.  Each has a different set of built-ins, and we want to preserve that
-// from compile to compile.
+// from compile to compile. Only level 0 (the frozen built-ins) is used, which every parse shares.
 TSymbolTable SymbolTables[EShLangCount];
 
+// Guards setting up and tearing down the shared built-ins; reading them needs no locking
+std::mutex SharedStateMutex;
+
 
 // Global pool allocator (per process)
 std::shared_ptr<TPoolAllocator> PerProcessGPA;
@@ -92,19 +104,12 @@ std::shared_ptr<TPoolAllocator> PerProcessGPA;
 ///      Information sink (for errors/warnings)
 /// \param symbolTables
 ///      Array of symbol tables (one for each language)
-/// \param bUseGlobalSymbolTable
-///      Whether to use the global symbol table or the per-language symbol table
 /// \return
 ///      True if succesfully initialized, false otherwise
 static bool InitializeSymbolTable( TBuiltInStrings* BuiltInStrings, EShLanguage language, TInfoSink& infoSink, 
-                            TSymbolTable* symbolTables, bool bUseGlobalSymbolTable )
+                            TSymbolTable* symbolTables )
 {
-   TSymbolTable* symbolTable;
-
-   if ( bUseGlobalSymbolTable )
-      symbolTable = symbolTables;
-   else
-      symbolTable = &symbolTables[language];
+   TSymbolTable* symbolTable = &symbolTables[language];
 
 	//@TODO: for now, we use same global symbol table for all target language versions.
 	// This is wrong and will have to be changed at some point.
@@ -115,7 +120,7 @@ static bool InitializeSymbolTable( TBuiltInStrings* BuiltInStrings, EShLanguage
 
    setInitialState();
 
-   assert(symbolTable->isEmpty() || symbolTable->atSharedBuiltInLevel());
+   assert(symbolTable->isEmpty());
 
    //
    // Parse the built-ins.  This should only happen once per
@@ -141,46 +146,22 @@ static bool InitializeSymbolTable( TBuiltInStrings* BuiltInStrings, EShLanguage
       }
    }
 
-   if (  !bUseGlobalSymbolTable )
-   {
-      IdentifyBuiltIns(parseContext.language, *symbolTable);
-   }
+   IdentifyBuiltIns(parseContext.language, *symbolTable);
 
    return true;
 }
 
+} // namespace
 
-/// Generate the built in symbol table
-/// \param infoSink
-///      Information sink (for errors/warnings)
-/// \param symbolTables
-///      Array of symbol tables (one for each language)
-/// \param bUseGlobalSymbolTable
-///      Whether to use the global symbol table or the per-language symbol table
-/// \param language
-///      Shading language to build symbol table for
-/// \return
-///      True if succesfully built, false otherwise
-static bool GenerateBuiltInSymbolTable(TInfoSink& infoSink, TSymbolTable* symbolTables, EShLanguage language)
+bool hlsl2glsl::ParseBuiltInSymbolTables(TSymbolTable* symbolTables, TInfoSink& infoSink)
 {
    TBuiltIns builtIns;
-
-   if ( language != EShLangCount )
-   {      
-      InitializeSymbolTable(builtIns.getBuiltInStrings(), language, infoSink, symbolTables, true);
-   }
-   else
-   {
-      builtIns.initialize();
-      InitializeSymbolTable(builtIns.getBuiltInStrings(), EShLangVertex, infoSink, symbolTables, false);
-      InitializeSymbolTable(builtIns.getBuiltInStrings(), EShLangFragment, infoSink, symbolTables, false);
-   }
-
-   return true;
+   builtIns.initialize();
+   bool success = InitializeSymbolTable(builtIns.getBuiltInStrings(), EShLangVertex, infoSink, symbolTables);
+   success = InitializeSymbolTable(builtIns.getBuiltInStrings(), EShLangFragment, infoSink, symbolTables) && success;
+   return success;
 }
 
-} // namespace
-
 int C_DECL Hlsl2Glsl_Initialize()
 {
    TInfoSink infoSink;
@@ -188,7 +169,23 @@ int C_DECL Hlsl2Glsl_Initialize()
    if (!InitProcess())
       return 0;
 
-   if (!PerProcessGPA)
+   std::lock_guard<std::mutex> lock(SharedStateMutex);
+
+   if (!PerProcessGPA && PrebuiltBuiltInSymbols)
+   {
+      // Built-ins were generated at build time, just load them
+      PerProcessGPA = std::make_shared<TPoolAllocator>();
+      PerProcessGPA->push();
+      auto gPoolAllocator = SetGlobalPoolAllocator(PerProcessGPA);
+
+      LoadBuiltInSymbolTable(PrebuiltBuiltInSymbols[EShLangVertex], SymbolTables[EShLangVertex]);
+      LoadBuiltInSymbolTable(PrebuiltBuiltInSymbols[EShLangFragment], SymbolTables[EShLangFragment]);
+      SymbolTables[EShLangVertex].freezeBuiltIns();
+      SymbolTables[EShLangFragment].freezeBuiltIns();
+
+      SetGlobalPoolAllocator(gPoolAllocator);
+   }
+   else if (!PerProcessGPA)
    {
       auto builtInPoolAllocator = std::make_shared<TPoolAllocator>();
       builtInPoolAllocator->push();
@@ -196,7 +193,7 @@ int C_DECL Hlsl2Glsl_Initialize()
    	  auto gPoolAllocator = SetGlobalPoolAllocator(builtInPoolAllocator);
 
       TSymbolTable symTables[EShLangCount];
-      GenerateBuiltInSymbolTable(infoSink, symTables, EShLangCount);
+      ParseBuiltInSymbolTables(symTables, infoSink);
 
       PerProcessGPA = std::make_shared<TPoolAllocator>();
       PerProcessGPA->push();
@@ -204,6 +201,8 @@ int C_DECL Hlsl2Glsl_Initialize()
 
       SymbolTables[EShLangVertex].copyTable(symTables[EShLangVertex]);
       SymbolTables[EShLangFragment].copyTable(symTables[EShLangFragment]);
+      SymbolTables[EShLangVertex].freezeBuiltIns();
+      SymbolTables[EShLangFragment].freezeBuiltIns();
 
       SetGlobalPoolAllocator(gPoolAllocator);
 
@@ -219,6 +218,7 @@ int C_DECL Hlsl2Glsl_Initialize()
 
 void C_DECL Hlsl2Glsl_Shutdown()
 {
+	std::unique_lock<std::mutex> lock(SharedStateMutex);
 	if (PerProcessGPA)
 	{
 		SymbolTables[EShLangVertex].pop();
@@ -227,6 +227,7 @@ void C_DECL Hlsl2Glsl_Shutdown()
 		PerProcessGPA->popAll();
 		PerProcessGPA.reset();
 	}
+	lock.unlock();
 	
 	DetachThread();
 }
@@ -254,31 +255,52 @@ void C_DECL Hlsl2Glsl_DestructCompiler( ShHandle handle )
    delete handle;
 }
 
-int C_DECL Hlsl2Glsl_Parse(
-	const ShHandle handle,
+namespace {
+
+// Makes the compiler's pool and type table the current ones for the duration of a call,
+// so that the syntax tree can outlive it
+class TASTPoolScope
+{
+public:
+	explicit TASTPoolScope(HlslCrossCompiler* compiler)
+	: previous(SetGlobalPoolAllocator(compiler->GetASTPool()))
+	, previousTypes(SetGlobalTypeTable(&compiler->GetASTTypes()))
+	{
+	}
+	~TASTPoolScope()
+	{
+		SetGlobalTypeTable(previousTypes);
+		SetGlobalPoolAllocator(previous);
+	}
+
+private:
+	std::shared_ptr<TPoolAllocator> previous;
+	TTypeTable* previousTypes;
+};
+
+
+static bool ParseShader(
+	HlslCrossCompiler* compiler,
 	const char* shaderString,
 	ETargetVersion targetVersion,
 	Hlsl2Glsl_ParseCallbacks* callbacks,
-	unsigned options)
+	unsigned options,
+	const std::shared_ptr<const TPreprocessedSource>& preprocessed)
 {
-   if (!InitThread())
-      return 0;
-
-   if (handle == 0)
-      return 0;
-
-   HlslCrossCompiler* compiler = handle;
+   compiler->ReleaseAST();
 
+   TASTPoolScope poolScope(compiler);
    GlobalPoolAllocator.push();
    compiler->infoSink.info.erase();
    compiler->infoSink.debug.erase();
 
    if (!shaderString)
-	   return 1;
+	   return true;
+   ++compiler->parseCount;
 
+   // Shares the frozen built-in level, and adds an empty level for per-shader built-ins
    TSymbolTable symbolTable(SymbolTables[compiler->getLanguage()]);
-
-   GenerateBuiltInSymbolTable(compiler->infoSink, &symbolTable, compiler->getLanguage());
+   symbolTable.push();
 
    TParseContext parseContext(symbolTable, compiler->getLanguage(), targetVersion, options, compiler->infoSink);
 
@@ -298,7 +320,23 @@ int C_DECL Hlsl2Glsl_Parse(
       parseContext.infoSink.info.message(EPrefixInternalError, "Wrong symbol table level");
 
 
-   int ret = PaParseString(const_cast<char*>(shaderString), parseContext, callbacks);
+   // Shaders that can include files get preprocessed up front, so that parsing them again
+   // for other targets reads the same tokens and never calls back into the application
+   std::shared_ptr<const TPreprocessedSource> tokens = preprocessed;
+   if (!tokens && callbacks)
+   {
+      std::shared_ptr<TPreprocessedSource> recorded = std::make_shared<TPreprocessedSource>();
+      PaPreprocessString(shaderString, callbacks, compiler->GetIncludeCache(), NULL, 0, *recorded);
+      tokens = recorded;
+   }
+
+   // Without callbacks nothing can be included
+   compiler->dependencies.clear();
+   if ((options & ETranslateOpRecordDependencies) && tokens)
+      compiler->dependencies = tokens->dependencies;
+   int ret = tokens ?
+      PaParsePreprocessed(*tokens, parseContext) :
+      PaParseString(const_cast<char*>(shaderString), parseContext);
    if (ret)
       success = false;
 
@@ -313,6 +351,10 @@ int C_DECL Hlsl2Glsl_Parse(
 
 		compiler->TransformAST (parseContext.treeRoot);
 		compiler->ProduceGLSL (parseContext.treeRoot, targetVersion, options);
+
+		// Keep the tree in the compiler's pool, for other target versions
+		compiler->KeepSource (shaderString, options, tokens);
+		compiler->KeepAST (parseContext.treeRoot, targetVersion, parseContext.targetDependent);
    }
    else if (!success)
    {
@@ -328,7 +370,9 @@ int C_DECL Hlsl2Glsl_Parse(
 			ir_output_tree(parseContext.treeRoot, parseContext.infoSink);
    }
 
-	ir_remove_tree(parseContext.treeRoot);
+   const bool keepTree = success && parseContext.treeRoot;
+   if (!keepTree)
+		ir_remove_tree(parseContext.treeRoot);
 
    //
    // Ensure symbol table is returned to the built-in level,
@@ -338,11 +382,34 @@ int C_DECL Hlsl2Glsl_Parse(
       symbolTable.pop();
 
    //
-   // Throw away all the temporary memory used by the compilation process.
+   // Without a tree to keep, throw away all the temporary memory used by the compilation process.
    //
-   GlobalPoolAllocator.pop();
+   if (!keepTree)
+   {
+      compiler->GetASTTypes().clear();
+      GlobalPoolAllocator.pop();
+   }
 
-   return success ? 1 : 0;
+   return success;
+}
+
+} // namespace
+
+
+int C_DECL Hlsl2Glsl_Parse(
+	const ShHandle handle,
+	const char* shaderString,
+	ETargetVersion targetVersion,
+	Hlsl2Glsl_ParseCallbacks* callbacks,
+	unsigned options)
+{
+   if (!InitThread())
+      return 0;
+
+   if (handle == 0)
+      return 0;
+
+   return ParseShader(handle, shaderString, targetVersion, callbacks, options, nullptr) ? 1 : 0;
 }
 
 
@@ -358,18 +425,50 @@ int C_DECL Hlsl2Glsl_Translate(
    HlslCrossCompiler* compiler = handle;
    compiler->infoSink.info.erase();
 
-   // \todo [2013-05-14 pyry] Maintain different support library per target version.
-   initializeHLSLSupportLibrary(targetVersion);
-
-	if (!compiler->IsASTTransformed() || !compiler->IsGlslProduced())
+	// A compile restored from the compile cache has no tree, only the tokens to parse one from
+	const bool parsed = compiler->IsASTTransformed() && compiler->IsGlslProduced();
+	if (!parsed && !compiler->GetPreprocessed())
 	{
 		compiler->infoSink.info.message(EPrefixError, "Shader does not have valid object code.");
 		return 0;
 	}
 
-   bool ret = compiler->GetLinker()->link(compiler, entry, targetVersion, options);
+	// Parsed for another target, or not parsed here at all: produce GLSL again
+	// from the kept tree if it fits, or else parse the kept source again
+	if (!parsed || compiler->GetGlslVersion() != targetVersion)
+	{
+		if (!InitThread())
+			return 0;
+
+		if (compiler->CanReuseAST(targetVersion))
+		{
+			TASTPoolScope poolScope(compiler);
+			compiler->ReproduceGLSL(targetVersion);
+		}
+		else
+		{
+			// Kept tokens for shaders that had includes, the source is complete otherwise
+			const std::string source = compiler->GetSource();
+			const std::shared_ptr<const TPreprocessedSource> preprocessed = compiler->GetPreprocessed();
+			const ETargetVersion keptVersion = compiler->GetGlslVersion();
+			const unsigned parseOptions = compiler->GetParseOptions();
+			if (!ParseShader(compiler, source.c_str(), targetVersion, 0, parseOptions, preprocessed))
+			{
+				// Stay usable for the targets that worked, reporting the errors of this one
+				const std::string errors = compiler->infoSink.info.c_str();
+				if (parsed)
+					ParseShader(compiler, source.c_str(), keptVersion, 0, parseOptions, preprocessed);
+				else
+					compiler->KeepSource(source.c_str(), parseOptions, preprocessed);
+				compiler->infoSink.info.erase();
+				compiler->infoSink.info << errors.c_str();
+				return 0;
+			}
+		}
+		compiler->infoSink.info.erase();
+	}
 
-   finalizeHLSLSupportLibrary();
+   bool ret = compiler->GetLinker()->link(compiler, entry, targetVersion, options);
 
    return ret ? 1 : 0;
 }
@@ -383,6 +482,13 @@ const char* C_DECL Hlsl2Glsl_GetShader( const ShHandle handle )
 }
 
 
+int C_DECL Hlsl2Glsl_GetParseCount( const ShHandle handle )
+{
+   if (handle == 0)
+      return 0;
+   return static_cast<HlslCrossCompiler*>(handle)->parseCount;
+}
+
 const char* C_DECL Hlsl2Glsl_GetInfoLog( const ShHandle handle )
 {
    if (!InitThread())
@@ -439,6 +545,660 @@ int C_DECL Hlsl2Glsl_SetUserAttributeNames ( ShHandle handle,
 }
 
 
+ShCacheHandle C_DECL Hlsl2Glsl_ConstructMemoryCache( size_t maxBytes )
+{
+	return NewMemoryCompileCache(maxBytes);
+}
+
+ShCacheHandle C_DECL Hlsl2Glsl_ConstructDirectoryCache( const char* path )
+{
+	if (!path)
+		return 0;
+	return NewDirectoryCompileCache(path);
+}
+
+ShCacheHandle C_DECL Hlsl2Glsl_ConstructCallbackCache( const Hlsl2Glsl_CacheCallbacks* callbacks )
+{
+	if (!callbacks)
+		return 0;
+	return NewCallbackCompileCache(*callbacks);
+}
+
+void C_DECL Hlsl2Glsl_DestructCache( ShCacheHandle cache )
+{
+	delete cache;
+}
+
+
+namespace {
+
+// Bump whenever the generated code or the entry format changes, so that old entries miss
+const char kCompileCacheVersion[] = "hlsl2glsl compile 1";
+
+static void HashPreprocessedSource(const TPreprocessedSource& source, TContentHash& hash)
+{
+	const unsigned int noFile = ~0u;
+	unsigned int file = noFile;
+	for (std::vector<TPreprocessedToken>::const_iterator it = source.tokens.begin(); it != source.tokens.end(); ++it)
+	{
+		// File names only change at include boundaries, -1 can't be a line number
+		if (it->file != file)
+		{
+			file = it->file;
+			hash.addInt(-1);
+			hash.add(source.files[file]);
+		}
+		hash.addInt(it->line);
+		hash.addString(source.text.c_str() + it->offset, it->length);
+	}
+	hash.addInt(-2);
+}
+
+// Only for sources that preprocessed without errors
+static void ComputeCompileCacheKey(HlslCrossCompiler* compiler, const TPreprocessedSource& source, const char* entry,
+	ETargetVersion targetVersion, unsigned options, std::string& key)
+{
+	TContentHash hash;
+	hash.addString(kCompileCacheVersion, sizeof(kCompileCacheVersion) - 1);
+	HashPreprocessedSource(source, hash);
+
+	hash.addInt(compiler->getLanguage());
+	hash.addString(entry, strlen(entry));
+	hash.addInt(targetVersion);
+	hash.addInt(options);
+
+	const TPrefixTable& prefixes = compiler->getPrefixTable();
+	hash.add(prefixes.prefixAttrib);
+	hash.add(prefixes.prefixLinker);
+	hash.add(prefixes.prefixTemp);
+	hash.add(prefixes.prefixUniform);
+	hash.add(prefixes.prefixVarying);
+	hash.add(prefixes.identBuiltinVar);
+	hash.add(prefixes.identMainFn);
+	hash.add(prefixes.identMutable);
+	hash.add(prefixes.identRetval);
+	hash.add(prefixes.identSwizTemp);
+
+	for (int i = 0; i < EAttrSemCount; ++i)
+	{
+		const char* name = compiler->GetLinker()->getUserAttribName(static_cast<EAttribSemantic>(i));
+		hash.addString(name, strlen(name));
+	}
+
+	key = hash.finish();
+}
+
+static char* CopyCString(const std::string& s)
+{
+	char* copy = new char[s.size() + 1];
+	memcpy(copy, s.c_str(), s.size() + 1);
+	return copy;
+}
+
+static void SaveCachedCompile(HlslCrossCompiler* compiler, bool success, TCachedCompile& compile)
+{
+	HlslLinker* linker = compiler->GetLinker();
+
+	compile.success = success;
+	compile.shaderText = linker->getShaderText();
+	compile.infoLog = compiler->infoSink.info.c_str();
+	compile.infoLog += compiler->infoSink.debug.c_str();
+
+	const ShUniformInfo* uniforms = linker->getUniformInfo();
+	for (int i = 0; i < linker->getUniformCount(); ++i)
+	{
+		TCachedUniform uniform;
+		uniform.name = uniforms[i].name;
+		uniform.hasSemantic = uniforms[i].semantic != 0;
+		uniform.semantic = uniform.hasSemantic ? uniforms[i].semantic : "";
+		uniform.hasRegisterSpec = uniforms[i].registerSpec != 0;
+		uniform.registerSpec = uniform.hasRegisterSpec ? uniforms[i].registerSpec : "";
+		uniform.type = uniforms[i].type;
+		uniform.arraySize = uniforms[i].arraySize;
+		compile.uniforms.push_back(uniform);
+	}
+}
+
+// The includes of a hit are those of source, which preprocessed to the same tokens as the
+// compile that was stored. Whatever the compiler parsed before is dropped; there is no tree,
+// a Hlsl2Glsl_Translate parses one from the tokens.
+static void RestoreCachedCompile(HlslCrossCompiler* compiler, const TCachedCompile& compile,
+	const std::shared_ptr<const TPreprocessedSource>& source, unsigned options)
+{
+	compiler->ReleaseAST();
+	if (compile.success)
+		compiler->KeepSource("", options, source);
+
+	compiler->infoSink.info.erase();
+	compiler->infoSink.debug.erase();
+	compiler->infoSink.info << compile.infoLog;
+
+	compiler->dependencies.clear();
+	if (options & ETranslateOpRecordDependencies)
+		compiler->dependencies = source->dependencies;
+
+	std::vector<ShUniformInfo> uniforms;
+	for (std::vector<TCachedUniform>::const_iterator it = compile.uniforms.begin(); it != compile.uniforms.end(); ++it)
+	{
+		ShUniformInfo info;
+		info.name = CopyCString(it->name);
+		info.semantic = it->hasSemantic ? CopyCString(it->semantic) : 0;
+		info.registerSpec = it->hasRegisterSpec ? CopyCString(it->registerSpec) : 0;
+		info.type = static_cast<EShType>(it->type);
+		info.arraySize = it->arraySize;
+		info.init = 0;
+		uniforms.push_back(info);
+	}
+	compiler->GetLinker()->setLinkedOutput(compile.shaderText, uniforms);
+}
+
+} // namespace
+
+
+int C_DECL Hlsl2Glsl_CompileCached(
+	const ShHandle handle,
+	ShCacheHandle cache,
+	const char* shaderString,
+	const char* entry,
+	ETargetVersion targetVersion,
+	Hlsl2Glsl_ParseCallbacks* callbacks,
+	unsigned options)
+{
+	if (!InitThread())
+		return 0;
+
+	if (handle == 0)
+		return 0;
+
+	if (!cache || !shaderString || !entry)
+	{
+		return (Hlsl2Glsl_Parse(handle, shaderString, targetVersion, callbacks, options) &&
+			Hlsl2Glsl_Translate(handle, entry, targetVersion, options)) ? 1 : 0;
+	}
+
+	// The tokens give the key, and are what gets parsed on a miss; tokens that stop at an
+	// error parse to that error, without the cache
+	std::shared_ptr<TPreprocessedSource> preprocessed = std::make_shared<TPreprocessedSource>();
+	if (!PaPreprocessString(shaderString, callbacks, handle->GetIncludeCache(), NULL, 0, *preprocessed))
+	{
+		return (ParseShader(handle, shaderString, targetVersion, callbacks, options, preprocessed) &&
+			Hlsl2Glsl_Translate(handle, entry, targetVersion, options)) ? 1 : 0;
+	}
+	std::string key;
+	ComputeCompileCacheKey(handle, *preprocessed, entry, targetVersion, options, key);
+
+	TCachedCompile compile;
+	std::string value;
+	if (cache->load(key, value) && DeserializeCachedCompile(value, compile))
+	{
+		RestoreCachedCompile(handle, compile, preprocessed, options);
+		return compile.success ? 1 : 0;
+	}
+
+	bool success = ParseShader(handle, shaderString, targetVersion, callbacks, options, preprocessed) &&
+		Hlsl2Glsl_Translate(handle, entry, targetVersion, options);
+
+	compile = TCachedCompile();
+	SaveCachedCompile(handle, success, compile);
+	cache->save(key, SerializeCachedCompile(compile));
+
+	return success ? 1 : 0;
+}
+
+
+ShIncludeCacheHandle C_DECL Hlsl2Glsl_ConstructIncludeCache( const Hlsl2Glsl_IncludeCacheCallbacks* callbacks )
+{
+	return new TIncludeCache(callbacks);
+}
+
+void C_DECL Hlsl2Glsl_DestructIncludeCache( ShIncludeCacheHandle cache )
+{
+	if (cache)
+		cache->release();
+}
+
+void C_DECL Hlsl2Glsl_GetIncludeCacheStats( ShIncludeCacheHandle cache, Hlsl2Glsl_IncludeCacheStats* stats )
+{
+	if (cache && stats)
+		cache->getStats(*stats);
+}
+
+void C_DECL Hlsl2Glsl_SetIncludeCache( ShHandle handle, ShIncludeCacheHandle cache )
+{
+	if (handle)
+		handle->SetIncludeCache(cache);
+}
+
+
+namespace {
+
+// Compiler for a job of Hlsl2Glsl_CompileBatch or Hlsl2Glsl_CompileVariants, false if it can't be set up
+static bool ConstructJobCompiler(const Hlsl2Glsl_BatchJob& job, Hlsl2Glsl_BatchResult& result)
+{
+	result.success = 0;
+	result.handle = Hlsl2Glsl_ConstructCompilerUserPrefix(job.language, job.prefixTable);
+	Hlsl2Glsl_SetIncludeCache(result.handle, job.includeCache);
+	return result.handle &&
+		(job.userAttribCount <= 0 ||
+		 Hlsl2Glsl_SetUserAttributeNames(result.handle, job.userAttribSemantics, job.userAttribNames, job.userAttribCount));
+}
+
+} // namespace
+
+
+int C_DECL Hlsl2Glsl_CompileBatch(
+	const Hlsl2Glsl_BatchJob* jobs,
+	int jobCount,
+	Hlsl2Glsl_BatchResult* results,
+	int threadCount)
+{
+	if (jobCount <= 0)
+		return 1;
+	if (!jobs || !results)
+		return 0;
+
+	// Each worker thread initializes its pool allocator and parse context on the first
+	// job it runs, and keeps using them for all of its other jobs. The compilers hold
+	// no per-thread data, so the caller can use and free them from any thread.
+	std::atomic<int> failures(0);
+	TWorkStealingPool pool(threadCount);
+	pool.run(jobCount, [&](int i)
+	{
+		const Hlsl2Glsl_BatchJob& job = jobs[i];
+		Hlsl2Glsl_BatchResult& result = results[i];
+
+		if (ConstructJobCompiler(job, result))
+		{
+			result.success = Hlsl2Glsl_CompileCached(result.handle, job.cache, job.shaderString, job.entry,
+				job.targetVersion, job.callbacks, job.options);
+		}
+
+		if (!result.success)
+			++failures;
+	},
+	[]()
+	{
+		DetachThread();
+	});
+
+	return failures == 0 ? 1 : 0;
+}
+
+
+namespace {
+
+struct TVariantCompile
+{
+	std::shared_ptr<TPreprocessedSource> preprocessed;
+	bool preprocessedOk;
+	std::string tokenHash;
+	int original;        // first variant with the same tokens, this one if none
+	bool hasDuplicates;
+	TCachedCompile result;  // of originals with duplicates
+};
+
+// The include cache of one Hlsl2Glsl_CompileVariants call can't tell files apart by path,
+// so a file is only shared between includes from the same including file
+static bool ResolveVariantInclude(bool isSystem, const char* fname, const char* parentfname, std::string& path, void* data)
+{
+	path = parentfname ? parentfname : "";
+	path += '\n';
+	path += fname;
+	return true;
+}
+
+// Dependencies recorded through ResolveVariantInclude, listed by their unresolved paths the
+// way a parse without an include cache lists them
+static void UnresolveVariantDependencies(TIncludeDependencies& dependencies)
+{
+	TIncludeDependencies unresolved;
+	for (size_t i = 0; i < dependencies.size(); ++i)
+	{
+		size_t j = 0;
+		while (j < unresolved.size() && unresolved[j].path != dependencies[i].unresolvedPath)
+			++j;
+		if (j < unresolved.size())
+			unresolved[j].found = unresolved[j].found || dependencies[i].found;
+		else
+		{
+			unresolved.push_back(dependencies[i]);
+			unresolved.back().path = dependencies[i].unresolvedPath;
+		}
+	}
+	dependencies.swap(unresolved);
+}
+
+static void CompileVariant(const Hlsl2Glsl_BatchJob& job, TVariantCompile& variant, Hlsl2Glsl_BatchResult& result,
+	std::atomic<int>& cached)
+{
+	if (!ConstructJobCompiler(job, result) || !InitThread())
+		return;
+	HlslCrossCompiler* compiler = result.handle;
+
+	// Like Hlsl2Glsl_CompileCached, but with the tokens already at hand
+	std::string key;
+	if (job.cache && job.entry && variant.preprocessedOk)
+	{
+		ComputeCompileCacheKey(compiler, *variant.preprocessed, job.entry, job.targetVersion, job.options, key);
+		std::string value;
+		if (job.cache->load(key, value) && DeserializeCachedCompile(value, variant.result))
+		{
+			RestoreCachedCompile(compiler, variant.result, variant.preprocessed, job.options);
+			result.success = variant.result.success ? 1 : 0;
+			++cached;
+			return;
+		}
+	}
+
+	const bool success = ParseShader(compiler, job.shaderString, job.targetVersion, job.callbacks, job.options, variant.preprocessed) &&
+		Hlsl2Glsl_Translate(compiler, job.entry, job.targetVersion, job.options);
+	result.success = success ? 1 : 0;
+
+	if (!key.empty() || variant.hasDuplicates)
+	{
+		variant.result = TCachedCompile();
+		SaveCachedCompile(compiler, success, variant.result);
+		if (!key.empty())
+			job.cache->save(key, SerializeCachedCompile(variant.result));
+	}
+}
+
+} // namespace
+
+
+int C_DECL Hlsl2Glsl_CompileVariants(
+	const Hlsl2Glsl_BatchJob* job,
+	const Hlsl2Glsl_Variant* variants,
+	int variantCount,
+	Hlsl2Glsl_BatchResult* results,
+	int threadCount,
+	Hlsl2Glsl_VariantStats* stats)
+{
+	if (stats)
+		*stats = Hlsl2Glsl_VariantStats();
+	if (variantCount <= 0)
+		return 1;
+	if (!job || !variants || !results)
+		return 0;
+
+	// Include files are only read once, by whichever variant gets to them first
+	TIncludeCache* includeCache = job->includeCache;
+	if (includeCache)
+		includeCache->retain();
+	else
+	{
+		Hlsl2Glsl_IncludeCacheCallbacks cacheCallbacks = { ResolveVariantInclude, 0, 0 };
+		includeCache = new TIncludeCache(&cacheCallbacks);
+	}
+
+	TWorkStealingPool pool(threadCount);
+	std::vector<TVariantCompile> compiles(variantCount);
+	pool.run(variantCount, [&](int i)
+	{
+		TVariantCompile& variant = compiles[i];
+		variant.preprocessed = std::make_shared<TPreprocessedSource>();
+		variant.preprocessedOk = PaPreprocessString(job->shaderString, job->callbacks, includeCache,
+			variants[i].defines, variants[i].defineCount, *variant.preprocessed);
+		if (!job->includeCache)
+			UnresolveVariantDependencies(variant.preprocessed->dependencies);
+
+		// Recorded errors parse to the same errors again, so they get deduplicated too
+		TContentHash hash;
+		HashPreprocessedSource(*variant.preprocessed, hash);
+		hash.addInt(variant.preprocessed->error);
+		hash.addInt(variant.preprocessed->outOfMemory);
+		variant.tokenHash = hash.finish();
+	});
+	includeCache->release();
+
+	// Variants the defines make no difference to are only parsed once
+	std::unordered_map<std::string, int> originals;
+	std::vector<int> unique;
+	for (int i = 0; i < variantCount; ++i)
+	{
+		TVariantCompile& variant = compiles[i];
+		std::pair<std::unordered_map<std::string, int>::iterator, bool> inserted = originals.insert(std::make_pair(variant.tokenHash, i));
+		variant.original = inserted.first->second;
+		variant.hasDuplicates = false;
+		if (inserted.second)
+			unique.push_back(i);
+		else
+			compiles[variant.original].hasDuplicates = true;
+	}
+
+	std::atomic<int> cached(0);
+	pool.run(static_cast<int>(unique.size()), [&](int u)
+	{
+		const int i = unique[u];
+		CompileVariant(*job, compiles[i], results[i], cached);
+	},
+	[]()
+	{
+		DetachThread();
+	});
+
+	for (int i = 0; i < variantCount; ++i)
+	{
+		const TVariantCompile& variant = compiles[i];
+		if (variant.original == i)
+			continue;
+		Hlsl2Glsl_BatchResult& result = results[i];
+		if (ConstructJobCompiler(*job, result) && results[variant.original].handle)
+		{
+			RestoreCachedCompile(result.handle, compiles[variant.original].result, variant.preprocessed, job->options);
+			result.success = results[variant.original].success;
+		}
+	}
+
+	int failures = 0;
+	for (int i = 0; i < variantCount; ++i)
+	{
+		if (!results[i].success)
+			++failures;
+	}
+
+	if (stats)
+	{
+		stats->duplicates = variantCount - static_cast<int>(unique.size());
+		stats->cached = cached;
+		stats->parsed = static_cast<int>(unique.size()) - stats->cached;
+	}
+
+	return failures == 0 ? 1 : 0;
+}
+
+
+namespace {
+
+// Blank source lines up to this many are written out as newlines instead of starting a span
+static const unsigned int kMaxNewlineGap = 8;
+
+// Write the tokens as text, one source line per text line, with a span wherever the
+// newlines alone can't tell the position
+static void WritePreprocessed(const TPreprocessedSource& source, std::string& text,
+	std::vector<Hlsl2Glsl_SourceSpan>& spans)
+{
+	text.clear();
+	spans.clear();
+
+	// The error message isn't part of the text
+	const size_t count = source.tokens.size() - (source.error ? 1 : 0);
+	unsigned int file = 0;
+	unsigned int line = 0;
+	for (size_t i = 0; i < count; ++i)
+	{
+		const TPreprocessedToken& token = source.tokens[i];
+		if (token.length == 0)
+			continue;
+
+		if (!spans.empty() && token.file == file && token.line == line)
+			text.push_back(' ');
+		else if (!spans.empty() && token.file == file && token.line > line && token.line - line <= kMaxNewlineGap)
+			text.append(token.line - line, '\n');
+		else
+		{
+			if (!spans.empty())
+				text.push_back('\n');
+			const Hlsl2Glsl_SourceSpan span = { (unsigned int) text.size(), token.file, token.line };
+			spans.push_back(span);
+		}
+		file = token.file;
+		line = token.line;
+		text.append(source.text, token.offset, token.length);
+	}
+}
+
+} // namespace
+
+
+int C_DECL Hlsl2Glsl_Preprocess(
+	const ShHandle handle,
+	const char* shaderString,
+	Hlsl2Glsl_ParseCallbacks* callbacks,
+	const Hlsl2Glsl_Define* defines,
+	int defineCount)
+{
+	if (!InitThread())
+		return 0;
+
+	if (handle == 0)
+		return 0;
+
+	handle->infoSink.info.erase();
+	handle->infoSink.debug.erase();
+
+	TPreprocessedSource preprocessed;
+	const bool success = PaPreprocessString(shaderString, callbacks, handle->GetIncludeCache(), defines, defineCount, preprocessed);
+	WritePreprocessed(preprocessed, handle->preprocessedText, handle->sourceMap);
+
+	handle->sourceFiles.swap(preprocessed.files);
+	handle->sourceFileNames.clear();
+	for (size_t i = 0; i < handle->sourceFiles.size(); ++i)
+		handle->sourceFileNames.push_back(handle->sourceFiles[i].c_str());
+
+	if (!shaderString)
+		handle->infoSink.info.message(EPrefixError, "Null shader source string");
+	else if (preprocessed.outOfMemory)
+		handle->infoSink.info.message(EPrefixError, "out of memory");
+	else if (preprocessed.error)
+	{
+		// Reported like the parse does, at the position of the error
+		const TPreprocessedToken& error = preprocessed.tokens.back();
+		TSourceLoc loc;
+		loc.file = handle->sourceFileNames[error.file];
+		loc.line = error.line;
+		handle->infoSink.info.location(loc);
+		handle->infoSink.info.prefix(EPrefixError);
+		handle->infoSink.info << "'' : " << (preprocessed.text.c_str() + error.offset) << " \n";
+	}
+
+	return success ? 1 : 0;
+}
+
+const char* C_DECL Hlsl2Glsl_GetPreprocessedText( const ShHandle handle )
+{
+	if (!handle)
+		return 0;
+	return handle->preprocessedText.c_str();
+}
+
+const Hlsl2Glsl_SourceSpan* C_DECL Hlsl2Glsl_GetSourceMap( const ShHandle handle, int* spanCount )
+{
+	if (!handle)
+		return 0;
+	if (spanCount)
+		*spanCount = static_cast<int>(handle->sourceMap.size());
+	return handle->sourceMap.empty() ? 0 : &handle->sourceMap[0];
+}
+
+const char* const* C_DECL Hlsl2Glsl_GetSourceFiles( const ShHandle handle, int* fileCount )
+{
+	if (!handle)
+		return 0;
+	if (fileCount)
+		*fileCount = static_cast<int>(handle->sourceFileNames.size());
+	return handle->sourceFileNames.empty() ? 0 : &handle->sourceFileNames[0];
+}
+
+
+const Hlsl2Glsl_Dependency* C_DECL Hlsl2Glsl_GetDependencies( const ShHandle handle, int* dependencyCount )
+{
+	if (!handle)
+		return 0;
+
+	std::vector<Hlsl2Glsl_Dependency>& list = handle->dependencyList;
+	list.clear();
+	for (size_t i = 0; i < handle->dependencies.size(); ++i)
+	{
+		const TIncludeDependency& dependency = handle->dependencies[i];
+		Hlsl2Glsl_Dependency entry;
+		entry.path = dependency.path.c_str();
+		entry.name = dependency.name.c_str();
+		entry.parentName = dependency.parentName.c_str();
+		entry.isSystem = dependency.isSystem ? 1 : 0;
+		entry.found = dependency.found ? 1 : 0;
+		list.push_back(entry);
+	}
+
+	if (dependencyCount)
+		*dependencyCount = static_cast<int>(list.size());
+	return list.empty() ? 0 : &list[0];
+}
+
+// Escape a file name for a make rule, the way compilers write depfiles
+static void WriteDepfilePath(std::string& out, const std::string& path)
+{
+	for (size_t i = 0; i < path.size(); ++i)
+	{
+		const char c = path[i];
+		if (c == ' ' || c == '\t')
+		{
+			// Backslashes right before a blank would escape it, double them
+			for (size_t j = i; j > 0 && path[j - 1] == '\\'; --j)
+				out += '\\';
+			out += '\\';
+		}
+		else if (c == '#')
+			out += '\\';
+		else if (c == '$')
+			out += '$';
+		out += c;
+	}
+}
+
+const char* C_DECL Hlsl2Glsl_GetDepfile( const ShHandle handle, const char* target )
+{
+	if (!handle)
+		return 0;
+
+	// Files that could not be opened are left out: make would stop for want of a rule to make
+	// them, and ninja would always rebuild target
+	std::string& depfile = handle->depfile;
+	depfile.clear();
+	WriteDepfilePath(depfile, target ? target : "");
+	depfile += ':';
+	for (size_t i = 0; i < handle->dependencies.size(); ++i)
+	{
+		if (!handle->dependencies[i].found)
+			continue;
+		depfile += " \\\n  ";
+		WriteDepfilePath(depfile, handle->dependencies[i].path);
+	}
+	depfile += '\n';
+
+	// An empty rule for each prerequisite, like "cc -MP", so make carries on once one is deleted
+	for (size_t i = 0; i < handle->dependencies.size(); ++i)
+	{
+		if (!handle->dependencies[i].found)
+			continue;
+		depfile += '\n';
+		WriteDepfilePath(depfile, handle->dependencies[i].path);
+		depfile += ":\n";
+	}
+	return depfile.c_str();
+}
+
+
 static bool kVersionUsesPrecision[ETargetVersionCount] = {
 	true,	// ES 1.00
 	false,	// 1.10
@@ -0,0 +1,111 @@
+// Copyright (c) The HLSL2GLSLFork Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE.txt file.
+
+
+#include "IncludeCache.h"
+
+namespace hlsl2glsl
+{
+
+TIncludeCache::TIncludeCache(const Hlsl2Glsl_IncludeCacheCallbacks* cacheCallbacks)
+:	refCount(1)
+,	bytes(0)
+,	hits(0)
+,	misses(0)
+,	invalidations(0)
+{
+	callbacks.resolve = cacheCallbacks ? cacheCallbacks->resolve : 0;
+	callbacks.hash = cacheCallbacks ? cacheCallbacks->hash : 0;
+	callbacks.data = cacheCallbacks ? cacheCallbacks->data : 0;
+}
+
+
+void TIncludeCache::retain()
+{
+	refCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+
+void TIncludeCache::release()
+{
+	if (refCount.fetch_sub(1, std::memory_order_acq_rel) == 1)
+		delete this;
+}
+
+
+bool TIncludeCache::resolve(bool isSystem, const char* fname, const char* parentfname, std::string& path) const
+{
+	path = fname;
+	if (!callbacks.resolve)
+		return true;
+	if (callbacks.resolve(isSystem, fname, parentfname, path, callbacks.data))
+		return true;
+	path = fname;
+	return false;
+}
+
+
+TIncludeCache::TFile TIncludeCache::open(bool isSystem, const char* fname, const char* parentfname, const char* parent,
+	const Hlsl2Glsl_ParseCallbacks& parseCallbacks, bool& opened)
+{
+	opened = false;
+	if (!parseCallbacks.includeOpenCallback)
+		return TFile();
+
+	// Without a path or hash to check it against, the file is read uncached
+	std::string path;
+	bool cacheable = resolve(isSystem, fname, parentfname, path);
+	std::string hash;
+	if (cacheable && callbacks.hash)
+		cacheable = callbacks.hash(path.c_str(), hash, callbacks.data);
+
+	const std::string key = (isSystem ? "<" : "\"") + path;
+	if (cacheable)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		TEntryMap::iterator it = entries.find(key);
+		if (it != entries.end())
+		{
+			if (it->second.hash == hash)
+			{
+				++hits;
+				return it->second.content;
+			}
+			++invalidations;
+		}
+		++misses;
+	}
+
+	std::string content;
+	opened = true;
+	if (!parseCallbacks.includeOpenCallback(isSystem, fname, parentfname, parent, content, parseCallbacks.data))
+		return TFile();
+
+	TFile file = std::make_shared<const std::string>(std::move(content));
+	if (cacheable)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		TEntry& entry = entries[key];
+		if (entry.content)
+			bytes -= entry.content->size();
+		entry.content = file;
+		entry.hash = hash;
+		bytes += file->size();
+	}
+	return file;
+}
+
+
+void TIncludeCache::getStats(Hlsl2Glsl_IncludeCacheStats& stats) const
+{
+	stats.hits = hits;
+	stats.misses = misses;
+	stats.invalidations = invalidations;
+
+	std::lock_guard<std::mutex> lock(mutex);
+	stats.files = entries.size();
+	stats.bytes = bytes;
+}
+
+} // namespace hlsl2glsl
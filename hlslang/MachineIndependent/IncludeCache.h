@@ -0,0 +1,93 @@
+// Copyright (c) The HLSL2GLSLFork Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE.txt file.
+
+
+#ifndef _INCLUDE_CACHE_INCLUDED_
+#define _INCLUDE_CACHE_INCLUDED_
+
+//
+// Contents of #include files, shared by all compilers and threads using the cache.
+// See Hlsl2Glsl_ConstructIncludeCache.
+//
+// Entries are keyed by the resolved path and whether it is a system include. Files
+// are handed out as reference counted strings, so the preprocessor reads them in place,
+// and an entry replaced while some parse still reads it stays alive until that parse
+// is done.
+//
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../../include/hlsl2glsl.h"
+
+namespace hlsl2glsl
+{
+
+class TIncludeCache
+{
+public:
+	typedef std::shared_ptr<const std::string> TFile;
+
+	explicit TIncludeCache(const Hlsl2Glsl_IncludeCacheCallbacks* callbacks);
+
+	// The cache itself is reference counted too; every compiler using it holds a reference
+	void retain();
+	void release();
+
+	/// Path of the file an #include reads, through the resolve callback if there is one.
+	/// Returns false if the callback tells to read the file uncached; path is then the name
+	/// as written.
+	bool resolve(bool isSystem, const char* fname, const char* parentfname, std::string& path) const;
+
+	/// Contents of the file an #include reads, through the parse callbacks if not cached
+	/// or changed. opened tells whether the include open callback got called. Returns a
+	/// null pointer if the callback fails.
+	TFile open(bool isSystem, const char* fname, const char* parentfname, const char* parent,
+		const Hlsl2Glsl_ParseCallbacks& callbacks, bool& opened);
+
+	void getStats(Hlsl2Glsl_IncludeCacheStats& stats) const;
+
+private:
+	~TIncludeCache() { }
+
+	struct TEntry
+	{
+		TFile content;
+		std::string hash;
+	};
+	typedef std::unordered_map<std::string, TEntry> TEntryMap;
+
+	Hlsl2Glsl_IncludeCacheCallbacks callbacks;
+	std::atomic<int> refCount;
+
+	mutable std::mutex mutex;
+	TEntryMap entries;
+	size_t bytes;
+
+	std::atomic<unsigned long long> hits;
+	std::atomic<unsigned long long> misses;
+	std::atomic<unsigned long long> invalidations;
+};
+
+//
+// A file the preprocessor read or tried to read for an #include, for depfiles.
+//
+struct TIncludeDependency
+{
+	std::string path;            // resolved through the include cache, else unresolvedPath
+	std::string unresolvedPath;  // the name as written, for a local include in the directory of the including file
+	std::string name;            // as written in the #include
+	std::string parentName;      // of the including file, "" for the shader itself
+	bool isSystem;
+	bool found;                  // false if the include open callback failed
+};
+typedef std::vector<TIncludeDependency> TIncludeDependencies;
+
+} // namespace hlsl2glsl
+
+#endif // _INCLUDE_CACHE_INCLUDED_
@@ -474,7 +474,7 @@ TIntermTyped* ir_add_conversion(TOperator op, const TType& type, TIntermTyped* n
       return node;
 
    // if basic types are identical, promotions will handle everything
-   if (type.getBasicType() == node->getTypePointer()->getBasicType())
+   if (type.getBasicType() == node->getType().getBasicType())
       return node;
 
    //
@@ -575,6 +575,7 @@ TIntermTyped* ir_add_conversion(TOperator op, const TType& type, TIntermTyped* n
 TIntermDeclaration* ir_add_declaration(TIntermSymbol* symbol, TIntermTyped* initializer, TSourceLoc line, TParseContext& ctx)
 {
 	TIntermDeclaration* decl = new TIntermDeclaration(symbol->getType());
+	decl->setTypeLine(symbol->getTypeLine());
 	decl->setLine(line);
 	
 	if (!initializer)
@@ -665,7 +666,7 @@ TIntermAggregate* ir_make_aggregate(TIntermNode* node, TSourceLoc line)
 
 	TIntermAggregate* aggNode = new TIntermAggregate;
 	if (node->getAsTyped())
-		aggNode->setType(*node->getAsTyped()->getTypePointer());
+		aggNode->setType(*node->getAsTyped());
 	
 	aggNode->getNodes().push_back(node);
 
@@ -708,7 +709,7 @@ TIntermTyped* ir_add_comma(TIntermTyped* left, TIntermTyped* right, TSourceLoc l
 	{
 		TIntermTyped *commaAggregate = ir_grow_aggregate(left, right, line);
 		commaAggregate->getAsAggregate()->setOperator(EOpComma);    
-		commaAggregate->setType(right->getType());
+		commaAggregate->setType(*right);
 		commaAggregate->getTypePointer()->changeQualifier(EvqTemporary);
 		return commaAggregate;
 	}
@@ -785,6 +786,7 @@ TIntermTyped* ir_add_selection(TIntermTyped* cond, TIntermTyped* trueBlock, TInt
    // Make a selection node.
    //
    TIntermSelection* node = new TIntermSelection(cond, trueBlock, falseBlock, trueBlock->getType());
+   node->setTypeLine(trueBlock->getTypeLine());
    node->setLine(line);
 
    if (!node->promoteTernary(infoSink)) {
@@ -834,16 +836,14 @@ TIntermTyped* ir_add_const_vector_swizzle(const TVectorFields& fields, TIntermTy
 	if (!constNode)
 		return NULL;
 	
-	TIntermConstant* res = ir_add_constant(node->getType(), line);
+	TIntermConstant* res = ir_add_constant(TType(node->getBasicType(), node->getPrecision(), EvqConst, fields.num), line);
 	for (int i = 0; i < fields.num; ++i)
 	{
-		int index = fields.offsets[i];
-		assert(index >= 0 && index < constNode->getCount());
+		unsigned index = fields.offsets[i];
+		assert(index < constNode->getCount());
 		res->setValue(i, constNode->getValue (index));
 	}
 	
-	res->setType(TType(node->getBasicType(), node->getPrecision(), EvqConst, fields.num));
-	
 	return res;
 }
 
@@ -905,6 +905,32 @@ TIntermBranch* ir_add_branch(TOperator branchOp, TIntermTyped* expression, TSour
 // Member functions of the nodes used for building the tree.
 
 
+void TIntermConstant::resize(unsigned n)
+{
+	Value* old = data();
+	if (n > kInlineValues && n > count)
+	{
+		// A block that shrank keeps its room, but that is not worth remembering: values
+		// only move after construction when a constant is copied into one
+		Value* grown = static_cast<Value*>(GlobalPoolAllocator.allocate(n * sizeof(Value)));
+		for (unsigned i = 0; i != count; ++i)
+			grown[i] = old[i];
+		values = grown;
+	}
+	else if (n <= kInlineValues && count > kInlineValues)
+	{
+		// Back into the node
+		for (unsigned i = 0; i != n; ++i)
+			inlineValues[i] = old[i];
+	}
+	const unsigned oldCount = count;
+	count = n;
+	Value* v = data();
+	for (unsigned i = oldCount; i < n; ++i)
+		v[i] = Value();
+}
+
+
 //
 // Say whether or not an operation node changes the value of a variable.
 //
@@ -1011,7 +1037,7 @@ bool TIntermUnary::promote(TParseContext& ctx)
          return false;
    }
 
-   setType(operand->getType());
+   setType(*operand);
 
    return true;
 }
@@ -1021,7 +1047,7 @@ TOperator ir_get_constructor_op_float(const TPublicType& t, TParseContext& ctx)
 {
 	TOperator op = EOpNull;
 	if (t.matrix) {
-		const bool hasNonSquare = (ctx.targetVersion >= ETargetGLSL_120);
+		const bool hasNonSquare = ctx.isGLSL120Target();
 		switch(t.matcols) {
 			case 2: switch(t.matrows) {
 				case 2: op = EOpConstructMat2x2;  break;
@@ -1088,7 +1114,7 @@ static TOperator getMatrixConstructOp(const TIntermTyped& intermediate, TParseCo
 	// before GLSL 1.20, only square matrices
 	const int c = intermediate.getColsCount();
 	const int r = intermediate.getRowsCount();
-	if (ctx.targetVersion < ETargetGLSL_120)
+	if (!ctx.isGLSL120Target())
 	{
 		if (c == 2 && r == 2)
 			return EOpConstructMat2x2FromMat;
@@ -1137,7 +1163,7 @@ static TOperator getMatrixConstructOpWithRHS(const TIntermTyped& intermediate, c
 	// If RHS is scalar and we're targeting old GLSL version, then
 	// no need to treat operator as "create small matrix from a 4x4 one";
 	// we can create it from scalar directly.
-	if (rhsType.isScalar() && ctx.targetVersion < ETargetGLSL_120)
+	if (rhsType.isScalar() && !ctx.isGLSL120Target())
 	{
 		const int c = intermediate.getColsCount();
 		const int r = intermediate.getRowsCount();
@@ -1171,12 +1197,10 @@ bool TIntermBinary::promote(TParseContext& ctx)
    //
    // Base assumption:  just make the type the same as the left
    // operand.  Then only deviations from this need be coded.
-   //
-   setType(TType(type, left->getPrecision(), EvqTemporary, left->getColsCount(), left->getRowsCount(), left->isMatrix()));
-
    // The result gets promoted to the highest precision.
+   //
    TPrecision higherPrecision = GetHigherPrecision(left->getPrecision(), right->getPrecision());
-   getTypePointer()->setPrecision(higherPrecision);
+   setType(TType(type, higherPrecision, EvqTemporary, left->getColsCount(), left->getRowsCount(), left->isMatrix()));
 
 
    //
@@ -1200,8 +1224,8 @@ bool TIntermBinary::promote(TParseContext& ctx)
          // Set array information.
          //
       case EOpAssign:
-         getType().setArraySize(left->getType().getArraySize());
-         getType().setArrayInformationType(left->getType().getArrayInformationType());
+         getTypePointer()->setArraySize(left->getType().getArraySize());
+         getTypePointer()->setArrayInformationType(left->getType().getArrayInformationType());
          break;
 
       default:
@@ -1310,15 +1334,15 @@ bool TIntermBinary::promote(TParseContext& ctx)
 
        //down convert left to match right
        TOperator convert = EOpNull;
-       if (left->getTypePointer()->isMatrix())
+       if (left->getType().isMatrix())
        {
            convert = getMatrixConstructOp(*right, ctx);
 		   if (convert == EOpNull)
 			   return false;
        }
-       else if (left->getTypePointer()->isVector())
+       else if (left->getType().isVector())
        {
-           switch (right->getTypePointer()->getBasicType())
+           switch (right->getType().getBasicType())
            {
            case EbtBool:  convert = TOperator( EOpConstructBVec2 + rows - 2); break;
            case EbtInt:   convert = TOperator( EOpConstructIVec2 + rows - 2); break;
@@ -1344,15 +1368,15 @@ bool TIntermBinary::promote(TParseContext& ctx)
    {
        //down convert right to match left
        TOperator convert = EOpNull;
-       if (right->getTypePointer()->isMatrix())
+       if (right->getType().isMatrix())
        {
            convert = getMatrixConstructOp(*left, ctx);
 		   if (convert == EOpNull)
 			   return false;
        }
-       else if (right->getTypePointer()->isVector())
+       else if (right->getType().isVector())
        {
-           switch (left->getTypePointer()->getBasicType())
+           switch (left->getType().getBasicType())
            {
            case EbtBool:  convert = TOperator( EOpConstructBVec2 + rows - 2); break;
            case EbtInt:   convert = TOperator( EOpConstructIVec2 + rows - 2); break;
@@ -1476,13 +1500,13 @@ bool TIntermBinary::promote(TParseContext& ctx)
 
          if (left->isMatrix() )
          {
-             convert = getMatrixConstructOpWithRHS(*left, *right->getTypePointer(), ctx);
+             convert = getMatrixConstructOpWithRHS(*left, right->getType(), ctx);
 			 if (convert == EOpNull)
 				 return false;
          }
          else if (left->isVector() )
          {
-            switch (left->getTypePointer()->getBasicType())
+            switch (left->getType().getBasicType())
             {
             case EbtBool:  convert = TOperator( EOpConstructBVec2 + left->getRowsCount() - 2); break;
             case EbtInt:   convert = TOperator( EOpConstructIVec2 + left->getRowsCount() - 2); break;
@@ -1492,7 +1516,7 @@ bool TIntermBinary::promote(TParseContext& ctx)
          }
          else
          {
-            switch (left->getTypePointer()->getBasicType())
+            switch (left->getType().getBasicType())
             {
             case EbtBool:  convert = EOpConstructBool; break;
             case EbtInt:   convert = EOpConstructInt; break;
@@ -1616,7 +1640,12 @@ TIntermTyped* ir_promote_constant(TBasicType promoteTo, TIntermConstant* right,
 {
 	unsigned size = right->getCount();
 	const TType& t = right->getType();
-	TIntermConstant* left = ir_add_constant(TType(promoteTo, t.getPrecision(), t.getQualifier(), t.getColsCount(), t.getRowsCount(), t.isMatrix(), t.isArray()), right->getLine());
+	TType promoted(promoteTo, t.getPrecision(), t.getQualifier(), t.getColsCount(), t.getRowsCount(), t.isMatrix(), t.isArray());
+	if (t.isArray())
+		promoted.setArraySize(t.getArraySize());
+	TIntermConstant* left = ir_add_constant(promoted, right->getLine());
+	// As many values as the source, whatever the promoted type counts
+	left->copyValuesFrom(*right);
 	for (unsigned i = 0; i != size; ++i) {
 		TIntermConstant::Value& value = right->getValue(i);
 		
@@ -0,0 +1,79 @@
+// Copyright (c) The HLSL2GLSLFork Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE.txt file.
+
+
+#ifndef _KEYWORDS_INCLUDED_
+#define _KEYWORDS_INCLUDED_
+
+//
+// Keywords and built-in type names of the scanner.
+//
+// Both scanners match anything shaped like an identifier with one rule and look it up
+// here. The table is a perfect hash written at build time by GenKeywords.cpp, gperf
+// style: the hash of a name picks a bucket, the bucket's displacement picks the one slot
+// that name can be in, so a lookup is one short hash and at most one string compare.
+// Type keywords come with the shape of their type already decoded, for the grammar to
+// use as is.
+//
+
+#include <cstddef>
+
+#include "../Include/BaseTypes.h"
+
+namespace hlsl2glsl
+{
+
+enum TKeywordKind
+{
+	EKwPlain,     // a parser token, like "return"
+	EKwType,      // a parser token for a type, the parser expects a declarator next
+	EKwTrue,      // BOOLCONSTANT
+	EKwFalse,     // BOOLCONSTANT
+	EKwReserved,  // an error
+	EKwIgnored,   // skipped, like "inline"
+};
+
+struct TKeyword
+{
+	const char* name;
+	unsigned char length;
+	int token;
+	TKeywordKind kind;
+
+	// Shape of the type of an EKwType keyword. Matrices are rows x cols, as spelled in HLSL;
+	// vectors and scalars have one row.
+	TBasicType basicType;
+	TPrecision precision;
+	unsigned char rows;
+	unsigned char cols;
+	bool matrix;
+};
+
+// The keyword spelled like the length characters at name, or NULL for anything else
+const TKeyword* FindKeyword(const char* name, size_t length);
+
+// The keyword hash only reads the length and a few characters of a name, the positions
+// GenKeywords picked to tell all keywords apart. Negative positions count from the end;
+// past either end the character is 0.
+inline unsigned int KeywordChar(const char* name, size_t length, int position)
+{
+	const size_t i = position < 0 ? length - static_cast<size_t>(-position) : static_cast<size_t>(position);
+	return i < length ? static_cast<unsigned char>(name[i]) : 0;
+}
+
+// One FNV-1a step of the keyword hash, which starts from the length
+inline unsigned int KeywordMix(unsigned int hash, unsigned int c)
+{
+	return (hash ^ c) * 16777619u;
+}
+
+// Slot of a name in the table of 1 << slotBits slots, with its bucket's displacement
+inline unsigned int KeywordSlot(unsigned int hash, unsigned int displacement, unsigned int slotBits)
+{
+	return ((hash ^ displacement) * 2654435761u) >> (32 - slotBits);
+}
+
+} // namespace hlsl2glsl
+
+#endif // _KEYWORDS_INCLUDED_
@@ -0,0 +1,188 @@
+// Generated by GenKeywords from the keyword list in GenKeywords.cpp, do not edit.
+
+#include "ParseHelper.h"
+#include "Keywords.h"
+#include "hlslang_tab.h"
+
+#include <cstring>
+
+namespace hlsl2glsl
+{
+
+static const TKeyword kKeywords[] = {
+	{ "const", 5, CONST_QUAL, EKwPlain, EbtVoid, EbpUndefined, 0, 0, false },
+	{ "static", 6, STATIC_QUAL, EKwPlain, EbtVoid, EbpUndefined, 0, 0, false },
+	{ "uniform", 7, UNIFORM, EKwPlain, EbtVoid, EbpUndefined, 0, 0, false },
+	{ "break", 5, BREAK, EKwPlain, EbtVoid, EbpUndefined, 0, 0, false },
+	{ "continue", 8, CONTINUE, EKwPlain, EbtVoid, EbpUndefined, 0, 0, false },
+	{ "do", 2, DO, EKwPlain, EbtVoid, EbpUndefined, 0, 0, false },
+	{ "for", 3, FOR, EKwPlain, EbtVoid, EbpUndefined, 0, 0, false },
+	{ "while", 5, WHILE, EKwPlain, EbtVoid, EbpUndefined, 0, 0, false },
+	{ "if", 2, IF, EKwPlain, EbtVoid, EbpUndefined, 0, 0, false },
+	{ "else", 4, ELSE, EKwPlain, EbtVoid, EbpUndefined, 0, 0, false },
+	{ "in", 2, IN_QUAL, EKwPlain, EbtVoid, EbpUndefined, 0, 0, false },
+	{ "out", 3, OUT_QUAL, EKwPlain, EbtVoid, EbpUndefined, 0, 0, false },
+	{ "inout", 5, INOUT_QUAL, EKwPlain, EbtVoid, EbpUndefined, 0, 0, false },
+	{ "discard", 7, DISCARD, EKwPlain, EbtVoid, EbpUndefined, 0, 0, false },
+	{ "return", 6, RETURN, EKwPlain, EbtVoid, EbpUndefined, 0, 0, false },
+	{ "struct", 6, STRUCT, EKwPlain, EbtVoid, EbpUndefined, 0, 0, false },
+	{ "true", 4, BOOLCONSTANT, EKwTrue, EbtVoid, EbpUndefined, 0, 0, false },
+	{ "false", 5, BOOLCONSTANT, EKwFalse, EbtVoid, EbpUndefined, 0, 0, false },
+	{ "float", 5, FLOAT_TYPE, EKwType, EbtFloat, EbpHigh, 1, 1, false },
+	{ "float1", 6, FLOAT_TYPE, EKwType, EbtFloat, EbpHigh, 1, 1, false },
+	{ "float2", 6, VEC2, EKwType, EbtFloat, EbpHigh, 1, 2, false },
+	{ "float3", 6, VEC3, EKwType, EbtFloat, EbpHigh, 1, 3, false },
+	{ "float4", 6, VEC4, EKwType, EbtFloat, EbpHigh, 1, 4, false },
+	{ "float2x2", 8, MATRIX2x2, EKwType, EbtFloat, EbpHigh, 2, 2, true },
+	{ "float2x3", 8, MATRIX2x3, EKwType, EbtFloat, EbpHigh, 2, 3, true },
+	{ "float2x4", 8, MATRIX2x4, EKwType, EbtFloat, EbpHigh, 2, 4, true },
+	{ "float3x2", 8, MATRIX3x2, EKwType, EbtFloat, EbpHigh, 3, 2, true },
+	{ "float3x3", 8, MATRIX3x3, EKwType, EbtFloat, EbpHigh, 3, 3, true },
+	{ "float3x4", 8, MATRIX3x4, EKwType, EbtFloat, EbpHigh, 3, 4, true },
+	{ "float4x2", 8, MATRIX4x2, EKwType, EbtFloat, EbpHigh, 4, 2, true },
+	{ "float4x3", 8, MATRIX4x3, EKwType, EbtFloat, EbpHigh, 4, 3, true },
+	{ "float4x4", 8, MATRIX4x4, EKwType, EbtFloat, EbpHigh, 4, 4, true },
+	{ "half", 4, HALF_TYPE, EKwType, EbtFloat, EbpMedium, 1, 1, false },
+	{ "half1", 5, HALF_TYPE, EKwType, EbtFloat, EbpMedium, 1, 1, false },
+	{ "half2", 5, HVEC2, EKwType, EbtFloat, EbpMedium, 1, 2, false },
+	{ "half3", 5, HVEC3, EKwType, EbtFloat, EbpMedium, 1, 3, false },
+	{ "half4", 5, HVEC4, EKwType, EbtFloat, EbpMedium, 1, 4, false },
+	{ "half2x2", 7, HMATRIX2x2, EKwType, EbtFloat, EbpMedium, 2, 2, true },
+	{ "half2x3", 7, HMATRIX2x3, EKwType, EbtFloat, EbpMedium, 2, 3, true },
+	{ "half2x4", 7, HMATRIX2x4, EKwType, EbtFloat, EbpMedium, 2, 4, true },
+	{ "half3x2", 7, HMATRIX3x2, EKwType, EbtFloat, EbpMedium, 3, 2, true },
+	{ "half3x3", 7, HMATRIX3x3, EKwType, EbtFloat, EbpMedium, 3, 3, true },
+	{ "half3x4", 7, HMATRIX3x4, EKwType, EbtFloat, EbpMedium, 3, 4, true },
+	{ "half4x2", 7, HMATRIX4x2, EKwType, EbtFloat, EbpMedium, 4, 2, true },
+	{ "half4x3", 7, HMATRIX4x3, EKwType, EbtFloat, EbpMedium, 4, 3, true },
+	{ "half4x4", 7, HMATRIX4x4, EKwType, EbtFloat, EbpMedium, 4, 4, true },
+	{ "fixed", 5, FIXED_TYPE, EKwType, EbtFloat, EbpLow, 1, 1, false },
+	{ "fixed1", 6, FIXED_TYPE, EKwType, EbtFloat, EbpLow, 1, 1, false },
+	{ "fixed2", 6, FVEC2, EKwType, EbtFloat, EbpLow, 1, 2, false },
+	{ "fixed3", 6, FVEC3, EKwType, EbtFloat, EbpLow, 1, 3, false },
+	{ "fixed4", 6, FVEC4, EKwType, EbtFloat, EbpLow, 1, 4, false },
+	{ "fixed2x2", 8, FMATRIX2x2, EKwType, EbtFloat, EbpLow, 2, 2, true },
+	{ "fixed2x3", 8, FMATRIX2x3, EKwType, EbtFloat, EbpLow, 2, 3, true },
+	{ "fixed2x4", 8, FMATRIX2x4, EKwType, EbtFloat, EbpLow, 2, 4, true },
+	{ "fixed3x2", 8, FMATRIX3x2, EKwType, EbtFloat, EbpLow, 3, 2, true },
+	{ "fixed3x3", 8, FMATRIX3x3, EKwType, EbtFloat, EbpLow, 3, 3, true },
+	{ "fixed3x4", 8, FMATRIX3x4, EKwType, EbtFloat, EbpLow, 3, 4, true },
+	{ "fixed4x2", 8, FMATRIX4x2, EKwType, EbtFloat, EbpLow, 4, 2, true },
+	{ "fixed4x3", 8, FMATRIX4x3, EKwType, EbtFloat, EbpLow, 4, 3, true },
+	{ "fixed4x4", 8, FMATRIX4x4, EKwType, EbtFloat, EbpLow, 4, 4, true },
+	{ "int", 3, INT_TYPE, EKwType, EbtInt, EbpHigh, 1, 1, false },
+	{ "int1", 4, INT_TYPE, EKwType, EbtInt, EbpHigh, 1, 1, false },
+	{ "int2", 4, IVEC2, EKwType, EbtInt, EbpHigh, 1, 2, false },
+	{ "int3", 4, IVEC3, EKwType, EbtInt, EbpHigh, 1, 3, false },
+	{ "int4", 4, IVEC4, EKwType, EbtInt, EbpHigh, 1, 4, false },
+	{ "uint", 4, INT_TYPE, EKwType, EbtInt, EbpHigh, 1, 1, false },
+	{ "uint1", 5, INT_TYPE, EKwType, EbtInt, EbpHigh, 1, 1, false },
+	{ "uint2", 5, IVEC2, EKwType, EbtInt, EbpHigh, 1, 2, false },
+	{ "uint3", 5, IVEC3, EKwType, EbtInt, EbpHigh, 1, 3, false },
+	{ "uint4", 5, IVEC4, EKwType, EbtInt, EbpHigh, 1, 4, false },
+	{ "bool", 4, BOOL_TYPE, EKwType, EbtBool, EbpHigh, 1, 1, false },
+	{ "bool1", 5, BOOL_TYPE, EKwType, EbtBool, EbpHigh, 1, 1, false },
+	{ "bool2", 5, BVEC2, EKwType, EbtBool, EbpHigh, 1, 2, false },
+	{ "bool3", 5, BVEC3, EKwType, EbtBool, EbpHigh, 1, 3, false },
+	{ "bool4", 5, BVEC4, EKwType, EbtBool, EbpHigh, 1, 4, false },
+	{ "void", 4, VOID_TYPE, EKwType, EbtVoid, EbpUndefined, 1, 1, false },
+	{ "string", 6, STRING_TYPE, EKwType, EbtVoid, EbpUndefined, 1, 1, false },
+	{ "vector", 6, VECTOR, EKwType, EbtVoid, EbpUndefined, 1, 1, false },
+	{ "matrix", 6, MATRIX, EKwType, EbtVoid, EbpUndefined, 1, 1, false },
+	{ "register", 8, REGISTER, EKwType, EbtVoid, EbpUndefined, 1, 1, false },
+	{ "sampler", 7, SAMPLERGENERIC, EKwType, EbtSamplerGeneric, EbpUndefined, 1, 1, false },
+	{ "sampler1D", 9, SAMPLER1D, EKwType, EbtSampler1D, EbpUndefined, 1, 1, false },
+	{ "sampler1DShadow", 15, SAMPLER1DSHADOW, EKwType, EbtSampler1DShadow, EbpLow, 1, 1, false },
+	{ "sampler2D", 9, SAMPLER2D, EKwType, EbtSampler2D, EbpUndefined, 1, 1, false },
+	{ "sampler2DShadow", 15, SAMPLER2DSHADOW, EKwType, EbtSampler2DShadow, EbpLow, 1, 1, false },
+	{ "sampler2DArray", 14, SAMPLER2DARRAY, EKwType, EbtSampler2DArray, EbpLow, 1, 1, false },
+	{ "sampler2D_half", 14, SAMPLER2D_HALF, EKwType, EbtSampler2D, EbpMedium, 1, 1, false },
+	{ "sampler2D_float", 15, SAMPLER2D_FLOAT, EKwType, EbtSampler2D, EbpHigh, 1, 1, false },
+	{ "sampler3D", 9, SAMPLER3D, EKwType, EbtSampler3D, EbpLow, 1, 1, false },
+	{ "samplerRECT", 11, SAMPLERRECT, EKwType, EbtSamplerRect, EbpUndefined, 1, 1, false },
+	{ "samplerRECTShadow", 17, SAMPLERRECTSHADOW, EKwType, EbtSamplerRectShadow, EbpLow, 1, 1, false },
+	{ "samplerCUBE", 11, SAMPLERCUBE, EKwType, EbtSamplerCube, EbpUndefined, 1, 1, false },
+	{ "samplerCUBE_half", 16, SAMPLERCUBE_HALF, EKwType, EbtSamplerCube, EbpMedium, 1, 1, false },
+	{ "samplerCUBE_float", 17, SAMPLERCUBE_FLOAT, EKwType, EbtSamplerCube, EbpHigh, 1, 1, false },
+	{ "texture", 7, TEXTURE, EKwType, EbtTexture, EbpUndefined, 1, 1, false },
+	{ "texture2D", 9, TEXTURE, EKwType, EbtTexture, EbpUndefined, 1, 1, false },
+	{ "texture3D", 9, TEXTURE, EKwType, EbtTexture, EbpUndefined, 1, 1, false },
+	{ "textureRECT", 11, TEXTURE, EKwType, EbtTexture, EbpUndefined, 1, 1, false },
+	{ "textureCUBE", 11, TEXTURE, EKwType, EbtTexture, EbpUndefined, 1, 1, false },
+	{ "sampler_state", 13, SAMPLERSTATE, EKwType, EbtVoid, EbpUndefined, 1, 1, false },
+	{ "inline", 6, 0, EKwIgnored, EbtVoid, EbpUndefined, 0, 0, false },
+	{ "noinline", 8, 0, EKwIgnored, EbtVoid, EbpUndefined, 0, 0, false },
+	{ "asm", 3, 0, EKwReserved, EbtVoid, EbpUndefined, 0, 0, false },
+	{ "class", 5, 0, EKwReserved, EbtVoid, EbpUndefined, 0, 0, false },
+	{ "union", 5, 0, EKwReserved, EbtVoid, EbpUndefined, 0, 0, false },
+	{ "enum", 4, 0, EKwReserved, EbtVoid, EbpUndefined, 0, 0, false },
+	{ "typedef", 7, 0, EKwReserved, EbtVoid, EbpUndefined, 0, 0, false },
+	{ "template", 8, 0, EKwReserved, EbtVoid, EbpUndefined, 0, 0, false },
+	{ "this", 4, 0, EKwReserved, EbtVoid, EbpUndefined, 0, 0, false },
+	{ "packed", 6, 0, EKwReserved, EbtVoid, EbpUndefined, 0, 0, false },
+	{ "goto", 4, 0, EKwReserved, EbtVoid, EbpUndefined, 0, 0, false },
+	{ "switch", 6, 0, EKwReserved, EbtVoid, EbpUndefined, 0, 0, false },
+	{ "default", 7, 0, EKwReserved, EbtVoid, EbpUndefined, 0, 0, false },
+	{ "volatile", 8, 0, EKwReserved, EbtVoid, EbpUndefined, 0, 0, false },
+	{ "public", 6, 0, EKwReserved, EbtVoid, EbpUndefined, 0, 0, false },
+	{ "extern", 6, 0, EKwReserved, EbtVoid, EbpUndefined, 0, 0, false },
+	{ "external", 8, 0, EKwReserved, EbtVoid, EbpUndefined, 0, 0, false },
+	{ "interface", 9, 0, EKwReserved, EbtVoid, EbpUndefined, 0, 0, false },
+	{ "long", 4, 0, EKwReserved, EbtVoid, EbpUndefined, 0, 0, false },
+	{ "short", 5, 0, EKwReserved, EbtVoid, EbpUndefined, 0, 0, false },
+	{ "double", 6, 0, EKwReserved, EbtVoid, EbpUndefined, 0, 0, false },
+	{ "unsigned", 8, 0, EKwReserved, EbtVoid, EbpUndefined, 0, 0, false },
+	{ "sampler3DRect", 13, 0, EKwReserved, EbtVoid, EbpUndefined, 0, 0, false },
+	{ "sizeof", 6, 0, EKwReserved, EbtVoid, EbpUndefined, 0, 0, false },
+	{ "cast", 4, 0, EKwReserved, EbtVoid, EbpUndefined, 0, 0, false },
+	{ "namespace", 9, 0, EKwReserved, EbtVoid, EbpUndefined, 0, 0, false },
+	{ "using", 5, 0, EKwReserved, EbtVoid, EbpUndefined, 0, 0, false },
+};
+
+static const unsigned short kBucketDisplacements[64] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0,
+	5, 1, 1, 0, 0, 0, 1, 18, 0, 0, 1, 1, 1, 0, 0, 0,
+	2, 1, 0, 0, 0, 2, 1, 2, 0, 0, 0, 0, 0, 1, 0, 1,
+	0, 0, 5, 0, 2, 3, 0, 1, 0, 0, 0, 6, 0, 2, 0, 3,
+};
+
+// Index into kKeywords plus one, 0 for empty slots
+static const unsigned char kSlots[256] = {
+	0, 120, 0, 0, 0, 0, 0, 0, 0, 48, 0, 104, 72, 0, 3, 17,
+	24, 54, 0, 58, 73, 0, 11, 0, 0, 0, 42, 0, 0, 0, 0, 0,
+	68, 0, 0, 0, 0, 84, 0, 114, 0, 21, 0, 0, 5, 35, 0, 0,
+	75, 80, 14, 1, 45, 18, 0, 46, 62, 0, 25, 0, 50, 67, 106, 27,
+	15, 66, 88, 117, 0, 0, 108, 0, 0, 76, 10, 0, 0, 96, 0, 118,
+	126, 6, 0, 0, 0, 0, 0, 99, 0, 0, 34, 0, 65, 0, 0, 38,
+	110, 111, 51, 124, 115, 0, 105, 0, 0, 20, 0, 0, 79, 0, 37, 78,
+	47, 121, 28, 77, 0, 92, 0, 0, 0, 30, 0, 40, 0, 0, 52, 0,
+	0, 0, 0, 0, 0, 0, 125, 112, 0, 0, 59, 0, 63, 100, 0, 33,
+	0, 82, 0, 0, 116, 107, 94, 0, 0, 101, 0, 95, 9, 0, 8, 7,
+	74, 91, 0, 12, 0, 55, 0, 41, 49, 4, 119, 89, 57, 29, 0, 0,
+	0, 123, 0, 71, 44, 86, 0, 0, 0, 83, 85, 0, 16, 36, 69, 0,
+	93, 0, 0, 87, 0, 0, 60, 32, 0, 0, 0, 0, 0, 0, 13, 61,
+	0, 0, 43, 70, 0, 53, 0, 127, 0, 0, 0, 0, 90, 0, 0, 0,
+	102, 0, 0, 109, 0, 19, 56, 0, 0, 103, 39, 26, 0, 0, 0, 97,
+	113, 23, 0, 0, 0, 0, 2, 98, 0, 81, 122, 0, 0, 22, 31, 64,
+};
+
+const TKeyword* FindKeyword(const char* name, size_t length)
+{
+	if (length > 17)
+		return NULL;
+
+	unsigned int hash = KeywordMix(2166136261u, static_cast<unsigned int>(length));
+	hash = KeywordMix(hash, KeywordChar(name, length, -1));
+	hash = KeywordMix(hash, KeywordChar(name, length, -3));
+	hash = KeywordMix(hash, KeywordChar(name, length, -5));
+	hash = KeywordMix(hash, KeywordChar(name, length, 7));
+	const unsigned int displacement = kBucketDisplacements[hash & 63];
+	const unsigned int slot = kSlots[KeywordSlot(hash, displacement, 8)];
+	if (!slot)
+		return NULL;
+
+	const TKeyword* keyword = &kKeywords[slot - 1];
+	return keyword->length == length && memcmp(keyword->name, name, length) == 0 ? keyword : NULL;
+}
+
+} // namespace hlsl2glsl
@@ -951,7 +951,7 @@ bool TParseContext::arrayTypeErrorCheck(const TSourceLoc& line, TPublicType type
 //
 // Returns true if there was an error.
 //
-bool TParseContext::arrayErrorCheck(const TSourceLoc& line, TString& identifier, TPublicType type, TVariable*& variable)
+bool TParseContext::arrayErrorCheck(const TSourceLoc& line, const TString& identifier, TPublicType type, TVariable*& variable)
 {
 
    return arrayErrorCheck( line, identifier, 0, type, variable);
@@ -974,7 +974,7 @@ static inline void AdjustTypeQualifier(TPublicType& type)
 //
 // Returns true if there was an error.
 //
-bool TParseContext::arrayErrorCheck(const TSourceLoc& line, TString& identifier, const TTypeInfo *info, TPublicType type, TVariable*& variable)
+bool TParseContext::arrayErrorCheck(const TSourceLoc& line, const TString& identifier, const TTypeInfo *info, TPublicType type, TVariable*& variable)
 {
    //
    // Don't check for reserved word use until after we know it's not in the symbol table,
@@ -1089,7 +1089,7 @@ bool TParseContext::arraySetMaxSize(TIntermSymbol *node, TType* type, int size,
 //
 // Returns true if there was an error.
 //
-bool TParseContext::nonInitConstErrorCheck(const TSourceLoc& line, TString& identifier, TPublicType& type)
+bool TParseContext::nonInitConstErrorCheck(const TSourceLoc& line, const TString& identifier, TPublicType& type)
 {
    //
    // Make the qualifier make sense.
@@ -1110,7 +1110,7 @@ bool TParseContext::nonInitConstErrorCheck(const TSourceLoc& line, TString& iden
 //
 // Returns true if there was an error.
 //
-bool TParseContext::nonInitErrorCheck(const TSourceLoc& line, TString& identifier, TPublicType& type)
+bool TParseContext::nonInitErrorCheck(const TSourceLoc& line, const TString& identifier, TPublicType& type)
 {
 
    return nonInitErrorCheck( line, identifier, 0, type);
@@ -1122,7 +1122,7 @@ bool TParseContext::nonInitErrorCheck(const TSourceLoc& line, TString& identifie
 //
 // Returns true if there was an error.
 //
-bool TParseContext::nonInitErrorCheck(const TSourceLoc& line, TString& identifier, const TTypeInfo *info, TPublicType& type)
+bool TParseContext::nonInitErrorCheck(const TSourceLoc& line, const TString& identifier, const TTypeInfo *info, TPublicType& type)
 {
    if (reservedErrorCheck(line, identifier))
       recover();
@@ -1179,23 +1179,17 @@ bool TParseContext::paramErrorCheck(const TSourceLoc& line, TQualifier qualifier
 //
 const TFunction* TParseContext::findFunction(const TSourceLoc& line, TFunction* call, bool *builtIn)
 {
-   const TSymbol* symbol = symbolTable.find(call->getMangledName(), builtIn);
+   // The exact match if there is one, or else an unambiguous type conversion
+   bool ambiguous = false;
+   const TSymbol* symbol = symbolTable.resolveCall(call, builtIn, ambiguous);
 
    if (symbol == 0)
    {
-      // The symbol was not found, look for a unambiguous type conversion
-      bool ambiguous = false;
-
-      symbol = symbolTable.findCompatible( call, builtIn, ambiguous);
-
-      if (symbol == 0)
-      {
-         if (ambiguous)
-            error(line, "cannot resolve function call unambiguously", call->getName().c_str(), "(check parameter types)");
-         else
-            error(line, "no matching overloaded function found", call->getName().c_str(), "");
-         return 0;
-      }
+      if (ambiguous)
+         error(line, "cannot resolve function call unambiguously", call->getName().c_str(), "(check parameter types)");
+      else
+         error(line, "no matching overloaded function found", call->getName().c_str(), "");
+      return 0;
    }
 
    if (! symbol->isFunction())
@@ -1213,7 +1207,7 @@ const TFunction* TParseContext::findFunction(const TSourceLoc& line, TFunction*
 // Initializers show up in several places in the grammar.  Have one set of
 // code to handle them here.
 //
-bool TParseContext::executeInitializer(TSourceLoc line, TString& identifier, TPublicType& pType, 
+bool TParseContext::executeInitializer(TSourceLoc line, const TString& identifier, TPublicType& pType, 
                                        TIntermTyped*& initializer, TIntermSymbol*& intermNode, TVariable* variable)
 {
 
@@ -1224,7 +1218,7 @@ bool TParseContext::executeInitializer(TSourceLoc line, TString& identifier, TPu
 // Initializers show up in several places in the grammar.  Have one set of
 // code to handle them here.
 //
-bool TParseContext::executeInitializer(TSourceLoc line, TString& identifier, const TTypeInfo *info, TPublicType& pType, 
+bool TParseContext::executeInitializer(TSourceLoc line, const TString& identifier, const TTypeInfo *info, TPublicType& pType, 
                                        TIntermTyped*& initializer, TIntermSymbol*& intermNode, TVariable* variable)
 {
 	AdjustTypeQualifier (pType);
@@ -1285,7 +1279,7 @@ bool TParseContext::executeInitializer(TSourceLoc line, TString& identifier, con
 	bool isConst = (initializerQualifier == EvqConst);
 	// GLSL 1.20+ allows more things in constant initializers;
 	// not so much for earlier GLSL versions.
-	if (!isConst && (targetVersion >= ETargetGLSL_120))
+	if (!isConst && isGLSL120Target())
 	{
 		/*
 		// isBranchConstant doesn't actually work yet, e.g. it sees "-foobar" and assumes it's
@@ -1650,7 +1644,7 @@ TIntermTyped* TParseContext::constructBuiltIn(const TType* type, TOperator op, T
 	TOperator basicOp;
 	
 	// Check for no-op constructions such as casting to the same builtin type.
-	if (node->getAsTyped() && *node->getAsTyped()->getTypePointer() == *type) {
+	if (node->getAsTyped() && node->getAsTyped()->getType() == *type) {
 		return node->getAsTyped();
 	}
 
@@ -1702,7 +1696,7 @@ TIntermTyped* TParseContext::constructBuiltIn(const TType* type, TOperator op, T
 	}
 
     // this conversion is not allowed, except when passing a parameter to a function
-    if ( newNode->getTypePointer()->isVector() && type->isVector() &&
+    if ( newNode->getType().isVector() && type->isVector() &&
          newNode->getRowsCount() < type->getRowsCount())
         return 0;
 
@@ -1715,13 +1709,13 @@ TIntermTyped* TParseContext::constructBuiltIn(const TType* type, TOperator op, T
 	  return newNode;
 
    //now perform HLSL style matrix conversions
-   if ( newNode->getTypePointer()->isMatrix() && type->isMatrix())
+   if ( newNode->getType().isMatrix() && type->isMatrix())
    {
       if (newNode->getColsCount() < type->getColsCount() ||
           newNode->getRowsCount() < type->getRowsCount())
           return 0;
 	   
-	   if (targetVersion < ETargetGLSL_120)
+	   if (!isGLSL120Target())
 	   {
 		   const int c = type->getColsCount();
 		   const int r = type->getRowsCount();
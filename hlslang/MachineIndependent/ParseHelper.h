@@ -6,12 +6,18 @@
 #ifndef _PARSER_HELPER_INCLUDED_
 #define _PARSER_HELPER_INCLUDED_
 
+#include "IncludeCache.h"
 #include "SymbolTable.h"
 #include "localintermediate.h"
 
+#include <string>
+#include <vector>
+
 namespace hlsl2glsl
 {
 
+struct TPreprocessedSource;
+
 //
 // The following are extra variables needed during parsing, grouped together so
 // they can be passed to the parser without needing a global.
@@ -23,6 +29,7 @@ struct TParseContext
 	, infoSink(is)
 	, language(L)
 	, targetVersion(ver)
+	, targetDependent(false)
 	, options(opts)
 	, treeRoot(0)
 	, recoveredFromError(false)
@@ -34,6 +41,9 @@ struct TParseContext
 	, functionReturnsValue(false)
 	, AfterEOF(false)
 	, preprocessor(nullptr)
+	, preprocessed(nullptr)
+	, nextPreprocessedToken(0)
+	, flexScanner(false)
 	{
 	}
 	
@@ -42,6 +52,10 @@ struct TParseContext
 	bool reservedErrorCheck(const TSourceLoc& line, const TString& identifier);
 	void recover();
 
+	// Parsing only differs between targets before and after GLSL 1.20. Ask through this,
+	// so that a tree that never did can be used for every target.
+	bool isGLSL120Target() { targetDependent = true; return targetVersion >= ETargetGLSL_120; }
+
 	TQualifier getDefaultQualifier() const { return symbolTable.atGlobalLevel() ? EvqGlobal : EvqTemporary; }
 	
 	TIntermTyped* add_binary(TOperator op, TIntermTyped* a, TIntermTyped* b, TSourceLoc line, const char* name, bool boolResult);
@@ -59,8 +73,8 @@ struct TParseContext
 	bool arraySizeErrorCheck(const TSourceLoc& line, TIntermTyped* expr, int& size);
 	bool arrayQualifierErrorCheck(const TSourceLoc& line, TPublicType type);
 	bool arrayTypeErrorCheck(const TSourceLoc& line, TPublicType type);
-	bool arrayErrorCheck(const TSourceLoc& line, TString& identifier, TPublicType type, TVariable*& variable);
-	bool arrayErrorCheck(const TSourceLoc& line, TString& identifier, const TTypeInfo *info, TPublicType type, TVariable*& variable);
+	bool arrayErrorCheck(const TSourceLoc& line, const TString& identifier, TPublicType type, TVariable*& variable);
+	bool arrayErrorCheck(const TSourceLoc& line, const TString& identifier, const TTypeInfo *info, TPublicType type, TVariable*& variable);
 	bool insertBuiltInArrayAtGlobalLevel();
 	bool voidErrorCheck(const TSourceLoc& line, const TString&, const TPublicType&);
 	bool boolErrorCheck(const TSourceLoc& line, const TIntermTyped*);
@@ -70,14 +84,14 @@ struct TParseContext
 	bool structQualifierErrorCheck(const TSourceLoc& line, const TPublicType& pType);
 	bool parameterSamplerErrorCheck(const TSourceLoc& line, TQualifier qualifier, const TType& type);
 	bool containsSampler(TType& type);
-	bool nonInitConstErrorCheck(const TSourceLoc& line, TString& identifier, TPublicType& type);
-	bool nonInitErrorCheck(const TSourceLoc& line, TString& identifier, const TTypeInfo *info, TPublicType& type);
-	bool nonInitErrorCheck(const TSourceLoc& line, TString& identifier, TPublicType& type);
+	bool nonInitConstErrorCheck(const TSourceLoc& line, const TString& identifier, TPublicType& type);
+	bool nonInitErrorCheck(const TSourceLoc& line, const TString& identifier, const TTypeInfo *info, TPublicType& type);
+	bool nonInitErrorCheck(const TSourceLoc& line, const TString& identifier, TPublicType& type);
 	bool paramErrorCheck(const TSourceLoc& line, TQualifier qualifier, TQualifier paramQualifier, TType* type);
 	const TFunction* findFunction(const TSourceLoc& line, TFunction* pfnCall, bool *builtIn = 0);
-	bool executeInitializer(TSourceLoc line, TString& identifier, const TTypeInfo *info, TPublicType& pType, 
+	bool executeInitializer(TSourceLoc line, const TString& identifier, const TTypeInfo *info, TPublicType& pType, 
 						   TIntermTyped*& initializer, TIntermSymbol*& intermNode, TVariable* variable = 0);
-	bool executeInitializer(TSourceLoc line, TString& identifier, TPublicType& pType, 
+	bool executeInitializer(TSourceLoc line, const TString& identifier, TPublicType& pType, 
 						   TIntermTyped*& initializer, TIntermSymbol*& intermNode, TVariable* variable = 0);
 	TIntermTyped* addConstructor(TIntermNode*, const TType*, TOperator, TFunction*, TSourceLoc);
 	TIntermTyped* constructArray(TIntermAggregate*, const TType*, TOperator, TSourceLoc);
@@ -96,6 +110,7 @@ public:
 	
 	EShLanguage language;
 	ETargetVersion targetVersion;
+	bool targetDependent;        // true if the tree depends on targetVersion
 	unsigned options; // TTranslateOptions bitmask
 	
 	TIntermNode* treeRoot;       // root of parse tree being created
@@ -108,11 +123,49 @@ public:
 	bool functionReturnsValue;   // true if a non-void function has a return
 	bool AfterEOF;
 	void* preprocessor;
+	const TPreprocessedSource* preprocessed;  // read instead of running the preprocessor, if set
+	size_t nextPreprocessedToken;
+	bool flexScanner;  // hand tokens to the flex scanner as text, instead of straight to the parser
 };
 
-int PaParseString(char* source, TParseContext&, Hlsl2Glsl_ParseCallbacks* = NULL);
-void PaReservedWord(void*);
-int PaIdentOrType(TString& id, TParseContext&, TSymbol*&);
+//
+// Tokens the preprocessor produced for a shader, with the positions they came from,
+// so that they can be hashed, compared and parsed without preprocessing again.
+//
+struct TPreprocessedToken
+{
+	unsigned int offset;  // of the token text in TPreprocessedSource::text
+	unsigned int length;
+	unsigned int file;    // index in TPreprocessedSource::files
+	unsigned int line;
+	int type;             // the preprocessor's Token
+};
+
+struct TPreprocessedSource
+{
+	TPreprocessedSource() : error(false), outOfMemory(false) { }
+
+	std::string text;
+	std::vector<TPreprocessedToken> tokens;
+	std::vector<std::string> files;
+	TIncludeDependencies dependencies;  // every include, once per path
+	bool error;        // preprocessing stopped at an error, the last token is its message
+	bool outOfMemory;  // preprocessing stopped after the last token, out of memory
+};
+
+// Parse source, reading includes through callbacks and includeCache (may be NULL)
+int PaParseString(char* source, TParseContext&, Hlsl2Glsl_ParseCallbacks* = NULL, TIncludeCache* = NULL);
+// Parse tokens recorded by PaPreprocessString, the same as PaParseString would parse their source
+int PaParsePreprocessed(const TPreprocessedSource& source, TParseContext&);
+// Only run the scanner over recorded tokens, returns how many tokens the parser would get
+size_t PaScanPreprocessed(const TPreprocessedSource& source, TParseContext&);
+
+// Only preprocess source, resolving includes through callbacks and includeCache (may be NULL),
+// after defining the defineCount macros in defines. Returns false on preprocessing errors;
+// output then holds the tokens up to and including the error, and the includes up to it.
+bool PaPreprocessString(const char* source, Hlsl2Glsl_ParseCallbacks* callbacks, TIncludeCache* includeCache,
+	const Hlsl2Glsl_Define* defines, int defineCount, TPreprocessedSource& output);
+int PaIdentOrType(TAtom id, TParseContext&, TSymbol*&);
 int PaParseComment(TSourceLoc &lineno, TParseContext&, void*);
 void setInitialState();
 
@@ -5,21 +5,86 @@
 
 #include "SymbolTable.h"
 #include <algorithm>
+#include <vector>
 
 namespace hlsl2glsl
 {
 
 TString* TParameter::NullSemantic = 0;
 
+// The overload lists of a level are sorted by parameter count
+static bool countBeforeFunction(int paramCount, const TFunction* function)
+{
+	return paramCount < function->getParamCount();
+}
+
+static bool functionBeforeCount(const TFunction* function, int paramCount)
+{
+	return function->getParamCount() < paramCount;
+}
+
+TSymbolTableLevel::TSymbolTableLevel(TAtomTable& atoms)
+	: atoms(atoms), pool(GlobalPoolAllocator), slots(inlineSlots), mask(kInlineSlots - 1), shift(61), count(0), frozen(false)
+{
+	const TSlot empty = { 0, 0 };
+	std::fill(inlineSlots, inlineSlots + kInlineSlots, empty);
+}
+
 bool TSymbolTableLevel::insert(TSymbol& symbol) 
 {
 	//
 	// returning true means symbol was added to the table
 	//
-	tInsertResult result;
-	result = level.insert(tLevelPair(symbol.getMangledName(), &symbol));
+	symbol.internName(atoms);
+	TAtom name = atoms.intern(symbol.getMangledName());
+	if (slotOf(name)->name)
+		return false;
+	
+	if ((count + 1) * 2 > mask + 1)
+		grow();
+	TSlot* slot = slotOf(name);
+	slot->name = name;
+	slot->symbol = &symbol;
+	++count;
 	
-	return result.second;
+	if (symbol.isFunction())
+	{
+		TFunction* function = static_cast<TFunction*>(&symbol);
+		tOverloads& functions = overloads[function->getNameAtom()];
+		functions.insert(std::upper_bound(functions.begin(), functions.end(), function->getParamCount(), countBeforeFunction), function);
+	}
+	return true;
+}
+
+void TSymbolTableLevel::grow()
+{
+	TSlot* old = slots;
+	const size_t oldSize = mask + 1;
+	const TSlot empty = { 0, 0 };
+	slots = static_cast<TSlot*>(pool.allocate(oldSize * 2 * sizeof(TSlot)));
+	mask = oldSize * 2 - 1;
+	--shift;
+	std::fill(slots, slots + mask + 1, empty);
+
+	// The old slots stay in the pool until it is popped
+	for (size_t j = 0; j < oldSize; ++j)
+	{
+		if (old[j].name)
+			*slotOf(old[j].name) = old[j];
+	}
+}
+
+void TSymbolTableLevel::clear()
+{
+	assert(!frozen);
+	const TSlot empty = { 0, 0 };
+	for (size_t i = 0; i <= mask; ++i)
+	{
+		delete slots[i].symbol;
+		slots[i] = empty;
+	}
+	count = 0;
+	overloads.clear();
 }
 
 // Recursively generate mangled names.
@@ -196,9 +261,8 @@ void TFunction::dump(TInfoSink &infoSink) const
 
 void TSymbolTableLevel::dump(TInfoSink &infoSink) const 
 {
-	tLevel::const_iterator it;
-	for (it = level.begin(); it != level.end(); ++it)
-		(*it).second->dump(infoSink);
+	for (const_iterator it = begin(); it != end(); ++it)
+		it->symbol->dump(infoSink);
 }
 
 void TSymbolTable::dump(TInfoSink &infoSink) const
@@ -219,8 +283,8 @@ TFunction::~TFunction()
 
 TSymbolTableLevel::~TSymbolTableLevel()
 {
-	for (tLevel::iterator it = level.begin(); it != level.end(); ++it)
-		delete (*it).second;
+	for (size_t i = 0; i <= mask; ++i)
+		delete slots[i].symbol;
 }
 
 
@@ -230,12 +294,11 @@ TSymbolTableLevel::~TSymbolTableLevel()
 // live across a large number of compiles.
 void TSymbolTableLevel::relateToOperator(const char* name, TOperator op) 
 {
-	tLevel::iterator it;
-	for (it = level.begin(); it != level.end(); ++it)
+	for (const_iterator it = begin(); it != end(); ++it)
 	{
-		if ((*it).second->isFunction())
+		if (it->symbol->isFunction())
 		{
-			TFunction* function = static_cast<TFunction*>((*it).second);
+			TFunction* function = static_cast<TFunction*>(it->symbol);
 			if (function->getName() == name)
 				function->relateToOperator(op);
 		}
@@ -246,6 +309,8 @@ void TSymbolTableLevel::relateToOperator(const char* name, TOperator op)
 TSymbol::TSymbol(const TSymbol& copyOf)
 {
 	name = NewPoolTString(copyOf.name->c_str());
+	info = copyOf.info;
+	global = copyOf.global;
 	uniqueId = copyOf.uniqueId;
 }
 
@@ -288,65 +353,88 @@ TFunction* TFunction::clone(TStructureMap& remapper)
 }
 
 
-TSymbolTableLevel* TSymbolTableLevel::clone(TStructureMap& remapper)
+TSymbolTableLevel* TSymbolTableLevel::clone(TStructureMap& remapper, TAtomTable& cloneAtoms)
 {
-	TSymbolTableLevel *symTableLevel = new TSymbolTableLevel();
-	tLevel::iterator iter;
-	for (iter = level.begin(); iter != level.end(); ++iter)
+	TSymbolTableLevel *symTableLevel = new TSymbolTableLevel(cloneAtoms);
+	for (const_iterator it = begin(); it != end(); ++it)
 	{
-		symTableLevel->insert(*iter->second->clone(remapper));
+		symTableLevel->insert(*it->symbol->clone(remapper));
 	}
 	
 	return symTableLevel;
 }
 
 // This is the sort function for parameter matching in findCompatible method below
-bool parameterSizeSortFunction(TParameter left, TParameter right) {
+static bool parameterSizeSortFunction(const TParameter* left, const TParameter* right) {
 	// non-numeric types come first
-	if (!IsNumeric(left.type->getBasicType()))
+	if (!IsNumeric(left->type->getBasicType()))
 		return true;
-	else if (IsNumeric(left.type->getBasicType()) && !IsNumeric(right.type->getBasicType()))
+	else if (IsNumeric(left->type->getBasicType()) && !IsNumeric(right->type->getBasicType()))
 		return false;
 	// then sort according to numeric type's dimension in descending order
-	else return (left.type->getColsCount() >= right.type->getColsCount() && left.type->getRowsCount() >= right.type->getRowsCount());
+	else return (left->type->getColsCount() >= right->type->getColsCount() && left->type->getRowsCount() >= right->type->getRowsCount());
 }
 
 // This function uses the matching rules as described in the Cg language doc (the closest
 // thing we have to HLSL function matching description) to find a matching compatible function.  
-TSymbol* TSymbolTableLevel::findCompatible (const TFunction *call, bool &ambiguous) const
+TSymbol* TSymbolTableLevel::findCompatible (const TFunction *call, TAtom name, bool &ambiguous) const
 {
 	ambiguous = false;
+	if (!name)
+		return NULL;
 	
-	const TString &name = call->getName();   
-	std::vector<TFunction*> funcList;
+	tOverloadIndex::const_iterator overloadsIt = overloads.find(name);
+	if (overloadsIt == overloads.end())
+		return NULL;
 	
 	// 1 and 2. Add all functions with matching names and argument count to the set to consider
-	tLevel::const_iterator it = level.begin();
-	while (it != level.end())
+	const int paramCount = call->getParamCount();
+	const tOverloads& functions = overloadsIt->second;
+	tOverloads::const_iterator first = std::lower_bound(functions.begin(), functions.end(), paramCount, functionBeforeCount);
+	tOverloads::const_iterator last = std::upper_bound(first, functions.end(), paramCount, countBeforeFunction);
+	if (first == last)
+		return NULL;
+	
+	// Calls rarely have more overloads or arguments than fit on the stack
+	const size_t kLocalCount = 32;
+	TFunction* localFuncs[kLocalCount];
+	TType::ECompatibility localCompat[kLocalCount];
+	const TParameter* localParams[kLocalCount];
+	std::vector<TFunction*> heapFuncs;
+	std::vector<TType::ECompatibility> heapCompat;
+	std::vector<const TParameter*> heapParams;
+	
+	size_t funcCount = last - first;
+	TFunction** funcList = localFuncs;
+	TType::ECompatibility* compatList = localCompat;
+	if (funcCount > kLocalCount)
 	{
-		if (it->second->getName() == name && it->second->isFunction())
-		{
-			TFunction* func = (TFunction*)it->second;
-			if (call->getParamCount() == func->getParamCount())
-				funcList.push_back (func);
-		}
-		++it;
+		heapFuncs.resize(funcCount);
+		heapCompat.resize(funcCount);
+		funcList = &heapFuncs[0];
+		compatList = &heapCompat[0];
 	}
-		
+	std::copy(first, last, funcList);
+	
 	// HLSL follows different matching rules than Cg, e.g. step(float, float2) is matched as step(float2, float) by HLSL
 	// while Cg matches step(float, float). Sort parameters by dimensions in descending order instead of left-to-right
 	// to keep parameters promoting up.
-	TVector<TParameter> sortedParameters;
-	for ( int nParam = 0; nParam < call->getParamCount() ; nParam++ )
+	const TParameter** sortedParameters = localParams;
+	if (static_cast<size_t>(paramCount) > kLocalCount)
+	{
+		heapParams.resize(paramCount);
+		sortedParameters = &heapParams[0];
+	}
+	for ( int nParam = 0; nParam < paramCount ; nParam++ )
 	{
-		sortedParameters.push_back((*call)[nParam]);
+		sortedParameters[nParam] = &(*call)[nParam];
 	}
-	std::sort(sortedParameters.begin(), sortedParameters.end(), parameterSizeSortFunction);
+	std::sort(sortedParameters, sortedParameters + paramCount, parameterSizeSortFunction);
 	
 	// For each actual parameter expression, in the sequence:
-	for ( int nParam = 0; nParam < sortedParameters.size() ; nParam++ )
+	for ( int nParam = 0; nParam < paramCount ; nParam++ )
 	{
-		const TType* type0 = sortedParameters[nParam].type;
+		const TType* type0 = sortedParameters[nParam]->type;
 		
 		// From the Cg function matching rules, perform the following matching on each parameter
 		//
@@ -377,56 +465,43 @@ TSymbol* TSymbolTableLevel::findCompatible (const TFunction *call, bool &ambiguo
 			TType::UPWARD_VECTOR_PROMOTION_EXISTS
 		};
 		
+		// The compatibility of each remaining function with this parameter, which the tests below filter on
+		for ( size_t nFunc = 0; nFunc < funcCount; nFunc++ )
+		{
+			compatList[nFunc] = type0->determineCompatibility ( (*funcList[nFunc])[nParam].type );
+		}
+		
 		// Iterate over each matching type (declared above)
 		for ( int nIter = 0; nIter < sizeof(eCompatType) / sizeof (TType::ECompatibility); nIter++ )
 		{
-			bool bMatchesCompatibility = false;
-			
 			// Grab the compatibility type for the test
 			TType::ECompatibility eCompatibility = eCompatType[nIter];
 			
-			std::vector<TFunction*>::iterator funcIter = funcList.begin();
-			while (funcIter != funcList.end())
-			{
-				const TFunction* curFunc = *(funcIter);
-				const TType* type1 = (*curFunc)[nParam].type;
-				
-				// Check to see if the compatibility matches the compatibility type for this test
-				if ( type0->determineCompatibility ( type1 ) == eCompatibility )
-				{
-					bMatchesCompatibility = true;
-					break;               
-				}
-				
-				funcIter++;
-			}
-			
-			if ( bMatchesCompatibility )
+			// Check to see if any function matches the compatibility type for this test
+			if ( std::find ( compatList, compatList + funcCount, eCompatibility ) != compatList + funcCount )
 			{
 				// Remove all that don't match this compatibility test
-				funcIter = funcList.begin();
-				while ( funcIter != funcList.end() )
+				size_t kept = 0;
+				for ( size_t nFunc = 0; nFunc < funcCount; nFunc++ )
 				{
-					TFunction* curFunc = *(funcIter);
-					const TType* type1 = (*curFunc)[nParam].type;
-					
-					if ( type0->determineCompatibility ( type1 ) != eCompatibility )
+					if ( compatList[nFunc] == eCompatibility )
 					{
-						funcIter = funcList.erase ( funcIter );               
+						funcList[kept] = funcList[nFunc];
+						compatList[kept] = compatList[nFunc];
+						kept++;
 					}
-					else
-						funcIter++;
 				}
+				funcCount = kept;
 			}
 		}
 	}
 	
 	
 	// If the function list has 1 element, then we were successful
-	if ( funcList.size() == 1 )
-		return funcList.front();
+	if ( funcCount == 1 )
+		return funcList[0];
 	// If there is more than one element, it is ambiguous
-	else if ( funcList.size () > 1 )
+	else if ( funcCount > 1 )
 	{
 		ambiguous = true;
 		return NULL;
@@ -436,13 +511,156 @@ TSymbol* TSymbolTableLevel::findCompatible (const TFunction *call, bool &ambiguo
 	return NULL;
 }
 
+// Compute everything TType otherwise computes lazily (and allocates from the current
+// thread's pool), so that reading the symbol does not write to it.
+void TFunction::freeze()
+{
+	returnType.getMangledName();
+	for (unsigned int i = 0; i < parameters.size(); ++i)
+		parameters[i].type->getMangledName();
+}
+
+void TSymbolTableLevel::freeze()
+{
+	for (const_iterator it = begin(); it != end(); ++it)
+		it->symbol->freeze();
+	frozen = true;
+}
+
+void TSymbolTable::unshareBuiltIns()
+{
+	if (!sharedBuiltIns)
+		return;
+
+	TStructureMap remapper;
+	table[0] = table[0]->clone(remapper, atoms);
+	sharedBuiltIns = false;
+
+	// What calls resolved to were functions of the shared level
+	calls.clear();
+	builtInCallsSnapshot.reset();
+	newBuiltInCalls.clear();
+}
+
+void TSymbolTable::pop()
+{
+	TSymbolTableLevel* level = table.back();
+	table.pop_back();
+	// Calls might have resolved to functions of this level
+	if (level->hasFunctions())
+		calls.clear();
+	// The atoms are in the pool of the built-ins, which goes away with them
+	if (table.empty())
+	{
+		delete level;
+		releaseSpareLevels();
+		atoms.clear();
+		builtInCalls.reset();
+	}
+	// Back to the shared built-ins, at the end of a compile
+	else if (atSharedBuiltInLevel())
+	{
+		delete level;
+		releaseSpareLevels();
+		publishBuiltInCalls();
+	}
+	// Keep block scopes for the next ones, they come and go all the time
+	else
+	{
+		level->clear();
+		spareLevels.push_back(level);
+	}
+}
+
+void TSymbolTable::releaseSpareLevels()
+{
+	for (size_t i = 0; i < spareLevels.size(); ++i)
+		delete spareLevels[i];
+	spareLevels.clear();
+}
+
+TSymbol* TSymbolTable::resolveCall(const TFunction* call, bool* builtIn, bool& ambiguous)
+{
+	TAtom signature = atoms.intern(call->getMangledName());
+	std::unordered_map<TAtom, TCallResolution>::const_iterator it = calls.find(signature);
+	if (it == calls.end())
+	{
+		TCallResolution resolution = { 0, false, false };
+		const bool builtInsOnly = resolvesToBuiltInsOnly(atoms.find(call->getName()));
+		std::string key;
+		TBuiltInCallResolutions::TResolutions::const_iterator shared;
+		if (builtInsOnly)
+		{
+			key.assign(signature->c_str(), signature->size());
+			shared = builtInCallsSnapshot->find(key);
+		}
+		if (builtInsOnly && shared != builtInCallsSnapshot->end())
+		{
+			resolution = shared->second;
+		}
+		else
+		{
+			resolution.symbol = find(signature, &resolution.builtIn);
+			if (resolution.symbol == 0)
+				resolution.symbol = findCompatible(call, &resolution.builtIn, resolution.ambiguous);
+			if (builtInsOnly)
+				newBuiltInCalls.push_back(std::make_pair(key, resolution));
+		}
+		it = calls.insert(std::make_pair(signature, resolution)).first;
+	}
+
+	if (builtIn)
+		*builtIn = it->second.builtIn;
+	ambiguous = it->second.ambiguous;
+	return it->second.symbol;
+}
+
+// True if no level above the shared built-ins declares functions called name, so calls
+// of it resolve the same in every compile
+bool TSymbolTable::resolvesToBuiltInsOnly(TAtom name) const
+{
+	if (!sharedBuiltIns || !builtInCallsSnapshot)
+		return false;
+	for (int level = 1; level <= currentLevel(); ++level)
+	{
+		if (name && table[level]->hasOverloads(name))
+			return false;
+	}
+	return true;
+}
+
+void TSymbolTable::publishBuiltInCalls()
+{
+	if (builtInCalls && !newBuiltInCalls.empty())
+		builtInCalls->publish(newBuiltInCalls);
+	newBuiltInCalls.clear();
+	calls.clear();
+}
+
+std::shared_ptr<const TBuiltInCallResolutions::TResolutions> TBuiltInCallResolutions::snapshot() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	if (!current)
+		return std::make_shared<TResolutions>();
+	return current;
+}
+
+void TBuiltInCallResolutions::publish(const TPending& resolutions)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	std::shared_ptr<TResolutions> next = current ? std::make_shared<TResolutions>(*current) : std::make_shared<TResolutions>();
+	for (TPending::const_iterator it = resolutions.begin(); it != resolutions.end(); ++it)
+		next->insert(*it);
+	current = next;
+}
+
 void TSymbolTable::copyTable(const TSymbolTable& copyOf)
 {
 	TStructureMap remapper;
 	uniqueId = copyOf.uniqueId;
 	for (unsigned int i = 0; i < copyOf.table.size(); ++i)
 	{
-		table.push_back(copyOf.table[i]->clone(remapper));
+		table.push_back(copyOf.table[i]->clone(remapper, atoms));
 	}
 }
 
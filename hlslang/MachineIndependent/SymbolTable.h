@@ -29,9 +29,18 @@
 //   are tracked in the intermediate representation, not the symbol table.
 //
 
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
 #include "../Include/Common.h"
 #include "../Include/intermediate.h"
 #include "../Include/InfoSink.h"
+#include "AtomTable.h"
  
 namespace hlsl2glsl
 {
@@ -46,6 +55,9 @@ public:
 	TSymbol(const TString *n, const TTypeInfo *i) :  name(n), info(i), global(false) { }
 	virtual ~TSymbol() { /* don't delete name, it's from the pool */ }
 	const TString& getName() const { return *name; }
+	// Once the symbol is in a symbol table, its name is an atom of that table
+	TAtom getNameAtom() const { return name; }
+	void internName(TAtomTable& atoms) { if (name) name = atoms.intern(*name); }
 	const TTypeInfo* getInfo() const { return info; }
 	void setInfo( const TTypeInfo *i) {  info = i; }
 	virtual const TString& getMangledName() const { return getName(); }
@@ -56,6 +68,7 @@ public:
 	bool isGlobal() const { return global; }
 	void setGlobal(bool g) { global = g; }
 	virtual void dump(TInfoSink &infoSink) const = 0;	
+	virtual void freeze() { }
 	TSymbol(const TSymbol&);
 	virtual TSymbol* clone(TStructureMap& remapper) = 0;
 
@@ -99,6 +112,7 @@ public:
 	TType* getArrayInformationType() { return arrayInformationType; }
 	
 	virtual void dump(TInfoSink &infoSink) const;
+	virtual void freeze() { type.getMangledName(); }
 
 	TVariable(const TVariable&, TStructureMap& remapper); // copy constructor
 	virtual TVariable* clone(TStructureMap& remapper);
@@ -117,7 +131,7 @@ protected:
 //
 struct TParameter 
 {
-	TString *name;
+	const TString *name;
 	const TTypeInfo *info;
 	TType* type;
 	void copyParam(const TParameter& param, TStructureMap& remapper) 
@@ -173,6 +187,7 @@ public:
 	const TParameter& operator [](int i) const { return parameters[i]; }
     
 	virtual void dump(TInfoSink &infoSink) const;
+	virtual void freeze();
 	TFunction(const TFunction&, TStructureMap& remapper);
 	virtual TFunction* clone(TStructureMap& remapper);
     
@@ -186,43 +201,143 @@ protected:
 };
 
 
+//
+// The symbols of one scope. Open addressing by the atoms of their mangled names, so a
+// lookup hashes a pointer and compares pointers, never strings. The first few slots are
+// inside the level, which is all most block scopes need; bigger levels (the globals, the
+// built-ins) move to slots from the pool the level was made in.
+//
 class TSymbolTableLevel 
 {
 public:
 	POOL_ALLOCATOR_NEW_DELETE(GlobalPoolAllocator)
-	TSymbolTableLevel() { }
+	// Symbols are keyed by the atoms of their mangled names, from atoms
+	explicit TSymbolTableLevel(TAtomTable& atoms);
 	~TSymbolTableLevel();
+	TSymbolTableLevel(const TSymbolTableLevel&) = delete;
+	TSymbolTableLevel& operator=(const TSymbolTableLevel&) = delete;
     
 	bool insert(TSymbol& symbol);
 	
-	TSymbol* find(const TString& name) const
+	// Names without an atom (swizzles, names being declared) are in no level
+	TSymbol* find(TAtom name) const
 	{
-		tLevel::const_iterator it = level.find(name);
-		if (it == level.end())
-			return 0;
-		else
-			return (*it).second;
+		return name ? slotOf(name)->symbol : 0;
 	}
 	
-	// vector might be best switched to a special allocator
-	TSymbol* findCompatible( const TFunction *call, bool &ambiguous) const;
+	// The overload of name that best matches the arguments of call. Only looks at the
+	// functions of this level with that name and the call's number of parameters.
+	TSymbol* findCompatible( const TFunction *call, TAtom name, bool &ambiguous) const;
 	
+	// True if functions called name are declared in this level
+	bool hasOverloads(TAtom name) const { return overloads.find(name) != overloads.end(); }
+	bool hasFunctions() const { return !overloads.empty(); }
+
+	// Delete all symbols, so the level can be used for another scope. Keeps its slots.
+	void clear();
+
 	void relateToOperator(const char* name, TOperator op);
 	void dump(TInfoSink &infoSink) const;
-	TSymbolTableLevel* clone(TStructureMap& remapper);
+	TSymbolTableLevel* clone(TStructureMap& remapper, TAtomTable& cloneAtoms);
+
+	// After this the level is only read, so it can be shared between threads
+	void freeze();
+	bool isFrozen() const { return frozen; }
+
+	struct TSlot
+	{
+		TAtom name;
+		TSymbol* symbol;
+	};
+
+	// Iterates the symbols of the level, in no particular order
+	class const_iterator
+	{
+	public:
+		const_iterator(const TSlot* slot, const TSlot* end) : slot(slot), end(end) { skipEmpty(); }
+		const TSlot& operator*() const { return *slot; }
+		const TSlot* operator->() const { return slot; }
+		const_iterator& operator++() { ++slot; skipEmpty(); return *this; }
+		bool operator==(const const_iterator& other) const { return slot == other.slot; }
+		bool operator!=(const const_iterator& other) const { return slot != other.slot; }
+	private:
+		void skipEmpty() { while (slot != end && !slot->name) ++slot; }
+		const TSlot* slot;
+		const TSlot* end;
+	};
+	const_iterator begin() const { return const_iterator(slots, slots + mask + 1); }
+	const_iterator end() const { return const_iterator(slots + mask + 1, slots + mask + 1); }
     
 protected:
-	typedef std::map<TString, TSymbol*, std::less<TString>, pool_allocator<std::pair<const TString, TSymbol*> > > tLevel;
-	typedef const tLevel::value_type tLevelPair;
-	typedef std::pair<tLevel::iterator, bool> tInsertResult;
-	
-	tLevel level;
+	// The slot of name, or the empty slot where it would go
+	TSlot* slotOf(TAtom name) const
+	{
+		size_t i = Hash(name, shift);
+		while (slots[i].name && slots[i].name != name)
+			i = (i + 1) & mask;
+		return &slots[i];
+	}
+	static size_t Hash(TAtom name, unsigned shift)
+	{
+		// Atoms are pool strings, so the low bits of their addresses are always the same.
+		// The product is 64 bits wide whatever size_t is, and its top bits index the slots.
+		const uint64_t key = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(name) >> 3);
+		return static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> shift);
+	}
+	void grow();
+
+	// Functions of the level by the atoms of their plain names, each list sorted by
+	// parameter count, so overload resolution does not have to scan the whole level
+	typedef TVector<TFunction*> tOverloads;
+	typedef std::unordered_map<TAtom, tOverloads, std::hash<TAtom>, std::equal_to<TAtom>, pool_allocator<std::pair<const TAtom, tOverloads> > > tOverloadIndex;
+
+	static const size_t kInlineSlots = 8;
+
+	TAtomTable& atoms;
+	TPoolAllocator& pool;       // where slots come from once the level outgrows its own
+	TSlot* slots;               // a power of two of them, at most half of them used
+	size_t mask;
+	unsigned shift;             // 64 less log2 of the slot count
+	size_t count;
+	TSlot inlineSlots[kInlineSlots];
+	tOverloadIndex overloads;
+	bool frozen;
+};
+
+//
+// What a call resolved to: the function, or none, or more than one equally good.
+//
+struct TCallResolution
+{
+	TSymbol* symbol;
+	bool builtIn;
+	bool ambiguous;
+};
+
+//
+// Call resolutions that only depend on the shared built-in level, keyed by the mangled
+// name of the call, kept with that level for all compiles to read. Compiles read a
+// snapshot that never changes, and publish what they resolved when they are done,
+// which replaces the snapshot with a bigger one.
+//
+class TBuiltInCallResolutions
+{
+public:
+	typedef std::unordered_map<std::string, TCallResolution> TResolutions;
+	typedef std::vector<std::pair<std::string, TCallResolution> > TPending;
+
+	std::shared_ptr<const TResolutions> snapshot() const;
+	void publish(const TPending& resolutions);
+
+private:
+	mutable std::mutex mutex;
+	std::shared_ptr<const TResolutions> current;
 };
 
 
 class TSymbolTable {
 public:
-	TSymbolTable() : uniqueId(0)
+	TSymbolTable() : uniqueId(0), sharedBuiltIns(false)
 	{
 		//
 		// The symbol table cannot be used until push() is called, but
@@ -231,10 +346,19 @@ public:
 		//
 	}
 
-	TSymbolTable(TSymbolTable& symTable)
+	//
+	// Shares the built-in level of symTable, which has to be frozen. It is never
+	// modified through this table (a private copy is made first if that is needed),
+	// so any number of tables on any number of threads can share it.
+	//
+	TSymbolTable(const TSymbolTable& symTable) : atoms(&symTable.atoms), sharedBuiltIns(true)
 	{
+		assert(symTable.table[0]->isFrozen());
 		table.push_back(symTable.table[0]);
 		uniqueId = symTable.uniqueId;
+		builtInCalls = symTable.builtInCalls;
+		if (builtInCalls)
+			builtInCallsSnapshot = builtInCalls->snapshot();
 	}
 
 	~TSymbolTable()
@@ -255,23 +379,35 @@ public:
 	bool atGlobalLevel() const { return table.size() <= 3; }
 	void push() 
 	{ 
-		table.push_back(new TSymbolTableLevel);
+		if (spareLevels.empty())
+			table.push_back(new TSymbolTableLevel(atoms));
+		else
+		{
+			table.push_back(spareLevels.back());
+			spareLevels.pop_back();
+		}
 	}
 
-	void pop() 
-	{ 
-		delete table[currentLevel()]; 
-		table.pop_back(); 
-	}
+	void pop();
 
 	bool insert(TSymbol& symbol)
 	{
+		if (atSharedBuiltInLevel())
+			unshareBuiltIns();
+		// A new overload can change what calls resolve to
+		if (symbol.isFunction())
+			calls.clear();
 		symbol.setGlobal(atGlobalLevel());
 		symbol.setUniqueId(++uniqueId);
 		return table[currentLevel()]->insert(symbol);
 	}
 
 	TSymbol* find(const TString& name, bool* builtIn = 0, bool *sameScope = 0) 
+	{
+		return find(atoms.find(name), builtIn, sameScope);
+	}
+
+	TSymbol* find(TAtom name, bool* builtIn = 0, bool *sameScope = 0) 
 	{
 		int level = currentLevel();
 		TSymbol* symbol;
@@ -293,11 +429,12 @@ public:
 	{
 		int level = currentLevel();
 		TSymbol *symbol = 0;
+		TAtom name = atoms.find(call->getName());
 		ambiguous = false;
 
 		do 
 		{
-			symbol = table[level]->findCompatible(call, ambiguous);
+			symbol = table[level]->findCompatible(call, name, ambiguous);
 			--level;
 		} while ( symbol == 0 && level >= 0 && !ambiguous);
 			
@@ -307,17 +444,57 @@ public:
 		return symbol;
 	}
 
+	// The function call resolves to: the one with the same mangled name if there is one,
+	// or else what findCompatible picks. The answers are remembered for the compile.
+	TSymbol* resolveCall(const TFunction* call, bool* builtIn, bool& ambiguous);
+
 	TSymbolTableLevel* getGlobalLevel() { assert(table.size() >= 3); return table[2]; }
-	void relateToOperator(const char* name, TOperator op) { table[0]->relateToOperator(name, op); }
+	const TSymbolTableLevel* getSharedBuiltInLevel() const { assert(!isEmpty()); return table[0]; }
+	int getUniqueId() const { return uniqueId; }
+	TAtomTable& getAtoms() { return atoms; }
+
+	// Use an already filled level as the shared built-in level, ids up to lastUniqueId are taken by it
+	void pushSharedBuiltInLevel(TSymbolTableLevel* builtIns, int lastUniqueId)
+	{
+		assert(isEmpty());
+		table.push_back(builtIns);
+		uniqueId = lastUniqueId;
+	}
+
+	void relateToOperator(const char* name, TOperator op) { unshareBuiltIns(); table[0]->relateToOperator(name, op); }
 	void dump(TInfoSink &infoSink) const;
 	void copyTable(const TSymbolTable& copyOf);
+	void freezeBuiltIns()
+	{
+		table[0]->freeze();
+		atoms.freeze();
+		builtInCalls = std::make_shared<TBuiltInCallResolutions>();
+	}
 
 protected:    
 	int currentLevel() const { return static_cast<int>(table.size()) - 1; }
 	bool atDynamicBuiltInLevel() const { return table.size() == 2; }
+	void unshareBuiltIns();
+	bool resolvesToBuiltInsOnly(TAtom name) const;
+	void publishBuiltInCalls();
+	void releaseSpareLevels();
 
+	TAtomTable atoms; // chained to the atoms of the shared built-ins
 	std::vector<TSymbolTableLevel*> table;
+	// Emptied levels for push to reuse. They are in the pool of the compile that popped
+	// them, so they only live as long as it does.
+	std::vector<TSymbolTableLevel*> spareLevels;
 	int uniqueId;     // for unique identification in code generation
+	bool sharedBuiltIns; // table[0] belongs to another symbol table
+
+	// Calls resolved so far, by the atoms of their mangled names. Forgotten whenever the
+	// functions in the table change.
+	std::unordered_map<TAtom, TCallResolution> calls;
+	// Resolutions that only depend on the shared built-ins: those of earlier compiles, and
+	// those of this compile to publish for later ones
+	std::shared_ptr<TBuiltInCallResolutions> builtInCalls;
+	std::shared_ptr<const TBuiltInCallResolutions::TResolutions> builtInCallsSnapshot;
+	TBuiltInCallResolutions::TPending newBuiltInCalls;
 };
 
 } // namespace hlsl2glsl
@@ -0,0 +1,153 @@
+// Copyright (c) The HLSL2GLSLFork Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE.txt file.
+
+
+#include "ThreadPool.h"
+
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+namespace hlsl2glsl
+{
+
+namespace {
+
+// Tasks are never added after the start, so a worker's deque is just the
+// range [front, back) of task indices that it has not handed out yet.
+struct TWorkQueue
+{
+	std::mutex mutex;
+	int front;
+	int back;
+
+	bool popFront(int& task)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (front == back)
+			return false;
+		task = front++;
+		return true;
+	}
+
+	bool stealBack(int& task)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (front == back)
+			return false;
+		task = --back;
+		return true;
+	}
+};
+
+
+struct TRunState
+{
+	const std::function<void(int)>* task;
+	const std::function<void()>* threadExit;
+	std::vector<std::unique_ptr<TWorkQueue> > queues;
+	std::atomic<bool> failed;
+	std::mutex errorMutex;
+	std::exception_ptr error;
+};
+
+
+static void RunTasks(TRunState& state, int self)
+{
+	const int queueCount = static_cast<int>(state.queues.size());
+	TWorkQueue& own = *state.queues[self];
+
+	while (!state.failed.load(std::memory_order_relaxed))
+	{
+		int task;
+		bool found = own.popFront(task);
+		for (int i = 1; !found && i < queueCount; ++i)
+			found = state.queues[(self + i) % queueCount]->stealBack(task);
+
+		// Nothing left anywhere, and nothing will be added
+		if (!found)
+			return;
+
+		try
+		{
+			(*state.task)(task);
+		}
+		catch (...)
+		{
+			std::lock_guard<std::mutex> lock(state.errorMutex);
+			if (!state.error)
+				state.error = std::current_exception();
+			state.failed = true;
+		}
+	}
+}
+
+static void RunWorkerThread(TRunState& state, int self)
+{
+	RunTasks(state, self);
+
+	if (*state.threadExit)
+		(*state.threadExit)();
+}
+
+} // namespace
+
+
+TWorkStealingPool::TWorkStealingPool(int threads)
+:	threadCount(threads)
+{
+	if (threadCount <= 0)
+		threadCount = static_cast<int>(std::thread::hardware_concurrency());
+	if (threadCount <= 0)
+		threadCount = 1;
+}
+
+
+void TWorkStealingPool::run(int taskCount, const std::function<void(int)>& task, const std::function<void()>& threadExit)
+{
+	if (taskCount <= 0)
+		return;
+
+	const int workerCount = threadCount < taskCount ? threadCount : taskCount;
+
+	TRunState state;
+	state.task = &task;
+	state.threadExit = &threadExit;
+	state.failed = false;
+
+	// Hand out contiguous blocks, so neighbouring jobs tend to run on the same thread
+	for (int i = 0; i < workerCount; ++i)
+	{
+		std::unique_ptr<TWorkQueue> queue(new TWorkQueue);
+		queue->front = static_cast<int>(static_cast<long long>(taskCount) * i / workerCount);
+		queue->back = static_cast<int>(static_cast<long long>(taskCount) * (i + 1) / workerCount);
+		state.queues.push_back(std::move(queue));
+	}
+
+	std::vector<std::thread> threads;
+	threads.reserve(workerCount - 1);
+	try
+	{
+		for (int i = 1; i < workerCount; ++i)
+			threads.push_back(std::thread(RunWorkerThread, std::ref(state), i));
+	}
+	catch (const std::system_error&)
+	{
+		// Out of threads: the queues of workers that did not start get stolen by the others
+	}
+
+	RunTasks(state, 0);
+
+	for (size_t i = 0; i < threads.size(); ++i)
+		threads[i].join();
+
+	if (state.error)
+		std::rethrow_exception(state.error);
+}
+
+} // namespace hlsl2glsl
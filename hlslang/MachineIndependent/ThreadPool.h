@@ -0,0 +1,46 @@
+// Copyright (c) The HLSL2GLSLFork Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE.txt file.
+
+
+#ifndef _THREAD_POOL_INCLUDED_
+#define _THREAD_POOL_INCLUDED_
+
+//
+// Work-stealing pool for running many independent tasks, e.g. the jobs of
+// Hlsl2Glsl_CompileBatch.
+//
+// Every worker owns a deque of task indices, initially one contiguous block of them.
+// A worker takes tasks from the front of its own deque and, once that runs dry,
+// steals from the back of the other deques. Workers live for one run() call; all
+// per-thread compiler state (pool allocator, parse context) is set up once per worker
+// and reused by every task the worker picks up.
+//
+
+#include <functional>
+
+namespace hlsl2glsl
+{
+
+class TWorkStealingPool
+{
+public:
+	/// threadCount <= 0 uses one thread per hardware thread
+	explicit TWorkStealingPool(int threadCount);
+
+	int getThreadCount() const { return threadCount; }
+
+	/// Call task(i) once for every i in [0, taskCount), and wait until all of them are done.
+	/// The calling thread is one of the workers. If a task throws, the first exception is
+	/// rethrown here after all workers stopped. threadExit, if set, is called on every
+	/// worker thread started by the pool right before it exits.
+	void run(int taskCount, const std::function<void(int)>& task,
+		const std::function<void()>& threadExit = std::function<void()>());
+
+private:
+	int threadCount;
+};
+
+} // namespace hlsl2glsl
+
+#endif // _THREAD_POOL_INCLUDED_
@@ -0,0 +1,149 @@
+// Copyright (c) The HLSL2GLSLFork Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE.txt file.
+
+
+#include "TypeTable.h"
+
+namespace hlsl2glsl
+{
+
+namespace
+{
+
+thread_local TTypeTable* sTypeTable = 0;
+
+bool SameString(const TString* a, const TString* b)
+{
+	return a == b || (a && b && *a == *b);
+}
+
+// FNV-1a steps
+unsigned int Mix(unsigned int hash, unsigned int value)
+{
+	return (hash ^ value) * 16777619u;
+}
+
+unsigned int MixString(unsigned int hash, const TString* s)
+{
+	if (!s)
+		return Mix(hash, 0);
+	for (size_t i = 0; i < s->size(); ++i)
+		hash = Mix(hash, static_cast<unsigned char>((*s)[i]));
+	return Mix(hash, static_cast<unsigned int>(s->size()));
+}
+
+unsigned int MixPointer(unsigned int hash, const void* p)
+{
+	const size_t value = reinterpret_cast<size_t>(p);
+	return Mix(Mix(hash, static_cast<unsigned int>(value)), static_cast<unsigned int>(value >> 16 >> 16));
+}
+
+} // namespace
+
+
+bool TType::sameAs(const TType& right) const
+{
+	return type == right.type &&
+		precision == right.precision &&
+		qualifier == right.qualifier &&
+		matrows == right.matrows &&
+		matcols == right.matcols &&
+		matrix == right.matrix &&
+		array == right.array &&
+		arraySize == right.arraySize &&
+		maxArraySize == right.maxArraySize &&
+		structure == right.structure &&
+		arrayInformationType == right.arrayInformationType &&
+		SameString(fieldName, right.fieldName) &&
+		SameString(typeName, right.typeName) &&
+		SameString(semantic, right.semantic);
+}
+
+unsigned int TType::hash() const
+{
+	unsigned int h = 2166136261u;
+	h = Mix(h, type | (precision << 8) | (qualifier << 16));
+	h = Mix(h, matrows | (matcols << 8) | (matrix << 16) | (array << 17));
+	h = Mix(h, arraySize);
+	h = Mix(h, maxArraySize);
+	h = MixPointer(h, structure);
+	h = MixPointer(h, arrayInformationType);
+	h = MixString(h, fieldName);
+	h = MixString(h, typeName);
+	h = MixString(h, semantic);
+	return h;
+}
+
+
+const TType* InternType(const TType& type)
+{
+	if (sTypeTable)
+		return sTypeTable->intern(type);
+	return new TType(type);
+}
+
+TTypeTable* SetGlobalTypeTable(TTypeTable* table)
+{
+	TTypeTable* previous = sTypeTable;
+	sTypeTable = table;
+	return previous;
+}
+
+
+const TType* TTypeTable::intern(const TType& type)
+{
+	const unsigned int hash = type.hash();
+	if (!slots.empty())
+	{
+		const size_t mask = slots.size() - 1;
+		for (size_t i = hash & mask; slots[i].type; i = (i + 1) & mask)
+		{
+			if (slots[i].hash == hash && slots[i].type->sameAs(type))
+				return slots[i].type;
+		}
+	}
+
+	if ((count + 1) * 2 > slots.size())
+		grow();
+
+	TType* shared = new TType(type);
+	shared->setLine(gNullSourceLoc);
+	const size_t mask = slots.size() - 1;
+	size_t i = hash & mask;
+	while (slots[i].type)
+		i = (i + 1) & mask;
+	slots[i].hash = hash;
+	slots[i].type = shared;
+	++count;
+	return shared;
+}
+
+
+void TTypeTable::clear()
+{
+	slots.clear();
+	count = 0;
+}
+
+
+void TTypeTable::grow()
+{
+	std::vector<TSlot> old;
+	old.swap(slots);
+	const TSlot empty = { 0, 0 };
+	slots.resize(old.empty() ? 64 : old.size() * 2, empty);
+
+	const size_t mask = slots.size() - 1;
+	for (size_t j = 0; j < old.size(); ++j)
+	{
+		if (!old[j].type)
+			continue;
+		size_t i = old[j].hash & mask;
+		while (slots[i].type)
+			i = (i + 1) & mask;
+		slots[i] = old[j];
+	}
+}
+
+} // namespace hlsl2glsl
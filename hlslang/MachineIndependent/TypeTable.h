@@ -0,0 +1,58 @@
+// Copyright (c) The HLSL2GLSLFork Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE.txt file.
+
+
+#ifndef _TYPE_TABLE_INCLUDED_
+#define _TYPE_TABLE_INCLUDED_
+
+//
+// Hash-consed types of syntax tree nodes. Most nodes have one of a few types (float, the
+// float vectors, the type of a variable they read), so nodes point at one shared copy of
+// each type instead of holding their own. The copies are made in the pool of the tree and
+// never change; a node that changes its type gets its own copy first.
+//
+// A compiler's table is made current, like its pool, for as long as the compiler works
+// on its tree.
+//
+
+#include <vector>
+
+#include "../Include/Common.h"
+#include "../Include/Types.h"
+
+namespace hlsl2glsl
+{
+
+class TTypeTable
+{
+public:
+	TTypeTable() : count(0) { }
+
+	/// The shared copy of type, made in the current pool the first time it is asked for
+	const TType* intern(const TType& type);
+
+	// Forget all types, when the pool they are in goes away
+	void clear();
+
+	size_t size() const { return count; }
+
+private:
+	struct TSlot
+	{
+		unsigned int hash;
+		const TType* type;
+	};
+
+	void grow();
+
+	std::vector<TSlot> slots;   // open addressing, a power of two in size
+	size_t count;
+};
+
+// The table InternType uses on this thread, NULL for none. Returns the previous one.
+TTypeTable* SetGlobalTypeTable(TTypeTable* table);
+
+} // namespace hlsl2glsl
+
+#endif // _TYPE_TABLE_INCLUDED_
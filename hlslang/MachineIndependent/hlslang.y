@@ -23,6 +23,7 @@ Jutta Degener, 1995
 
 #include "SymbolTable.h"
 #include "ParseHelper.h"
+#include "Keywords.h"
 #include "../../include/hlsl2glsl.h"
 
 // Bring types from hlsl2glsl into scope
@@ -38,7 +39,7 @@ namespace hlsl2glsl { void yyerror(TParseContext&, void* /*scanner*/, const char
 }
 
 #define NONSQUARE_MATRIX_CHECK(S, L) { \
-	if (parseContext.targetVersion < ETargetGLSL_120) { \
+	if (!parseContext.isGLSL120Target()) { \
 		parseContext.error(L, " not supported in pre-GLSL1.20", S, "", ""); \
 		parseContext.recover(); \
 	} \
@@ -54,16 +55,28 @@ namespace hlsl2glsl { void yyerror(TParseContext&, void* /*scanner*/, const char
 	(RES).setBasic(T, qual, (PAR).line); \
 	(RES).precision = PREC
 
+// The type of a type keyword, its shape comes decoded from the keyword table
+#define SET_KEYWORD_TYPE(RES,PAR) \
+	const TKeyword& keyword = *(PAR).keyword; \
+	if (keyword.matrix && keyword.rows != keyword.cols) \
+		NONSQUARE_MATRIX_CHECK(keyword.name, (PAR).line); \
+	SET_BASIC_TYPE(RES,PAR,keyword.basicType,keyword.precision); \
+	if (keyword.matrix) \
+		(RES).setMatrix(keyword.cols, keyword.rows); \
+	else if (keyword.cols > 1) \
+		(RES).setVector(keyword.cols)
+
 
 %}
 %union {
     struct {
         hlsl2glsl::TSourceLoc line;
         union {
-            hlsl2glsl::TString *string;
+            const hlsl2glsl::TString *string;  // an atom of the symbol table
             float f;
             int i;
             bool b;
+            const hlsl2glsl::TKeyword* keyword;  // of type keywords
         };
         hlsl2glsl::TSymbol* symbol;
     } lex;
@@ -306,7 +319,7 @@ postfix_expression
         else if ($1->isVector())       
             $$->setType(TType($1->getBasicType(), $1->getPrecision(), EvqTemporary));
         else
-            $$->setType($1->getType());
+            $$->setType(*$1);
     }
     | function_call {
         $$ = $1;
@@ -1195,7 +1208,7 @@ init_declarator_list
         if (parseContext.nonInitErrorCheck($3.line, *$3.string, $4, type))
             parseContext.recover();
 		
-		TSymbol* sym = parseContext.symbolTable.find(*$3.string);
+		TSymbol* sym = parseContext.symbolTable.find($3.string);
 		if (!sym)
 			$$ = $1;
 		else
@@ -1322,7 +1335,7 @@ init_declarator_list
         TIntermSymbol* symbol;
 		if ( !IsSampler(type.type)) {
 			if (!parseContext.executeInitializer($3.line, *$3.string, $4, type, $6, symbol)) {
-				TSymbol* variable = parseContext.symbolTable.find(*$3.string);
+				TSymbol* variable = parseContext.symbolTable.find($3.string);
 				if (!variable)
 					$$ = $1;
 				else 				
@@ -1361,7 +1374,7 @@ single_declaration
         if (error &= parseContext.nonInitErrorCheck($2.line, *$2.string, $3, $1))
             parseContext.recover();
 		
-		TSymbol* symbol = parseContext.symbolTable.find(*$2.string);
+		TSymbol* symbol = parseContext.symbolTable.find($2.string);
 		if (!error && symbol) {
 			$$ = ir_add_declaration(symbol, NULL, $2.line, parseContext);
 		} else {
@@ -1384,7 +1397,7 @@ single_declaration
                 parseContext.recover();
         }
 		
-		TSymbol* symbol = parseContext.symbolTable.find(*$2.string);
+		TSymbol* symbol = parseContext.symbolTable.find($2.string);
 		if (symbol) {
 			$$ = ir_add_declaration(symbol, NULL, $2.line, parseContext);
 		} else {
@@ -1498,7 +1511,7 @@ single_declaration
 			if (parseContext.nonInitErrorCheck($2.line, *$2.string, $3, $1))
 				parseContext.recover();
 				
-			TSymbol* symbol = parseContext.symbolTable.find(*$2.string);
+			TSymbol* symbol = parseContext.symbolTable.find($2.string);
 			if (symbol) {
 				$$ = ir_add_declaration(symbol, NULL, $2.line, parseContext);
 			} else {
@@ -1580,22 +1593,22 @@ type_specifier
 
 type_specifier_nonarray
     : VOID_TYPE {
-        SET_BASIC_TYPE($$,$1,EbtVoid,EbpUndefined);
+        SET_KEYWORD_TYPE($$,$1);
     }
     | FLOAT_TYPE {
-        SET_BASIC_TYPE($$,$1,EbtFloat,EbpHigh);
+        SET_KEYWORD_TYPE($$,$1);
     }
     | HALF_TYPE {
-        SET_BASIC_TYPE($$,$1,EbtFloat,EbpMedium);
+        SET_KEYWORD_TYPE($$,$1);
     }
     | FIXED_TYPE {
-        SET_BASIC_TYPE($$,$1,EbtFloat,EbpLow);
+        SET_KEYWORD_TYPE($$,$1);
     }
     | INT_TYPE {
-        SET_BASIC_TYPE($$,$1,EbtInt,EbpHigh);
+        SET_KEYWORD_TYPE($$,$1);
     }
     | BOOL_TYPE {
-        SET_BASIC_TYPE($$,$1,EbtBool,EbpHigh);
+        SET_KEYWORD_TYPE($$,$1);
     }
     | VECTOR LEFT_ANGLE FLOAT_TYPE COMMA INTCONSTANT RIGHT_ANGLE {
         TQualifier qual = parseContext.getDefaultQualifier();
@@ -1631,236 +1644,176 @@ type_specifier_nonarray
         }
     }
     | VEC2 {
-        SET_BASIC_TYPE($$,$1,EbtFloat,EbpHigh);
-        $$.setVector(2);
+        SET_KEYWORD_TYPE($$,$1);
     }
     | VEC3 {
-        SET_BASIC_TYPE($$,$1,EbtFloat,EbpHigh);
-        $$.setVector(3);
+        SET_KEYWORD_TYPE($$,$1);
     }
     | VEC4 {
-        SET_BASIC_TYPE($$,$1,EbtFloat,EbpHigh);
-        $$.setVector(4);
+        SET_KEYWORD_TYPE($$,$1);
     }
     | HVEC2 {
-        SET_BASIC_TYPE($$,$1,EbtFloat,EbpMedium);
-        $$.setVector(2);
+        SET_KEYWORD_TYPE($$,$1);
     }
     | HVEC3 {
-        SET_BASIC_TYPE($$,$1,EbtFloat,EbpMedium);
-        $$.setVector(3);
+        SET_KEYWORD_TYPE($$,$1);
     }
     | HVEC4 {
-        SET_BASIC_TYPE($$,$1,EbtFloat,EbpMedium);
-        $$.setVector(4);
+        SET_KEYWORD_TYPE($$,$1);
     }
     | FVEC2 {
-        SET_BASIC_TYPE($$,$1,EbtFloat,EbpLow);
-        $$.setVector(2);
+        SET_KEYWORD_TYPE($$,$1);
     }
     | FVEC3 {
-        SET_BASIC_TYPE($$,$1,EbtFloat,EbpLow);
-        $$.setVector(3);
+        SET_KEYWORD_TYPE($$,$1);
     }
     | FVEC4 {
-        SET_BASIC_TYPE($$,$1,EbtFloat,EbpLow);
-        $$.setVector(4);
+        SET_KEYWORD_TYPE($$,$1);
     }
     | BVEC2 {
-        SET_BASIC_TYPE($$,$1,EbtBool,EbpHigh);
-        $$.setVector(2);
+        SET_KEYWORD_TYPE($$,$1);
     }
     | BVEC3 {
-        SET_BASIC_TYPE($$,$1,EbtBool,EbpHigh);
-        $$.setVector(3);
+        SET_KEYWORD_TYPE($$,$1);
     }
     | BVEC4 {
-        SET_BASIC_TYPE($$,$1,EbtBool,EbpHigh);
-        $$.setVector(4);
+        SET_KEYWORD_TYPE($$,$1);
     }
     | IVEC2 {
-        SET_BASIC_TYPE($$,$1,EbtInt,EbpHigh);
-        $$.setVector(2);
+        SET_KEYWORD_TYPE($$,$1);
     }
     | IVEC3 {
-        SET_BASIC_TYPE($$,$1,EbtInt,EbpHigh);
-        $$.setVector(3);
+        SET_KEYWORD_TYPE($$,$1);
     }
     | IVEC4 {
-        SET_BASIC_TYPE($$,$1,EbtInt,EbpHigh);
-        $$.setVector(4);
+        SET_KEYWORD_TYPE($$,$1);
     }
     | MATRIX2x2 {
-        SET_BASIC_TYPE($$,$1,EbtFloat,EbpHigh);
-        $$.setMatrix(2, 2);
+        SET_KEYWORD_TYPE($$,$1);
     }
     | MATRIX2x3 {
-		NONSQUARE_MATRIX_CHECK("float2x3", $1.line);
-        SET_BASIC_TYPE($$,$1,EbtFloat,EbpHigh);
-        $$.setMatrix(3, 2);
+        SET_KEYWORD_TYPE($$,$1);
     }
     | MATRIX2x4 {
-		NONSQUARE_MATRIX_CHECK("float2x4", $1.line);
-        SET_BASIC_TYPE($$,$1,EbtFloat,EbpHigh);
-        $$.setMatrix(4, 2);
+        SET_KEYWORD_TYPE($$,$1);
     }
     | MATRIX3x2 {
-		NONSQUARE_MATRIX_CHECK("float3x2", $1.line);
-        SET_BASIC_TYPE($$,$1,EbtFloat,EbpHigh);
-        $$.setMatrix(2, 3);
+        SET_KEYWORD_TYPE($$,$1);
     }
     | MATRIX3x3 {
-        SET_BASIC_TYPE($$,$1,EbtFloat,EbpHigh);
-        $$.setMatrix(3, 3);
+        SET_KEYWORD_TYPE($$,$1);
     }
     | MATRIX3x4 {
-		NONSQUARE_MATRIX_CHECK("float3x4", $1.line);
-        SET_BASIC_TYPE($$,$1,EbtFloat,EbpHigh);
-        $$.setMatrix(4, 3);
+        SET_KEYWORD_TYPE($$,$1);
     }
     | MATRIX4x2 {
-		NONSQUARE_MATRIX_CHECK("float4x2", $1.line);
-        SET_BASIC_TYPE($$,$1,EbtFloat,EbpHigh);
-        $$.setMatrix(2, 4);
+        SET_KEYWORD_TYPE($$,$1);
     }
     | MATRIX4x3 {
-		NONSQUARE_MATRIX_CHECK("float4x3", $1.line);
-        SET_BASIC_TYPE($$,$1,EbtFloat,EbpHigh);
-        $$.setMatrix(3, 4);
+        SET_KEYWORD_TYPE($$,$1);
     }
     | MATRIX4x4 {
-        SET_BASIC_TYPE($$,$1,EbtFloat,EbpHigh);
-        $$.setMatrix(4, 4);
+        SET_KEYWORD_TYPE($$,$1);
     }
     | HMATRIX2x2 {
-        SET_BASIC_TYPE($$,$1,EbtFloat,EbpMedium);
-        $$.setMatrix(2, 2);
+        SET_KEYWORD_TYPE($$,$1);
     }
     | HMATRIX2x3 {
-		NONSQUARE_MATRIX_CHECK("half2x3", $1.line);
-        SET_BASIC_TYPE($$,$1,EbtFloat,EbpMedium);
-        $$.setMatrix(3, 2);
+        SET_KEYWORD_TYPE($$,$1);
     }
     | HMATRIX2x4 {
-		NONSQUARE_MATRIX_CHECK("half2x4", $1.line);
-        SET_BASIC_TYPE($$,$1,EbtFloat,EbpMedium);
-        $$.setMatrix(4, 2);
+        SET_KEYWORD_TYPE($$,$1);
     }
     | HMATRIX3x2 {
-		NONSQUARE_MATRIX_CHECK("half3x2", $1.line);
-        SET_BASIC_TYPE($$,$1,EbtFloat,EbpMedium);
-        $$.setMatrix(2, 3);
+        SET_KEYWORD_TYPE($$,$1);
     }
     | HMATRIX3x3 {
-        SET_BASIC_TYPE($$,$1,EbtFloat,EbpMedium);
-        $$.setMatrix(3, 3);
+        SET_KEYWORD_TYPE($$,$1);
     }
     | HMATRIX3x4 {
-		NONSQUARE_MATRIX_CHECK("half3x4", $1.line);
-        SET_BASIC_TYPE($$,$1,EbtFloat,EbpMedium);
-        $$.setMatrix(4, 3);
+        SET_KEYWORD_TYPE($$,$1);
     }
     | HMATRIX4x2 {
-		NONSQUARE_MATRIX_CHECK("half4x2", $1.line);
-        SET_BASIC_TYPE($$,$1,EbtFloat,EbpMedium);
-        $$.setMatrix(2, 4);
+        SET_KEYWORD_TYPE($$,$1);
     }
     | HMATRIX4x3 {
-		NONSQUARE_MATRIX_CHECK("half4x3", $1.line);
-        SET_BASIC_TYPE($$,$1,EbtFloat,EbpMedium);
-        $$.setMatrix(3, 4);
+        SET_KEYWORD_TYPE($$,$1);
     }
     | HMATRIX4x4 {
-        SET_BASIC_TYPE($$,$1,EbtFloat,EbpMedium);
-        $$.setMatrix(4, 4);
+        SET_KEYWORD_TYPE($$,$1);
     }
     | FMATRIX2x2 {
-        SET_BASIC_TYPE($$,$1,EbtFloat,EbpLow);
-        $$.setMatrix(2, 2);
+        SET_KEYWORD_TYPE($$,$1);
     }
     | FMATRIX2x3 {
-		NONSQUARE_MATRIX_CHECK("fixed2x3", $1.line);
-        SET_BASIC_TYPE($$,$1,EbtFloat,EbpLow);
-        $$.setMatrix(3, 2);
+        SET_KEYWORD_TYPE($$,$1);
     }
     | FMATRIX2x4 {
-		NONSQUARE_MATRIX_CHECK("fixed2x4", $1.line);
-        SET_BASIC_TYPE($$,$1,EbtFloat,EbpLow);
-        $$.setMatrix(4, 2);
+        SET_KEYWORD_TYPE($$,$1);
     }
     | FMATRIX3x2 {
-		NONSQUARE_MATRIX_CHECK("fixed3x2", $1.line);
-        SET_BASIC_TYPE($$,$1,EbtFloat,EbpLow);
-        $$.setMatrix(2, 3);
+        SET_KEYWORD_TYPE($$,$1);
     }
     | FMATRIX3x3 {
-        SET_BASIC_TYPE($$,$1,EbtFloat,EbpLow);
-        $$.setMatrix(3, 3);
+        SET_KEYWORD_TYPE($$,$1);
     }
     | FMATRIX3x4 {
-		NONSQUARE_MATRIX_CHECK("fixed3x4", $1.line);
-        SET_BASIC_TYPE($$,$1,EbtFloat,EbpLow);
-        $$.setMatrix(4, 3);
+        SET_KEYWORD_TYPE($$,$1);
     }
     | FMATRIX4x2 {
-		NONSQUARE_MATRIX_CHECK("fixed4x2", $1.line);
-        SET_BASIC_TYPE($$,$1,EbtFloat,EbpLow);
-        $$.setMatrix(2, 4);
+        SET_KEYWORD_TYPE($$,$1);
     }
     | FMATRIX4x3 {
-		NONSQUARE_MATRIX_CHECK("fixed4x3", $1.line);
-        SET_BASIC_TYPE($$,$1,EbtFloat,EbpLow);
-        $$.setMatrix(3, 4);
+        SET_KEYWORD_TYPE($$,$1);
     }
     | FMATRIX4x4 {
-        SET_BASIC_TYPE($$,$1,EbtFloat,EbpLow);
-        $$.setMatrix(4, 4);
+        SET_KEYWORD_TYPE($$,$1);
     }
 	| TEXTURE {
-        SET_BASIC_TYPE($$,$1,EbtTexture,EbpUndefined);
+        SET_KEYWORD_TYPE($$,$1);
     }  
     | SAMPLERGENERIC {
-        SET_BASIC_TYPE($$,$1,EbtSamplerGeneric,EbpUndefined);
+        SET_KEYWORD_TYPE($$,$1);
     }  
     | SAMPLER1D {
-        SET_BASIC_TYPE($$,$1,EbtSampler1D,EbpUndefined);
+        SET_KEYWORD_TYPE($$,$1);
     } 
     | SAMPLER2D {
-        SET_BASIC_TYPE($$,$1,EbtSampler2D,EbpUndefined);
+        SET_KEYWORD_TYPE($$,$1);
     } 
 	| SAMPLER2D_HALF {
-		SET_BASIC_TYPE($$,$1,EbtSampler2D,EbpMedium);
-	}
+        SET_KEYWORD_TYPE($$,$1);
+    }
 	| SAMPLER2D_FLOAT {
-		SET_BASIC_TYPE($$,$1,EbtSampler2D,EbpHigh);
-	}
+        SET_KEYWORD_TYPE($$,$1);
+    }
     | SAMPLER3D {
-        SET_BASIC_TYPE($$,$1,EbtSampler3D,EbpLow);
+        SET_KEYWORD_TYPE($$,$1);
     } 
     | SAMPLERCUBE {
-        SET_BASIC_TYPE($$,$1,EbtSamplerCube,EbpUndefined);
+        SET_KEYWORD_TYPE($$,$1);
     } 
 	| SAMPLERCUBE_HALF {
-		SET_BASIC_TYPE($$,$1,EbtSamplerCube,EbpMedium);
-	}
+        SET_KEYWORD_TYPE($$,$1);
+    }
 	| SAMPLERCUBE_FLOAT {
-		SET_BASIC_TYPE($$,$1,EbtSamplerCube,EbpHigh);
-	}
+        SET_KEYWORD_TYPE($$,$1);
+    }
     | SAMPLERRECT {
-        SET_BASIC_TYPE($$,$1,EbtSamplerRect,EbpUndefined);
+        SET_KEYWORD_TYPE($$,$1);
     }
     | SAMPLERRECTSHADOW {
-        SET_BASIC_TYPE($$,$1,EbtSamplerRectShadow,EbpLow); // ES3 doesn't have default precision for shadow samplers, so always emit lowp
+        SET_KEYWORD_TYPE($$,$1);
     } 
     | SAMPLER1DSHADOW {
-        SET_BASIC_TYPE($$,$1,EbtSampler1DShadow,EbpLow); // ES3 doesn't have default precision for shadow samplers, so always emit lowp
+        SET_KEYWORD_TYPE($$,$1);
     } 
     | SAMPLER2DSHADOW {
-        SET_BASIC_TYPE($$,$1,EbtSampler2DShadow,EbpLow); // ES3 doesn't have default precision for shadow samplers, so always emit lowp
+        SET_KEYWORD_TYPE($$,$1);
     }     
 	| SAMPLER2DARRAY {
-		SET_BASIC_TYPE($$,$1,EbtSampler2DArray,EbpLow);
-	}
+        SET_KEYWORD_TYPE($$,$1);
+    }
     | struct_specifier {
         $$ = $1;
         $$.qualifier = parseContext.getDefaultQualifier();
@@ -144,6 +144,19 @@ typedef int (*MOJOSHADER_hlslang_includeOpen)(MOJOSHADER_hlslang_includeType inc
 typedef void (*MOJOSHADER_hlslang_includeClose)(const char *data,
                             MOJOSHADER_hlslang_malloc m, MOJOSHADER_hlslang_free f, void *d);
 
+/*
+ * This callback tells an app about an #include that was skipped without
+ *  calling includeOpen, because the file was included before and its include
+ *  guard or #pragma once keeps it from adding anything again.
+ *
+ * (inctype), (fname) and (parentfname) are as for includeOpen, (d) is the
+ *  allocator data.
+ *
+ * This callback is optional.
+ */
+typedef void (*MOJOSHADER_hlslang_includeSkipped)(MOJOSHADER_hlslang_includeType inctype,
+                            const char *fname, const char *parentfname, void *d);
+
 
 
 #ifdef __cplusplus
@@ -150,6 +150,178 @@ void hlmojo_stringcache_destroy(hlmojo_StringCache *cache)
 
 
 
+// The arena...
+//
+// Allocations up to ARENA_MAX_SMALL bytes are rounded up to a power of two
+//  and carved from the current block, with their size class in a header just
+//  before them. Freeing one puts it on the free list of its class. Bigger
+//  allocations get a block of their own, which goes back to the app as soon
+//  as they are freed.
+
+#define ARENA_MIN_SMALL_SHIFT 4
+#define ARENA_MAX_SMALL_SHIFT 12
+#define ARENA_MAX_SMALL (1 << ARENA_MAX_SMALL_SHIFT)
+#define ARENA_CLASSES (ARENA_MAX_SMALL_SHIFT - ARENA_MIN_SMALL_SHIFT + 1)
+#define ARENA_LARGE ARENA_CLASSES
+#define ARENA_MAX_BLOCK (256 * 1024)
+
+typedef struct hlmojo_ArenaBlock
+{
+    struct hlmojo_ArenaBlock *prev;
+    struct hlmojo_ArenaBlock *next;
+    size_t bytes;
+    size_t used;
+} hlmojo_ArenaBlock;
+
+typedef struct hlmojo_ArenaFree
+{
+    struct hlmojo_ArenaFree *next;
+} hlmojo_ArenaFree;
+
+struct hlmojo_Arena
+{
+    hlmojo_ArenaBlock *blocks;  // the current one first, then the full ones.
+    hlmojo_ArenaBlock *large;   // one per big allocation.
+    hlmojo_ArenaFree *free_lists[ARENA_CLASSES];
+    size_t block_size;
+    MOJOSHADER_hlslang_malloc m;
+    MOJOSHADER_hlslang_free f;
+    void *d;
+};
+
+// Every allocation starts after one of these, holding its size class.
+typedef uint64 hlmojo_ArenaHeader;
+
+static inline uint8 *arena_block_data(hlmojo_ArenaBlock *block)
+{
+    return ((uint8 *) block) + sizeof (hlmojo_ArenaBlock);
+} // arena_block_data
+
+static hlmojo_ArenaBlock *arena_new_block(hlmojo_Arena *arena, size_t bytes)
+{
+    hlmojo_ArenaBlock *block = (hlmojo_ArenaBlock *)
+                    arena->m((int) (sizeof (hlmojo_ArenaBlock) + bytes), arena->d);
+    if (block == NULL)
+        return NULL;
+    block->prev = NULL;
+    block->next = NULL;
+    block->bytes = bytes;
+    block->used = 0;
+    return block;
+} // arena_new_block
+
+hlmojo_Arena *hlmojo_arena_create(size_t blksz, MOJOSHADER_hlslang_malloc m,
+                                  MOJOSHADER_hlslang_free f, void *d)
+{
+    hlmojo_Arena *arena = (hlmojo_Arena *) m(sizeof (hlmojo_Arena), d);
+    if (arena == NULL)
+        return NULL;
+    memset(arena, '\0', sizeof (hlmojo_Arena));
+    arena->block_size = blksz;
+    arena->m = m;
+    arena->f = f;
+    arena->d = d;
+    return arena;
+} // hlmojo_arena_create
+
+void *hlmojo_arena_alloc(hlmojo_Arena *arena, size_t len)
+{
+    if (len > ARENA_MAX_SMALL)
+    {
+        const size_t bytes = sizeof (hlmojo_ArenaHeader) + len;
+        hlmojo_ArenaBlock *block = arena_new_block(arena, bytes);
+        if (block == NULL)
+            return NULL;
+        block->used = bytes;
+        block->next = arena->large;
+        if (arena->large != NULL)
+            arena->large->prev = block;
+        arena->large = block;
+
+        hlmojo_ArenaHeader *header = (hlmojo_ArenaHeader *) arena_block_data(block);
+        *header = ARENA_LARGE;
+        return header + 1;
+    } // if
+
+    uint32 sizeclass = 0;
+    while (((size_t) 1 << (sizeclass + ARENA_MIN_SMALL_SHIFT)) < len)
+        sizeclass++;
+
+    hlmojo_ArenaFree *item = arena->free_lists[sizeclass];
+    if (item != NULL)
+    {
+        arena->free_lists[sizeclass] = item->next;
+        return item;
+    } // if
+
+    const size_t bytes = sizeof (hlmojo_ArenaHeader) +
+                         ((size_t) 1 << (sizeclass + ARENA_MIN_SMALL_SHIFT));
+    hlmojo_ArenaBlock *block = arena->blocks;
+    if ((block == NULL) || (block->bytes - block->used < bytes))
+    {
+        // the rest of the current block is lost, but blocks grow, so that
+        //  is never more than a small part of the arena.
+        if ((block != NULL) && (arena->block_size < ARENA_MAX_BLOCK))
+            arena->block_size *= 2;
+        block = arena_new_block(arena, arena->block_size);
+        if (block == NULL)
+            return NULL;
+        block->next = arena->blocks;
+        arena->blocks = block;
+    } // if
+
+    hlmojo_ArenaHeader *header = (hlmojo_ArenaHeader *) (arena_block_data(block) + block->used);
+    block->used += bytes;
+    *header = sizeclass;
+    return header + 1;
+} // hlmojo_arena_alloc
+
+void hlmojo_arena_free(hlmojo_Arena *arena, void *ptr)
+{
+    if (ptr == NULL)
+        return;
+
+    hlmojo_ArenaHeader *header = ((hlmojo_ArenaHeader *) ptr) - 1;
+    if (*header == ARENA_LARGE)
+    {
+        hlmojo_ArenaBlock *block = ((hlmojo_ArenaBlock *) header) - 1;
+        if (block->prev != NULL)
+            block->prev->next = block->next;
+        else
+            arena->large = block->next;
+        if (block->next != NULL)
+            block->next->prev = block->prev;
+        arena->f(block, arena->d);
+        return;
+    } // if
+
+    hlmojo_ArenaFree *item = (hlmojo_ArenaFree *) ptr;
+    item->next = arena->free_lists[*header];
+    arena->free_lists[*header] = item;
+} // hlmojo_arena_free
+
+static void arena_free_blocks(hlmojo_Arena *arena, hlmojo_ArenaBlock *block)
+{
+    while (block != NULL)
+    {
+        hlmojo_ArenaBlock *next = block->next;
+        arena->f(block, arena->d);
+        block = next;
+    } // while
+} // arena_free_blocks
+
+void hlmojo_arena_destroy(hlmojo_Arena *arena)
+{
+    if (arena != NULL)
+    {
+        arena_free_blocks(arena, arena->blocks);
+        arena_free_blocks(arena, arena->large);
+        arena->f(arena, arena->d);
+    } // if
+} // hlmojo_arena_destroy
+
+
+
 typedef struct hlmojo_BufferBlock
 {
     uint8 *data;
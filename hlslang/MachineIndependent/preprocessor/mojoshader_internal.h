@@ -93,6 +93,20 @@ const char *hlmojo_stringcache_len(hlmojo_StringCache *cache, const char *str,
 void hlmojo_stringcache_destroy(hlmojo_StringCache *cache);
 
 
+// Memory arenas...
+//
+// Everything one preprocessor run allocates comes from its arena, which gets
+//  memory from the app's allocator in large blocks and gives it all back at
+//  once. Freed allocations are recycled by size, so expanding macros over and
+//  over does not grow the arena.
+
+typedef struct hlmojo_Arena hlmojo_Arena;
+hlmojo_Arena *hlmojo_arena_create(size_t blksz,MOJOSHADER_hlslang_malloc m,MOJOSHADER_hlslang_free f,void *d);
+void *hlmojo_arena_alloc(hlmojo_Arena *arena, size_t len);
+void hlmojo_arena_free(hlmojo_Arena *arena, void *ptr);
+void hlmojo_arena_destroy(hlmojo_Arena *arena);
+
+
 // Dynamic buffers...
 
 typedef struct hlmojo_Buffer hlmojo_Buffer;
@@ -247,6 +261,10 @@ typedef struct hlmojo_IncludeState
     unsigned int line;
     hlmojo_Conditional *conditional_stack;
     MOJOSHADER_hlslang_includeClose close_callback;
+    const char *include_key;  // cached name of an #included file, NULL otherwise.
+    const char *guard_macro;  // cached; the #ifndef that may guard the whole file.
+    const hlmojo_Conditional *guard_conditional;
+    int guard_state;
     struct hlmojo_IncludeState *next;
 } hlmojo_IncludeState;
 
@@ -258,6 +276,7 @@ hlmojo_Preprocessor *hlmojo_preprocessor_start(const char *fname, const char *so
                             unsigned int sourcelen,
                             MOJOSHADER_hlslang_includeOpen open_callback,
                             MOJOSHADER_hlslang_includeClose close_callback,
+                            MOJOSHADER_hlslang_includeSkipped skipped_callback,
                             const MOJOSHADER_hlslang_preprocessorDefine *defines,
                             unsigned int define_count,
                             MOJOSHADER_hlslang_malloc m, MOJOSHADER_hlslang_free f, void *d);
@@ -35,6 +35,156 @@ typedef unsigned char uchar;
 
 static uchar sentinel[YYMAXFILL];
 
+// Fast paths for the long runs of bytes the lexer would otherwise match one at a
+//  time: whitespace, identifier tails and comment bodies. Each returns where the
+//  run ends, never reading at or past limit, so the re2c rules take over from
+//  there exactly as if they had matched the run themselves.
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define LEXER_SSE2 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+#define LEXER_NEON 1
+#include <arm_neon.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+static inline unsigned int lowest_bit(uint64 mask)
+{
+    unsigned long index;
+    _BitScanForward64(&index, mask);
+    return (unsigned int) index;
+} // lowest_bit
+static inline unsigned int bit_count(uint64 mask) { return (unsigned int) __popcnt64(mask); }
+#else
+static inline unsigned int lowest_bit(uint64 mask) { return (unsigned int) __builtin_ctzll(mask); }
+static inline unsigned int bit_count(uint64 mask) { return (unsigned int) __builtin_popcountll(mask); }
+#endif
+
+#define IS_IDENT_START(c) ( ((unsigned) (((c) | 0x20) - 'a') < 26) || ((c) == '_') )
+#define IS_IDENT(c) ( IS_IDENT_START(c) || ((unsigned) ((c) - '0') < 10) )
+#define IS_BLANK(c) ( ((c) == ' ') || ((c) == '\t') || ((c) == '\v') || ((c) == '\f') )
+
+#if LEXER_SSE2
+typedef __m128i Chunk;
+#define CHUNK_SIZE 16
+#define CHUNK_BITS 1  // mask bits per byte
+static inline Chunk load_chunk(const uchar *p) { return _mm_loadu_si128((const __m128i *) p); }
+static inline Chunk match_byte(Chunk c, uchar b) { return _mm_cmpeq_epi8(c, _mm_set1_epi8((char) b)); }
+static inline Chunk match_range(Chunk c, uchar lo, uchar count)  // lo <= c < lo+count
+{
+    const __m128i d = _mm_sub_epi8(c, _mm_set1_epi8((char) lo));
+    return _mm_cmpeq_epi8(_mm_min_epu8(d, _mm_set1_epi8((char) (count - 1))), d);
+} // match_range
+static inline Chunk either(Chunk a, Chunk b) { return _mm_or_si128(a, b); }
+static inline Chunk lower_case(Chunk c) { return _mm_or_si128(c, _mm_set1_epi8(0x20)); }
+static inline uint64 chunk_mask(Chunk c) { return (uint64) (unsigned int) _mm_movemask_epi8(c); }
+#define FULL_MASK ((uint64) 0xFFFF)
+#elif LEXER_NEON
+typedef uint8x16_t Chunk;
+#define CHUNK_SIZE 16
+#define CHUNK_BITS 4
+static inline Chunk load_chunk(const uchar *p) { return vld1q_u8(p); }
+static inline Chunk match_byte(Chunk c, uchar b) { return vceqq_u8(c, vdupq_n_u8(b)); }
+static inline Chunk match_range(Chunk c, uchar lo, uchar count)
+{
+    return vcltq_u8(vsubq_u8(c, vdupq_n_u8(lo)), vdupq_n_u8(count));
+} // match_range
+static inline Chunk either(Chunk a, Chunk b) { return vorrq_u8(a, b); }
+static inline Chunk lower_case(Chunk c) { return vorrq_u8(c, vdupq_n_u8(0x20)); }
+static inline uint64 chunk_mask(Chunk c)  // four bits per byte
+{
+    return vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(c), 4)), 0);
+} // chunk_mask
+#define FULL_MASK (~((uint64) 0))
+#endif
+
+static const uchar *skip_blanks(const uchar *p, const uchar *limit)
+{
+#ifdef CHUNK_SIZE
+    while (limit - p >= CHUNK_SIZE)
+    {
+        const Chunk c = load_chunk(p);
+        const uint64 stop = ~chunk_mask(either(either(match_byte(c, ' '), match_byte(c, '\t')),
+                                               either(match_byte(c, '\v'), match_byte(c, '\f')))) & FULL_MASK;
+        if (stop)
+            return p + lowest_bit(stop) / CHUNK_BITS;
+        p += CHUNK_SIZE;
+    } // while
+#endif
+    while ((p < limit) && IS_BLANK(*p))
+        p++;
+    return p;
+} // skip_blanks
+
+static const uchar *skip_identifier(const uchar *p, const uchar *limit)
+{
+#ifdef CHUNK_SIZE
+    while (limit - p >= CHUNK_SIZE)
+    {
+        const Chunk c = load_chunk(p);
+        const Chunk ident = either(either(match_range(lower_case(c), 'a', 26), match_range(c, '0', 10)),
+                                   match_byte(c, '_'));
+        const uint64 stop = ~chunk_mask(ident) & FULL_MASK;
+        if (stop)
+            return p + lowest_bit(stop) / CHUNK_BITS;
+        p += CHUNK_SIZE;
+    } // while
+#endif
+    while ((p < limit) && IS_IDENT(*p))
+        p++;
+    return p;
+} // skip_identifier
+
+// up to the end of a // comment, the newline is left to the rules.
+static const uchar *skip_line_comment(const uchar *p, const uchar *limit)
+{
+#ifdef CHUNK_SIZE
+    while (limit - p >= CHUNK_SIZE)
+    {
+        const Chunk c = load_chunk(p);
+        const uint64 stop = chunk_mask(either(match_byte(c, '\n'), match_byte(c, '\r')));
+        if (stop)
+            return p + lowest_bit(stop) / CHUNK_BITS;
+        p += CHUNK_SIZE;
+    } // while
+#endif
+    while ((p < limit) && (*p != '\n') && (*p != '\r'))
+        p++;
+    return p;
+} // skip_line_comment
+
+// up to the next '*' or '\r' in a /* */ comment, counting the '\n's on the way.
+//  "\r\n" and "\r" are left to the rules, so each newline counts once.
+static const uchar *skip_block_comment(const uchar *p, const uchar *limit,
+                                       unsigned int *line)
+{
+#ifdef CHUNK_SIZE
+    while (limit - p >= CHUNK_SIZE)
+    {
+        const Chunk c = load_chunk(p);
+        const uint64 stop = chunk_mask(either(match_byte(c, '*'), match_byte(c, '\r')));
+        const uint64 newlines = chunk_mask(match_byte(c, '\n'));
+        if (stop)
+        {
+            const unsigned int at = lowest_bit(stop);
+            *line += bit_count(newlines & ((((uint64) 1) << at) - 1)) / CHUNK_BITS;
+            return p + at / CHUNK_BITS;
+        } // if
+        *line += bit_count(newlines) / CHUNK_BITS;
+        p += CHUNK_SIZE;
+    } // while
+#endif
+    for (; (p < limit) && (*p != '*') && (*p != '\r'); p++)
+    {
+        if (*p == '\n')
+            (*line)++;
+    } // for
+    return p;
+} // skip_block_comment
+
+
 static Token update_state(hlmojo_IncludeState *s, int eoi, const uchar *cur,
                           const uchar *tok, const Token val)
 {
@@ -73,8 +223,15 @@ Token hlmojo_preprocessor_lexer(hlmojo_IncludeState *s)
         goto ppdirective;  // may jump back to scanner_loop.
 
 scanner_loop:
+    if (!s->report_whitespace)
+        cursor = skip_blanks(cursor, limit);
     if (YYLIMIT == YYCURSOR) YYFILL(1);
     token = cursor;
+    if (IS_IDENT_START(*cursor))
+    {
+        cursor = skip_identifier(cursor + 1, limit);
+        RET(TOKEN_IDENTIFIER);
+    } // if
 
 
 {
@@ -1147,6 +1304,8 @@ yy180:
 
 
 multilinecomment:
+    if (!eoi)
+        cursor = skip_block_comment(cursor, limit, &s->line);
     if (YYLIMIT == YYCURSOR) YYFILL(1);
     matchptr = cursor;
 // The "*\/" is just to avoid screwing up text editor syntax highlighting.
@@ -1210,6 +1369,8 @@ yy192:
 
 
 singlelinecomment:
+    if (!eoi)
+        cursor = skip_line_comment(cursor, limit);
     if (YYLIMIT == YYCURSOR) YYFILL(1);
     matchptr = cursor;
 
@@ -39,6 +39,35 @@ static void print_debug_lexing_position(hlmojo_IncludeState *s)
 #define print_debug_lexing_position(s)
 #endif
 
+typedef struct hlmojo_DefineSlot
+{
+    uint32 hash;
+    hlmojo_Define *define;  // NULL if the slot was never used
+} hlmojo_DefineSlot;
+
+// A function-like macro expansion, to replay when the macro gets the same
+//  arguments again.
+typedef struct hlmojo_Expansion
+{
+    uint32 hash;
+    const hlmojo_Define *define;  // NULL if the slot was never used.
+    uint32 generation;            // of the defines when it was expanded.
+    char *args;        // original text of each argument, '\0' terminated.
+    size_t argslen;
+    char *expansion;
+    unsigned int expansionlen;
+} hlmojo_Expansion;
+
+#define EXPANSION_MEMO_SIZE 64
+
+// What an #included file was found to be guarded by, to skip including it again.
+typedef struct hlmojo_IncludeGuard
+{
+    const char *key;    // cached, see include_key().
+    const char *macro;  // cached, NULL for #pragma once.
+    struct hlmojo_IncludeGuard *next;
+} hlmojo_IncludeGuard;
+
 typedef struct Context
 {
     int isfail;
@@ -48,13 +77,21 @@ typedef struct Context
     hlmojo_Conditional *conditional_pool;
     hlmojo_IncludeState *include_stack;
     hlmojo_IncludeState *include_pool;
-    hlmojo_Define *define_hashtable[256];
+    hlmojo_DefineSlot *define_table;
+    uint32 define_table_size;
+    uint32 define_slots_used;  // live defines plus tombstones
+    uint32 define_count;
+    uint32 define_generation;  // bumped by every #define and #undef.
     hlmojo_Define *define_pool;
     hlmojo_Define *file_macro;
     hlmojo_Define *line_macro;
     hlmojo_StringCache *filename_cache;
+    hlmojo_IncludeGuard *include_guards;
+    hlmojo_Expansion *expansion_memo;  // EXPANSION_MEMO_SIZE slots, or NULL.
+    hlmojo_Arena *arena;  // everything above lives in here.
     MOJOSHADER_hlslang_includeOpen open_callback;
     MOJOSHADER_hlslang_includeClose close_callback;
+    MOJOSHADER_hlslang_includeSkipped skipped_callback;
     MOJOSHADER_hlslang_malloc malloc;
     MOJOSHADER_hlslang_free free;
     void *malloc_data;
@@ -70,7 +107,7 @@ static inline void out_of_memory(Context *ctx)
 
 static inline void *Malloc(Context *ctx, const size_t len)
 {
-    void *retval = ctx->malloc((int) len, ctx->malloc_data);
+    void *retval = hlmojo_arena_alloc(ctx->arena, len);
     if (retval == NULL)
         out_of_memory(ctx);
     return retval;
@@ -78,7 +115,7 @@ static inline void *Malloc(Context *ctx, const size_t len)
 
 static inline void Free(Context *ctx, void *ptr)
 {
-    ctx->free(ptr, ctx->malloc_data);
+    hlmojo_arena_free(ctx->arena, ptr);
 } // Free
 
 static void *MallocBridge(int bytes, void *data)
@@ -299,16 +336,7 @@ void MOJOSHADER_hlslang_internal_include_close(const char *data, MOJOSHADER_hlsl
 
 // Pool stuff...
 // ugh, I hate this macro salsa.
-#define FREE_POOL(type, poolname) \
-    static void free_##poolname##_pool(Context *ctx) { \
-        type *item = ctx->poolname##_pool; \
-        while (item != NULL) { \
-            type *next = item->next; \
-            Free(ctx, item); \
-            item = next; \
-        } \
-    }
-
+// Pooled items are never freed one by one, they go with the arena.
 #define GET_POOL(type, poolname) \
     static type *get_##poolname(Context *ctx) { \
         type *retval = ctx->poolname##_pool; \
@@ -328,7 +356,6 @@ void MOJOSHADER_hlslang_internal_include_close(const char *data, MOJOSHADER_hlsl
     }
 
 #define IMPLEMENT_POOL(type, poolname) \
-    FREE_POOL(type, poolname) \
     GET_POOL(type, poolname) \
     PUT_POOL(type, poolname)
 
@@ -339,50 +366,143 @@ IMPLEMENT_POOL(hlmojo_Define, define)
 
 // hlmojo_Preprocessor define hashtable stuff...
 
-// !!! FIXME: why isn't this using mojoshader_common.c's code?
+// Open addressing with linear probing. The table is a power of two in size and
+//  grows before it gets three quarters full, counting the slots #undef left
+//  behind; growing drops those. Each slot keeps the full hash of its name, so a
+//  probe only looks at the name when the hashes match.
+
+#define DEFINE_TABLE_MIN_SIZE 64
+
+// marks a slot whose define was #undef'd, so probes carry on past it.
+static hlmojo_Define define_tombstone;
 
-// this is djb's xor hashing function.
-static inline uint32 hash_string_djbxor(const char *sym)
+// 32-bit FNV-1a.
+static inline uint32 hash_define(const char *sym, const size_t symlen)
 {
-    register uint32 hash = 5381;
-    while (*sym)
-        hash = ((hash << 5) + hash) ^ *(sym++);
+    uint32 hash = 2166136261u;
+    size_t i;
+    for (i = 0; i < symlen; i++)
+    {
+        hash ^= (uint8) sym[i];
+        hash *= 16777619u;
+    } // for
     return hash;
-} // hash_string_djbxor
+} // hash_define
 
-static inline uint8 hash_define(const char *sym)
+static inline int define_name_matches(const hlmojo_Define *def,
+                                      const char *sym, const size_t symlen)
 {
-    return (uint8) hash_string_djbxor(sym);
-} // hash_define
+    return ( (strncmp(def->identifier, sym, symlen) == 0) &&
+             (def->identifier[symlen] == '\0') );
+} // define_name_matches
+
+// the slot holding sym, or NULL.
+static hlmojo_DefineSlot *find_define_slot(Context *ctx, const char *sym,
+                                           const size_t symlen, const uint32 hash)
+{
+    if (ctx->define_table == NULL)
+        return NULL;
+
+    const uint32 mask = ctx->define_table_size - 1;
+    uint32 i;
+    for (i = hash & mask; ctx->define_table[i].define != NULL; i = (i + 1) & mask)
+    {
+        hlmojo_DefineSlot *slot = &ctx->define_table[i];
+        if ( (slot->hash == hash) && (slot->define != &define_tombstone) &&
+             (define_name_matches(slot->define, sym, symlen)) )
+            return slot;
+    } // for
+
+    return NULL;
+} // find_define_slot
+
+static int grow_define_table(Context *ctx)
+{
+    // double when live defines fill half of it, otherwise just sweep out
+    //  the tombstones.
+    uint32 size = ctx->define_table_size;
+    if (size == 0)
+        size = DEFINE_TABLE_MIN_SIZE;
+    else if (ctx->define_count * 2 >= size)
+        size *= 2;
+
+    hlmojo_DefineSlot *table = (hlmojo_DefineSlot *) Malloc(ctx, sizeof (hlmojo_DefineSlot) * size);
+    if (table == NULL)
+        return 0;
+    memset(table, '\0', sizeof (hlmojo_DefineSlot) * size);
+
+    const uint32 mask = size - 1;
+    uint32 i;
+    for (i = 0; i < ctx->define_table_size; i++)
+    {
+        const hlmojo_DefineSlot *slot = &ctx->define_table[i];
+        if ((slot->define == NULL) || (slot->define == &define_tombstone))
+            continue;
+        uint32 j = slot->hash & mask;
+        while (table[j].define != NULL)
+            j = (j + 1) & mask;
+        table[j] = *slot;
+    } // for
+
+    Free(ctx, ctx->define_table);
+    ctx->define_table = table;
+    ctx->define_table_size = size;
+    ctx->define_slots_used = ctx->define_count;
+    return 1;
+} // grow_define_table
 
 
 static int add_define(Context *ctx, const char *sym, const char *val,
                       char **parameters, int paramcount)
 {
-    const uint8 hash = hash_define(sym);
-    hlmojo_Define *bucket = ctx->define_hashtable[hash];
-    while (bucket)
+    const size_t symlen = strlen(sym);
+    const uint32 hash = hash_define(sym, symlen);
+    if (find_define_slot(ctx, sym, symlen, hash) != NULL)
     {
-        if (strcmp(bucket->identifier, sym) == 0)
-        {
-            failf(ctx, "'%s' already defined", sym); // !!! FIXME: warning?
-            // !!! FIXME: gcc reports the location of previous #define here.
+        failf(ctx, "'%s' already defined", sym); // !!! FIXME: warning?
+        // !!! FIXME: gcc reports the location of previous #define here.
+        return 0;
+    } // if
+
+    if ((ctx->define_slots_used + 1) * 4 > ctx->define_table_size * 3)
+    {
+        if (!grow_define_table(ctx))
             return 0;
-        } // if
-        bucket = bucket->next;
-    } // while
+    } // if
 
-    bucket = get_define(ctx);
-    if (bucket == NULL)
+    hlmojo_Define *def = get_define(ctx);
+    if (def == NULL)
         return 0;
 
-    bucket->definition = val;
-    bucket->original = NULL;
-    bucket->identifier = sym;
-    bucket->parameters = (const char **) parameters;
-    bucket->paramcount = paramcount;
-    bucket->next = ctx->define_hashtable[hash];
-    ctx->define_hashtable[hash] = bucket;
+    def->definition = val;
+    def->original = NULL;
+    def->identifier = sym;
+    def->parameters = (const char **) parameters;
+    def->paramcount = paramcount;
+
+    // reuse the first tombstone on the way, if there is one.
+    const uint32 mask = ctx->define_table_size - 1;
+    hlmojo_DefineSlot *slot = NULL;
+    uint32 i;
+    for (i = hash & mask; ctx->define_table[i].define != NULL; i = (i + 1) & mask)
+    {
+        if (ctx->define_table[i].define == &define_tombstone)
+        {
+            slot = &ctx->define_table[i];
+            break;
+        } // if
+    } // for
+
+    if (slot == NULL)
+    {
+        slot = &ctx->define_table[i];
+        ctx->define_slots_used++;
+    } // if
+
+    slot->hash = hash;
+    slot->define = def;
+    ctx->define_count++;
+    ctx->define_generation++;
     return 1;
 } // add_define
 
@@ -405,77 +525,67 @@ static void free_define(Context *ctx, hlmojo_Define *def)
 
 static int remove_define(Context *ctx, const char *sym)
 {
-    const uint8 hash = hash_define(sym);
-    hlmojo_Define *bucket = ctx->define_hashtable[hash];
-    hlmojo_Define *prev = NULL;
-    while (bucket)
-    {
-        if (strcmp(bucket->identifier, sym) == 0)
-        {
-            if (prev == NULL)
-                ctx->define_hashtable[hash] = bucket->next;
-            else
-                prev->next = bucket->next;
-            free_define(ctx, bucket);
-            return 1;
-        } // if
-        prev = bucket;
-        bucket = bucket->next;
-    } // while
+    const size_t symlen = strlen(sym);
+    hlmojo_DefineSlot *slot = find_define_slot(ctx, sym, symlen, hash_define(sym, symlen));
+    if (slot == NULL)
+        return 0;
 
-    return 0;
+    free_define(ctx, slot->define);
+    slot->define = &define_tombstone;
+    ctx->define_count--;
+    ctx->define_generation++;
+    return 1;
 } // remove_define
 
 
-static const hlmojo_Define *find_define(Context *ctx, const char *sym)
+// __FILE__ and __LINE__ are answered before the table is looked at: as long as
+//  they are special they can't be in it, since (re)#defining them ends that.
+static inline int is_file_or_line(const char *sym, const size_t symlen)
 {
-    const uint8 hash = hash_define(sym);
-    hlmojo_Define *bucket = ctx->define_hashtable[hash];
-    while (bucket)
-    {
-        if (strcmp(bucket->identifier, sym) == 0)
-            return bucket;
-        bucket = bucket->next;
-    } // while
-
-    const uint8 filestrhash = 67;
-    assert(hash_define("__FILE__") == filestrhash);
-
-    const uint8 linestrhash = 75;
-    assert(hash_define("__LINE__") == linestrhash);
-
-    if ( (hash == filestrhash) && (ctx->file_macro) && (strcmp(sym, "__FILE__") == 0) )
-    {
-        Free(ctx, (char *) ctx->file_macro->definition);
-        const hlmojo_IncludeState *state = ctx->include_stack;
-        const char *fname = state ? state->filename : "";
-        const size_t len = strlen(fname) + 2;
-        char *str = (char *) Malloc(ctx, len);
-        if (!str)
-            return NULL;
-        str[0] = '\"';
-        memcpy(str + 1, fname, len - 2);
-        str[len - 1] = '\"';
-        ctx->file_macro->definition = str;
-        return ctx->file_macro;
-    } // if
+    return ( (symlen == 8) && (sym[0] == '_') && (sym[1] == '_') &&
+             (sym[6] == '_') && (sym[7] == '_') );
+} // is_file_or_line
 
-    else if ( (hash == linestrhash) && (ctx->line_macro) && (strcmp(sym, "__LINE__") == 0) )
+static const hlmojo_Define *find_define(Context *ctx, const char *sym,
+                                        const size_t symlen)
+{
+    if (is_file_or_line(sym, symlen))
     {
-        Free(ctx, (char *) ctx->line_macro->definition);
-        const hlmojo_IncludeState *state = ctx->include_stack;
-        const size_t bufsize = 32;
-        char *str = (char *) Malloc(ctx, bufsize);
-        if (!str)
-            return 0;
+        if ( (ctx->file_macro) && (memcmp(sym + 2, "FILE", 4) == 0) )
+        {
+            Free(ctx, (char *) ctx->file_macro->definition);
+            const hlmojo_IncludeState *state = ctx->include_stack;
+            const char *fname = state ? state->filename : "";
+            const size_t len = strlen(fname) + 2;
+            char *str = (char *) Malloc(ctx, len + 1);
+            if (!str)
+                return NULL;
+            str[0] = '\"';
+            memcpy(str + 1, fname, len - 2);
+            str[len - 1] = '\"';
+            str[len] = '\0';
+            ctx->file_macro->definition = str;
+            return ctx->file_macro;
+        } // if
 
-        const size_t len = snprintf(str, bufsize, "%u", state->line);
-        assert(len < bufsize); (void) len;
-        ctx->line_macro->definition = str;
-        return ctx->line_macro;
-    } // else
+        else if ( (ctx->line_macro) && (memcmp(sym + 2, "LINE", 4) == 0) )
+        {
+            Free(ctx, (char *) ctx->line_macro->definition);
+            const hlmojo_IncludeState *state = ctx->include_stack;
+            const size_t bufsize = 32;
+            char *str = (char *) Malloc(ctx, bufsize);
+            if (!str)
+                return 0;
+
+            const size_t len = snprintf(str, bufsize, "%u", state->line);
+            assert(len < bufsize); (void) len;
+            ctx->line_macro->definition = str;
+            return ctx->line_macro;
+        } // else if
+    } // if
 
-    return NULL;
+    const hlmojo_DefineSlot *slot = find_define_slot(ctx, sym, symlen, hash_define(sym, symlen));
+    return slot ? slot->define : NULL;
 } // find_define
 
 
@@ -483,10 +593,7 @@ static const hlmojo_Define *find_define_by_token(Context *ctx)
 {
     hlmojo_IncludeState *state = ctx->include_stack;
     assert(state->tokenval == TOKEN_IDENTIFIER);
-    char *sym = (char *) alloca(state->tokenlen+1);
-    memcpy(sym, state->token, state->tokenlen);
-    sym[state->tokenlen] = '\0';
-    return find_define(ctx, sym);
+    return find_define(ctx, state->token, state->tokenlen);
 } // find_define_by_token
 
 
@@ -510,21 +617,110 @@ static const hlmojo_Define *find_macro_arg(const hlmojo_IncludeState *state,
 } // find_macro_arg
 
 
-static void put_all_defines(Context *ctx)
+// Include guards...
+//
+// An #included file whose tokens are all inside "#ifndef X ... #endif" comes out
+//  empty once X is defined, and one with "#pragma once" always does after the
+//  first time. Both get recorded when seen, and the file isn't opened again
+//  while that holds. Files are told apart by their name as written in the
+//  #include, and for local includes the directory of the including file.
+
+typedef enum
+{
+    GUARD_START = 0,  // nothing but newlines yet.
+    GUARD_INSIDE,     // inside the #ifndef that opened the file.
+    GUARD_AFTER,      // after its #endif, only newlines since.
+    GUARD_NONE        // not guarded.
+} GuardState;
+
+static const char *include_key(Context *ctx, MOJOSHADER_hlslang_includeType incltype,
+                               const char *fname, const char *parentfname)
 {
+    const int local = (incltype == MOJOSHADER_hlslang_INCLUDETYPE_LOCAL);
+    size_t dirlen = 0;
     size_t i;
-    for (i = 0; i < STATICARRAYLEN(ctx->define_hashtable); i++)
+    if ((local) && (parentfname != NULL))
     {
-        hlmojo_Define *bucket = ctx->define_hashtable[i];
-        ctx->define_hashtable[i] = NULL;
-        while (bucket)
+        for (i = 0; parentfname[i]; i++)
         {
-            hlmojo_Define *next = bucket->next;
-            free_define(ctx, bucket);
-            bucket = next;
-        } // while
+            if ((parentfname[i] == '/') || (parentfname[i] == '\\'))
+                dirlen = i + 1;
+        } // for
+    } // if
+
+    const size_t fnamelen = strlen(fname);
+    char *key = (char *) alloca(dirlen + fnamelen + 2);
+    key[0] = local ? '\"' : '<';
+    if (dirlen > 0)
+        memcpy(key + 1, parentfname, dirlen);
+    memcpy(key + 1 + dirlen, fname, fnamelen + 1);
+    return hlmojo_stringcache(ctx->filename_cache, key);
+} // include_key
+
+static hlmojo_IncludeGuard *find_include_guard(Context *ctx, const char *key)
+{
+    hlmojo_IncludeGuard *guard;
+    for (guard = ctx->include_guards; guard != NULL; guard = guard->next)
+    {
+        if (guard->key == key)  // both cached, so the same pointer.
+            return guard;
     } // for
-} // put_all_defines
+    return NULL;
+} // find_include_guard
+
+static void add_include_guard(Context *ctx, const char *key, const char *macro)
+{
+    hlmojo_IncludeGuard *guard = find_include_guard(ctx, key);
+    if (guard == NULL)
+    {
+        guard = (hlmojo_IncludeGuard *) Malloc(ctx, sizeof (hlmojo_IncludeGuard));
+        if (guard == NULL)
+            return;
+        guard->key = key;
+        guard->macro = macro;
+        guard->next = ctx->include_guards;
+        ctx->include_guards = guard;
+    } // if
+    else if (macro == NULL)
+        guard->macro = NULL;  // #pragma once wins.
+} // add_include_guard
+
+static int include_is_guarded(Context *ctx, const char *key)
+{
+    const hlmojo_IncludeGuard *guard = find_include_guard(ctx, key);
+    if (guard == NULL)
+        return 0;
+    else if (guard->macro == NULL)
+        return 1;
+    return (find_define(ctx, guard->macro, strlen(guard->macro)) != NULL);
+} // include_is_guarded
+
+// Sees every token of an #included file, before it's handled.
+static void track_include_guard(Context *ctx, hlmojo_IncludeState *state,
+                                const Token token)
+{
+    if (token == ((Token) '\n'))
+        return;
+
+    switch (state->guard_state)
+    {
+        case GUARD_START:
+            // _handle_pp_ifdef() moves on to GUARD_INSIDE.
+            if (token != TOKEN_PP_IFNDEF)
+                state->guard_state = GUARD_NONE;
+            break;
+
+        case GUARD_AFTER:
+            if (token == TOKEN_EOI)
+                add_include_guard(ctx, state->include_key, state->guard_macro);
+            else
+                state->guard_state = GUARD_NONE;
+            break;
+
+        default:
+            break;
+    } // switch
+} // track_include_guard
 
 
 static int push_source(Context *ctx, const char *fname, const char *source,
@@ -570,11 +766,17 @@ static void pop_source(Context *ctx)
     if (state == NULL)
         return;
 
-    if (state->close_callback)
+    // Files the app opened go back to the app, our own sources to the arena.
+    if (state->close_callback == ctx->close_callback)
     {
-        state->close_callback(state->source_base, ctx->malloc,
-                              ctx->free, ctx->malloc_data);
+        if (state->close_callback)
+        {
+            state->close_callback(state->source_base, ctx->malloc,
+                                  ctx->free, ctx->malloc_data);
+        } // if
     } // if
+    else if (state->close_callback)
+        state->close_callback(state->source_base, MallocBridge, FreeBridge, ctx);
 
     // state->filename is a pointer to the filename cache; don't free it here!
 
@@ -605,6 +807,7 @@ hlmojo_Preprocessor *hlmojo_preprocessor_start(const char *fname, const char *so
                             unsigned int sourcelen,
                             MOJOSHADER_hlslang_includeOpen open_callback,
                             MOJOSHADER_hlslang_includeClose close_callback,
+                            MOJOSHADER_hlslang_includeSkipped skipped_callback,
                             const MOJOSHADER_hlslang_preprocessorDefine *defines,
                             unsigned int define_count,
                             MOJOSHADER_hlslang_malloc m, MOJOSHADER_hlslang_free f, void *d)
@@ -616,16 +819,26 @@ hlmojo_Preprocessor *hlmojo_preprocessor_start(const char *fname, const char *so
     assert(m != NULL);
     assert(f != NULL);
 
-    Context *ctx = (Context *) m(sizeof (Context), d);
+    // a few kilobytes cover most shaders, blocks grow from there.
+    hlmojo_Arena *arena = hlmojo_arena_create(8 * 1024, m, f, d);
+    if (arena == NULL)
+        return NULL;
+
+    Context *ctx = (Context *) hlmojo_arena_alloc(arena, sizeof (Context));
     if (ctx == NULL)
+    {
+        hlmojo_arena_destroy(arena);
         return NULL;
+    } // if
 
     memset(ctx, '\0', sizeof (Context));
+    ctx->arena = arena;
     ctx->malloc = m;
     ctx->free = f;
     ctx->malloc_data = d;
     ctx->open_callback = open_callback;
     ctx->close_callback = close_callback;
+    ctx->skipped_callback = skipped_callback;
 
     ctx->filename_cache = hlmojo_stringcache_create(MallocBridge, FreeBridge, ctx);
     okay = ((okay) && (ctx->filename_cache != NULL));
@@ -688,21 +901,12 @@ void hlmojo_preprocessor_end(hlmojo_Preprocessor *_ctx)
     if (ctx == NULL)
         return;
 
+    // the app still has to get its #included files back.
     while (ctx->include_stack != NULL)
         pop_source(ctx);
 
-    put_all_defines(ctx);
-
-    if (ctx->filename_cache != NULL)
-        hlmojo_stringcache_destroy(ctx->filename_cache);
-
-    free_define(ctx, ctx->file_macro);
-    free_define(ctx, ctx->line_macro);
-    free_define_pool(ctx);
-    free_conditional_pool(ctx);
-    free_include_pool(ctx);
-
-    Free(ctx, ctx);
+    // defines, the filename cache, pools and the context itself all go at once.
+    hlmojo_arena_destroy(ctx->arena);
 } // hlmojo_preprocessor_end
 
 
@@ -804,6 +1008,17 @@ static void handle_pp_include(Context *ctx)
         return;
     } // else
 
+    const char *key = include_key(ctx, incltype, filename, state->filename);
+    if (key == NULL)
+        return;  // out of memory.
+    else if (include_is_guarded(ctx, key))
+    {
+        // would come out empty, don't even open it.
+        if (ctx->skipped_callback != NULL)
+            ctx->skipped_callback(incltype, filename, state->filename, ctx->malloc_data);
+        return;
+    } // else if
+
     const char *newdata = NULL;
     unsigned int newbytes = 0;
     if ((ctx->open_callback == NULL) || (ctx->close_callback == NULL))
@@ -825,7 +1040,10 @@ static void handle_pp_include(Context *ctx)
     {
         assert(ctx->out_of_memory);
         ctx->close_callback(newdata, ctx->malloc, ctx->free, ctx->malloc_data);
+        return;
     } // if
+
+    ctx->include_stack->include_key = key;
 } // handle_pp_include
 
 
@@ -931,6 +1149,8 @@ static void handle_pp_pragma(Context *ctx)
 {
     hlmojo_IncludeState *state = ctx->include_stack;
     int done = 0;
+    int words = 0;
+    int once = 0;
 
     state->report_whitespace = 1;
     while ((!done) && (!ctx->out_of_memory))
@@ -939,9 +1159,19 @@ static void handle_pp_pragma(Context *ctx)
         switch (token)
         {
             case ((Token) '\n'):
+                if ((once) && (words == 1) && (state->include_key != NULL))
+                    add_include_guard(ctx, state->include_key, NULL);
                 done = 1;
                 break;
 
+            case ((Token) ' '):
+                break;
+
+            case TOKEN_IDENTIFIER:
+                once = ((words++ == 0) && (state->tokenlen == 4) &&
+                        (memcmp(state->token, "once", 4) == 0));
+                break;
+
             case TOKEN_INCOMPLETE_COMMENT:
             case TOKEN_EOI:
                 pushback(state);  // move back so we catch this later.
@@ -950,6 +1180,7 @@ static void handle_pp_pragma(Context *ctx)
 
             default:
                 // just strip #pragma from source
+                words++;
                 break;
         } // switch
     } // while
@@ -1244,7 +1475,7 @@ static hlmojo_Conditional *_handle_pp_ifdef(Context *ctx, const Token type)
         return NULL;
 
     hlmojo_Conditional *parent = state->conditional_stack;
-    const int found = (find_define(ctx, sym) != NULL);
+    const int found = (find_define(ctx, sym, strlen(sym)) != NULL);
     const int chosen = (type == TOKEN_PP_IFDEF) ? found : !found;
     const int skipping = ( (((parent) && (parent->skipping))) || (!chosen) );
 
@@ -1254,6 +1485,15 @@ static hlmojo_Conditional *_handle_pp_ifdef(Context *ctx, const Token type)
     conditional->chosen = chosen;
     conditional->next = parent;
     state->conditional_stack = conditional;
+
+    if ((type == TOKEN_PP_IFNDEF) && (state->include_key != NULL) &&
+        (state->guard_state == GUARD_START))
+    {
+        state->guard_macro = hlmojo_stringcache(ctx->filename_cache, sym);
+        state->guard_conditional = conditional;
+        state->guard_state = (state->guard_macro != NULL) ? GUARD_INSIDE : GUARD_NONE;
+    } // if
+
     return conditional;
 } // _handle_pp_ifdef
 
@@ -1270,10 +1510,125 @@ static inline void handle_pp_ifndef(Context *ctx)
 } // handle_pp_ifndef
 
 
+// Macro expansion memo...
+//
+// A function-like macro expands to text that only depends on its definition
+//  and the text of its arguments, with the object-like macros in them
+//  replaced. Unless some #define or #undef happened in between, a call with
+//  the same arguments as an earlier one expands to the same text again, so
+//  that is remembered and pushed again instead of built again. Arguments are
+//  in reverse order here, as handle_macro_args() collects them.
+
+static uint32 hash_expansion(const hlmojo_Define *def, const hlmojo_Define *params)
+{
+    uint32 hash = hash_define(def->identifier, strlen(def->identifier));
+    for (; params != NULL; params = params->next)
+    {
+        const char *str;
+        for (str = params->original; *str; str++)
+            hash = (hash ^ (uint8) *str) * 16777619u;
+        hash *= 16777619u;  // as if hashing the terminator, too.
+    } // for
+    return hash;
+} // hash_expansion
+
+static int expansion_args_match(const hlmojo_Expansion *memo,
+                                const hlmojo_Define *params)
+{
+    const char *args = memo->args;
+    const char *end = args + memo->argslen;
+    for (; params != NULL; params = params->next)
+    {
+        const size_t len = strlen(params->original) + 1;
+        if (((size_t) (end - args) < len) || (memcmp(args, params->original, len) != 0))
+            return 0;
+        args += len;
+    } // for
+    return (args == end);
+} // expansion_args_match
+
+static const hlmojo_Expansion *find_expansion(Context *ctx, const hlmojo_Define *def,
+                                              const hlmojo_Define *params,
+                                              const uint32 hash)
+{
+    if (ctx->expansion_memo == NULL)
+        return NULL;
+
+    const hlmojo_Expansion *memo = &ctx->expansion_memo[hash & (EXPANSION_MEMO_SIZE-1)];
+    if ((memo->define != def) || (memo->hash != hash))
+        return NULL;
+    else if (memo->generation != ctx->define_generation)
+        return NULL;
+    else if (!expansion_args_match(memo, params))
+        return NULL;
+    return memo;
+} // find_expansion
+
+static void forget_expansion(Context *ctx, hlmojo_Expansion *memo)
+{
+    // if it's still being lexed, the arena gets it back in the end.
+    const hlmojo_IncludeState *state = ctx->include_stack;
+    while ((state != NULL) && (state->source_base != memo->expansion))
+        state = state->next;
+    if (state == NULL)
+        Free(ctx, memo->expansion);
+
+    Free(ctx, memo->args);
+    memset(memo, '\0', sizeof (hlmojo_Expansion));
+} // forget_expansion
+
+// Returns non-zero if the memo took over (expansion).
+static int remember_expansion(Context *ctx, const hlmojo_Define *def,
+                              const hlmojo_Define *params, const uint32 hash,
+                              char *expansion, const unsigned int expansionlen)
+{
+    if (ctx->expansion_memo == NULL)
+    {
+        const size_t len = sizeof (hlmojo_Expansion) * EXPANSION_MEMO_SIZE;
+        ctx->expansion_memo = (hlmojo_Expansion *) Malloc(ctx, len);
+        if (ctx->expansion_memo == NULL)
+            return 0;
+        memset(ctx->expansion_memo, '\0', len);
+    } // if
+
+    size_t argslen = 0;
+    const hlmojo_Define *param;
+    for (param = params; param != NULL; param = param->next)
+        argslen += strlen(param->original) + 1;
+
+    char *args = (char *) Malloc(ctx, argslen + 1);
+    if (args == NULL)
+        return 0;
+
+    char *ptr = args;
+    for (param = params; param != NULL; param = param->next)
+    {
+        const size_t len = strlen(param->original) + 1;
+        memcpy(ptr, param->original, len);
+        ptr += len;
+    } // for
+
+    hlmojo_Expansion *memo = &ctx->expansion_memo[hash & (EXPANSION_MEMO_SIZE-1)];
+    if (memo->define != NULL)
+        forget_expansion(ctx, memo);
+
+    memo->hash = hash;
+    memo->define = def;
+    memo->generation = ctx->define_generation;
+    memo->args = args;
+    memo->argslen = argslen;
+    memo->expansion = expansion;
+    memo->expansionlen = expansionlen;
+    return 1;
+} // remember_expansion
+
+
 static int replace_and_push_macro(Context *ctx, const hlmojo_Define *def,
-                                  const hlmojo_Define *params)
+                                  const hlmojo_Define *params, const int memoize)
 {
     char *final = NULL;
+    unsigned int finallen = 0;
+    MOJOSHADER_hlslang_includeClose close_callback = close_define_include;
 
     // We push the #define and lex it, building a buffer with argument
     //  replacement, stringification, and concatenation.
@@ -1367,10 +1722,18 @@ static int replace_and_push_macro(Context *ctx, const hlmojo_Define *def,
     hlmojo_buffer_destroy(buffer);
     pop_source(ctx);  // ditch the macro.
     state = ctx->include_stack;
-    if (!push_source(ctx, state->filename, final, strlen(final), state->line,
-                     close_define_include))
+
+    finallen = (unsigned int) strlen(final);
+    if ((memoize) && (remember_expansion(ctx, def, params,
+                                         hash_expansion(def, params),
+                                         final, finallen)))
+        close_callback = NULL;  // the memo has it now.
+
+    if (!push_source(ctx, state->filename, final, finallen, state->line,
+                     close_callback))
     {
-        Free(ctx, final);
+        if (close_callback != NULL)
+            Free(ctx, final);
         return 0;
     } // if
 
@@ -1390,6 +1753,8 @@ static int handle_macro_args(Context *ctx, const char *sym, const hlmojo_Define
     hlmojo_Define *params = NULL;
     const int expected = (def->paramcount < 0) ? 0 : def->paramcount;
     int saw_params = 0;
+    int memoize = 1;  // unless an argument has __FILE__ or __LINE__ in it.
+    const hlmojo_Expansion *memo = NULL;
     hlmojo_IncludeState saved;  // can't pushback, we need the original token.
 	int void_call = 0;
 	int paren = 1;
@@ -1446,6 +1811,9 @@ static int handle_macro_args(Context *ctx, const char *sym, const hlmojo_Define
             else if (t == TOKEN_IDENTIFIER)
             {
                 const hlmojo_Define *def = find_define_by_token(ctx);
+                // either can be NULL once #undef'd, so don't match a non-macro to it.
+                if ((def != NULL) && ((def == ctx->file_macro) || (def == ctx->line_macro)))
+                    memoize = 0;
                 // don't replace macros with arguments so they replace correctly, later.
                 if ((def) && (def->paramcount == 0))
                 {
@@ -1538,8 +1906,19 @@ static int handle_macro_args(Context *ctx, const char *sym, const hlmojo_Define
         goto handle_macro_args_failed;
     } // if
 
-    // this handles arg replacement and the '##' and '#' operators.
-    retval = replace_and_push_macro(ctx, def, params);
+    if (memoize)
+        memo = find_expansion(ctx, def, params, hash_expansion(def, params));
+
+    if (memo != NULL)
+    {
+        retval = push_source(ctx, state->filename, memo->expansion,
+                             memo->expansionlen, state->line, NULL);
+    } // if
+    else
+    {
+        // this handles arg replacement and the '##' and '#' operators.
+        retval = replace_and_push_macro(ctx, def, params, memoize);
+    } // else
 
 handle_macro_args_failed:
     while (params)
@@ -1566,16 +1945,13 @@ static int handle_pp_identifier(Context *ctx)
     hlmojo_IncludeState *state = ctx->include_stack;
     const char *fname = state->filename;
     const unsigned int line = state->line;
-    char *sym = (char *) alloca(state->tokenlen+1);
-    memcpy(sym, state->token, state->tokenlen);
-    sym[state->tokenlen] = '\0';
 
     // Is this identifier #defined?
-    const hlmojo_Define *def = find_define(ctx, sym);
+    const hlmojo_Define *def = find_define_by_token(ctx);
     if (def == NULL)
         return 0;   // just send the token through unchanged.
     else if (def->paramcount != 0)
-        return handle_macro_args(ctx, sym, def);
+        return handle_macro_args(ctx, def->identifier, def);
 
     const size_t deflen = strlen(def->definition);
     return push_source(ctx, fname, def->definition, deflen, line, NULL);
@@ -1955,6 +2331,8 @@ static void handle_pp_elif(Context *ctx)
         fail(ctx, "#elif after #else");
     else
     {
+        if (cond == state->guard_conditional)
+            state->guard_state = GUARD_NONE;
         const hlmojo_Conditional *parent = cond->next;
         cond->type = TOKEN_PP_ELIF;
         cond->skipping = (parent && parent->skipping) || cond->chosen || !rc;
@@ -1977,6 +2355,8 @@ static void handle_pp_else(Context *ctx)
         fail(ctx, "#else after #else");
     else
     {
+        if (cond == state->guard_conditional)
+            state->guard_state = GUARD_NONE;
         const hlmojo_Conditional *parent = cond->next;
         cond->type = TOKEN_PP_ELSE;
         cond->skipping = (parent && parent->skipping) || cond->chosen;
@@ -1997,6 +2377,12 @@ static void handle_pp_endif(Context *ctx)
         fail(ctx, "Unmatched #endif");
     else
     {
+        if (cond == state->guard_conditional)
+        {
+            if (state->guard_state == GUARD_INSIDE)
+                state->guard_state = GUARD_AFTER;
+            state->guard_conditional = NULL;  // the pointer may get reused.
+        } // if
         state->conditional_stack = cond->next;  // pop it.
         put_conditional(ctx, cond);
     } // else
@@ -2057,6 +2443,9 @@ static inline const char *_hlmojo_preprocessor_nexttoken(hlmojo_Preprocessor *_c
         if (token != TOKEN_IDENTIFIER)
             ctx->recursion_count = 0;
 
+        if ((state->include_key != NULL) && (state->guard_state != GUARD_NONE))
+            track_include_guard(ctx, state, token);
+
         if (token == TOKEN_EOI)
         {
             assert(state->bytes_left == 0);
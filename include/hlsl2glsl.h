@@ -249,6 +249,10 @@ enum TTranslateOptions
 	//  instead of outputting e.g. "xlat_attrib_TEXCOORD0" for "appdata_t.texcoord : TEXCOORD0"
 	//  we will output "appdata_t_texcoord"
 	ETranslateOpPropogateOriginalAttribNames = (1<<4),
+
+	// For Hlsl2Glsl_Parse, Hlsl2Glsl_CompileCached and Hlsl2Glsl_CompileVariants: record every
+	// file the shader includes, see Hlsl2Glsl_GetDependencies
+	ETranslateOpRecordDependencies = (1<<5),
 };
 
 
@@ -257,9 +261,17 @@ enum TTranslateOptions
 /// If handle creation fails, 0 will be returned.
 namespace hlsl2glsl {
 class HlslCrossCompiler;
+class TCompileCache;
+class TIncludeCache;
 } // namespace hlsl2glsl
 typedef hlsl2glsl::HlslCrossCompiler* ShHandle;
 
+/// Handle to a compile cache, see Hlsl2Glsl_CompileCached.
+typedef hlsl2glsl::TCompileCache* ShCacheHandle;
+
+/// Handle to an include file cache, see Hlsl2Glsl_ConstructIncludeCache.
+typedef hlsl2glsl::TIncludeCache* ShIncludeCacheHandle;
+
 extern "C" {
 
 /// Initialize the HLSL2GLSL translator.  This function must be called once prior to calling any other
@@ -294,6 +306,7 @@ struct Hlsl2Glsl_ParseCallbacks
 /// Parse HLSL shader to prepare it for final translation.
 /// \param callbacks
 ///		File read callback for #include processing. If NULL is passed, then #include directives will result in error.
+///		Only called before Hlsl2Glsl_Parse returns; neither the callbacks nor their data are kept.
 /// \param options
 ///		Flags of TTranslateOptions
 HLSL2GLSL_IMPORT_EXPORT int C_DECL Hlsl2Glsl_Parse(
@@ -306,6 +319,12 @@ HLSL2GLSL_IMPORT_EXPORT int C_DECL Hlsl2Glsl_Parse(
 
 
 /// After parsing a HLSL shader, do the final translation to GLSL.
+///
+/// Can be called again with other target versions; the parsed shader is kept with the handle
+/// until the next Hlsl2Glsl_Parse. Only where the HLSL rules differ before and after GLSL 1.20
+/// (non-square matrices, matrix conversions, global initializers) and the shader used them is
+/// the shader parsed again, from the preprocessed tokens the handle kept, so #include files are not
+/// read again.
 HLSL2GLSL_IMPORT_EXPORT int C_DECL Hlsl2Glsl_Translate(
 	const ShHandle handle,
 	const char* entry,
@@ -320,6 +339,11 @@ HLSL2GLSL_IMPORT_EXPORT const char* C_DECL Hlsl2Glsl_GetShader( const ShHandle h
 HLSL2GLSL_IMPORT_EXPORT const char* C_DECL Hlsl2Glsl_GetInfoLog( const ShHandle handle );
 
 
+/// How many times the handle parsed a shader: once per Hlsl2Glsl_Parse, and once more each
+/// time Hlsl2Glsl_Translate had to parse it again for its target.
+HLSL2GLSL_IMPORT_EXPORT int C_DECL Hlsl2Glsl_GetParseCount( const ShHandle handle );
+
+
 /// After translating, retrieve the number of uniforms
 HLSL2GLSL_IMPORT_EXPORT int C_DECL Hlsl2Glsl_GetUniformCount( const ShHandle handle );
 
@@ -351,6 +375,252 @@ HLSL2GLSL_IMPORT_EXPORT int C_DECL Hlsl2Glsl_SetUserAttributeNames ( ShHandle ha
 
 HLSL2GLSL_IMPORT_EXPORT bool C_DECL Hlsl2Glsl_VersionUsesPrecision (ETargetVersion version);
 
+
+/// Callbacks for an application provided compile cache store. Keys are 64 hex digit content hashes,
+/// values opaque binary strings. Both can get called from several threads at once.
+typedef bool (C_DECL *Hlsl2Glsl_CacheLoadFunc)(const char* key, std::string& value, void* data);
+typedef void (C_DECL *Hlsl2Glsl_CacheSaveFunc)(const char* key, const std::string& value, void* data);
+struct Hlsl2Glsl_CacheCallbacks
+{
+	Hlsl2Glsl_CacheLoadFunc load;
+	Hlsl2Glsl_CacheSaveFunc save;
+	void* data;
+};
+
+/// Construct an in-memory compile cache holding up to maxBytes of results (0 for no limit),
+/// dropping the least recently used ones first.
+HLSL2GLSL_IMPORT_EXPORT ShCacheHandle C_DECL Hlsl2Glsl_ConstructMemoryCache( size_t maxBytes );
+
+/// Construct a compile cache that keeps one file per result in the given, existing directory.
+/// Files are written atomically, so several processes can share the directory.
+HLSL2GLSL_IMPORT_EXPORT ShCacheHandle C_DECL Hlsl2Glsl_ConstructDirectoryCache( const char* path );
+
+/// Construct a compile cache backed by application callbacks.
+HLSL2GLSL_IMPORT_EXPORT ShCacheHandle C_DECL Hlsl2Glsl_ConstructCallbackCache( const Hlsl2Glsl_CacheCallbacks* callbacks );
+
+HLSL2GLSL_IMPORT_EXPORT void C_DECL Hlsl2Glsl_DestructCache( ShCacheHandle cache );
+
+/// Hlsl2Glsl_Parse followed by Hlsl2Glsl_Translate, looking the result up in cache first.
+///
+/// The result is keyed on the preprocessed shader (with all includes resolved), the language, entry,
+/// target version, options, prefix table and user attribute names of the compiler. On a hit, the
+/// stored GLSL text, uniform info and info log are returned through the compiler without parsing or
+/// translating, and the compiler drops whatever it parsed before. Hlsl2Glsl_Translate on it later
+/// parses the shader from its preprocessed tokens. Shaders that fail to preprocess are compiled
+/// without the cache.
+/// \return
+///   1 on success, 0 on failure, as for Hlsl2Glsl_Translate
+HLSL2GLSL_IMPORT_EXPORT int C_DECL Hlsl2Glsl_CompileCached(
+	const ShHandle handle,
+	ShCacheHandle cache,
+	const char* shaderString,
+	const char* entry,
+	ETargetVersion targetVersion,
+	Hlsl2Glsl_ParseCallbacks* callbacks,
+	unsigned options);
+
+
+/// Maps an #include to the path of the file it reads, e.g. resolved against the including file.
+/// Return false to read the file without the cache.
+typedef bool (C_DECL *Hlsl2Glsl_IncludeResolveFunc)(bool isSystem, const char* fname, const char* parentfname, std::string& path, void* data);
+/// Hash of the current content of the file at path, e.g. as kept by the build system. Cached
+/// files with another hash are read again. Return false to read the file without the cache.
+typedef bool (C_DECL *Hlsl2Glsl_IncludeHashFunc)(const char* path, std::string& hash, void* data);
+struct Hlsl2Glsl_IncludeCacheCallbacks
+{
+	/// May be NULL, then files are keyed by their name as written in the #include
+	Hlsl2Glsl_IncludeResolveFunc resolve;
+	/// May be NULL, then cached files are never checked for changes
+	Hlsl2Glsl_IncludeHashFunc hash;
+	void* data;
+};
+
+struct Hlsl2Glsl_IncludeCacheStats
+{
+	/// Includes read from the cache
+	unsigned long long hits;
+	/// Includes read through the include open callback, including invalidations
+	unsigned long long misses;
+	/// Cached files read again because their hash changed
+	unsigned long long invalidations;
+	/// Files and bytes held by the cache
+	size_t files;
+	size_t bytes;
+};
+
+/// Construct a cache for the contents of #include files, to share them between compilers and threads.
+/// Files are read through the include open callback passed to the parse the first time they are
+/// included, and from then on read in place from the cache. callbacks may be NULL.
+/// The callbacks can get called from several threads at once.
+HLSL2GLSL_IMPORT_EXPORT ShIncludeCacheHandle C_DECL Hlsl2Glsl_ConstructIncludeCache( const Hlsl2Glsl_IncludeCacheCallbacks* callbacks );
+
+/// Compilers using the cache keep it alive until they are destructed.
+HLSL2GLSL_IMPORT_EXPORT void C_DECL Hlsl2Glsl_DestructIncludeCache( ShIncludeCacheHandle cache );
+
+HLSL2GLSL_IMPORT_EXPORT void C_DECL Hlsl2Glsl_GetIncludeCacheStats( ShIncludeCacheHandle cache, Hlsl2Glsl_IncludeCacheStats* stats );
+
+/// Read #include files through cache in all following parses with this compiler (NULL to stop).
+HLSL2GLSL_IMPORT_EXPORT void C_DECL Hlsl2Glsl_SetIncludeCache( ShHandle handle, ShIncludeCacheHandle cache );
+
+
+/// One shader for Hlsl2Glsl_CompileBatch.
+struct Hlsl2Glsl_BatchJob
+{
+	const char* shaderString;
+	EShLanguage language;
+	const char* entry;
+	ETargetVersion targetVersion;
+	/// Flags of TTranslateOptions, used for both parsing and translation
+	unsigned options;
+	/// Prefixes as for Hlsl2Glsl_ConstructCompilerUserPrefix, may be NULL
+	const ShUserPrefixTable* prefixTable;
+	/// #include callbacks as for Hlsl2Glsl_Parse, may be NULL. They get called from the worker threads.
+	Hlsl2Glsl_ParseCallbacks* callbacks;
+	/// User attribute names as for Hlsl2Glsl_SetUserAttributeNames, may be NULL/0
+	const EAttribSemantic* userAttribSemantics;
+	const char** userAttribNames;
+	int userAttribCount;
+	/// Compile through this cache as with Hlsl2Glsl_CompileCached, may be NULL
+	ShCacheHandle cache;
+	/// Read #include files through this cache as with Hlsl2Glsl_SetIncludeCache, may be NULL
+	ShIncludeCacheHandle includeCache;
+};
+
+/// Result of one Hlsl2Glsl_CompileBatch job.
+struct Hlsl2Glsl_BatchResult
+{
+	/// Compiler the job ran on, query it with Hlsl2Glsl_GetShader, Hlsl2Glsl_GetInfoLog etc.
+	/// and free it with Hlsl2Glsl_DestructCompiler. 0 if the compiler could not be created.
+	ShHandle handle;
+	/// 1 if both parsing and translation succeeded
+	int success;
+};
+
+/// Compile many shaders at once: each job is parsed and translated as with Hlsl2Glsl_Parse and
+/// Hlsl2Glsl_Translate on its own compiler. The jobs run on a work-stealing pool of threadCount
+/// threads (one per hardware thread if threadCount <= 0), the calling thread being one of them.
+/// results[i] belongs to jobs[i].
+/// \return
+///   1 if all jobs succeeded, 0 otherwise
+HLSL2GLSL_IMPORT_EXPORT int C_DECL Hlsl2Glsl_CompileBatch(
+	const Hlsl2Glsl_BatchJob* jobs,
+	int jobCount,
+	Hlsl2Glsl_BatchResult* results,
+	int threadCount);
+
+
+/// A macro for Hlsl2Glsl_CompileVariants, as if by "#define name value" before the shader.
+/// name can have parameters, e.g. "SCALE(x)".
+struct Hlsl2Glsl_Define
+{
+	const char* name;
+	/// May be NULL for an empty definition
+	const char* value;
+};
+
+/// One keyword variant of the shader for Hlsl2Glsl_CompileVariants.
+struct Hlsl2Glsl_Variant
+{
+	const Hlsl2Glsl_Define* defines;
+	int defineCount;
+};
+
+struct Hlsl2Glsl_VariantStats
+{
+	/// Variants that were parsed and translated
+	int parsed;
+	/// Variants that preprocessed to the same tokens as another variant, and share its result
+	int duplicates;
+	/// Variants found in the compile cache of the job
+	int cached;
+};
+
+/// Compile one shader under several sets of defines. Each variant gives the result that
+/// Hlsl2Glsl_CompileBatch would for job with the variant's defines, but the work that does
+/// not depend on the defines is shared: #include files are read once for all variants (through
+/// job.includeCache, or a cache of this call if NULL), every variant is preprocessed once, and
+/// variants that preprocess to the same tokens are parsed and translated only once. The
+/// handles of such duplicates hold the result like a compile cache hit does, and parse their
+/// tokens when translated again. Runs on threadCount threads as Hlsl2Glsl_CompileBatch.
+/// results[i] belongs to variants[i]. stats may be NULL.
+/// \return
+///   1 if all variants succeeded, 0 otherwise
+HLSL2GLSL_IMPORT_EXPORT int C_DECL Hlsl2Glsl_CompileVariants(
+	const Hlsl2Glsl_BatchJob* job,
+	const Hlsl2Glsl_Variant* variants,
+	int variantCount,
+	Hlsl2Glsl_BatchResult* results,
+	int threadCount,
+	Hlsl2Glsl_VariantStats* stats);
+
+
+/// Where a run of the Hlsl2Glsl_Preprocess text came from: the text from offset up to the
+/// next span's offset starts at line of file, and every newline in it is one line further.
+struct Hlsl2Glsl_SourceSpan
+{
+	unsigned int offset;
+	/// Index in the names of Hlsl2Glsl_GetSourceFiles
+	unsigned int file;
+	unsigned int line;
+};
+
+/// Only preprocess the shader, with the defines as for a variant of Hlsl2Glsl_CompileVariants
+/// (defines may be NULL/0). #include files are read through callbacks as for Hlsl2Glsl_Parse,
+/// and through the include cache of the compiler if it has one. The parsed shader and GLSL of
+/// the compiler are left as they are.
+///
+/// The expanded tokens are kept with the compiler as text, separated by spaces, with a newline
+/// where the source line changes. Parsing the text gives the same result as parsing the
+/// shader, except for line numbers: those are mapped back through the source map.
+/// \return
+///   1 on success, 0 on preprocessing errors, which are in the info log
+HLSL2GLSL_IMPORT_EXPORT int C_DECL Hlsl2Glsl_Preprocess(
+	const ShHandle handle,
+	const char* shaderString,
+	Hlsl2Glsl_ParseCallbacks* callbacks,
+	const Hlsl2Glsl_Define* defines,
+	int defineCount);
+
+/// After preprocessing, the expanded text. On errors, the text up to the error.
+HLSL2GLSL_IMPORT_EXPORT const char* C_DECL Hlsl2Glsl_GetPreprocessedText( const ShHandle handle );
+
+/// After preprocessing, the spans of the text in order of their offsets, one per jump in
+/// source position
+HLSL2GLSL_IMPORT_EXPORT const Hlsl2Glsl_SourceSpan* C_DECL Hlsl2Glsl_GetSourceMap( const ShHandle handle, int* spanCount );
+
+/// After preprocessing, the names of the files the spans refer to. The shader itself is "",
+/// included files are named as in their #include.
+HLSL2GLSL_IMPORT_EXPORT const char* const* C_DECL Hlsl2Glsl_GetSourceFiles( const ShHandle handle, int* fileCount );
+
+
+
+/// A file the last Hlsl2Glsl_Parse with ETranslateOpRecordDependencies read or tried to read
+/// for an #include.
+struct Hlsl2Glsl_Dependency
+{
+	/// Resolved through the include cache of the compiler, else the name as written, for a local
+	/// include in the directory of the including file. Unresolved paths are relative to the
+	/// directory of the shader, and tell two files apart only as far as their names do.
+	const char* path;
+	/// As written in the #include, and the name of the including file ("" for the shader itself)
+	const char* name;
+	const char* parentName;
+	int isSystem;
+	/// 0 if the include open callback failed
+	int found;
+};
+
+/// After parsing with ETranslateOpRecordDependencies, the files the shader includes, once per
+/// path, in the order they were first included. Includes left out because of an include guard
+/// or #pragma once count too, and so do files that could not be opened. Compiles that come from
+/// the compile cache or from a duplicate variant list the includes of their own preprocessing.
+HLSL2GLSL_IMPORT_EXPORT const Hlsl2Glsl_Dependency* C_DECL Hlsl2Glsl_GetDependencies( const ShHandle handle, int* dependencyCount );
+
+/// The dependencies as a Makefile rule for target, with an empty rule for each of them, as
+/// written by "cc -MD -MP": the paths are escaped for make. Files that could not be opened are
+/// left out, since the compile failed without them. Ninja reads the same format as a depfile.
+HLSL2GLSL_IMPORT_EXPORT const char* C_DECL Hlsl2Glsl_GetDepfile( const ShHandle handle, const char* target );
+
 } // extern "C"
 
 #endif // _HLSL2GLSL_INTERFACE_INCLUDED_
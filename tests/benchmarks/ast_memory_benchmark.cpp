@@ -0,0 +1,46 @@
+// Reports how much memory the parse of each shader in tests/ leaves in the compiler's pool,
+// which is mostly its syntax tree. The bytes counter is what to look at; every shader is
+// parsed once. Uses library internals, so this is only built against the static library.
+
+#include "benchmark_common.h"
+
+#include "hlslCrossCompiler.h"
+
+#include <string>
+
+namespace {
+
+using namespace hlsl2glsl;
+
+void BM_ASTMemory(benchmark::State& state, EShLanguage language, const std::string& source)
+{
+    BenchmarkLibrary library;
+    size_t bytes = 0;
+
+    for (auto _ : state) {
+        ShHandle compiler = Hlsl2Glsl_ConstructCompiler(language);
+        const size_t before = compiler->GetASTPool()->getTotalBytes();
+        if (!Hlsl2Glsl_Parse(compiler, source.c_str(), ETargetGLSL_110, nullptr, 0)) {
+            state.SkipWithError(Hlsl2Glsl_GetInfoLog(compiler));
+        }
+        bytes = compiler->GetASTPool()->getTotalBytes() - before;
+        Hlsl2Glsl_DestructCompiler(compiler);
+    }
+    state.counters["bytes"] = static_cast<double>(bytes);
+}
+
+// One benchmark per shader that parses without #include callbacks
+bool RegisterCorpus()
+{
+    for (const CorpusFile& file : ListCorpus()) {
+        if (file.name.find("include") == std::string::npos) {
+            const std::string name = "BM_ASTMemory/" + file.dir + "/" + file.name;
+            benchmark::RegisterBenchmark(name.c_str(), BM_ASTMemory, file.language, file.source)->Iterations(1);
+        }
+    }
+    return true;
+}
+
+const bool registered = RegisterCorpus();
+
+} // namespace
@@ -0,0 +1,61 @@
+#include "benchmark_common.h"
+
+#include <vector>
+
+namespace {
+
+constexpr const char* kLightingShaderSrc = R"""(
+sampler2D diffuseMap;
+sampler2D normalMap;
+float4 lightDir;
+float4 lightColor;
+
+float3 unpackNormal (float4 encoded)
+{
+	return encoded.xyz * 2.0 - 1.0;
+}
+
+float4 main (float2 uv : TEXCOORD0, float3 viewDir : TEXCOORD1) : COLOR0
+{
+	float4 albedo = tex2D (diffuseMap, uv);
+	float3 n = normalize (unpackNormal (tex2D (normalMap, uv)));
+	float3 h = normalize (lightDir.xyz + normalize (viewDir));
+	float diff = saturate (dot (n, lightDir.xyz));
+	float spec = pow (saturate (dot (n, h)), 32.0);
+	return albedo * lightColor * diff + spec;
+}
+)""";
+
+constexpr int kBatchSize = 256;
+
+// Throughput of Hlsl2Glsl_CompileBatch for a given thread count; should scale with the number of cores.
+void BM_CompileBatch(benchmark::State& state)
+{
+    BenchmarkLibrary library;
+    const int threadCount = static_cast<int>(state.range(0));
+
+    std::vector<Hlsl2Glsl_BatchJob> jobs(kBatchSize);
+    for (auto& job : jobs) {
+        job = Hlsl2Glsl_BatchJob { kLightingShaderSrc, EShLangFragment, "main", ETargetGLSL_110, 0,
+            nullptr, nullptr, nullptr, nullptr, 0, nullptr, nullptr };
+    }
+    std::vector<Hlsl2Glsl_BatchResult> results(jobs.size());
+
+    for (auto _ : state) {
+        bool ok = Hlsl2Glsl_CompileBatch(jobs.data(), kBatchSize, results.data(), threadCount) != 0;
+        if (!ok) {
+            state.SkipWithError(Hlsl2Glsl_GetInfoLog(results[0].handle));
+        }
+        for (auto& result : results) {
+            Hlsl2Glsl_DestructCompiler(result.handle);
+        }
+        if (!ok) {
+            break;
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * kBatchSize);
+}
+
+BENCHMARK(BM_CompileBatch)->RangeMultiplier(2)->Range(1, 16)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+} // namespace
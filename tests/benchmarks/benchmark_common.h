@@ -0,0 +1,85 @@
+#pragma once
+
+#include "hlsl2glsl.h"
+
+#include "benchmark/benchmark.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Keeps the library initialized for the duration of a benchmark.
+class BenchmarkLibrary
+{
+public:
+    BenchmarkLibrary()
+    {
+        if (!Hlsl2Glsl_Initialize())
+        {
+            throw std::runtime_error { "failed to initialize HLSL2GLSL" };
+        }
+    }
+
+    ~BenchmarkLibrary()
+    {
+        Hlsl2Glsl_Shutdown();
+    }
+
+    BenchmarkLibrary(const BenchmarkLibrary&) = delete;
+    BenchmarkLibrary& operator=(const BenchmarkLibrary&) = delete;
+};
+
+// Parses and translates the shader with a fresh compiler, like the test runner does.
+// Returns false and fills in infoLog on any error.
+inline bool CompileShader(EShLanguage type, const std::string& shaderSrc, std::string& infoLog,
+                          ETargetVersion targetVersion = ETargetGLSL_110, unsigned options = 0)
+{
+    ShHandle parser = Hlsl2Glsl_ConstructCompiler(type);
+    bool ok = Hlsl2Glsl_Parse(parser, shaderSrc.c_str(), targetVersion, nullptr, options) &&
+              Hlsl2Glsl_Translate(parser, "main", targetVersion, options);
+    if (!ok)
+        infoLog = Hlsl2Glsl_GetInfoLog(parser);
+    Hlsl2Glsl_DestructCompiler(parser);
+    return ok;
+}
+
+// A shader of the test corpus in tests/, dir is fragment or vertex.
+struct CorpusFile
+{
+    EShLanguage language;
+    std::string dir;
+    std::string name;
+    std::string source;
+};
+
+// Reads every -in.txt shader of the test corpus, in the order the test runner sees them.
+inline std::vector<CorpusFile> ListCorpus()
+{
+    std::vector<CorpusFile> corpus;
+    const std::pair<const char*, EShLanguage> dirs[] = {
+        { "fragment", EShLangFragment },
+        { "vertex", EShLangVertex },
+    };
+    for (const auto& dir : dirs) {
+        std::vector<std::filesystem::path> files;
+        for (const auto& entry : std::filesystem::directory_iterator(std::filesystem::path(HLSL2GLSL_TESTS_DIR) / dir.first)) {
+            const std::string name = entry.path().filename().string();
+            if (name.size() > 7 && name.compare(name.size() - 7, 7, "-in.txt") == 0) {
+                files.push_back(entry.path());
+            }
+        }
+        std::sort(files.begin(), files.end());
+
+        for (const auto& file : files) {
+            std::ifstream in(file);
+            std::stringstream source;
+            source << in.rdbuf();
+            corpus.push_back({ dir.second, dir.first, file.filename().string(), source.str() });
+        }
+    }
+    return corpus;
+}
@@ -0,0 +1,44 @@
+#include "benchmark_common.h"
+
+namespace {
+
+constexpr const char* kShaderSrc = R"""(
+sampler2D diffuseMap;
+float4 lightDir;
+float4 lightColor;
+
+float4 main (float2 uv : TEXCOORD0, float3 normal : TEXCOORD1) : COLOR0
+{
+	float4 albedo = tex2D (diffuseMap, uv);
+	float diff = saturate (dot (normalize (normal), lightDir.xyz));
+	return albedo * lightColor * diff;
+}
+)""";
+
+// Compile through the cache; with a warm cache this only preprocesses and hashes the shader.
+void BM_CompileCached(benchmark::State& state)
+{
+    BenchmarkLibrary library;
+    const bool warm = state.range(0) != 0;
+    ShCacheHandle cache = Hlsl2Glsl_ConstructMemoryCache(0);
+
+    for (auto _ : state) {
+        if (!warm) {
+            state.PauseTiming();
+            Hlsl2Glsl_DestructCache(cache);
+            cache = Hlsl2Glsl_ConstructMemoryCache(0);
+            state.ResumeTiming();
+        }
+        ShHandle compiler = Hlsl2Glsl_ConstructCompiler(EShLangFragment);
+        if (!Hlsl2Glsl_CompileCached(compiler, cache, kShaderSrc, "main", ETargetGLSL_110, nullptr, 0)) {
+            state.SkipWithError(Hlsl2Glsl_GetInfoLog(compiler));
+        }
+        Hlsl2Glsl_DestructCompiler(compiler);
+    }
+
+    Hlsl2Glsl_DestructCache(cache);
+}
+
+BENCHMARK(BM_CompileCached)->ArgName("warm")->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
+
+} // namespace
@@ -0,0 +1,73 @@
+#include "benchmark_common.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+namespace {
+
+constexpr const char* kShaderSrc = R"""(
+#include "engine.h"
+
+float4 main (float2 uv : TEXCOORD0) : COLOR0
+{
+	return Tint (uv.xyxy);
+}
+)""";
+
+// A large header, like engine headers mostly made of features this shader leaves off
+std::filesystem::path WriteHeader()
+{
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / "hlsl2glsl-include-cache-benchmark.h";
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out << "#ifdef ENGINE_EXTRA_FEATURES\n";
+    for (int i = 0; out.tellp() < 100 * 1024; ++i) {
+        out << "float4 Feature" << i << " (float4 v) { return v * " << i << ".0 + float4 (0.25, 0.5, 0.75, 1.0); }\n";
+    }
+    out << "#endif\n";
+    out << "float4 Tint (float4 v) { return v * 0.5; }\n";
+    return path;
+}
+
+// Reads includes from disk, as applications do
+bool OpenInclude(bool isSystem, const char* fname, const char* parentfname, const char* parent, std::string& output, void* data)
+{
+    std::ifstream in(*static_cast<const std::filesystem::path*>(data), std::ios::binary);
+    output.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    return !in.bad();
+}
+
+void CloseInclude(const char* file, void* data)
+{
+}
+
+void BM_ParseIncludes(benchmark::State& state)
+{
+    BenchmarkLibrary library;
+    std::filesystem::path header = WriteHeader();
+    Hlsl2Glsl_ParseCallbacks callbacks { OpenInclude, CloseInclude, &header };
+    ShIncludeCacheHandle cache = state.range(0) ? Hlsl2Glsl_ConstructIncludeCache(nullptr) : nullptr;
+
+    for (auto _ : state) {
+        ShHandle compiler = Hlsl2Glsl_ConstructCompiler(EShLangFragment);
+        Hlsl2Glsl_SetIncludeCache(compiler, cache);
+        if (!Hlsl2Glsl_Parse(compiler, kShaderSrc, ETargetGLSL_110, &callbacks, 0)) {
+            state.SkipWithError(Hlsl2Glsl_GetInfoLog(compiler));
+        }
+        Hlsl2Glsl_DestructCompiler(compiler);
+    }
+
+    if (cache) {
+        Hlsl2Glsl_IncludeCacheStats stats {};
+        Hlsl2Glsl_GetIncludeCacheStats(cache, &stats);
+        state.counters["hits"] = static_cast<double>(stats.hits);
+        state.counters["misses"] = static_cast<double>(stats.misses);
+        Hlsl2Glsl_DestructIncludeCache(cache);
+    }
+    std::filesystem::remove(header);
+}
+
+BENCHMARK(BM_ParseIncludes)->ArgName("cached")->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
+
+} // namespace
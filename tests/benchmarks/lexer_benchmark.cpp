@@ -0,0 +1,66 @@
+// Preprocessor throughput on a large synthetic shader, shaped like the output of templated
+// includes: banner comments, deep indentation and long identifiers. Uses library internals,
+// so this is only built against the static library.
+
+#include "benchmark_common.h"
+
+#include "ParseHelper.h"
+
+#include <string>
+
+namespace {
+
+using namespace hlsl2glsl;
+
+constexpr size_t kCorpusBytes = 4 << 20;
+
+// With or without comments between the functions
+std::string SyntheticCorpus(bool comments)
+{
+    std::string source;
+    for (int i = 0; source.size() < kCorpusBytes; ++i) {
+        const std::string n = std::to_string(i);
+        if (comments) {
+            source +=
+                "/*\n"
+                " * ComputeLighting_" + n + " was expanded from the lighting template for this permutation.\n"
+                " * Do not edit: changes get overwritten the next time the templates are expanded.\n"
+                " *\n"
+                " * Parameters: worldNormal    - normalized world space normal of the surface\n"
+                " *             worldPosition  - world space position of the shaded point\n"
+                " */\n"
+                "// --------------------------------------------------------------------------------\n";
+        }
+        source +=
+            "float4 ComputeLighting_" + n + " (float3 worldNormal, float3 worldPosition)\n"
+            "{\n"
+            "                float4 accumulatedLightColor = float4 (0.0, 0.0, 0.0, 0.0);\n"
+            "                float3 directionToLight = normalize (LightPositionWorldSpace.xyz - worldPosition);\n"
+            "                float lambertianReflectance = saturate (dot (worldNormal, directionToLight));\n"
+            "                accumulatedLightColor += LightColorAndIntensity * lambertianReflectance;\n"
+            "                return accumulatedLightColor;\n"
+            "}\n\n";
+    }
+    return source;
+}
+
+void BM_PreprocessLargeSource(benchmark::State& state)
+{
+    const std::string source = SyntheticCorpus(state.range(0) != 0);
+
+    size_t tokens = 0;
+    for (auto _ : state) {
+        TPreprocessedSource output;
+        if (!PaPreprocessString(source.c_str(), nullptr, nullptr, nullptr, 0, output)) {
+            state.SkipWithError("preprocessing failed");
+            break;
+        }
+        tokens = output.tokens.size();
+    }
+    state.SetBytesProcessed(state.iterations() * source.size());
+    state.counters["tokens"] = static_cast<double>(tokens);
+}
+
+BENCHMARK(BM_PreprocessLargeSource)->ArgName("comments")->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+
+} // namespace
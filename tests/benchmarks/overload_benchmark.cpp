@@ -0,0 +1,78 @@
+// Parses shaders that are mostly calls of overloaded built-ins like lerp, max, dot and
+// tex2D: the FXAA shaders in tests/, and generated ones repeating the same calls.
+
+#include "benchmark_common.h"
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+namespace {
+
+const char* const kCallHeavyShaders[] = {
+    "z-fxaa3-11-pc39-in.txt",
+    "z-fxaa3-11-consolepc-in.txt",
+    "z-fxaa-preset3-in.txt",
+};
+
+std::string ReadFragmentShader(const char* name)
+{
+    std::ifstream in(std::filesystem::path(HLSL2GLSL_TESTS_DIR) / "fragment" / name);
+    std::stringstream source;
+    source << in.rdbuf();
+    return source.str();
+}
+
+void BM_ParseCallHeavy(benchmark::State& state)
+{
+    BenchmarkLibrary library;
+    const char* name = kCallHeavyShaders[state.range(0)];
+    const std::string source = ReadFragmentShader(name);
+    state.SetLabel(name);
+
+    for (auto _ : state) {
+        ShHandle parser = Hlsl2Glsl_ConstructCompiler(EShLangFragment);
+        if (!Hlsl2Glsl_Parse(parser, source.c_str(), ETargetGLSL_110, nullptr, 0)) {
+            state.SkipWithError(Hlsl2Glsl_GetInfoLog(parser));
+        }
+        Hlsl2Glsl_DestructCompiler(parser);
+    }
+    state.SetBytesProcessed(state.iterations() * source.size());
+}
+
+BENCHMARK(BM_ParseCallHeavy)->ArgName("shader")->DenseRange(0, 2)->Unit(benchmark::kMicrosecond);
+
+// state.range(0) statements calling the same few built-ins with the same argument types,
+// some of them needing conversions, like lighting code unrolled over many lights
+std::string RepeatedCallShader(int statementCount)
+{
+    std::string source =
+        "sampler2D tex;\nfloat4x4 world;\nfloat3 lightDir;\n"
+        "float4 main (float2 uv : TEXCOORD0, float3 n : TEXCOORD1) : COLOR0\n{\n\tfloat4 c = 0.0;\n";
+    for (int i = 0; i < statementCount; ++i) {
+        source += "\tc += tex2D (tex, uv) * saturate (dot (n, lightDir)) + mul (world, float4 (n, 1.0)) * lerp (0.25, c.x, 0.5) + max (c, 0);\n";
+    }
+    source += "\treturn c;\n}\n";
+    return source;
+}
+
+void BM_ParseRepeatedCalls(benchmark::State& state)
+{
+    BenchmarkLibrary library;
+    const int statementCount = static_cast<int>(state.range(0));
+    const std::string source = RepeatedCallShader(statementCount);
+
+    for (auto _ : state) {
+        ShHandle parser = Hlsl2Glsl_ConstructCompiler(EShLangFragment);
+        if (!Hlsl2Glsl_Parse(parser, source.c_str(), ETargetGLSL_110, nullptr, 0)) {
+            state.SkipWithError(Hlsl2Glsl_GetInfoLog(parser));
+        }
+        Hlsl2Glsl_DestructCompiler(parser);
+    }
+    state.SetItemsProcessed(state.iterations() * statementCount * 6);
+}
+
+BENCHMARK(BM_ParseRepeatedCalls)->ArgName("statements")->Arg(64)->Arg(1024)->Unit(benchmark::kMicrosecond);
+
+} // namespace
@@ -0,0 +1,63 @@
+#include "benchmark_common.h"
+
+#include <string>
+
+namespace {
+
+constexpr const char* kMinimalShaderSrc = R"""(
+float4 main () : COLOR0
+{
+	return 0.0;
+}
+)""";
+
+// Fixed per-parse cost: compiler setup, symbol table setup and teardown around a trivial shader.
+void BM_ParseStart(benchmark::State& state)
+{
+    BenchmarkLibrary library;
+
+    for (auto _ : state) {
+        ShHandle parser = Hlsl2Glsl_ConstructCompiler(EShLangFragment);
+        if (!Hlsl2Glsl_Parse(parser, kMinimalShaderSrc, ETargetGLSL_110, nullptr, 0)) {
+            state.SkipWithError(Hlsl2Glsl_GetInfoLog(parser));
+        }
+        Hlsl2Glsl_DestructCompiler(parser);
+    }
+}
+
+BENCHMARK(BM_ParseStart)->Unit(benchmark::kMicrosecond);
+
+// state.range(0) statements made mostly of literals: matrices spelled out component by
+// component, folded arithmetic, and swizzles of const vectors.
+std::string ConstantHeavyShader(int statementCount)
+{
+    std::string source = "const float4 k = float4 (0.5, 0.25, 2.0, 1.0);\n";
+    source += "float4 main (float4 uv : TEXCOORD0) : COLOR0\n{\n\tfloat4 acc = uv;\n";
+    for (int i = 0; i < statementCount; ++i) {
+        const std::string n = std::to_string(i);
+        source += "\tacc = mul (float4x4 (1.0, 0.0, 0.0, " + n + ".0, 0.0, 1.0, 0.0, 0.5, 0.0, 0.0, 1.0, 0.25, 0.0, 0.0, 0.0, 1.0), acc);\n";
+        source += "\tacc += k.xyzw * (2.0 * 3.0 - " + n + ") + k.wzyx + float4 (1, 2, 3, -4) / 8.0;\n";
+    }
+    source += "\treturn acc;\n}\n";
+    return source;
+}
+
+void BM_ParseConstantHeavy(benchmark::State& state)
+{
+    BenchmarkLibrary library;
+    const int statementCount = static_cast<int>(state.range(0));
+    const std::string source = ConstantHeavyShader(statementCount);
+
+    for (auto _ : state) {
+        ShHandle parser = Hlsl2Glsl_ConstructCompiler(EShLangFragment);
+        if (!Hlsl2Glsl_Parse(parser, source.c_str(), ETargetGLSL_110, nullptr, 0)) {
+            state.SkipWithError(Hlsl2Glsl_GetInfoLog(parser));
+        }
+        Hlsl2Glsl_DestructCompiler(parser);
+    }
+    state.SetItemsProcessed(state.iterations() * statementCount);
+}
+
+BENCHMARK(BM_ParseConstantHeavy)->Arg(64)->Arg(512)->Unit(benchmark::kMicrosecond);
+
+} // namespace
@@ -0,0 +1,84 @@
+#include "benchmark_common.h"
+
+#include <string>
+
+namespace {
+
+// state.range(0) object-like macros, each of them defined, tested with #ifdef, read in an
+// #if expression and #undef'd again, around a shader that only uses a few of them
+std::string DefineHeavyShader(int defineCount)
+{
+    std::string source;
+    for (int i = 0; i < defineCount; ++i) {
+        source += "#define KEYWORD_" + std::to_string(i) + " " + std::to_string(i % 7) + "\n";
+    }
+    for (int i = 0; i < defineCount; ++i) {
+        const std::string name = "KEYWORD_" + std::to_string(i);
+        source += "#ifdef " + name + "\n#if " + name + " > 3 && __LINE__ > 0\n#endif\n#endif\n";
+    }
+    source += "float4 main () : COLOR0\n{\n\treturn float4 (KEYWORD_1, KEYWORD_2, KEYWORD_3, __LINE__);\n}\n";
+    for (int i = 0; i < defineCount; i += 2) {
+        source += "#undef KEYWORD_" + std::to_string(i) + "\n";
+    }
+    return source;
+}
+
+void BM_PreprocessDefines(benchmark::State& state)
+{
+    BenchmarkLibrary library;
+    const int defineCount = static_cast<int>(state.range(0));
+    const std::string source = DefineHeavyShader(defineCount);
+
+    for (auto _ : state) {
+        ShHandle parser = Hlsl2Glsl_ConstructCompiler(EShLangFragment);
+        if (!Hlsl2Glsl_Parse(parser, source.c_str(), ETargetGLSL_110, nullptr, 0)) {
+            state.SkipWithError(Hlsl2Glsl_GetInfoLog(parser));
+        }
+        Hlsl2Glsl_DestructCompiler(parser);
+    }
+    state.SetItemsProcessed(state.iterations() * defineCount);
+}
+
+BENCHMARK(BM_PreprocessDefines)->ArgName("defines")->Arg(64)->Arg(1024)->Arg(16384)->Unit(benchmark::kMicrosecond);
+
+// state.range(0) calls of function-like macros, like the sampling helpers of FXAA, with the
+// arguments of most calls repeating earlier ones
+std::string MacroCallShader(int callCount)
+{
+    std::string source =
+        "#define TexTop(t, p) tex2D (t, p.xy)\n"
+        "#define TexOff(t, p, o, r) tex2D (t, p.xy + (o * r))\n"
+        "#define Luma(rgba) dot (rgba.xyz, float3 (0.299, 0.587, 0.114))\n"
+        "#define Lerp3(a, b, c, w) lerp (lerp (a, b, w), c, w)\n"
+        "sampler2D tex;\nfloat2 rcpFrame;\n"
+        "float4 main (float2 pos : TEXCOORD0) : COLOR0\n{\n\tfloat l = 0.0;\n";
+    for (int i = 0; i < callCount; ++i) {
+        const std::string x = std::to_string(i % 3 - 1);
+        const std::string y = std::to_string(i % 5 - 2);
+        source += "\tl += Luma (TexOff (tex, pos, float2 (" + x + ", " + y + "), rcpFrame)) + "
+                  "Luma (TexTop (tex, pos)) * Lerp3 (0.25, 0.5, 0.75, l);\n";
+    }
+    source += "\treturn float4 (l, l, l, 1.0);\n}\n";
+    return source;
+}
+
+void BM_PreprocessMacroCalls(benchmark::State& state)
+{
+    BenchmarkLibrary library;
+    const int callCount = static_cast<int>(state.range(0));
+    const std::string source = MacroCallShader(callCount);
+
+    ShHandle parser = Hlsl2Glsl_ConstructCompiler(EShLangFragment);
+    for (auto _ : state) {
+        if (!Hlsl2Glsl_Preprocess(parser, source.c_str(), nullptr, nullptr, 0)) {
+            state.SkipWithError(Hlsl2Glsl_GetInfoLog(parser));
+            break;
+        }
+    }
+    Hlsl2Glsl_DestructCompiler(parser);
+    state.SetItemsProcessed(state.iterations() * callCount * 4);
+}
+
+BENCHMARK(BM_PreprocessMacroCalls)->ArgName("calls")->Arg(256)->Arg(4096)->Unit(benchmark::kMicrosecond);
+
+} // namespace
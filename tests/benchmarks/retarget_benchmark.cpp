@@ -0,0 +1,59 @@
+#include "benchmark_common.h"
+
+namespace {
+
+constexpr const char* kPlainShaderSrc = R"""(
+sampler2D diffuseMap;
+float4 lightDir;
+float4 lightColor;
+
+float4 main (float2 uv : TEXCOORD0, float3 normal : TEXCOORD1) : COLOR0
+{
+	float4 albedo = tex2D (diffuseMap, uv);
+	float diff = saturate (dot (normalize (normal), lightDir.xyz));
+	return albedo * lightColor * diff;
+}
+)""";
+
+// The matrix cast parses differently before GLSL 1.20, so this one needs two parses
+constexpr const char* kMatrixShaderSrc = R"""(
+sampler2D diffuseMap;
+float4x4 normalMatrix;
+float4 lightDir;
+float4 lightColor;
+
+float4 main (float2 uv : TEXCOORD0, float3 normal : TEXCOORD1) : COLOR0
+{
+	float4 albedo = tex2D (diffuseMap, uv);
+	float3 n = mul ((float3x3)normalMatrix, normal);
+	float diff = saturate (dot (normalize (n), lightDir.xyz));
+	return albedo * lightColor * diff;
+}
+)""";
+
+constexpr ETargetVersion kTargets[] = { ETargetGLSL_ES_100, ETargetGLSL_120, ETargetGLSL_ES_300 };
+
+// Emit one shader for every shipped target, parsing per target or translating one handle repeatedly
+void BM_CompileTargets(benchmark::State& state)
+{
+    BenchmarkLibrary library;
+    const char* src = state.range(0) ? kMatrixShaderSrc : kPlainShaderSrc;
+    const bool retarget = state.range(1) != 0;
+
+    for (auto _ : state) {
+        ShHandle compiler = Hlsl2Glsl_ConstructCompiler(EShLangFragment);
+        for (ETargetVersion version : kTargets) {
+            bool ok = (retarget && version != kTargets[0]) ||
+                Hlsl2Glsl_Parse(compiler, src, version, nullptr, 0);
+            ok = ok && Hlsl2Glsl_Translate(compiler, "main", version, 0);
+            if (!ok) {
+                state.SkipWithError(Hlsl2Glsl_GetInfoLog(compiler));
+            }
+        }
+        Hlsl2Glsl_DestructCompiler(compiler);
+    }
+}
+
+BENCHMARK(BM_CompileTargets)->ArgNames({ "matrix", "retarget" })->ArgsProduct({ { 0, 1 }, { 0, 1 } })->Unit(benchmark::kMicrosecond);
+
+} // namespace
@@ -0,0 +1,41 @@
+#include "benchmark_common.h"
+
+namespace {
+
+// Fragment shader with `count` generic samplers. Each one is only typed by a texture lookup inside
+// its own helper function, so the type has to travel back from the parameter to the call site.
+std::string MakeGenericSamplerShader(int count)
+{
+    std::string src;
+    for (int i = 0; i < count; ++i) {
+        const std::string n = std::to_string(i);
+        src += "sampler tex" + n + ";\n";
+        src += "float4 fetch" + n + " (sampler s, float2 uv) { return tex2D (s, uv); }\n";
+    }
+    src += "float4 main (float2 uv : TEXCOORD0) : COLOR0\n{\n\tfloat4 c = 0.0;\n";
+    for (int i = 0; i < count; ++i) {
+        const std::string n = std::to_string(i);
+        src += "\tc += fetch" + n + " (tex" + n + ", uv);\n";
+    }
+    src += "\treturn c;\n}\n";
+    return src;
+}
+
+void BM_GenericSamplerTyping(benchmark::State& state)
+{
+    BenchmarkLibrary library;
+    const std::string src = MakeGenericSamplerShader(static_cast<int>(state.range(0)));
+
+    std::string infoLog;
+    for (auto _ : state) {
+        if (!CompileShader(EShLangFragment, src, infoLog)) {
+            state.SkipWithError(infoLog.c_str());
+            break;
+        }
+    }
+    state.SetComplexityN(state.range(0));
+}
+
+BENCHMARK(BM_GenericSamplerTyping)->RangeMultiplier(2)->Range(8, 512)->Complexity();
+
+} // namespace
@@ -0,0 +1,115 @@
+// Compares the two ways preprocessed tokens reach the parser: written out as text for the
+// flex scanner to match again, or handed over directly with the preprocessor's token type.
+// The shaders in tests/ are preprocessed once up front, so only scanning and parsing, or
+// scanning alone, are timed. Uses library internals, so this is only built against the static library.
+
+#include "benchmark_common.h"
+
+#include "BuiltInSymbols.h"
+#include "ParseHelper.h"
+#include "TypeTable.h"
+
+#include <memory>
+#include <vector>
+
+namespace {
+
+using namespace hlsl2glsl;
+
+struct CorpusShader
+{
+    EShLanguage language;
+    TPreprocessedSource tokens;
+};
+
+std::vector<std::unique_ptr<CorpusShader>> LoadCorpus()
+{
+    std::vector<std::unique_ptr<CorpusShader>> corpus;
+    for (const CorpusFile& file : ListCorpus()) {
+        // Shaders that need #include callbacks are left out
+        auto shader = std::make_unique<CorpusShader>();
+        shader->language = file.language;
+        if (PaPreprocessString(file.source.c_str(), nullptr, nullptr, nullptr, 0, shader->tokens)) {
+            corpus.push_back(std::move(shader));
+        }
+    }
+    return corpus;
+}
+
+// Parse every shader in the corpus, or only scan it, state.range(0) tells whether through the
+// flex scanner
+void RunCorpus(benchmark::State& state, bool scanOnly)
+{
+    BenchmarkLibrary library;
+    const bool flexScanner = state.range(0) != 0;
+    const std::vector<std::unique_ptr<CorpusShader>> corpus = LoadCorpus();
+
+    size_t tokenCount = 0;
+    for (const auto& shader : corpus) {
+        tokenCount += shader->tokens.tokens.size();
+    }
+
+    GlobalPoolAllocator.push();
+    {
+        TInfoSink builtInSink;
+        TSymbolTable symbolTables[EShLangCount];
+        if (!ParseBuiltInSymbolTables(symbolTables, builtInSink)) {
+            state.SkipWithError(builtInSink.info.c_str());
+        }
+        for (TSymbolTable& symbolTable : symbolTables) {
+            symbolTable.freezeBuiltIns();
+        }
+
+        for (auto _ : state) {
+            for (const auto& shader : corpus) {
+                GlobalPoolAllocator.push();
+                {
+                    // Chained to the frozen built-ins, like a compile's table, so the
+                    // atoms of the shader go away with it
+                    TSymbolTable symbolTable(symbolTables[shader->language]);
+                    symbolTable.push();
+                    symbolTable.push();
+
+                    TTypeTable types;
+                    SetGlobalTypeTable(&types);
+
+                    TInfoSink infoSink;
+                    TParseContext parseContext(symbolTable, shader->language, ETargetGLSL_110, 0, infoSink);
+                    parseContext.flexScanner = flexScanner;
+                    GlobalParseContext = &parseContext;
+                    if (scanOnly) {
+                        benchmark::DoNotOptimize(PaScanPreprocessed(shader->tokens, parseContext));
+                    } else {
+                        PaParsePreprocessed(shader->tokens, parseContext);
+                        benchmark::DoNotOptimize(parseContext.treeRoot);
+                    }
+                    GlobalParseContext = nullptr;
+                    SetGlobalTypeTable(nullptr);
+                }
+                GlobalPoolAllocator.pop();
+            }
+        }
+    }
+    GlobalPoolAllocator.pop();
+
+    state.SetItemsProcessed(state.iterations() * tokenCount);
+    state.counters["shaders"] = static_cast<double>(corpus.size());
+    state.counters["tokens"] = static_cast<double>(tokenCount);
+}
+
+void BM_ParseCorpusTokens(benchmark::State& state)
+{
+    RunCorpus(state, false);
+}
+
+BENCHMARK(BM_ParseCorpusTokens)->ArgName("flex")->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+
+// Scanner throughput alone: keywords, type names and identifiers make up most of the tokens
+void BM_ScanCorpusTokens(benchmark::State& state)
+{
+    RunCorpus(state, true);
+}
+
+BENCHMARK(BM_ScanCorpusTokens)->ArgName("flex")->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+
+} // namespace
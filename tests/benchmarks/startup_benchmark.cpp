@@ -0,0 +1,61 @@
+// Compares the two ways of setting up the built-in symbol tables at startup: parsing the
+// built-in prototypes, and loading the tables generated at build time. Uses library
+// internals, so this is only built against the static library.
+
+#include "benchmark_common.h"
+
+#include "BuiltInSymbols.h"
+
+namespace {
+
+using namespace hlsl2glsl;
+
+void BM_InitializeShutdown(benchmark::State& state)
+{
+    for (auto _ : state) {
+        BenchmarkLibrary library;
+    }
+}
+
+void BM_BuiltInSymbolsParse(benchmark::State& state)
+{
+    BenchmarkLibrary library;
+
+    for (auto _ : state) {
+        GlobalPoolAllocator.push();
+        {
+            TInfoSink infoSink;
+            TSymbolTable symbolTables[EShLangCount];
+            if (!ParseBuiltInSymbolTables(symbolTables, infoSink)) {
+                state.SkipWithError(infoSink.info.c_str());
+            }
+        }
+        GlobalPoolAllocator.pop();
+    }
+}
+
+void BM_BuiltInSymbolsLoad(benchmark::State& state)
+{
+    BenchmarkLibrary library;
+    if (!PrebuiltBuiltInSymbols) {
+        state.SkipWithError("built without HLSL2GLSL_PREBUILT_BUILTINS");
+        return;
+    }
+
+    for (auto _ : state) {
+        GlobalPoolAllocator.push();
+        {
+            TSymbolTable symbolTables[EShLangCount];
+            for (int i = 0; i < EShLangCount; ++i) {
+                LoadBuiltInSymbolTable(PrebuiltBuiltInSymbols[i], symbolTables[i]);
+            }
+        }
+        GlobalPoolAllocator.pop();
+    }
+}
+
+BENCHMARK(BM_InitializeShutdown)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_BuiltInSymbolsParse)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_BuiltInSymbolsLoad)->Unit(benchmark::kMicrosecond);
+
+} // namespace
@@ -0,0 +1,49 @@
+// Parses shaders that are mostly name lookups: many globals, read from deeply nested
+// blocks that each declare a few locals of their own.
+
+#include "benchmark_common.h"
+
+#include <string>
+
+namespace {
+
+// state.range(0) blocks of a few statements, each block opening a scope with two locals
+// and a nested one, reading globals from a pool of state.range(1)
+std::string LookupHeavyShader(int blockCount, int globalCount)
+{
+    std::string source;
+    for (int i = 0; i < globalCount; ++i) {
+        source += "float g" + std::to_string(i) + ";\n";
+    }
+    source += "float4 main (float2 uv : TEXCOORD0) : COLOR0\n{\n\tfloat acc = uv.x;\n";
+    for (int i = 0; i < blockCount; ++i) {
+        const std::string g0 = "g" + std::to_string(i % globalCount);
+        const std::string g1 = "g" + std::to_string((i * 7 + 3) % globalCount);
+        const std::string g2 = "g" + std::to_string((i * 13 + 5) % globalCount);
+        source += "\t{\n\t\tfloat a = " + g0 + " + acc;\n\t\tfloat b = a * " + g1 + ";\n";
+        source += "\t\tif (a > " + g2 + ") {\n\t\t\tfloat c = b - " + g0 + ";\n\t\t\tacc += c * a + " + g1 + ";\n\t\t}\n";
+        source += "\t\tacc += a + b;\n\t}\n";
+    }
+    source += "\treturn float4 (acc, acc, acc, 1.0);\n}\n";
+    return source;
+}
+
+void BM_ParseLookupHeavy(benchmark::State& state)
+{
+    BenchmarkLibrary library;
+    const int blockCount = static_cast<int>(state.range(0));
+    const std::string source = LookupHeavyShader(blockCount, static_cast<int>(state.range(1)));
+
+    for (auto _ : state) {
+        ShHandle parser = Hlsl2Glsl_ConstructCompiler(EShLangFragment);
+        if (!Hlsl2Glsl_Parse(parser, source.c_str(), ETargetGLSL_110, nullptr, 0)) {
+            state.SkipWithError(Hlsl2Glsl_GetInfoLog(parser));
+        }
+        Hlsl2Glsl_DestructCompiler(parser);
+    }
+    state.SetItemsProcessed(state.iterations() * blockCount);
+}
+
+BENCHMARK(BM_ParseLookupHeavy)->ArgNames({"blocks", "globals"})->Args({64, 16})->Args({256, 128})->Unit(benchmark::kMicrosecond);
+
+} // namespace
@@ -0,0 +1,125 @@
+#include "benchmark_common.h"
+
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr const char* kShaderSrc = R"""(
+#include "lighting.h"
+
+sampler2D diffuseMap;
+sampler2D normalMap;
+float4 lightColor;
+
+float4 main (float2 uv : TEXCOORD0, float3 viewDir : TEXCOORD1) : COLOR0
+{
+	float4 albedo = tex2D (diffuseMap, uv);
+#ifdef NORMALMAP
+	float3 n = normalize (UnpackNormal (tex2D (normalMap, uv)));
+#else
+	float3 n = float3 (0.0, 0.0, 1.0);
+#endif
+	float4 c = albedo * lightColor * Diffuse (n);
+#ifdef SPECULAR
+	c += Specular (n, viewDir);
+#endif
+	return c;
+}
+)""";
+
+constexpr const char* kLightingHeader = R"""(
+float4 lightDir;
+
+float3 UnpackNormal (float4 encoded)
+{
+	return encoded.xyz * 2.0 - 1.0;
+}
+
+float Diffuse (float3 n)
+{
+	return saturate (dot (n, lightDir.xyz));
+}
+
+float Specular (float3 n, float3 viewDir)
+{
+	float3 h = normalize (lightDir.xyz + normalize (viewDir));
+	return pow (saturate (dot (n, h)), 32.0);
+}
+
+#ifdef SHADOWS
+float Shadow (float4 coord) { return coord.z; }
+#endif
+)""";
+
+// FOG is only used by other passes, so half of the variants come out the same
+const char* const kKeywords[] = { "NORMALMAP", "SPECULAR", "SHADOWS", "FOG" };
+constexpr int kVariantCount = 1 << 4;
+
+bool OpenInclude(bool isSystem, const char* fname, const char* parentfname, const char* parent, std::string& output, void* data)
+{
+    output = kLightingHeader;
+    return true;
+}
+
+void CloseInclude(const char* file, void* data)
+{
+}
+
+// Every keyword combination: separate compiles of the source with #defines prepended, or one
+// Hlsl2Glsl_CompileVariants call
+void BM_CompileVariants(benchmark::State& state)
+{
+    BenchmarkLibrary library;
+    const bool variants = state.range(0) != 0;
+    Hlsl2Glsl_ParseCallbacks callbacks { OpenInclude, CloseInclude, nullptr };
+
+    std::vector<std::vector<Hlsl2Glsl_Define>> defineSets(kVariantCount);
+    std::vector<Hlsl2Glsl_Variant> variantList;
+    std::vector<std::string> sources;
+    for (int i = 0; i < kVariantCount; ++i) {
+        std::string source;
+        for (int k = 0; k < 4; ++k) {
+            if (i & (1 << k)) {
+                defineSets[i].push_back(Hlsl2Glsl_Define { kKeywords[k], nullptr });
+                source += std::string("#define ") + kKeywords[k] + "\n";
+            }
+        }
+        variantList.push_back(Hlsl2Glsl_Variant { defineSets[i].data(), static_cast<int>(defineSets[i].size()) });
+        sources.push_back(source + kShaderSrc);
+    }
+
+    std::vector<Hlsl2Glsl_BatchJob> jobs;
+    for (const auto& source : sources) {
+        jobs.push_back(Hlsl2Glsl_BatchJob { source.c_str(), EShLangFragment, "main", ETargetGLSL_110, 0,
+            nullptr, &callbacks, nullptr, nullptr, 0, nullptr, nullptr });
+    }
+    const Hlsl2Glsl_BatchJob variantJob { kShaderSrc, EShLangFragment, "main", ETargetGLSL_110, 0,
+        nullptr, &callbacks, nullptr, nullptr, 0, nullptr, nullptr };
+    std::vector<Hlsl2Glsl_BatchResult> results(kVariantCount);
+    Hlsl2Glsl_VariantStats stats {};
+
+    for (auto _ : state) {
+        const bool ok = variants ?
+            Hlsl2Glsl_CompileVariants(&variantJob, variantList.data(), kVariantCount, results.data(), 1, &stats) != 0 :
+            Hlsl2Glsl_CompileBatch(jobs.data(), kVariantCount, results.data(), 1) != 0;
+        if (!ok) {
+            state.SkipWithError(Hlsl2Glsl_GetInfoLog(results[0].handle));
+        }
+        for (auto& result : results) {
+            Hlsl2Glsl_DestructCompiler(result.handle);
+        }
+        if (!ok) {
+            break;
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * kVariantCount);
+    if (variants) {
+        state.counters["parsed"] = stats.parsed;
+        state.counters["duplicates"] = stats.duplicates;
+    }
+}
+
+BENCHMARK(BM_CompileVariants)->ArgName("variants")->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+
+} // namespace
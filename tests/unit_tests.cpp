@@ -212,4 +212,74 @@ void main() {
 )""");
 }
 
+// NOLINTNEXTLINE
+TEST_F(Hlsl2GlslTest, ManyDefines)
+{
+    // Enough macros to grow the define table a few times, half of them #undef'd again
+    std::string src;
+    for (int i = 0; i < 1000; ++i) {
+        src += "#define K" + std::to_string(i) + " " + std::to_string(i) + "\n";
+    }
+    for (int i = 0; i < 1000; i += 2) {
+        src += "#undef K" + std::to_string(i) + "\n";
+    }
+    src += "#define K0 5\n"
+        "#if defined(K2) || !defined(K3) || K0 != 5 || K999 != 999\n#error wrong defines\n#endif\n"
+        "#if __LINE__ != 1505\n#error wrong line\n#endif\n"
+        "float4 main () : COLOR0 { return K1; }\n";
+
+    auto [success, output] = compileShader(FRAGMENT_SHADER, src);
+    EXPECT_TRUE(success) << output;
+    EXPECT_THAT(output, HasSubstr("return vec4( 1.0)"));
+}
+
+// NOLINTNEXTLINE
+TEST_F(Hlsl2GlslTest, KeywordsAndIdentifiers)
+{
+    // Identifiers that start like keywords, and the shapes of the built-in type names
+    targetVersion = ETargetGLSL_ES_300;
+    auto [success, output] = compileShader(FRAGMENT_SHADER, R"""(
+half2x3 inlined;
+inline float4 main (float3 float4x4Matrix : TEXCOORD0, fixed int5 : TEXCOORD1) : COLOR0
+{
+    uint2 sampler2D_ = uint2 (1, 2);
+    bool3 ifs = bool3 (true, false, true);
+    return float4 (mul (float4x4Matrix.xy, inlined), int5 + sampler2D_.x) * (ifs.x ? 1.0 : 0.0);
+}
+)""");
+    EXPECT_TRUE(success) << output;
+    EXPECT_THAT(output, HasSubstr("uniform mediump mat3x2 inlined;"));
+    EXPECT_THAT(output, HasSubstr("in highp vec3 float4x4Matrix, in lowp float int5"));
+    EXPECT_THAT(output, HasSubstr("ivec2 sampler2D_ = ivec2( 1, 2);"));
+    EXPECT_THAT(output, HasSubstr("bvec3 ifs = bvec3( true, false, true);"));
+
+    auto [reserved, log] = compileShader(FRAGMENT_SHADER, "float4 main () : COLOR0 { float double = 1.0; return double; }\n");
+    EXPECT_FALSE(reserved);
+    EXPECT_THAT(log, HasSubstr("'double' : Reserved word."));
+}
+
+// NOLINTNEXTLINE
+TEST_F(Hlsl2GlslTest, OverloadsDeclaredAfterCalls)
+{
+    // Calls resolved before a better overload is declared, and built-ins resolved by an
+    // earlier compile, have to be looked up again
+    auto [success, output] = compileShader(FRAGMENT_SHADER, R"""(
+float scale (float a) { return a * 2.0; }
+float first (int i) { return scale (i) + saturate (0.5); }
+float scale (int a) { return float (a) * 3.0; }
+float4 main () : COLOR0 { return float4 (first (1), scale (2), 0.0, 1.0); }
+)""");
+    EXPECT_TRUE(success) << output;
+    EXPECT_THAT(output, HasSubstr("return (scale( float(i)) + xll_saturate_f(0.5));"));
+    EXPECT_THAT(output, HasSubstr("return vec4( first( 1), scale( 2), 0.0, 1.0);"));
+
+    std::tie(success, output) = compileShader(FRAGMENT_SHADER, R"""(
+float saturate (float a) { return a; }
+float4 main () : COLOR0 { return saturate (0.5); }
+)""");
+    EXPECT_TRUE(success) << output;
+    EXPECT_THAT(output, HasSubstr("return vec4( saturate( 0.5));"));
+    EXPECT_THAT(output, Not(HasSubstr("xll_saturate_f")));
+}
+
 } // namespace
\ No newline at end of file
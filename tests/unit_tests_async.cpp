@@ -2,6 +2,7 @@
 
 #include <thread>
 #include <future>
+#include <vector>
 
 using namespace ::testing;
 
@@ -35,10 +36,8 @@ fixed4 main (float4 uv : TEXCOORD0) : COLOR0
 
 using CompilerResult = std::pair<bool, std::string>;
 
-CompilerResult CompileShader(EShLanguage type, ETargetVersion targetVersion, const std::string& shaderSrc)
+ShUserPrefixTable MakePrefixTable()
 {
-    unsigned options = 0;
-
     ShUserPrefixTable prefixTable {};
     prefixTable.prefixAttrib = "at_attrib_";
     prefixTable.prefixLinker = "l_";
@@ -50,15 +49,23 @@ CompilerResult CompileShader(EShLanguage type, ETargetVersion targetVersion, con
     prefixTable.identMutable = "at_mutable";
     prefixTable.identRetval = "at_retval";
     prefixTable.identSwizTemp = "at_swiz_temp";
+    return prefixTable;
+}
 
-    static EAttribSemantic userAttribSemantics[] = {
-        EAttrSemPosition,
-        EAttrSemNormal,
-    };
-    static const char* userAttribNames[] = {
-        "a_position",
-        "a_normal",
-    };
+EAttribSemantic userAttribSemantics[] = {
+    EAttrSemPosition,
+    EAttrSemNormal,
+};
+const char* userAttribNames[] = {
+    "a_position",
+    "a_normal",
+};
+
+CompilerResult CompileShader(EShLanguage type, ETargetVersion targetVersion, const std::string& shaderSrc)
+{
+    unsigned options = 0;
+
+    ShUserPrefixTable prefixTable = MakePrefixTable();
 
     std::unique_ptr<hlsl2glsl::HlslCrossCompiler, decltype(&Hlsl2Glsl_DestructCompiler)> parser(
         Hlsl2Glsl_ConstructCompilerUserPrefix(type, &prefixTable), &Hlsl2Glsl_DestructCompiler);
@@ -352,4 +359,70 @@ INSTANTIATE_TEST_SUITE_P(AsyncJobs,
                              testing::Values(false)
                          ));
 
+class Hlsl2GlslBatchTest : public TestWithParam<int>
+{
+public:
+    void SetUp() override
+    {
+        if (!Hlsl2Glsl_Initialize()) {
+            throw std::runtime_error { "failed to initialize HLSL2GLSL" };
+        }
+    }
+
+    void TearDown() override
+    {
+        Hlsl2Glsl_Shutdown();
+    }
+};
+
+// NOLINTNEXTLINE
+TEST_P(Hlsl2GlslBatchTest, ResultsMatchSingleCompiles)
+{
+    constexpr const char* kInvalidShaderSrc = "float4 main () : COLOR0 { return undefined; }";
+
+    const ShUserPrefixTable prefixTable = MakePrefixTable();
+    const struct {
+        EShLanguage type;
+        ETargetVersion version;
+        const char* src;
+    } kShaders[] = {
+        { VERTEX_SHADER, ETargetGLSL_ES_100, kVertexShaderSrc },
+        { FRAGMENT_SHADER, ETargetGLSL_ES_100, kFragmentShaderSrc },
+        { VERTEX_SHADER, ETargetGLSL_ES_300, kVertexShaderSrc },
+        { FRAGMENT_SHADER, ETargetGLSL_ES_300, kFragmentShaderSrc },
+        { FRAGMENT_SHADER, ETargetGLSL_110, kInvalidShaderSrc },
+    };
+    constexpr size_t kShaderCount = std::size(kShaders);
+
+    std::vector<CompilerResult> expected;
+    for (const auto& shader : kShaders) {
+        expected.push_back(CompileShader(shader.type, shader.version, shader.src));
+    }
+
+    std::vector<Hlsl2Glsl_BatchJob> jobs(97);
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        const auto& shader = kShaders[i % kShaderCount];
+        jobs[i] = Hlsl2Glsl_BatchJob { shader.src, shader.type, "main", shader.version, 0, &prefixTable, nullptr,
+            userAttribSemantics, userAttribNames, static_cast<int>(std::size(userAttribSemantics)), nullptr, nullptr };
+    }
+
+    std::vector<Hlsl2Glsl_BatchResult> results(jobs.size());
+    EXPECT_EQ(0, Hlsl2Glsl_CompileBatch(jobs.data(), static_cast<int>(jobs.size()), results.data(), GetParam()));
+
+    for (size_t i = 0; i < results.size(); ++i) {
+        ShHandle handle = results[i].handle;
+        ASSERT_NE(nullptr, handle);
+        const CompilerResult& want = expected[i % kShaderCount];
+        EXPECT_EQ(want.first, results[i].success != 0) << "job " << i;
+        EXPECT_EQ(want.second, want.first ? GetCompiledShaderText(handle) : std::string(Hlsl2Glsl_GetInfoLog(handle)))
+            << "job " << i;
+        Hlsl2Glsl_DestructCompiler(handle);
+    }
+}
+
+// NOLINTNEXTLINE
+INSTANTIATE_TEST_SUITE_P(BatchThreads,
+                         Hlsl2GlslBatchTest,
+                         testing::Values(0, 1, 2, 4, 16));
+
 } // namespace
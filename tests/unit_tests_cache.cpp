@@ -0,0 +1,295 @@
+#include "unit_tests_common.h"
+
+#include <filesystem>
+#include <map>
+#include <vector>
+
+using namespace ::testing;
+
+namespace {
+
+constexpr const char* kShaderSrc = R"""(
+#include "lighting.h"
+
+float4x4 matrix_mvp : register(c0);
+float4 tint[2];
+
+void main (float4 vertex : POSITION, out float4 overtex : POSITION, out float4 ocolor : COLOR0)
+{
+    overtex = mul (matrix_mvp, vertex);
+    ocolor = Light (tint[0], tint[1]);
+}
+)""";
+
+struct CacheState
+{
+    std::map<std::string, std::string> entries;
+    int loads = 0;
+    int saves = 0;
+};
+
+bool LoadEntry(const char* key, std::string& value, void* data)
+{
+    auto* state = static_cast<CacheState*>(data);
+    ++state->loads;
+    auto it = state->entries.find(key);
+    if (it == state->entries.end())
+        return false;
+    value = it->second;
+    return true;
+}
+
+void SaveEntry(const char* key, const std::string& value, void* data)
+{
+    auto* state = static_cast<CacheState*>(data);
+    ++state->saves;
+    state->entries[key] = value;
+}
+
+class Hlsl2GlslCacheTest : public IncludeFilesTest
+{
+public:
+    Hlsl2GlslCacheTest()
+    {
+        files.files["lighting.h"] = "float4 Light (float4 a, float4 b) { return a * b; }\n";
+    }
+
+    CompileOutput compile(ShCacheHandle cache, const char* src = kShaderSrc, ETargetVersion version = ETargetGLSL_110,
+        unsigned options = 0, const ShUserPrefixTable* prefixTable = nullptr, const char* positionName = nullptr)
+    {
+        ShHandle compiler = Hlsl2Glsl_ConstructCompilerUserPrefix(EShLangVertex, prefixTable);
+        if (positionName) {
+            const EAttribSemantic semantic = EAttrSemPosition;
+            Hlsl2Glsl_SetUserAttributeNames(compiler, &semantic, &positionName, 1);
+        }
+        CompileOutput output;
+        output.success = Hlsl2Glsl_CompileCached(compiler, cache, src, "main", version, &callbacks, options) != 0;
+        output.text = GetCompiledShaderText(compiler);
+        output.infoLog = Hlsl2Glsl_GetInfoLog(compiler);
+        Hlsl2Glsl_DestructCompiler(compiler);
+        return output;
+    }
+
+    // Whether the compile of kShaderSrc came from cache, as told by a variant compile of it,
+    // which looks it up the same way Hlsl2Glsl_CompileCached does
+    bool isCached(ShCacheHandle cache, std::string& text)
+    {
+        const Hlsl2Glsl_BatchJob job { kShaderSrc, EShLangVertex, "main", ETargetGLSL_110, 0,
+            nullptr, &callbacks, nullptr, nullptr, 0, cache, nullptr };
+        const Hlsl2Glsl_Variant variant { nullptr, 0 };
+        Hlsl2Glsl_BatchResult result {};
+        Hlsl2Glsl_VariantStats stats {};
+        EXPECT_EQ(1, Hlsl2Glsl_CompileVariants(&job, &variant, 1, &result, 1, &stats));
+        text = GetCompiledShaderText(result.handle);
+        Hlsl2Glsl_DestructCompiler(result.handle);
+        return stats.cached == 1;
+    }
+};
+
+// NOLINTNEXTLINE
+TEST_F(Hlsl2GlslCacheTest, HitReturnsStoredResult)
+{
+    CacheState state;
+    Hlsl2Glsl_CacheCallbacks cacheCallbacks { LoadEntry, SaveEntry, &state };
+    ShCacheHandle cache = Hlsl2Glsl_ConstructCallbackCache(&cacheCallbacks);
+
+    CompileOutput uncached = compile(nullptr);
+    ASSERT_TRUE(uncached.success) << uncached.infoLog;
+    EXPECT_THAT(uncached.text, HasSubstr("// matrix_mvp:<none> type 21 arrsize 0 register c0"));
+
+    files.opens = 0;
+    CompileOutput miss = compile(cache);
+    EXPECT_EQ(1, state.saves);
+    EXPECT_EQ(1, files.opens); // once for both the key and the parse
+
+    files.opens = 0;
+    CompileOutput hit = compile(cache);
+    EXPECT_EQ(1, state.saves);
+    EXPECT_EQ(2, state.loads);
+    EXPECT_EQ(1, files.opens); // for the key
+
+    for (const CompileOutput* output : { &miss, &hit }) {
+        EXPECT_EQ(uncached.success, output->success);
+        EXPECT_EQ(uncached.text, output->text);
+        EXPECT_EQ(uncached.infoLog, output->infoLog);
+    }
+
+    Hlsl2Glsl_DestructCache(cache);
+}
+
+// NOLINTNEXTLINE
+TEST_F(Hlsl2GlslCacheTest, FailuresAreCached)
+{
+    CacheState state;
+    Hlsl2Glsl_CacheCallbacks cacheCallbacks { LoadEntry, SaveEntry, &state };
+    ShCacheHandle cache = Hlsl2Glsl_ConstructCallbackCache(&cacheCallbacks);
+
+    files.files["lighting.h"] = "float4 Light (float4 a, float4 b) { return undefined; }\n";
+    CompileOutput miss = compile(cache);
+    CompileOutput hit = compile(cache);
+    EXPECT_FALSE(miss.success);
+    EXPECT_FALSE(hit.success);
+    EXPECT_THAT(miss.infoLog, HasSubstr("undefined"));
+    EXPECT_EQ(miss.infoLog, hit.infoLog);
+    EXPECT_EQ(1, state.saves);
+
+    Hlsl2Glsl_DestructCache(cache);
+}
+
+// NOLINTNEXTLINE
+TEST_F(Hlsl2GlslCacheTest, HitThenRetarget)
+{
+    ShCacheHandle cache = Hlsl2Glsl_ConstructMemoryCache(0);
+    compile(cache);
+    const CompileOutput expected = compile(nullptr, kShaderSrc, ETargetGLSL_120);
+    ASSERT_TRUE(expected.success) << expected.infoLog;
+
+    // A hit on a handle that parsed another shader before
+    ShHandle compiler = Hlsl2Glsl_ConstructCompiler(EShLangVertex);
+    ASSERT_TRUE(Hlsl2Glsl_Parse(compiler, "float4 main (float4 v : POSITION) : POSITION { return v * 2.0; }\n", ETargetGLSL_110, nullptr, 0));
+    files.opens = 0;
+    ASSERT_TRUE(Hlsl2Glsl_CompileCached(compiler, cache, kShaderSrc, "main", ETargetGLSL_110, &callbacks, 0));
+    EXPECT_EQ(1, files.opens);
+
+    // Parses the hit's shader, from its tokens
+    EXPECT_TRUE(Hlsl2Glsl_Translate(compiler, "main", ETargetGLSL_120, 0));
+    EXPECT_EQ(1, files.opens);
+    EXPECT_EQ(expected.text, GetCompiledShaderText(compiler));
+    EXPECT_EQ(expected.infoLog, Hlsl2Glsl_GetInfoLog(compiler));
+    Hlsl2Glsl_DestructCompiler(compiler);
+
+    // A failure from the cache has nothing to translate
+    files.files["lighting.h"] = "float4 Light (float4 a, float4 b) { return undefined; }\n";
+    compile(cache);
+    compiler = Hlsl2Glsl_ConstructCompiler(EShLangVertex);
+    ASSERT_TRUE(Hlsl2Glsl_Parse(compiler, "float4 main (float4 v : POSITION) : POSITION { return v * 2.0; }\n", ETargetGLSL_110, nullptr, 0));
+    EXPECT_FALSE(Hlsl2Glsl_CompileCached(compiler, cache, kShaderSrc, "main", ETargetGLSL_110, &callbacks, 0));
+    EXPECT_FALSE(Hlsl2Glsl_Translate(compiler, "main", ETargetGLSL_120, 0));
+    EXPECT_THAT(Hlsl2Glsl_GetInfoLog(compiler), HasSubstr("does not have valid object code"));
+    Hlsl2Glsl_DestructCompiler(compiler);
+
+    Hlsl2Glsl_DestructCache(cache);
+}
+
+// NOLINTNEXTLINE
+TEST_F(Hlsl2GlslCacheTest, HitRecordsDependencies)
+{
+    ShCacheHandle cache = Hlsl2Glsl_ConstructMemoryCache(0);
+
+    for (const char* pass : { "miss", "hit" }) {
+        files.opens = 0;
+        ShHandle compiler = Hlsl2Glsl_ConstructCompiler(EShLangVertex);
+        ASSERT_TRUE(Hlsl2Glsl_CompileCached(compiler, cache, kShaderSrc, "main", ETargetGLSL_110, &callbacks, ETranslateOpRecordDependencies)) << pass;
+        int count = 0;
+        const Hlsl2Glsl_Dependency* dependencies = Hlsl2Glsl_GetDependencies(compiler, &count);
+        ASSERT_EQ(1, count) << pass;
+        EXPECT_STREQ("lighting.h", dependencies[0].path) << pass;
+        EXPECT_EQ(1, dependencies[0].found) << pass;
+
+        // Not left over from the last compile on the handle when not asked for
+        ASSERT_TRUE(Hlsl2Glsl_CompileCached(compiler, cache, kShaderSrc, "main", ETargetGLSL_120, &callbacks, 0)) << pass;
+        EXPECT_EQ(nullptr, Hlsl2Glsl_GetDependencies(compiler, &count)) << pass;
+        Hlsl2Glsl_DestructCompiler(compiler);
+    }
+
+    Hlsl2Glsl_DestructCache(cache);
+}
+
+// NOLINTNEXTLINE
+TEST_F(Hlsl2GlslCacheTest, KeyCoversAllInputs)
+{
+    CacheState state;
+    Hlsl2Glsl_CacheCallbacks cacheCallbacks { LoadEntry, SaveEntry, &state };
+    ShCacheHandle cache = Hlsl2Glsl_ConstructCallbackCache(&cacheCallbacks);
+
+    ShUserPrefixTable prefixTable {};
+    prefixTable.prefixUniform = "u_";
+
+    compile(cache);
+    compile(cache, kShaderSrc, ETargetGLSL_120);
+    compile(cache, kShaderSrc, ETargetGLSL_110, ETranslateOpAvoidBuiltinAttribNames);
+    compile(cache, kShaderSrc, ETargetGLSL_110, 0, &prefixTable);
+    compile(cache, kShaderSrc, ETargetGLSL_110, 0, nullptr, "a_position");
+    files.files["lighting.h"] = "float4 Light (float4 a, float4 b) { return a + b; }\n";
+    compile(cache);
+    // Same tokens on other lines end up in different #line directives
+    files.files["lighting.h"] = "\nfloat4 Light (float4 a, float4 b) { return a + b; }\n";
+    compile(cache);
+    EXPECT_EQ(7, state.saves);
+    EXPECT_EQ(7u, state.entries.size());
+
+    // Comments and whitespace don't make it past the preprocessor
+    files.files["lighting.h"] = "\nfloat4 Light (float4 a,float4 b) { return a + b; } // sum\n";
+    compile(cache);
+    EXPECT_EQ(7, state.saves);
+
+    Hlsl2Glsl_DestructCache(cache);
+}
+
+// NOLINTNEXTLINE
+TEST_F(Hlsl2GlslCacheTest, MemoryCache)
+{
+    ShCacheHandle cache = Hlsl2Glsl_ConstructMemoryCache(0);
+
+    CompileOutput miss = compile(cache);
+    files.opens = 0;
+    CompileOutput hit = compile(cache);
+    EXPECT_EQ(1, files.opens);
+    EXPECT_EQ(miss.text, hit.text);
+    EXPECT_EQ(miss.infoLog, hit.infoLog);
+    std::string text;
+    EXPECT_TRUE(isCached(cache, text));
+    EXPECT_EQ(miss.text, text);
+
+    Hlsl2Glsl_DestructCache(cache);
+
+    // Too small to hold anything
+    cache = Hlsl2Glsl_ConstructMemoryCache(1);
+    compile(cache);
+    EXPECT_FALSE(isCached(cache, text));
+    EXPECT_EQ(miss.text, text);
+    Hlsl2Glsl_DestructCache(cache);
+}
+
+// NOLINTNEXTLINE
+TEST_F(Hlsl2GlslCacheTest, DirectoryCache)
+{
+    const std::filesystem::path directory = std::filesystem::temp_directory_path() /
+        ("hlsl2glsl-cache-test-" + std::to_string(::testing::UnitTest::GetInstance()->random_seed()));
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+
+    // Every cache instance stands for another build sharing the directory
+    ShCacheHandle cache = Hlsl2Glsl_ConstructDirectoryCache(directory.string().c_str());
+    CompileOutput miss = compile(cache);
+    Hlsl2Glsl_DestructCache(cache);
+
+    cache = Hlsl2Glsl_ConstructDirectoryCache(directory.string().c_str());
+    files.opens = 0;
+    CompileOutput hit = compile(cache);
+    Hlsl2Glsl_DestructCache(cache);
+
+    EXPECT_EQ(1, files.opens);
+    EXPECT_EQ(miss.text, hit.text);
+    EXPECT_EQ(miss.infoLog, hit.infoLog);
+
+    // Only the finished entry is left, named by its 64 digit key
+    std::vector<std::string> entries;
+    for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+        entries.push_back(entry.path().filename().string());
+    }
+    ASSERT_EQ(1u, entries.size());
+    EXPECT_EQ(64u, entries[0].size());
+
+    // Damaged entries are misses, and get replaced
+    std::filesystem::resize_file(directory / entries[0], 10);
+    cache = Hlsl2Glsl_ConstructDirectoryCache(directory.string().c_str());
+    CompileOutput repaired = compile(cache);
+    Hlsl2Glsl_DestructCache(cache);
+    EXPECT_EQ(miss.text, repaired.text);
+    EXPECT_GT(std::filesystem::file_size(directory / entries[0]), 10u);
+
+    std::filesystem::remove_all(directory);
+}
+
+} // namespace
@@ -11,6 +11,10 @@
 #include <stdexcept>
 #include <optional>
 #include <array>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <string>
 
 #define VERTEX_SHADER EShLangVertex
 #define FRAGMENT_SHADER EShLangFragment
@@ -76,3 +80,72 @@ inline std::string GetCompiledShaderText(ShHandle parser)
 
     return txt;
 }
+
+// #include files for the parse callbacks, by path from the directory of the shader
+struct IncludeFiles
+{
+    std::mutex mutex;
+    std::map<std::string, std::string> files;
+    std::map<std::string, int> opensByPath;
+    std::atomic<int> opens { 0 };
+    std::atomic<int> closes { 0 };
+};
+
+// Opens local files relative to the including one and system files by name, counting the opens and closes
+inline bool OpenIncludeFile(bool isSystem, const char* fname, const char* parentfname, const char* parent, std::string& output, void* data)
+{
+    auto* files = static_cast<IncludeFiles*>(data);
+    const std::string parentName = (parentfname && !isSystem) ? parentfname : "";
+    const std::string path = parentName.substr(0, parentName.rfind('/') + 1) + fname;
+    std::lock_guard<std::mutex> lock(files->mutex);
+    ++files->opens;
+    auto it = files->files.find(path);
+    if (it == files->files.end())
+        return false;
+    ++files->opensByPath[path];
+    output = it->second;
+    return true;
+}
+
+inline void CloseIncludeFile(const char* file, void* data)
+{
+    ++static_cast<IncludeFiles*>(data)->closes;
+}
+
+// Initializes the library around each test, and gives the shaders of the test IncludeFiles
+class IncludeFilesTest : public ::testing::Test
+{
+public:
+    IncludeFiles files;
+    Hlsl2Glsl_ParseCallbacks callbacks { OpenIncludeFile, CloseIncludeFile, &files };
+
+    void SetUp() override
+    {
+        if (!Hlsl2Glsl_Initialize()) {
+            throw std::runtime_error { "failed to initialize HLSL2GLSL" };
+        }
+    }
+
+    void TearDown() override
+    {
+        Hlsl2Glsl_Shutdown();
+    }
+};
+
+// What a compile, or a translate, left on its handle
+struct CompileOutput
+{
+    bool success;
+    std::string text;
+    std::string infoLog;
+
+    bool operator==(const CompileOutput& other) const
+    {
+        return success == other.success && text == other.text && infoLog == other.infoLog;
+    }
+};
+
+inline std::ostream& operator<<(std::ostream& os, const CompileOutput& output)
+{
+    return os << (output.success ? "success" : "failure") << "\n" << output.text << "\n" << output.infoLog;
+}
@@ -0,0 +1,299 @@
+#include "unit_tests_common.h"
+
+#include <map>
+#include <mutex>
+#include <vector>
+
+using namespace ::testing;
+
+namespace {
+
+constexpr const char* kShaderSrc = R"""(
+#include "lighting.h"
+
+float4 tint;
+
+fixed4 main (float3 normal : TEXCOORD0) : COLOR0
+{
+    return Light (normal) * tint;
+}
+)""";
+
+// Hashes of the files, by resolved path
+struct IncludeHashes
+{
+    std::mutex mutex;
+    std::map<std::string, std::string> hashes;
+};
+
+bool ResolveInclude(bool isSystem, const char* fname, const char* parentfname, std::string& path, void* data)
+{
+    // Pretend "local.h" means another file for every parent
+    if (std::string(fname) == "local.h")
+        return false;
+    path = std::string("/shaders/") + fname;
+    return true;
+}
+
+bool HashInclude(const char* path, std::string& hash, void* data)
+{
+    auto* hashes = static_cast<IncludeHashes*>(data);
+    std::lock_guard<std::mutex> lock(hashes->mutex);
+    hash = hashes->hashes[path];
+    return true;
+}
+
+class Hlsl2GlslIncludeCacheTest : public IncludeFilesTest
+{
+public:
+    IncludeHashes hashes;
+
+    Hlsl2GlslIncludeCacheTest()
+    {
+        files.files = {
+            { "lighting.h", "#include \"common.h\"\nfloat4 Light (float3 n) { return Scale (n.xyzz); }\n" },
+            { "common.h", "float4 Scale (float4 v) { return v * 0.5; }\n" },
+        };
+    }
+
+    std::string compile(ShIncludeCacheHandle cache, const char* src = kShaderSrc)
+    {
+        ShHandle compiler = Hlsl2Glsl_ConstructCompiler(EShLangFragment);
+        Hlsl2Glsl_SetIncludeCache(compiler, cache);
+        std::string output;
+        if (Hlsl2Glsl_Parse(compiler, src, ETargetGLSL_110, &callbacks, 0) &&
+            Hlsl2Glsl_Translate(compiler, "main", ETargetGLSL_110, 0)) {
+            output = GetCompiledShaderText(compiler);
+        } else {
+            output = std::string("error: ") + Hlsl2Glsl_GetInfoLog(compiler);
+        }
+        Hlsl2Glsl_DestructCompiler(compiler);
+        return output;
+    }
+
+    static Hlsl2Glsl_IncludeCacheStats stats(ShIncludeCacheHandle cache)
+    {
+        Hlsl2Glsl_IncludeCacheStats result {};
+        Hlsl2Glsl_GetIncludeCacheStats(cache, &result);
+        return result;
+    }
+};
+
+// NOLINTNEXTLINE
+TEST_F(Hlsl2GlslIncludeCacheTest, SharedBetweenCompilers)
+{
+    const std::string uncached = compile(nullptr);
+    EXPECT_THAT(uncached, HasSubstr("Scale"));
+    EXPECT_EQ(2, files.opens);
+
+    ShIncludeCacheHandle cache = Hlsl2Glsl_ConstructIncludeCache(nullptr);
+    files.opens = 0;
+    files.closes = 0;
+    EXPECT_EQ(uncached, compile(cache));
+    EXPECT_EQ(2, files.opens);
+    EXPECT_EQ(uncached, compile(cache));
+    EXPECT_EQ(uncached, compile(cache));
+    EXPECT_EQ(2, files.opens);
+    EXPECT_EQ(files.opens, files.closes);
+
+    const Hlsl2Glsl_IncludeCacheStats cacheStats = stats(cache);
+    EXPECT_EQ(4u, cacheStats.hits);
+    EXPECT_EQ(2u, cacheStats.misses);
+    EXPECT_EQ(0u, cacheStats.invalidations);
+    EXPECT_EQ(2u, cacheStats.files);
+    EXPECT_EQ(files.files["lighting.h"].size() + files.files["common.h"].size(), cacheStats.bytes);
+
+    Hlsl2Glsl_DestructIncludeCache(cache);
+}
+
+// NOLINTNEXTLINE
+TEST_F(Hlsl2GlslIncludeCacheTest, FailedIncludesAreNotCached)
+{
+    ShIncludeCacheHandle cache = Hlsl2Glsl_ConstructIncludeCache(nullptr);
+    const char* src = "#include \"missing.h\"\nfloat4 main () : COLOR0 { return 1.0; }\n";
+    EXPECT_THAT(compile(cache, src), HasSubstr("error"));
+    EXPECT_THAT(compile(cache, src), HasSubstr("error"));
+    EXPECT_EQ(2, files.opens);
+    EXPECT_EQ(0u, stats(cache).files);
+    Hlsl2Glsl_DestructIncludeCache(cache);
+}
+
+// NOLINTNEXTLINE
+TEST_F(Hlsl2GlslIncludeCacheTest, ResolveAndHashCallbacks)
+{
+    Hlsl2Glsl_IncludeCacheCallbacks cacheCallbacks { ResolveInclude, HashInclude, &hashes };
+    ShIncludeCacheHandle cache = Hlsl2Glsl_ConstructIncludeCache(&cacheCallbacks);
+    files.files["local.h"] = "float4 Local () { return 1.0; }\n";
+    hashes.hashes["/shaders/common.h"] = "1";
+    const char* src = "#include \"lighting.h\"\n#include \"local.h\"\nfloat4 main (float3 n : TEXCOORD0) : COLOR0 { return Light (n) + Local (); }\n";
+
+    const std::string first = compile(cache, src);
+    EXPECT_EQ(first, compile(cache, src));
+    // local.h is read every time
+    EXPECT_EQ(4, files.opens);
+    EXPECT_EQ(2u, stats(cache).hits);
+
+    // A new hash reads the file again
+    {
+        std::lock_guard<std::mutex> lock(files.mutex);
+        files.files["common.h"] = "float4 Scale (float4 v) { return v * 0.25; }\n";
+        hashes.hashes["/shaders/common.h"] = "2";
+    }
+    files.opens = 0;
+    const std::string changed = compile(cache, src);
+    EXPECT_THAT(changed, HasSubstr("0.25"));
+    EXPECT_EQ(2, files.opens);
+
+    const Hlsl2Glsl_IncludeCacheStats cacheStats = stats(cache);
+    EXPECT_EQ(3u, cacheStats.hits);
+    EXPECT_EQ(3u, cacheStats.misses);
+    EXPECT_EQ(1u, cacheStats.invalidations);
+    EXPECT_EQ(2u, cacheStats.files);
+
+    Hlsl2Glsl_DestructIncludeCache(cache);
+}
+
+// NOLINTNEXTLINE
+TEST_F(Hlsl2GlslIncludeCacheTest, OutlivesItsHandle)
+{
+    ShIncludeCacheHandle cache = Hlsl2Glsl_ConstructIncludeCache(nullptr);
+    ShHandle compiler = Hlsl2Glsl_ConstructCompiler(EShLangFragment);
+    Hlsl2Glsl_SetIncludeCache(compiler, cache);
+    Hlsl2Glsl_DestructIncludeCache(cache);
+
+    EXPECT_TRUE(Hlsl2Glsl_Parse(compiler, kShaderSrc, ETargetGLSL_110, &callbacks, 0));
+    EXPECT_TRUE(Hlsl2Glsl_Parse(compiler, kShaderSrc, ETargetGLSL_110, &callbacks, 0));
+    EXPECT_EQ(2, files.opens);
+    Hlsl2Glsl_DestructCompiler(compiler);
+}
+
+// NOLINTNEXTLINE
+TEST_F(Hlsl2GlslIncludeCacheTest, Batch)
+{
+    const std::string uncached = compile(nullptr);
+    ShIncludeCacheHandle cache = Hlsl2Glsl_ConstructIncludeCache(nullptr);
+
+    std::vector<Hlsl2Glsl_BatchJob> jobs(40);
+    for (auto& job : jobs) {
+        job = Hlsl2Glsl_BatchJob { kShaderSrc, EShLangFragment, "main", ETargetGLSL_110, 0,
+            nullptr, &callbacks, nullptr, nullptr, 0, nullptr, cache };
+    }
+    std::vector<Hlsl2Glsl_BatchResult> results(jobs.size());
+    EXPECT_EQ(1, Hlsl2Glsl_CompileBatch(jobs.data(), static_cast<int>(jobs.size()), results.data(), 4));
+    for (const auto& result : results) {
+        EXPECT_EQ(uncached, GetCompiledShaderText(result.handle));
+        Hlsl2Glsl_DestructCompiler(result.handle);
+    }
+
+    // Threads can miss the same file at once, but each include is counted once
+    const Hlsl2Glsl_IncludeCacheStats cacheStats = stats(cache);
+    EXPECT_EQ(2 * jobs.size(), cacheStats.hits + cacheStats.misses);
+    EXPECT_GE(cacheStats.misses, 2u);
+    EXPECT_EQ(2u, cacheStats.files);
+    EXPECT_EQ(files.opens, files.closes);
+
+    Hlsl2Glsl_DestructIncludeCache(cache);
+}
+
+// NOLINTNEXTLINE
+TEST_F(Hlsl2GlslIncludeCacheTest, Dependencies)
+{
+    Hlsl2Glsl_IncludeCacheCallbacks cacheCallbacks { ResolveInclude, nullptr, &hashes };
+    ShIncludeCacheHandle cache = Hlsl2Glsl_ConstructIncludeCache(&cacheCallbacks);
+    files.files["guarded.h"] = "#ifndef GUARDED_H\n#define GUARDED_H\nfloat4 Guarded () { return 1.0; }\n#endif\n";
+    const char* src =
+        "#include \"lighting.h\"\n"
+        "#include \"guarded.h\"\n"
+        "#include \"common.h\"\n"
+        "#include \"guarded.h\"\n"
+        "#include <missing.h>\n"
+        "float4 main (float3 n : TEXCOORD0) : COLOR0 { return Light (n) + Guarded (); }\n";
+
+    ShHandle compiler = Hlsl2Glsl_ConstructCompiler(EShLangFragment);
+    Hlsl2Glsl_SetIncludeCache(compiler, cache);
+    EXPECT_FALSE(Hlsl2Glsl_Parse(compiler, src, ETargetGLSL_110, &callbacks, ETranslateOpRecordDependencies));
+    // guarded.h is not opened again, but still listed once
+    EXPECT_EQ(4, files.opens);
+
+    int count = 0;
+    const Hlsl2Glsl_Dependency* dependencies = Hlsl2Glsl_GetDependencies(compiler, &count);
+    ASSERT_EQ(4, count);
+    EXPECT_STREQ("/shaders/lighting.h", dependencies[0].path);
+    EXPECT_STREQ("lighting.h", dependencies[0].name);
+    EXPECT_STREQ("", dependencies[0].parentName);
+    EXPECT_STREQ("/shaders/common.h", dependencies[1].path);
+    EXPECT_STREQ("lighting.h", dependencies[1].parentName);
+    EXPECT_STREQ("/shaders/guarded.h", dependencies[2].path);
+    EXPECT_STREQ("/shaders/missing.h", dependencies[3].path);
+    EXPECT_EQ(1, dependencies[3].isSystem);
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_EQ(0, dependencies[i].isSystem);
+        EXPECT_EQ(1, dependencies[i].found);
+    }
+    EXPECT_EQ(0, dependencies[3].found);
+
+    // Without missing.h, and with a rule of its own for each file, so make neither stops for
+    // want of a rule to make one nor once one is deleted
+    EXPECT_STREQ("shader.glsl: \\\n  /shaders/lighting.h \\\n  /shaders/common.h \\\n  /shaders/guarded.h\n"
+        "\n/shaders/lighting.h:\n\n/shaders/common.h:\n\n/shaders/guarded.h:\n",
+        Hlsl2Glsl_GetDepfile(compiler, "shader.glsl"));
+
+    // Only recorded when asked for
+    EXPECT_TRUE(Hlsl2Glsl_Parse(compiler, kShaderSrc, ETargetGLSL_110, &callbacks, 0));
+    EXPECT_EQ(nullptr, Hlsl2Glsl_GetDependencies(compiler, &count));
+    EXPECT_EQ(0, count);
+    EXPECT_STREQ("shader.glsl:\n", Hlsl2Glsl_GetDepfile(compiler, "shader.glsl"));
+
+    Hlsl2Glsl_DestructCompiler(compiler);
+    Hlsl2Glsl_DestructIncludeCache(cache);
+}
+
+// NOLINTNEXTLINE
+TEST_F(Hlsl2GlslIncludeCacheTest, DepfileEscaping)
+{
+    files.files["my lights.h"] = "float4 Light (float3 n) { return n.xyzz; }\n";
+    files.files["$cost#2.h"] = "";
+    const char* src =
+        "#include \"my lights.h\"\n"
+        "#include \"$cost#2.h\"\n"
+        "float4 main (float3 n : TEXCOORD0) : COLOR0 { return Light (n); }\n";
+
+    ShHandle compiler = Hlsl2Glsl_ConstructCompiler(EShLangFragment);
+    EXPECT_TRUE(Hlsl2Glsl_Parse(compiler, src, ETargetGLSL_110, &callbacks, ETranslateOpRecordDependencies));
+    EXPECT_STREQ("out/my\\ shader.o: \\\n  my\\ lights.h \\\n  $$cost\\#2.h\n\nmy\\ lights.h:\n\n$$cost\\#2.h:\n",
+        Hlsl2Glsl_GetDepfile(compiler, "out/my shader.o"));
+    // A backslash before a blank would escape it
+    EXPECT_STREQ("dir\\\\\\ x.o: \\\n  my\\ lights.h \\\n  $$cost\\#2.h\n\nmy\\ lights.h:\n\n$$cost\\#2.h:\n",
+        Hlsl2Glsl_GetDepfile(compiler, "dir\\ x.o"));
+    Hlsl2Glsl_DestructCompiler(compiler);
+}
+
+// NOLINTNEXTLINE
+TEST_F(Hlsl2GlslIncludeCacheTest, DependenciesWithoutResolving)
+{
+    files.files["a/x.h"] = "#include \"name.h\"\n";
+    files.files["b/y.h"] = "#include \"name.h\"\n#include <sys.h>\n";
+    files.files["a/name.h"] = "";
+    files.files["b/name.h"] = "";
+    files.files["sys.h"] = "";
+    const char* src =
+        "#include \"a/x.h\"\n"
+        "#include \"b/y.h\"\n"
+        "float4 main (float3 n : TEXCOORD0) : COLOR0 { return n.xyzz; }\n";
+
+    // Local includes are found next to the file that includes them, system ones are not
+    ShHandle compiler = Hlsl2Glsl_ConstructCompiler(EShLangFragment);
+    EXPECT_TRUE(Hlsl2Glsl_Parse(compiler, src, ETargetGLSL_110, &callbacks, ETranslateOpRecordDependencies));
+    int count = 0;
+    const Hlsl2Glsl_Dependency* dependencies = Hlsl2Glsl_GetDependencies(compiler, &count);
+    ASSERT_EQ(5, count);
+    EXPECT_STREQ("a/x.h", dependencies[0].path);
+    EXPECT_STREQ("a/name.h", dependencies[1].path);
+    EXPECT_STREQ("name.h", dependencies[1].name);
+    EXPECT_STREQ("b/y.h", dependencies[2].path);
+    EXPECT_STREQ("b/name.h", dependencies[3].path);
+    EXPECT_STREQ("sys.h", dependencies[4].path);
+    Hlsl2Glsl_DestructCompiler(compiler);
+}
+
+} // namespace
@@ -0,0 +1,256 @@
+#include "unit_tests_common.h"
+
+#include <algorithm>
+#include <map>
+
+using namespace ::testing;
+
+namespace {
+
+constexpr const char* kShaderSrc = R"""(#include "common.h"
+#define SCALE(x) ((x) * 0.5)
+
+float4 tint;
+
+
+fixed4 main (float3 normal : TEXCOORD0) : COLOR0
+{
+#ifdef LIGHTING
+    return Light (normal) * tint;
+#endif
+
+
+
+
+
+
+
+
+
+    return SCALE (tint) * __LINE__;
+}
+)""";
+
+struct SourcePosition
+{
+    std::string file;
+    unsigned int line;
+
+    bool operator==(const SourcePosition& other) const
+    {
+        return file == other.file && line == other.line;
+    }
+};
+
+std::ostream& operator<<(std::ostream& os, const SourcePosition& position)
+{
+    return os << "\"" << position.file << "\":" << position.line;
+}
+
+class Hlsl2GlslPreprocessTest : public IncludeFilesTest
+{
+public:
+    ShHandle compiler = nullptr;
+
+    Hlsl2GlslPreprocessTest()
+    {
+        files.files = {
+            { "common.h", "float4 Light (float3 n)\n{\n    return n.xyzz;\n}\n" },
+            { "guarded.h", "// comment\n#ifndef GUARDED_H\n#define GUARDED_H\n#include \"nested.h\"\nfloat guarded;\n#endif\n\n" },
+            { "nested.h", "\n#ifndef NESTED_H\n#define NESTED_H\n#if 1\nfloat nested;\n#endif\n#endif // NESTED_H\n" },
+            { "once.h", "#pragma once\nfloat once;\n" },
+            { "after.h", "#ifndef AFTER_H\n#define AFTER_H\nfloat after;\n#endif\nfloat again;\n" },
+            { "else.h", "#ifndef ELSE_H\n#define ELSE_H\nfloat first;\n#else\nfloat second;\n#endif\n" },
+            { "a/same.h", "#include \"name.h\"\n" },
+            { "b/same.h", "#include \"name.h\"\n" },
+            { "a/name.h", "#pragma once\nfloat a;\n" },
+            { "b/name.h", "#pragma once\nfloat b;\n" },
+        };
+    }
+
+    void SetUp() override
+    {
+        IncludeFilesTest::SetUp();
+        compiler = Hlsl2Glsl_ConstructCompiler(EShLangFragment);
+    }
+
+    void TearDown() override
+    {
+        Hlsl2Glsl_DestructCompiler(compiler);
+        IncludeFilesTest::TearDown();
+    }
+
+    // Where the text at offset came from, by the source map
+    SourcePosition position(size_t offset) const
+    {
+        int spanCount = 0;
+        int fileCount = 0;
+        const Hlsl2Glsl_SourceSpan* spans = Hlsl2Glsl_GetSourceMap(compiler, &spanCount);
+        const char* const* names = Hlsl2Glsl_GetSourceFiles(compiler, &fileCount);
+        const std::string text = Hlsl2Glsl_GetPreprocessedText(compiler);
+
+        int span = 0;
+        while (span + 1 < spanCount && spans[span + 1].offset <= offset) {
+            ++span;
+        }
+        EXPECT_LT(spans[span].file, static_cast<unsigned int>(fileCount));
+        const unsigned int newlines = static_cast<unsigned int>(std::count(text.begin() + spans[span].offset, text.begin() + offset, '\n'));
+        return { names[spans[span].file], spans[span].line + newlines };
+    }
+
+    SourcePosition position(const std::string& token) const
+    {
+        const std::string text = Hlsl2Glsl_GetPreprocessedText(compiler);
+        const size_t offset = text.rfind(token);
+        EXPECT_NE(std::string::npos, offset) << token;
+        return position(offset);
+    }
+};
+
+// NOLINTNEXTLINE
+TEST_F(Hlsl2GlslPreprocessTest, TextAndSourceMap)
+{
+    ASSERT_EQ(1, Hlsl2Glsl_Preprocess(compiler, kShaderSrc, &callbacks, nullptr, 0)) << Hlsl2Glsl_GetInfoLog(compiler);
+
+    EXPECT_EQ(std::string("float4 Light ( float3 n )\n{\nreturn n . xyzz ;\n}\n"
+        "float4 tint ;\n\n\nfixed4 main ( float3 normal : TEXCOORD0 ) : COLOR0\n{\n"
+        "return ( ( tint ) * 0.5 ) * 21 ;\n}"), Hlsl2Glsl_GetPreprocessedText(compiler));
+
+    int spanCount = 0;
+    Hlsl2Glsl_GetSourceMap(compiler, &spanCount);
+    EXPECT_EQ(3, spanCount);
+
+    EXPECT_EQ((SourcePosition { "common.h", 1 }), position("float4 Light"));
+    EXPECT_EQ((SourcePosition { "common.h", 3 }), position("xyzz"));
+    EXPECT_EQ((SourcePosition { "", 4 }), position("tint ;"));
+    EXPECT_EQ((SourcePosition { "", 7 }), position("main"));
+    // After a gap too long for newlines
+    EXPECT_EQ((SourcePosition { "", 21 }), position("return ("));
+    EXPECT_EQ((SourcePosition { "", 22 }), position("}"));
+}
+
+// NOLINTNEXTLINE
+TEST_F(Hlsl2GlslPreprocessTest, Defines)
+{
+    const Hlsl2Glsl_Define defines[] = { { "LIGHTING", nullptr } };
+    ASSERT_EQ(1, Hlsl2Glsl_Preprocess(compiler, kShaderSrc, &callbacks, defines, 1)) << Hlsl2Glsl_GetInfoLog(compiler);
+
+    const std::string text = Hlsl2Glsl_GetPreprocessedText(compiler);
+    EXPECT_THAT(text, HasSubstr("return Light ( normal ) * tint ;"));
+    EXPECT_EQ((SourcePosition { "", 10 }), position("return Light"));
+}
+
+// NOLINTNEXTLINE
+TEST_F(Hlsl2GlslPreprocessTest, ParsesLikeTheSource)
+{
+    ASSERT_EQ(1, Hlsl2Glsl_Preprocess(compiler, kShaderSrc, &callbacks, nullptr, 0));
+    const std::string text = Hlsl2Glsl_GetPreprocessedText(compiler);
+
+    ShHandle other = Hlsl2Glsl_ConstructCompiler(EShLangFragment);
+    ASSERT_TRUE(Hlsl2Glsl_Parse(other, text.c_str(), ETargetGLSL_110, nullptr, 0)) << Hlsl2Glsl_GetInfoLog(other);
+    ASSERT_TRUE(Hlsl2Glsl_Translate(other, "main", ETargetGLSL_110, 0)) << Hlsl2Glsl_GetInfoLog(other);
+    EXPECT_THAT(GetCompiledShaderText(other), HasSubstr("((tint * 0.5) * 21.0)"));
+    Hlsl2Glsl_DestructCompiler(other);
+}
+
+// NOLINTNEXTLINE
+TEST_F(Hlsl2GlslPreprocessTest, Errors)
+{
+    EXPECT_EQ(0, Hlsl2Glsl_Preprocess(compiler, "float4 a;\n#include \"missing.h\"\n", &callbacks, nullptr, 0));
+    EXPECT_EQ(std::string("float4 a ;"), Hlsl2Glsl_GetPreprocessedText(compiler));
+    EXPECT_THAT(Hlsl2Glsl_GetInfoLog(compiler), HasSubstr("(3): ERROR: '' : Include callback failed"));
+
+    // The same error as parsing reports
+    ShHandle other = Hlsl2Glsl_ConstructCompiler(EShLangFragment);
+    EXPECT_FALSE(Hlsl2Glsl_Parse(other, "float4 a;\n#include \"missing.h\"\n", ETargetGLSL_110, &callbacks, 0));
+    EXPECT_THAT(Hlsl2Glsl_GetInfoLog(other), HasSubstr(Hlsl2Glsl_GetInfoLog(compiler)));
+    Hlsl2Glsl_DestructCompiler(other);
+
+    EXPECT_EQ(0, Hlsl2Glsl_Preprocess(compiler, nullptr, nullptr, nullptr, 0));
+    EXPECT_EQ(std::string(), Hlsl2Glsl_GetPreprocessedText(compiler));
+}
+
+// NOLINTNEXTLINE
+TEST_F(Hlsl2GlslPreprocessTest, LongRuns)
+{
+    // Comments, blanks and identifiers longer than the lexer's chunks, with every kind of newline
+    const std::string longName(40, 'x');
+    const std::string src =
+        "/* a comment * with ** stars\n and \r\n all \r kinds of\n\n newlines, longer than sixteen bytes */ float\t\v\f                    " + longName + "_0 ;\n"
+        "// a line comment longer than sixteen bytes \r\n"
+        "float /**/ b1234567890abcdefghijklmnopqrstuvwxyz_ABCDEFGHIJKLMNOPQRSTUVWXYZ ; // again\r"
+        "float \t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t c ;\n"
+        "/*\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n*/ float d ; " + longName;
+    ASSERT_EQ(1, Hlsl2Glsl_Preprocess(compiler, src.c_str(), nullptr, nullptr, 0)) << Hlsl2Glsl_GetInfoLog(compiler);
+
+    const std::string text = Hlsl2Glsl_GetPreprocessedText(compiler);
+    EXPECT_THAT(text, HasSubstr("float " + longName + "_0 ;"));
+    EXPECT_THAT(text, HasSubstr("float b1234567890abcdefghijklmnopqrstuvwxyz_ABCDEFGHIJKLMNOPQRSTUVWXYZ ;"));
+    EXPECT_EQ((SourcePosition { "", 6 }), position(longName + "_0"));
+    EXPECT_EQ((SourcePosition { "", 8 }), position("b1234567890"));
+    EXPECT_EQ((SourcePosition { "", 9 }), position("c ;"));
+    EXPECT_EQ((SourcePosition { "", 30 }), position("d ;"));
+    EXPECT_EQ(text.size() - longName.size(), text.rfind(longName));
+}
+
+// NOLINTNEXTLINE
+TEST_F(Hlsl2GlslPreprocessTest, IncludeGuards)
+{
+    const char* src =
+        "#include \"guarded.h\"\n#include \"nested.h\"\n#include \"guarded.h\"\n"
+        "#include \"once.h\"\n#include \"once.h\"\n"
+        "#include \"after.h\"\n#include \"after.h\"\n"
+        "#include \"else.h\"\n#include \"else.h\"\n"
+        "#include \"a/same.h\"\n#include \"b/same.h\"\n#include \"a/same.h\"\n";
+    ASSERT_EQ(1, Hlsl2Glsl_Preprocess(compiler, src, &callbacks, nullptr, 0)) << Hlsl2Glsl_GetInfoLog(compiler);
+
+    EXPECT_EQ(std::string("float nested ;\nfloat guarded ;\nfloat once ;\nfloat after ;\n\nfloat again ; float again ;\n"
+        "float first ;\n\nfloat second ;\nfloat a ; float b ;"), Hlsl2Glsl_GetPreprocessedText(compiler));
+
+    // Guarded files are opened once, others each time
+    const std::map<std::string, int> expected {
+        { "guarded.h", 1 }, { "nested.h", 1 }, { "once.h", 1 }, { "after.h", 2 }, { "else.h", 2 },
+        { "a/same.h", 2 }, { "b/same.h", 1 }, { "a/name.h", 1 }, { "b/name.h", 1 },
+    };
+    EXPECT_EQ(expected, files.opensByPath);
+}
+
+// NOLINTNEXTLINE
+TEST_F(Hlsl2GlslPreprocessTest, UndefinedGuard)
+{
+    const char* src = "#include \"nested.h\"\n#undef NESTED_H\n#include \"nested.h\"\n#include \"nested.h\"\n";
+    ASSERT_EQ(1, Hlsl2Glsl_Preprocess(compiler, src, &callbacks, nullptr, 0)) << Hlsl2Glsl_GetInfoLog(compiler);
+
+    EXPECT_EQ(std::string("float nested ; float nested ;"), Hlsl2Glsl_GetPreprocessedText(compiler));
+    EXPECT_EQ(2, files.opensByPath["nested.h"]);
+}
+
+// NOLINTNEXTLINE
+TEST_F(Hlsl2GlslPreprocessTest, RepeatedMacroCalls)
+{
+    // Calls with the same arguments, around everything that changes what they expand to
+    const char* src =
+        "#define K 1\n"
+        "#define F(a, b) a + b * K + #a\n"
+        "F (x, K);\n"
+        "F (x, K);\n"
+        "F (x,K);\n"
+        "#undef K\n#define K 2\n"
+        "F (x, K);\n"
+        "#undef F\n#define F(a, b) a - b\n"
+        "F (x, K);\n"
+        "#define G(a) a\n"
+        "G (__LINE__); G (__LINE__);\n"
+        "G (__LINE__);\n"
+        "G (__FILE__);\n";
+    ASSERT_EQ(1, Hlsl2Glsl_Preprocess(compiler, src, nullptr, nullptr, 0)) << Hlsl2Glsl_GetInfoLog(compiler);
+
+    EXPECT_EQ(std::string("x + 1 * 1 + \"x\" ;\nx + 1 * 1 + \"x\" ;\nx + 1 * 1 + \"x\" ;\n\n\nx + 2 * 2 + \"x\" ;\n\n\n"
+        "x - 2 ;\n\n13 ; 13 ;\n14 ;\n\"\" ;"), Hlsl2Glsl_GetPreprocessedText(compiler));
+
+    // The same again in a preprocessor that starts over
+    ASSERT_EQ(1, Hlsl2Glsl_Preprocess(compiler, "#define K 3\n#define F(a, b) a + b * K + #a\nF (x, K);\n", nullptr, nullptr, 0));
+    EXPECT_EQ(std::string("x + 3 * 3 + \"x\" ;"), Hlsl2Glsl_GetPreprocessedText(compiler));
+}
+
+} // namespace
@@ -0,0 +1,166 @@
+#include "unit_tests_common.h"
+
+using namespace ::testing;
+
+namespace {
+
+// The matrix cast parses differently before GLSL 1.20
+constexpr const char* kMatrixShaderSrc = R"""(
+#include "common.h"
+
+float4x4 matrix_mvp;
+float4x4 matrix_normal;
+
+void main (float4 vertex : POSITION, out float4 overtex : POSITION, float3 normal : NORMAL, out float3 onormal : TEXCOORD0)
+{
+    overtex = mul (matrix_mvp, vertex);
+    onormal = Scale (mul ((float3x3)matrix_normal, normal));
+}
+)""";
+
+constexpr const char* kPlainShaderSrc = R"""(
+#include "common.h"
+
+float4 offset;
+
+void main (float4 vertex : POSITION, out float4 overtex : POSITION, float3 normal : NORMAL, out float3 onormal : TEXCOORD0)
+{
+    overtex = vertex + offset;
+    onormal = Scale (normal);
+}
+)""";
+
+constexpr const char* kNonSquareShaderSrc = R"""(
+#include "common.h"
+
+float3x4 matrix_bones;
+
+void main (float4 vertex : POSITION, out float4 overtex : POSITION, float3 normal : NORMAL, out float3 onormal : TEXCOORD0)
+{
+    overtex = float4 (mul (matrix_bones, vertex), 1.0);
+    onormal = Scale (normal);
+}
+)""";
+
+constexpr ETargetVersion kTargets[] = { ETargetGLSL_ES_100, ETargetGLSL_110, ETargetGLSL_120, ETargetGLSL_140, ETargetGLSL_ES_300 };
+
+class Hlsl2GlslRetargetTest : public IncludeFilesTest
+{
+public:
+    Hlsl2GlslRetargetTest()
+    {
+        files.files["common.h"] = "float3 Scale (float3 v) { return v * 0.5; }\n";
+    }
+
+    static CompileOutput translate(ShHandle compiler, ETargetVersion version)
+    {
+        CompileOutput output;
+        output.success = Hlsl2Glsl_Translate(compiler, "main", version, 0) != 0;
+        output.text = output.success ? GetCompiledShaderText(compiler) : std::string();
+        output.infoLog = Hlsl2Glsl_GetInfoLog(compiler);
+        return output;
+    }
+
+    // Parse and translate on a handle of its own
+    CompileOutput compile(const char* src, ETargetVersion version)
+    {
+        ShHandle compiler = Hlsl2Glsl_ConstructCompiler(EShLangVertex);
+        CompileOutput output;
+        if (Hlsl2Glsl_Parse(compiler, src, version, &callbacks, 0)) {
+            output = translate(compiler, version);
+        } else {
+            output = { false, std::string(), Hlsl2Glsl_GetInfoLog(compiler) };
+        }
+        Hlsl2Glsl_DestructCompiler(compiler);
+        return output;
+    }
+};
+
+// NOLINTNEXTLINE
+TEST_F(Hlsl2GlslRetargetTest, TargetNeutralShaderIsParsedOnce)
+{
+    ShHandle compiler = Hlsl2Glsl_ConstructCompiler(EShLangVertex);
+    ASSERT_TRUE(Hlsl2Glsl_Parse(compiler, kPlainShaderSrc, ETargetGLSL_ES_300, &callbacks, 0));
+
+    for (ETargetVersion version : kTargets) {
+        files.opens = 0;
+        CompileOutput output = translate(compiler, version);
+        EXPECT_EQ(0, files.opens) << "target " << version;
+        EXPECT_TRUE(output.success) << output;
+        EXPECT_EQ(compile(kPlainShaderSrc, version), output) << "target " << version;
+    }
+    EXPECT_EQ(1, Hlsl2Glsl_GetParseCount(compiler));
+
+    Hlsl2Glsl_DestructCompiler(compiler);
+}
+
+// NOLINTNEXTLINE
+TEST_F(Hlsl2GlslRetargetTest, MatrixShaderIsParsedOncePerSide)
+{
+    ShHandle compiler = Hlsl2Glsl_ConstructCompiler(EShLangVertex);
+    ASSERT_TRUE(Hlsl2Glsl_Parse(compiler, kMatrixShaderSrc, ETargetGLSL_ES_300, &callbacks, 0));
+
+    const std::pair<ETargetVersion, bool> steps[] = {
+        { ETargetGLSL_ES_300, false },
+        { ETargetGLSL_120, false },
+        { ETargetGLSL_ES_100, true },   // parsed again with pre-1.20 rules
+        { ETargetGLSL_110, false },
+        { ETargetGLSL_140, true },
+    };
+    EXPECT_EQ(1, Hlsl2Glsl_GetParseCount(compiler));
+    for (const auto& [version, parsedAgain] : steps) {
+        files.opens = 0;
+        const int parses = Hlsl2Glsl_GetParseCount(compiler);
+        CompileOutput output = translate(compiler, version);
+        EXPECT_EQ(parses + (parsedAgain ? 1 : 0), Hlsl2Glsl_GetParseCount(compiler)) << "target " << version;
+        // From the kept tokens, if at all
+        EXPECT_EQ(0, files.opens) << "target " << version;
+        EXPECT_TRUE(output.success) << output;
+        EXPECT_EQ(compile(kMatrixShaderSrc, version), output) << "target " << version;
+    }
+
+    // Differs between the sides
+    EXPECT_NE(compile(kMatrixShaderSrc, ETargetGLSL_ES_100).text, compile(kMatrixShaderSrc, ETargetGLSL_ES_300).text);
+
+    Hlsl2Glsl_DestructCompiler(compiler);
+}
+
+// NOLINTNEXTLINE
+TEST_F(Hlsl2GlslRetargetTest, FailedRetargetKeepsShader)
+{
+    ShHandle compiler = Hlsl2Glsl_ConstructCompiler(EShLangVertex);
+    ASSERT_TRUE(Hlsl2Glsl_Parse(compiler, kNonSquareShaderSrc, ETargetGLSL_120, &callbacks, 0));
+
+    CompileOutput output = translate(compiler, ETargetGLSL_ES_100);
+    EXPECT_FALSE(output.success);
+    EXPECT_THAT(output.infoLog, HasSubstr("not supported in pre-GLSL1.20"));
+    EXPECT_EQ(compile(kNonSquareShaderSrc, ETargetGLSL_ES_100).infoLog, output.infoLog);
+
+    output = translate(compiler, ETargetGLSL_ES_300);
+    EXPECT_TRUE(output.success) << output;
+    EXPECT_EQ(compile(kNonSquareShaderSrc, ETargetGLSL_ES_300), output);
+
+    Hlsl2Glsl_DestructCompiler(compiler);
+}
+
+// NOLINTNEXTLINE
+TEST_F(Hlsl2GlslRetargetTest, RetargetOutlivesCallbacks)
+{
+    ShHandle compiler = Hlsl2Glsl_ConstructCompiler(EShLangVertex);
+    {
+        // Gone by the time the shader gets parsed again
+        IncludeFiles parseFiles;
+        parseFiles.files = files.files;
+        Hlsl2Glsl_ParseCallbacks parseCallbacks { OpenIncludeFile, CloseIncludeFile, &parseFiles };
+        ASSERT_TRUE(Hlsl2Glsl_Parse(compiler, kMatrixShaderSrc, ETargetGLSL_ES_300, &parseCallbacks, 0));
+        EXPECT_EQ(1, parseFiles.opens);
+    }
+
+    CompileOutput output = translate(compiler, ETargetGLSL_ES_100);
+    EXPECT_TRUE(output.success) << output;
+    EXPECT_EQ(compile(kMatrixShaderSrc, ETargetGLSL_ES_100), output);
+
+    Hlsl2Glsl_DestructCompiler(compiler);
+}
+
+} // namespace
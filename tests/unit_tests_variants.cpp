@@ -0,0 +1,263 @@
+#include "unit_tests_common.h"
+
+#include <vector>
+
+using namespace ::testing;
+
+namespace {
+
+constexpr const char* kShaderSrc = R"""(
+#include "lighting.h"
+
+float4 tint;
+
+fixed4 main (float3 normal : TEXCOORD0) : COLOR0
+{
+#ifdef LIGHTING
+    return Light (normal) * tint * SCALE;
+#else
+    return tint * SCALE;
+#endif
+}
+)""";
+
+// What kShaderSrc preprocesses to, on the same lines
+std::string ExpandShader(bool lighting, const char* scale)
+{
+    return std::string("\n#include \"lighting.h\"\n\nfloat4 tint;\n\nfixed4 main (float3 normal : TEXCOORD0) : COLOR0\n{\n\n") +
+        (lighting ? std::string("    return Light (normal) * tint * ") + scale + ";\n\n\n" :
+                    std::string("\n\n    return tint * ") + scale + ";\n") +
+        "\n}\n";
+}
+
+class Hlsl2GlslVariantsTest : public IncludeFilesTest
+{
+public:
+    Hlsl2GlslVariantsTest()
+    {
+        files.files = {
+            { "lighting.h", "#include \"common.h\"\nfloat4 Light (float3 n) { return Scale (n.xyzz); }\n" },
+            { "common.h", "float4 Scale (float4 v) { return v * 0.5; }\n" },
+        };
+    }
+
+    Hlsl2Glsl_BatchJob job(ShCacheHandle cache = nullptr)
+    {
+        return Hlsl2Glsl_BatchJob { kShaderSrc, EShLangFragment, "main", ETargetGLSL_110, 0,
+            nullptr, &callbacks, nullptr, nullptr, 0, cache, nullptr };
+    }
+
+    static CompileOutput output(ShHandle compiler, bool success)
+    {
+        return { success, success ? GetCompiledShaderText(compiler) : std::string(), Hlsl2Glsl_GetInfoLog(compiler) };
+    }
+
+    // Parse and translate on a handle of its own
+    CompileOutput compile(const std::string& src, ETargetVersion version = ETargetGLSL_110)
+    {
+        ShHandle compiler = Hlsl2Glsl_ConstructCompiler(EShLangFragment);
+        const bool success = Hlsl2Glsl_Parse(compiler, src.c_str(), version, &callbacks, 0) &&
+            Hlsl2Glsl_Translate(compiler, "main", version, 0);
+        CompileOutput result = output(compiler, success);
+        Hlsl2Glsl_DestructCompiler(compiler);
+        return result;
+    }
+
+    std::vector<CompileOutput> compileVariants(const Hlsl2Glsl_BatchJob& variantJob, const std::vector<std::vector<Hlsl2Glsl_Define>>& defineSets,
+        Hlsl2Glsl_VariantStats& stats, int expectedReturn = 1)
+    {
+        std::vector<Hlsl2Glsl_Variant> variants;
+        for (const auto& defines : defineSets) {
+            variants.push_back(Hlsl2Glsl_Variant { defines.data(), static_cast<int>(defines.size()) });
+        }
+        std::vector<Hlsl2Glsl_BatchResult> results(variants.size());
+        EXPECT_EQ(expectedReturn, Hlsl2Glsl_CompileVariants(&variantJob, variants.data(), static_cast<int>(variants.size()), results.data(), 4, &stats));
+
+        std::vector<CompileOutput> outputs;
+        for (const auto& result : results) {
+            outputs.push_back(output(result.handle, result.success != 0));
+            Hlsl2Glsl_DestructCompiler(result.handle);
+        }
+        return outputs;
+    }
+};
+
+// NOLINTNEXTLINE
+TEST_F(Hlsl2GlslVariantsTest, SameAsSeparateCompiles)
+{
+    const std::vector<std::vector<Hlsl2Glsl_Define>> defineSets {
+        { { "SCALE", "1.0" } },
+        { { "LIGHTING", nullptr }, { "SCALE", "2.0" } },
+        { { "SCALE", "tint.x" }, { "LIGHTING", "1" } },
+    };
+    const std::vector<std::string> expanded {
+        ExpandShader(false, "1.0"),
+        ExpandShader(true, "2.0"),
+        ExpandShader(true, "tint.x"),
+    };
+
+    Hlsl2Glsl_VariantStats stats {};
+    const std::vector<CompileOutput> outputs = compileVariants(job(), defineSets, stats);
+    EXPECT_EQ(3, stats.parsed);
+    EXPECT_EQ(0, stats.duplicates);
+    EXPECT_EQ(0, stats.cached);
+    // Both includes are read once for all variants
+    EXPECT_EQ(2, files.opens);
+    EXPECT_EQ(files.opens, files.closes);
+
+    for (size_t i = 0; i < outputs.size(); ++i) {
+        EXPECT_TRUE(outputs[i].success) << outputs[i];
+        EXPECT_EQ(compile(expanded[i]), outputs[i]) << "variant " << i;
+    }
+}
+
+// NOLINTNEXTLINE
+TEST_F(Hlsl2GlslVariantsTest, IdenticalVariantsAreParsedOnce)
+{
+    const std::vector<std::vector<Hlsl2Glsl_Define>> defineSets {
+        { { "SCALE", "1.0" } },
+        { { "SCALE", "1.0" }, { "UNUSED", nullptr } },
+        { { "LIGHTING", nullptr }, { "SCALE", "1.0" } },
+        { { "UNUSED", "2" }, { "SCALE", "1.0" } },
+        { { "SCALE", "1.0" }, { "LIGHTING", nullptr }, { "UNUSED", nullptr } },
+    };
+
+    Hlsl2Glsl_VariantStats stats {};
+    const std::vector<CompileOutput> outputs = compileVariants(job(), defineSets, stats);
+    EXPECT_EQ(2, stats.parsed);
+    EXPECT_EQ(3, stats.duplicates);
+
+    EXPECT_EQ(compile(ExpandShader(false, "1.0")), outputs[0]);
+    EXPECT_EQ(outputs[0], outputs[1]);
+    EXPECT_EQ(outputs[0], outputs[3]);
+    EXPECT_EQ(compile(ExpandShader(true, "1.0")), outputs[2]);
+    EXPECT_EQ(outputs[2], outputs[4]);
+}
+
+// NOLINTNEXTLINE
+TEST_F(Hlsl2GlslVariantsTest, FailingVariants)
+{
+    const std::vector<std::vector<Hlsl2Glsl_Define>> defineSets {
+        { { "SCALE", "1.0" } },
+        { { "SCALE", "undefined" } },
+        { { "SCALE", "undefined" }, { "UNUSED", nullptr } },
+        { },
+    };
+
+    Hlsl2Glsl_VariantStats stats {};
+    const std::vector<CompileOutput> outputs = compileVariants(job(), defineSets, stats, 0);
+    EXPECT_EQ(3, stats.parsed);
+    EXPECT_EQ(1, stats.duplicates);
+
+    EXPECT_TRUE(outputs[0].success);
+    EXPECT_EQ(compile(ExpandShader(false, "undefined")), outputs[1]);
+    EXPECT_THAT(outputs[1].infoLog, HasSubstr("undefined"));
+    EXPECT_EQ(outputs[1], outputs[2]);
+    EXPECT_EQ(compile(kShaderSrc), outputs[3]);
+    EXPECT_FALSE(outputs[3].success);
+}
+
+// NOLINTNEXTLINE
+TEST_F(Hlsl2GlslVariantsTest, CompileCache)
+{
+    ShCacheHandle cache = Hlsl2Glsl_ConstructMemoryCache(0);
+    const std::vector<std::vector<Hlsl2Glsl_Define>> defineSets {
+        { { "SCALE", "1.0" } },
+        { { "SCALE", "1.0" }, { "LIGHTING", nullptr } },
+        { { "SCALE", "1.0" }, { "UNUSED", nullptr } },
+    };
+
+    Hlsl2Glsl_VariantStats stats {};
+    const std::vector<CompileOutput> first = compileVariants(job(cache), defineSets, stats);
+    EXPECT_EQ(2, stats.parsed);
+    EXPECT_EQ(0, stats.cached);
+
+    const std::vector<CompileOutput> second = compileVariants(job(cache), defineSets, stats);
+    EXPECT_EQ(0, stats.parsed);
+    EXPECT_EQ(1, stats.duplicates);
+    EXPECT_EQ(2, stats.cached);
+    EXPECT_EQ(first, second);
+
+    Hlsl2Glsl_DestructCache(cache);
+}
+
+// NOLINTNEXTLINE
+TEST_F(Hlsl2GlslVariantsTest, RecordDependencies)
+{
+    ShCacheHandle cache = Hlsl2Glsl_ConstructMemoryCache(0);
+    Hlsl2Glsl_BatchJob variantJob = job(cache);
+    variantJob.options = ETranslateOpRecordDependencies;
+    const std::vector<std::vector<Hlsl2Glsl_Define>> defineSets {
+        { { "SCALE", "1.0" } },
+        { { "SCALE", "1.0" }, { "UNUSED", nullptr } },
+    };
+    std::vector<Hlsl2Glsl_Variant> variants;
+    for (const auto& defines : defineSets) {
+        variants.push_back(Hlsl2Glsl_Variant { defines.data(), static_cast<int>(defines.size()) });
+    }
+
+    // Parsed, then duplicate of it, then both from the cache
+    for (int pass = 0; pass < 2; ++pass) {
+        std::vector<Hlsl2Glsl_BatchResult> results(variants.size());
+        Hlsl2Glsl_VariantStats stats {};
+        ASSERT_EQ(1, Hlsl2Glsl_CompileVariants(&variantJob, variants.data(), static_cast<int>(variants.size()), results.data(), 2, &stats));
+        EXPECT_EQ(1, stats.duplicates);
+        EXPECT_EQ(pass, stats.cached);
+
+        for (size_t i = 0; i < results.size(); ++i) {
+            int count = 0;
+            const Hlsl2Glsl_Dependency* dependencies = Hlsl2Glsl_GetDependencies(results[i].handle, &count);
+            ASSERT_EQ(2, count) << "pass " << pass << " variant " << i;
+            EXPECT_STREQ("lighting.h", dependencies[0].path);
+            EXPECT_STREQ("", dependencies[0].parentName);
+            EXPECT_STREQ("common.h", dependencies[1].path);
+            EXPECT_STREQ("lighting.h", dependencies[1].parentName);
+            Hlsl2Glsl_DestructCompiler(results[i].handle);
+        }
+    }
+
+    Hlsl2Glsl_DestructCache(cache);
+}
+
+// NOLINTNEXTLINE
+TEST_F(Hlsl2GlslVariantsTest, TranslateToOtherTargets)
+{
+    // The matrix cast parses differently before GLSL 1.20, so the variant gets parsed again
+    Hlsl2Glsl_BatchJob variantJob = job();
+    variantJob.shaderString = "float4x4 m;\nfloat4 main (float4 v : TEXCOORD0) : COLOR0 { return float4 (mul ((float3x3)m, v.xyz), SCALE); }\n";
+    const Hlsl2Glsl_Define define { "SCALE", "0.5" };
+    const Hlsl2Glsl_Variant variant { &define, 1 };
+    Hlsl2Glsl_BatchResult result {};
+    ASSERT_EQ(1, Hlsl2Glsl_CompileVariants(&variantJob, &variant, 1, &result, 1, nullptr));
+
+    const std::string expanded = "float4x4 m;\nfloat4 main (float4 v : TEXCOORD0) : COLOR0 { return float4 (mul ((float3x3)m, v.xyz), 0.5); }\n";
+    for (ETargetVersion version : { ETargetGLSL_ES_100, ETargetGLSL_140, ETargetGLSL_110 }) {
+        const bool success = Hlsl2Glsl_Translate(result.handle, "main", version, 0) != 0;
+        EXPECT_EQ(compile(expanded, version), output(result.handle, success)) << "target " << version;
+    }
+    Hlsl2Glsl_DestructCompiler(result.handle);
+}
+
+// NOLINTNEXTLINE
+TEST_F(Hlsl2GlslVariantsTest, DuplicatesTranslateToOtherTargets)
+{
+    Hlsl2Glsl_BatchJob variantJob = job();
+    variantJob.shaderString = "float4x4 m;\nfloat4 main (float4 v : TEXCOORD0) : COLOR0 { return float4 (mul ((float3x3)m, v.xyz), SCALE); }\n";
+    const Hlsl2Glsl_Define defines[] = { { "SCALE", "0.5" }, { "UNUSED", nullptr } };
+    const Hlsl2Glsl_Variant variants[] = { { defines, 1 }, { defines, 2 } };
+    Hlsl2Glsl_BatchResult results[2] {};
+    Hlsl2Glsl_VariantStats stats {};
+    ASSERT_EQ(1, Hlsl2Glsl_CompileVariants(&variantJob, variants, 2, results, 2, &stats));
+    EXPECT_EQ(1, stats.duplicates);
+
+    const std::string expanded = "float4x4 m;\nfloat4 main (float4 v : TEXCOORD0) : COLOR0 { return float4 (mul ((float3x3)m, v.xyz), 0.5); }\n";
+    for (ETargetVersion version : { ETargetGLSL_110, ETargetGLSL_ES_100, ETargetGLSL_140 }) {
+        const bool success = Hlsl2Glsl_Translate(results[1].handle, "main", version, 0) != 0;
+        EXPECT_EQ(compile(expanded, version), output(results[1].handle, success)) << "target " << version;
+    }
+    for (const Hlsl2Glsl_BatchResult& result : results) {
+        Hlsl2Glsl_DestructCompiler(result.handle);
+    }
+}
+
+} // namespace